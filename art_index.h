@@ -0,0 +1,1098 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "rank_index.h"
+
+// ART 键编码：把键转换为定长字节串，字节串的字典序与键的顺序一致
+template<typename K, typename = void>
+struct ArtKeyTraits;
+
+// 整数：大端字节序，有符号数翻转符号位
+template<typename K>
+struct ArtKeyTraits<K, std::enable_if_t<std::is_integral_v<K> && !std::is_same_v<K, bool>>>
+{
+    static constexpr size_t LENGTH = sizeof(K);
+
+    static void Encode(K key, uint8_t* pOut)
+    {
+        using U = std::make_unsigned_t<K>;
+        U uValue = static_cast<U>(key);
+        if constexpr (std::is_signed_v<K>)
+        {
+            uValue ^= static_cast<U>(U(1) << (8 * sizeof(K) - 1));
+        }
+        for (size_t i = 0; i < LENGTH; ++i)
+        {
+            pOut[i] = static_cast<uint8_t>(uValue >> (8 * (LENGTH - 1 - i)));
+        }
+    }
+};
+
+// 排行榜排序键：分数降序编码为8字节，再接8字节成员编号
+template<>
+struct ArtKeyTraits<RankKey>
+{
+    static constexpr size_t LENGTH = 16;
+
+    static void Encode(const RankKey& stKey, uint8_t* pOut)
+    {
+        // 浮点数按位转换为按大小排列的无符号数，取反得到降序；+0 与 -0 比较相等，统一编码
+        double dScore = stKey.m_dScore == 0 ? 0.0 : stKey.m_dScore;
+        uint64_t ulBits = std::bit_cast<uint64_t>(dScore);
+        ulBits = (ulBits >> 63) != 0 ? ~ulBits : (ulBits | (1ULL << 63));
+        ArtKeyTraits<uint64_t>::Encode(~ulBits, pOut);
+        ArtKeyTraits<uint64_t>::Encode(stKey.m_ulMember, pOut + 8);
+    }
+};
+
+// 自适应基数树(ART)有序索引，接口与 SkipList 相同，键由 ArtKeyTraits 编码为定长字节串
+// 内部节点按子节点数在 Node4/16/48/256 之间伸缩，公共前缀压缩在节点中，深度不超过键长，查找是几次按字节的下标访问；
+// 叶子存完整的键，只有一个后代的路径直接指向叶子
+// 每个内部节点记录子树中的叶子数，排名 = 沿查找路径累加左侧兄弟的叶子数，O(键长)
+// 读操作按乐观锁耦合(optimistic lock coupling)遍历：读节点前记下版本号，取到子节点后校验版本，记下子节点版本号后再校验一次父节点(根节点则确认根指针未变)，被修改或作废则从根重来，读不加锁；
+// 写操作沿路径的叶子数要和结构修改一起生效，写操作之间由写锁串行，路径上的节点在修改期间加写锁使并发的读重试
+// 被替换的节点和叶子放入退休列表，由 ReclaimRetired 或析构时释放，调用方保证此时没有其他线程访问
+template<typename K, typename V, typename Access = ConcurrentAccess>
+class ArtIndex
+{
+    private:
+        using Traits = ArtKeyTraits<K>;
+        using Ref = uintptr_t;// 子节点引用，最低位为1时指向叶子，0为空
+        using Slot = std::atomic<Ref>;
+
+        static constexpr size_t   KEY_LEN = Traits::LENGTH;
+        static constexpr uint64_t OBSOLETE = 1;// 版本号第0位：节点已作废
+        static constexpr uint64_t LOCKED = 2;  // 版本号第1位：节点正在修改
+
+        // 单线程访问时的空锁
+        struct NullLock
+        {
+            void lock() {}
+            void unlock() {}
+        };
+
+        using WriteMutex = std::conditional_t<Access::CONCURRENT, std::mutex, NullLock>;
+
+        enum ENodeType : uint8_t
+        {
+            NODE4,
+            NODE16,
+            NODE48,
+            NODE256,
+        };
+
+        // 叶子，创建后不再修改；更新值时换成新叶子
+        struct Leaf
+        {
+            K       m_stKey;
+            V       m_stValue;
+            uint8_t m_aucKey[KEY_LEN];// 编码后的键
+        };
+
+        // 内部节点公共部分，读者可能与写者同时访问，字段都是原子变量
+        struct Inner
+        {
+            std::atomic<uint64_t> m_ulVersion{ 0 };// 版本号
+            std::atomic<uint64_t> m_ulCount{ 0 };  // 子树中的叶子数
+            const ENodeType       m_eType;         // 节点类型
+            std::atomic<uint8_t>  m_ucPrefixLen{ 0 };// 压缩前缀长度
+            std::atomic<uint16_t> m_usChildren{ 0 };// 子节点数
+            std::atomic<uint8_t>  m_aucPrefix[KEY_LEN];// 压缩前缀
+
+            explicit Inner(ENodeType eType) : m_eType(eType)
+            {
+            }
+        };
+
+        // Node4、Node16：键和子节点按键升序存放
+        template<ENodeType TYPE, size_t CAPACITY>
+        struct SortedNode : Inner
+        {
+            std::atomic<uint8_t> m_aucKeys[CAPACITY];
+            Slot                 m_astChildren[CAPACITY];
+
+            SortedNode() : Inner(TYPE)
+            {
+            }
+        };
+
+        using Node4 = SortedNode<NODE4, 4>;
+        using Node16 = SortedNode<NODE16, 16>;
+
+        // Node48：按字节查下标，0 表示没有子节点，否则为子节点位置加一
+        struct Node48 : Inner
+        {
+            std::atomic<uint8_t> m_aucIndex[256];
+            Slot                 m_astChildren[48];
+
+            Node48() : Inner(NODE48)
+            {
+            }
+        };
+
+        struct Node256 : Inner
+        {
+            Slot m_astChildren[256];
+
+            Node256() : Inner(NODE256)
+            {
+            }
+        };
+
+        // 遍历的结果：继续、回调要求停止、读到的节点已变化需要重来
+        enum class EVisit
+        {
+            Continue,
+            Stop,
+            Restart,
+        };
+
+        Slot                m_stRoot{ 0 };     // 根节点
+        std::atomic<size_t> m_ulSize{ 0 };     // 叶子数
+        WriteMutex          m_stWriteMutex;    // 串行化写操作，并保护退休列表
+        std::vector<Ref>    m_vecRetired;      // 已替换下来的节点和叶子
+
+        static bool IsLeaf(Ref ref)
+        {
+            return (ref & 1) != 0;
+        }
+
+        static Leaf* AsLeaf(Ref ref)
+        {
+            return reinterpret_cast<Leaf*>(ref & ~Ref(1));
+        }
+
+        static Inner* AsInner(Ref ref)
+        {
+            return reinterpret_cast<Inner*>(ref);
+        }
+
+        static Ref MakeLeaf(const K& key, const V& value, const uint8_t* aucKey)
+        {
+            Leaf* pLeaf = new Leaf{ key, value, {} };
+            std::memcpy(pLeaf->m_aucKey, aucKey, KEY_LEN);
+            return reinterpret_cast<Ref>(pLeaf) | 1;
+        }
+
+        static size_t GetCapacity(const Inner* pNode)
+        {
+            static constexpr size_t CAPACITY[] = { 4, 16, 48, 256 };
+            return CAPACITY[pNode->m_eType];
+        }
+
+        // 读：等待写锁释放后记下版本号，节点已作废时返回false
+        static bool ReadLock(const Inner* pNode, uint64_t& ulVersion)
+        {
+            if constexpr (!Access::CONCURRENT)
+            {
+                ulVersion = 0;
+                return true;
+            }
+            ulVersion = pNode->m_ulVersion.load(std::memory_order_acquire);
+            while ((ulVersion & LOCKED) != 0)
+            {
+                ulVersion = pNode->m_ulVersion.load(std::memory_order_acquire);
+            }
+            return (ulVersion & OBSOLETE) == 0;
+        }
+
+        // 读：校验读取期间节点没有被修改
+        static bool Validate(const Inner* pNode, uint64_t ulVersion)
+        {
+            if constexpr (!Access::CONCURRENT)
+            {
+                return true;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return pNode->m_ulVersion.load(std::memory_order_relaxed) == ulVersion;
+        }
+
+        // 读：记下子节点的版本号后确认它仍挂在父节点下(父节点为空时确认仍是根)，否则子节点可能已被改了前缀或摘下
+        // 父节点的版本号在此之前未变，子节点的版本号就是在它可达时读到的，之后对子节点的修改都能由它的版本号发现
+        bool ValidateParent(const Inner* pParent, uint64_t ulParentVersion, Ref ref) const
+        {
+            if (pParent != nullptr)
+            {
+                return Validate(pParent, ulParentVersion);
+            }
+            return m_stRoot.load(std::memory_order_acquire) == ref;
+        }
+
+        // 写：只有持有写锁的线程修改版本号
+        static void WriteLock(Inner* pNode)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                pNode->m_ulVersion.store(pNode->m_ulVersion.load(std::memory_order_relaxed) + LOCKED, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+        }
+
+        static void WriteUnlock(Inner* pNode, bool bObsolete = false)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                pNode->m_ulVersion.store(pNode->m_ulVersion.load(std::memory_order_relaxed) + LOCKED + (bObsolete ? OBSOLETE : 0), std::memory_order_release);
+            }
+        }
+
+        static void LockPath(Inner* const* apPath, size_t ulCount)
+        {
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                WriteLock(apPath[i]);
+            }
+        }
+
+        static void UnlockPath(Inner* const* apPath, size_t ulCount)
+        {
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                WriteUnlock(apPath[i]);
+            }
+        }
+
+        static void AddCounts(Inner* const* apPath, size_t ulCount, int64_t llDelta)
+        {
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                std::atomic<uint64_t>& stCount = apPath[i]->m_ulCount;
+                stCount.store(stCount.load(std::memory_order_relaxed) + static_cast<uint64_t>(llDelta), std::memory_order_relaxed);
+            }
+        }
+
+        static uint64_t GetChildCount(Ref ref)
+        {
+            if (ref == 0)
+            {
+                return 0;
+            }
+            return IsLeaf(ref) ? 1 : AsInner(ref)->m_ulCount.load(std::memory_order_relaxed);
+        }
+
+        static void SetPrefix(Inner* pNode, const uint8_t* aucPrefix, size_t ulLen)
+        {
+            for (size_t i = 0; i < ulLen; ++i)
+            {
+                pNode->m_aucPrefix[i].store(aucPrefix[i], std::memory_order_relaxed);
+            }
+            pNode->m_ucPrefixLen.store(static_cast<uint8_t>(ulLen), std::memory_order_relaxed);
+        }
+
+        static size_t CopyPrefix(const Inner* pNode, uint8_t* aucOut)
+        {
+            size_t ulLen = std::min<size_t>(pNode->m_ucPrefixLen.load(std::memory_order_relaxed), KEY_LEN);
+            for (size_t i = 0; i < ulLen; ++i)
+            {
+                aucOut[i] = pNode->m_aucPrefix[i].load(std::memory_order_relaxed);
+            }
+            return ulLen;
+        }
+
+        // 比较节点前缀与 aucKey 中对应的字节，返回 <0、0、>0
+        static int ComparePrefix(const Inner* pNode, size_t ulLen, const uint8_t* aucKey)
+        {
+            for (size_t i = 0; i < ulLen; ++i)
+            {
+                uint8_t ucByte = pNode->m_aucPrefix[i].load(std::memory_order_relaxed);
+                if (ucByte != aucKey[i])
+                {
+                    return ucByte < aucKey[i] ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+        // 字节 ucByte 对应的子节点槽，没有时返回空；Node256 返回的槽可能为空引用
+        static Slot* FindChild(Inner* pNode, uint8_t ucByte)
+        {
+            switch (pNode->m_eType)
+            {
+            case NODE4:
+                return FindSorted(static_cast<Node4*>(pNode), ucByte);
+            case NODE16:
+                return FindSorted(static_cast<Node16*>(pNode), ucByte);
+            case NODE48:
+            {
+                Node48* pNode48 = static_cast<Node48*>(pNode);
+                uint8_t ucIndex = pNode48->m_aucIndex[ucByte].load(std::memory_order_relaxed);
+                return ucIndex != 0 ? &pNode48->m_astChildren[ucIndex - 1] : nullptr;
+            }
+            default:
+                return &static_cast<Node256*>(pNode)->m_astChildren[ucByte];
+            }
+        }
+
+        template<typename Node>
+        static Slot* FindSorted(Node* pNode, uint8_t ucByte)
+        {
+            size_t ulCount = std::min<size_t>(pNode->m_usChildren.load(std::memory_order_relaxed), std::size(pNode->m_aucKeys));
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                uint8_t ucKey = pNode->m_aucKeys[i].load(std::memory_order_relaxed);
+                if (ucKey >= ucByte)
+                {
+                    return ucKey == ucByte ? &pNode->m_astChildren[i] : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        // 按字节升序对不小于 uiFrom 的子节点调用 fn(字节, 引用)
+        template<typename Fn>
+        static void ForEachChild(Inner* pNode, unsigned uiFrom, Fn&& fn)
+        {
+            switch (pNode->m_eType)
+            {
+            case NODE4:
+                ForEachSorted(static_cast<Node4*>(pNode), uiFrom, fn);
+                break;
+            case NODE16:
+                ForEachSorted(static_cast<Node16*>(pNode), uiFrom, fn);
+                break;
+            case NODE48:
+            {
+                Node48* pNode48 = static_cast<Node48*>(pNode);
+                for (unsigned i = uiFrom; i < 256; ++i)
+                {
+                    uint8_t ucIndex = pNode48->m_aucIndex[i].load(std::memory_order_relaxed);
+                    if (ucIndex != 0)
+                    {
+                        fn(static_cast<uint8_t>(i), pNode48->m_astChildren[ucIndex - 1].load(std::memory_order_acquire));
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                Node256* pNode256 = static_cast<Node256*>(pNode);
+                for (unsigned i = uiFrom; i < 256; ++i)
+                {
+                    Ref ref = pNode256->m_astChildren[i].load(std::memory_order_acquire);
+                    if (ref != 0)
+                    {
+                        fn(static_cast<uint8_t>(i), ref);
+                    }
+                }
+                break;
+            }
+            }
+        }
+
+        template<typename Node, typename Fn>
+        static void ForEachSorted(Node* pNode, unsigned uiFrom, Fn& fn)
+        {
+            size_t ulCount = std::min<size_t>(pNode->m_usChildren.load(std::memory_order_relaxed), std::size(pNode->m_aucKeys));
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                uint8_t ucKey = pNode->m_aucKeys[i].load(std::memory_order_relaxed);
+                if (ucKey >= uiFrom)
+                {
+                    fn(ucKey, pNode->m_astChildren[i].load(std::memory_order_acquire));
+                }
+            }
+        }
+
+        // 字节小于 ucByte 的子树的叶子数之和；大节点在后半段时用总数减去其余部分
+        static uint64_t CountBelow(Inner* pNode, uint8_t ucByte)
+        {
+            uint64_t ulCount = 0;
+            if (pNode->m_eType >= NODE48 && ucByte >= 128)
+            {
+                ForEachChild(pNode, ucByte, [&](uint8_t, Ref ref)
+                {
+                    ulCount += GetChildCount(ref);
+                });
+                return pNode->m_ulCount.load(std::memory_order_relaxed) - ulCount;
+            }
+            ForEachChild(pNode, 0, [&](uint8_t ucKey, Ref ref)
+            {
+                if (ucKey < ucByte)
+                {
+                    ulCount += GetChildCount(ref);
+                }
+            });
+            return ulCount;
+        }
+
+        // 以下在持有写锁时调用
+
+        template<typename Node>
+        static void InsertSortedChild(Node* pNode, uint8_t ucByte, Ref ref)
+        {
+            size_t ulCount = pNode->m_usChildren.load(std::memory_order_relaxed);
+            size_t ulPos = ulCount;
+            while (ulPos > 0 && pNode->m_aucKeys[ulPos - 1].load(std::memory_order_relaxed) > ucByte)
+            {
+                pNode->m_aucKeys[ulPos].store(pNode->m_aucKeys[ulPos - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                pNode->m_astChildren[ulPos].store(pNode->m_astChildren[ulPos - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                --ulPos;
+            }
+            pNode->m_aucKeys[ulPos].store(ucByte, std::memory_order_relaxed);
+            pNode->m_astChildren[ulPos].store(ref, std::memory_order_release);
+            pNode->m_usChildren.store(static_cast<uint16_t>(ulCount + 1), std::memory_order_relaxed);
+        }
+
+        template<typename Node>
+        static void EraseSortedChild(Node* pNode, uint8_t ucByte)
+        {
+            size_t ulCount = pNode->m_usChildren.load(std::memory_order_relaxed);
+            size_t ulPos = 0;
+            while (pNode->m_aucKeys[ulPos].load(std::memory_order_relaxed) != ucByte)
+            {
+                ++ulPos;
+            }
+            for (; ulPos + 1 < ulCount; ++ulPos)
+            {
+                pNode->m_aucKeys[ulPos].store(pNode->m_aucKeys[ulPos + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                pNode->m_astChildren[ulPos].store(pNode->m_astChildren[ulPos + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            pNode->m_astChildren[ulCount - 1].store(0, std::memory_order_relaxed);
+            pNode->m_usChildren.store(static_cast<uint16_t>(ulCount - 1), std::memory_order_relaxed);
+        }
+
+        // 加入子节点，调用方保证节点未满
+        static void AddChild(Inner* pNode, uint8_t ucByte, Ref ref)
+        {
+            switch (pNode->m_eType)
+            {
+            case NODE4:
+                InsertSortedChild(static_cast<Node4*>(pNode), ucByte, ref);
+                break;
+            case NODE16:
+                InsertSortedChild(static_cast<Node16*>(pNode), ucByte, ref);
+                break;
+            case NODE48:
+            {
+                Node48* pNode48 = static_cast<Node48*>(pNode);
+                size_t ulPos = 0;
+                while (pNode48->m_astChildren[ulPos].load(std::memory_order_relaxed) != 0)
+                {
+                    ++ulPos;
+                }
+                pNode48->m_astChildren[ulPos].store(ref, std::memory_order_release);
+                pNode48->m_aucIndex[ucByte].store(static_cast<uint8_t>(ulPos + 1), std::memory_order_relaxed);
+                pNode48->m_usChildren.store(static_cast<uint16_t>(pNode48->m_usChildren.load(std::memory_order_relaxed) + 1), std::memory_order_relaxed);
+                break;
+            }
+            default:
+                static_cast<Node256*>(pNode)->m_astChildren[ucByte].store(ref, std::memory_order_release);
+                pNode->m_usChildren.store(static_cast<uint16_t>(pNode->m_usChildren.load(std::memory_order_relaxed) + 1), std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        static void EraseChild(Inner* pNode, uint8_t ucByte)
+        {
+            switch (pNode->m_eType)
+            {
+            case NODE4:
+                EraseSortedChild(static_cast<Node4*>(pNode), ucByte);
+                break;
+            case NODE16:
+                EraseSortedChild(static_cast<Node16*>(pNode), ucByte);
+                break;
+            case NODE48:
+            {
+                Node48* pNode48 = static_cast<Node48*>(pNode);
+                uint8_t ucIndex = pNode48->m_aucIndex[ucByte].load(std::memory_order_relaxed);
+                pNode48->m_aucIndex[ucByte].store(0, std::memory_order_relaxed);
+                pNode48->m_astChildren[ucIndex - 1].store(0, std::memory_order_relaxed);
+                pNode48->m_usChildren.store(static_cast<uint16_t>(pNode48->m_usChildren.load(std::memory_order_relaxed) - 1), std::memory_order_relaxed);
+                break;
+            }
+            default:
+                static_cast<Node256*>(pNode)->m_astChildren[ucByte].store(0, std::memory_order_relaxed);
+                pNode->m_usChildren.store(static_cast<uint16_t>(pNode->m_usChildren.load(std::memory_order_relaxed) - 1), std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        static Inner* NewNode(ENodeType eType)
+        {
+            switch (eType)
+            {
+            case NODE4:
+                return new Node4();
+            case NODE16:
+                return new Node16();
+            case NODE48:
+                return new Node48();
+            default:
+                return new Node256();
+            }
+        }
+
+        static void DeleteNode(Inner* pNode)
+        {
+            switch (pNode->m_eType)
+            {
+            case NODE4:
+                delete static_cast<Node4*>(pNode);
+                break;
+            case NODE16:
+                delete static_cast<Node16*>(pNode);
+                break;
+            case NODE48:
+                delete static_cast<Node48*>(pNode);
+                break;
+            default:
+                delete static_cast<Node256*>(pNode);
+                break;
+            }
+        }
+
+        // 复制为 eType 类型的新节点，前缀、叶子数和子节点不变；用于节点伸缩
+        static Inner* CopyNode(Inner* pNode, ENodeType eType)
+        {
+            Inner* pNew = NewNode(eType);
+            uint8_t aucPrefix[KEY_LEN];
+            SetPrefix(pNew, aucPrefix, CopyPrefix(pNode, aucPrefix));
+            pNew->m_ulCount.store(pNode->m_ulCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            ForEachChild(pNode, 0, [&](uint8_t ucByte, Ref ref)
+            {
+                AddChild(pNew, ucByte, ref);
+            });
+            return pNew;
+        }
+
+        // 删除子节点后是否换成更小的节点，与扩大的阈值错开，避免在边界上反复伸缩
+        static bool ShouldShrink(const Inner* pNode)
+        {
+            size_t ulCount = pNode->m_usChildren.load(std::memory_order_relaxed);
+            return (pNode->m_eType == NODE16 && ulCount <= 3) || (pNode->m_eType == NODE48 && ulCount <= 12) || (pNode->m_eType == NODE256 && ulCount <= 37);
+        }
+
+        void FreeTree(Ref ref)
+        {
+            if (ref == 0)
+            {
+                return;
+            }
+            if (IsLeaf(ref))
+            {
+                delete AsLeaf(ref);
+                return;
+            }
+            Inner* pNode = AsInner(ref);
+            ForEachChild(pNode, 0, [this](uint8_t, Ref stChild)
+            {
+                FreeTree(stChild);
+            });
+            DeleteNode(pNode);
+        }
+
+        // 找编码为 aucKey 的叶子，没有时返回空
+        Leaf* FindLeaf(const uint8_t* aucKey) const
+        {
+            while (true)
+            {
+                Ref ref = m_stRoot.load(std::memory_order_acquire);
+                const Inner* pParent = nullptr;
+                uint64_t ulParentVersion = 0;
+                size_t ulDepth = 0;
+                bool bRestart = false;
+                while (!bRestart)
+                {
+                    if (ref == 0)
+                    {
+                        return nullptr;
+                    }
+                    if (IsLeaf(ref))
+                    {
+                        Leaf* pLeaf = AsLeaf(ref);
+                        return std::memcmp(pLeaf->m_aucKey, aucKey, KEY_LEN) == 0 ? pLeaf : nullptr;
+                    }
+                    Inner* pNode = AsInner(ref);
+                    uint64_t ulVersion = 0;
+                    if (!ReadLock(pNode, ulVersion) || !ValidateParent(pParent, ulParentVersion, ref))
+                    {
+                        bRestart = true;
+                        break;
+                    }
+                    size_t ulLen = pNode->m_ucPrefixLen.load(std::memory_order_relaxed);
+                    if (ulDepth + ulLen >= KEY_LEN || ComparePrefix(pNode, ulLen, aucKey + ulDepth) != 0)
+                    {
+                        if (!Validate(pNode, ulVersion))
+                        {
+                            bRestart = true;
+                            break;
+                        }
+                        return nullptr;
+                    }
+                    ulDepth += ulLen;
+                    Slot* pSlot = FindChild(pNode, aucKey[ulDepth]);
+                    ref = pSlot != nullptr ? pSlot->load(std::memory_order_acquire) : 0;
+                    bRestart = !Validate(pNode, ulVersion);
+                    pParent = pNode;
+                    ulParentVersion = ulVersion;
+                    ++ulDepth;
+                }
+            }
+        }
+
+        // 按序访问 ref 子树中不小于边界(bStrict 时大于)的叶子，pBound 为空时整棵子树都在边界之后
+        // 每个节点在版本校验内取出子节点快照，再在锁外逐个访问；校验失败返回 Restart，由调用方从最后访问的键之后重来
+        // pParent 为取出 ref 的节点及其版本号，根节点时为空；进入内部节点前要确认它仍挂在父节点下
+        template<typename Fn>
+        EVisit Visit(const Inner* pParent, uint64_t ulParentVersion, Ref ref, size_t ulDepth, const uint8_t* pBound, bool bStrict, Fn& fn, uint8_t* aucLast, bool& bHasLast)
+        {
+            if (IsLeaf(ref))
+            {
+                Leaf* pLeaf = AsLeaf(ref);
+                if (pBound != nullptr)
+                {
+                    int iCmp = std::memcmp(pLeaf->m_aucKey, pBound, KEY_LEN);
+                    if (iCmp < 0 || (iCmp == 0 && bStrict))
+                    {
+                        return EVisit::Continue;
+                    }
+                }
+                std::memcpy(aucLast, pLeaf->m_aucKey, KEY_LEN);
+                bHasLast = true;
+                return fn(pLeaf->m_stKey, pLeaf->m_stValue) ? EVisit::Continue : EVisit::Stop;
+            }
+            Inner* pNode = AsInner(ref);
+            uint64_t ulVersion = 0;
+            if (!ReadLock(pNode, ulVersion) || !ValidateParent(pParent, ulParentVersion, ref))
+            {
+                return EVisit::Restart;
+            }
+            size_t ulLen = pNode->m_ucPrefixLen.load(std::memory_order_relaxed);
+            if (ulDepth + ulLen >= KEY_LEN)
+            {
+                return EVisit::Restart;
+            }
+            if (pBound != nullptr)
+            {
+                int iCmp = ComparePrefix(pNode, ulLen, pBound + ulDepth);
+                if (iCmp < 0)
+                {
+                    // 整棵子树都小于边界
+                    return Validate(pNode, ulVersion) ? EVisit::Continue : EVisit::Restart;
+                }
+                if (iCmp > 0)
+                {
+                    pBound = nullptr;
+                }
+            }
+            ulDepth += ulLen;
+            uint8_t aucBytes[256];
+            Ref astChildren[256];
+            size_t ulCount = 0;
+            ForEachChild(pNode, pBound != nullptr ? pBound[ulDepth] : 0, [&](uint8_t ucByte, Ref stChild)
+            {
+                if (ulCount < 256 && stChild != 0)
+                {
+                    aucBytes[ulCount] = ucByte;
+                    astChildren[ulCount++] = stChild;
+                }
+            });
+            if (!Validate(pNode, ulVersion))
+            {
+                return EVisit::Restart;
+            }
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                // 只有与边界同字节的子树需要继续比较边界
+                const uint8_t* pChildBound = pBound != nullptr && aucBytes[i] == pBound[ulDepth] ? pBound : nullptr;
+                EVisit eVisit = Visit(pNode, ulVersion, astChildren[i], ulDepth + 1, pChildBound, bStrict, fn, aucLast, bHasLast);
+                if (eVisit != EVisit::Continue)
+                {
+                    return eVisit;
+                }
+            }
+            return EVisit::Continue;
+        }
+
+        template<typename Fn>
+        void ForEachFromBytes(const uint8_t* pBound, Fn& fn)
+        {
+            uint8_t aucBound[KEY_LEN];
+            uint8_t aucLast[KEY_LEN];
+            bool bHasLast = false;
+            bool bStrict = false;
+            while (true)
+            {
+                Ref ref = m_stRoot.load(std::memory_order_acquire);
+                if (ref == 0 || Visit(nullptr, 0, ref, 0, pBound, bStrict, fn, aucLast, bHasLast) != EVisit::Restart)
+                {
+                    return;
+                }
+                // 从最后交给回调的键之后继续，已访问的键不重复
+                if (bHasLast)
+                {
+                    std::memcpy(aucBound, aucLast, KEY_LEN);
+                    pBound = aucBound;
+                    bStrict = true;
+                }
+            }
+        }
+
+    public:
+        ArtIndex() = default;
+        ArtIndex(const ArtIndex&) = delete;
+        ArtIndex& operator=(const ArtIndex&) = delete;
+
+        ~ArtIndex()
+        {
+            FreeTree(m_stRoot.load(std::memory_order_relaxed));
+            ReclaimRetired();
+        }
+
+        // 插入键值对，键已存在时更新值
+        bool Insert(K key, V value)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+            Inner* apPath[KEY_LEN + 1];// 从根到当前节点的内部节点，写入时都要加锁并更新叶子数
+            size_t ulPath = 0;
+            Slot* pSlot = &m_stRoot;
+            size_t ulDepth = 0;
+            while (true)
+            {
+                Ref ref = pSlot->load(std::memory_order_relaxed);
+                if (ref == 0)
+                {
+                    // 只有空树的根为空
+                    pSlot->store(MakeLeaf(key, value, aucKey), std::memory_order_release);
+                    m_ulSize.fetch_add(1, std::memory_order_release);
+                    return true;
+                }
+                if (IsLeaf(ref))
+                {
+                    Leaf* pLeaf = AsLeaf(ref);
+                    if (std::memcmp(pLeaf->m_aucKey, aucKey, KEY_LEN) == 0)
+                    {
+                        // 键已存在：换成新叶子，读者不会读到写了一半的值
+                        LockPath(apPath, ulPath);
+                        pSlot->store(MakeLeaf(key, value, aucKey), std::memory_order_release);
+                        UnlockPath(apPath, ulPath);
+                        m_vecRetired.push_back(ref);
+                        return true;
+                    }
+                    // 与已有叶子分叉：新建 Node4，前缀为两个键从当前深度起的公共部分
+                    size_t ulCommon = ulDepth;
+                    while (pLeaf->m_aucKey[ulCommon] == aucKey[ulCommon])
+                    {
+                        ++ulCommon;
+                    }
+                    Inner* pNew = NewNode(NODE4);
+                    SetPrefix(pNew, aucKey + ulDepth, ulCommon - ulDepth);
+                    AddChild(pNew, pLeaf->m_aucKey[ulCommon], ref);
+                    AddChild(pNew, aucKey[ulCommon], MakeLeaf(key, value, aucKey));
+                    pNew->m_ulCount.store(2, std::memory_order_relaxed);
+                    LockPath(apPath, ulPath);
+                    AddCounts(apPath, ulPath, 1);
+                    pSlot->store(reinterpret_cast<Ref>(pNew), std::memory_order_release);
+                    UnlockPath(apPath, ulPath);
+                    break;
+                }
+                Inner* pNode = AsInner(ref);
+                uint8_t aucPrefix[KEY_LEN];
+                size_t ulLen = CopyPrefix(pNode, aucPrefix);
+                size_t ulMatch = 0;
+                while (ulMatch < ulLen && aucPrefix[ulMatch] == aucKey[ulDepth + ulMatch])
+                {
+                    ++ulMatch;
+                }
+                if (ulMatch < ulLen)
+                {
+                    // 前缀在 ulMatch 处分叉：在上方插入 Node4，原节点的前缀去掉分叉字节及之前的部分
+                    Inner* pNew = NewNode(NODE4);
+                    SetPrefix(pNew, aucKey + ulDepth, ulMatch);
+                    AddChild(pNew, aucPrefix[ulMatch], ref);
+                    AddChild(pNew, aucKey[ulDepth + ulMatch], MakeLeaf(key, value, aucKey));
+                    pNew->m_ulCount.store(pNode->m_ulCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    LockPath(apPath, ulPath);
+                    WriteLock(pNode);
+                    SetPrefix(pNode, aucPrefix + ulMatch + 1, ulLen - ulMatch - 1);
+                    AddCounts(apPath, ulPath, 1);
+                    pSlot->store(reinterpret_cast<Ref>(pNew), std::memory_order_release);
+                    WriteUnlock(pNode);
+                    UnlockPath(apPath, ulPath);
+                    break;
+                }
+                ulDepth += ulLen;
+                Slot* pChild = FindChild(pNode, aucKey[ulDepth]);
+                if (pChild != nullptr && pChild->load(std::memory_order_relaxed) != 0)
+                {
+                    apPath[ulPath++] = pNode;
+                    pSlot = pChild;
+                    ++ulDepth;
+                    continue;
+                }
+                // 在本节点加入新叶子，节点已满时换成更大的节点
+                Ref stLeaf = MakeLeaf(key, value, aucKey);
+                LockPath(apPath, ulPath);
+                WriteLock(pNode);
+                if (pNode->m_usChildren.load(std::memory_order_relaxed) == GetCapacity(pNode))
+                {
+                    Inner* pBig = CopyNode(pNode, static_cast<ENodeType>(pNode->m_eType + 1));
+                    AddChild(pBig, aucKey[ulDepth], stLeaf);
+                    pBig->m_ulCount.store(pBig->m_ulCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    AddCounts(apPath, ulPath, 1);
+                    pSlot->store(reinterpret_cast<Ref>(pBig), std::memory_order_release);
+                    WriteUnlock(pNode, true);
+                    m_vecRetired.push_back(ref);
+                }
+                else
+                {
+                    AddChild(pNode, aucKey[ulDepth], stLeaf);
+                    pNode->m_ulCount.store(pNode->m_ulCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    AddCounts(apPath, ulPath, 1);
+                    WriteUnlock(pNode);
+                }
+                UnlockPath(apPath, ulPath);
+                break;
+            }
+            m_ulSize.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        bool Remove(K key)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+            Inner* apPath[KEY_LEN + 1];
+            Slot* apSlots[KEY_LEN + 1];// 各节点所在的槽
+            uint8_t aucBytes[KEY_LEN + 1];// 各节点中通往下一层的字节
+            size_t ulPath = 0;
+            Slot* pSlot = &m_stRoot;
+            size_t ulDepth = 0;
+            Ref ref = 0;
+            while (true)
+            {
+                ref = pSlot->load(std::memory_order_relaxed);
+                if (ref == 0)
+                {
+                    return false;
+                }
+                if (IsLeaf(ref))
+                {
+                    if (std::memcmp(AsLeaf(ref)->m_aucKey, aucKey, KEY_LEN) != 0)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                Inner* pNode = AsInner(ref);
+                size_t ulLen = pNode->m_ucPrefixLen.load(std::memory_order_relaxed);
+                if (ComparePrefix(pNode, ulLen, aucKey + ulDepth) != 0)
+                {
+                    return false;
+                }
+                ulDepth += ulLen;
+                Slot* pChild = FindChild(pNode, aucKey[ulDepth]);
+                if (pChild == nullptr || pChild->load(std::memory_order_relaxed) == 0)
+                {
+                    return false;
+                }
+                apPath[ulPath] = pNode;
+                apSlots[ulPath] = pSlot;
+                aucBytes[ulPath] = aucKey[ulDepth];
+                ++ulPath;
+                pSlot = pChild;
+                ++ulDepth;
+            }
+            m_vecRetired.push_back(ref);
+            m_ulSize.fetch_sub(1, std::memory_order_release);
+            if (ulPath == 0)
+            {
+                m_stRoot.store(0, std::memory_order_release);
+                return true;
+            }
+            Inner* pParent = apPath[ulPath - 1];
+            Slot* pParentSlot = apSlots[ulPath - 1];
+            LockPath(apPath, ulPath);
+            EraseChild(pParent, aucBytes[ulPath - 1]);
+            AddCounts(apPath, ulPath, -1);
+            Inner* pReplace = nullptr;
+            if (pParent->m_eType == NODE4 && pParent->m_usChildren.load(std::memory_order_relaxed) == 1)
+            {
+                // 只剩一个子节点：由它顶替本节点，本节点的前缀和分支字节并入子节点的前缀
+                uint8_t ucByte = 0;
+                Ref stOnly = 0;
+                ForEachChild(pParent, 0, [&](uint8_t ucKey, Ref stChild)
+                {
+                    ucByte = ucKey;
+                    stOnly = stChild;
+                });
+                if (!IsLeaf(stOnly))
+                {
+                    Inner* pOnly = AsInner(stOnly);
+                    uint8_t aucPrefix[KEY_LEN];
+                    size_t ulLen = CopyPrefix(pParent, aucPrefix);
+                    aucPrefix[ulLen++] = ucByte;
+                    ulLen += CopyPrefix(pOnly, aucPrefix + ulLen);
+                    WriteLock(pOnly);
+                    SetPrefix(pOnly, aucPrefix, ulLen);
+                    WriteUnlock(pOnly);
+                }
+                pParentSlot->store(stOnly, std::memory_order_release);
+                pReplace = pParent;
+            }
+            else if (ShouldShrink(pParent))
+            {
+                pParentSlot->store(reinterpret_cast<Ref>(CopyNode(pParent, static_cast<ENodeType>(pParent->m_eType - 1))), std::memory_order_release);
+                pReplace = pParent;
+            }
+            UnlockPath(apPath, ulPath - 1);
+            WriteUnlock(pParent, pReplace != nullptr);
+            if (pReplace != nullptr)
+            {
+                m_vecRetired.push_back(reinterpret_cast<Ref>(pReplace));
+            }
+            return true;
+        }
+
+        // 批量插入和删除，与 SkipList 的接口保持一致；逐个键执行，各键的查找路径不共享
+        template<typename It>
+        void InsertSorted(It first, It last)
+        {
+            for (; first != last; ++first)
+            {
+                Insert(first->first, first->second);
+            }
+        }
+
+        template<typename It>
+        size_t RemoveSorted(It first, It last)
+        {
+            size_t ulRemoved = 0;
+            for (; first != last; ++first)
+            {
+                if (Remove(*first))
+                {
+                    ++ulRemoved;
+                }
+            }
+            return ulRemoved;
+        }
+
+        bool Contains(K key)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            return FindLeaf(aucKey) != nullptr;
+        }
+
+        V GetValue(K key)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            Leaf* pLeaf = FindLeaf(aucKey);
+            return pLeaf != nullptr ? pLeaf->m_stValue : V();
+        }
+
+        // 按键升序遍历，回调返回false时提前结束；遍历中遇到修改时从最后访问的键之后继续
+        template<typename Fn>
+        void ForEach(Fn&& fn)
+        {
+            ForEachFromBytes(nullptr, fn);
+        }
+
+        // 从第一个不小于 key 的键开始按升序遍历，回调返回false时提前结束
+        template<typename Fn>
+        void ForEachFrom(const K& key, Fn&& fn)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            ForEachFromBytes(aucKey, fn);
+        }
+
+        // 获取键的排名(严格小于该键的键数)：沿查找路径累加左侧子树的叶子数，O(键长)
+        size_t GetRank(const K& key)
+        {
+            uint8_t aucKey[KEY_LEN];
+            Traits::Encode(key, aucKey);
+            while (true)
+            {
+                Ref ref = m_stRoot.load(std::memory_order_acquire);
+                const Inner* pParent = nullptr;
+                uint64_t ulParentVersion = 0;
+                size_t ulDepth = 0;
+                uint64_t ulRank = 0;
+                while (true)
+                {
+                    if (ref == 0)
+                    {
+                        return ulRank;
+                    }
+                    if (IsLeaf(ref))
+                    {
+                        return ulRank + (std::memcmp(AsLeaf(ref)->m_aucKey, aucKey, KEY_LEN) < 0 ? 1 : 0);
+                    }
+                    Inner* pNode = AsInner(ref);
+                    uint64_t ulVersion = 0;
+                    if (!ReadLock(pNode, ulVersion) || !ValidateParent(pParent, ulParentVersion, ref))
+                    {
+                        break;
+                    }
+                    size_t ulLen = pNode->m_ucPrefixLen.load(std::memory_order_relaxed);
+                    int iCmp = ulDepth + ulLen < KEY_LEN ? ComparePrefix(pNode, ulLen, aucKey + ulDepth) : 0;
+                    uint64_t ulBelow = 0;
+                    Ref stNext = 0;
+                    if (iCmp < 0)
+                    {
+                        // 整棵子树都小于该键
+                        ulBelow = pNode->m_ulCount.load(std::memory_order_relaxed);
+                    }
+                    else if (iCmp == 0 && ulDepth + ulLen < KEY_LEN)
+                    {
+                        ulDepth += ulLen;
+                        ulBelow = CountBelow(pNode, aucKey[ulDepth]);
+                        Slot* pSlot = FindChild(pNode, aucKey[ulDepth]);
+                        stNext = pSlot != nullptr ? pSlot->load(std::memory_order_acquire) : 0;
+                        ++ulDepth;
+                    }
+                    if (!Validate(pNode, ulVersion))
+                    {
+                        break;
+                    }
+                    ulRank += ulBelow;
+                    if (stNext == 0)
+                    {
+                        return ulRank;
+                    }
+                    pParent = pNode;
+                    ulParentVersion = ulVersion;
+                    ref = stNext;
+                }
+            }
+        }
+
+        // 释放退休列表中的节点和叶子，调用方需保证此时没有其他线程访问索引
+        void ReclaimRetired()
+        {
+            std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+            for (Ref ref : m_vecRetired)
+            {
+                if (IsLeaf(ref))
+                {
+                    delete AsLeaf(ref);
+                }
+                else
+                {
+                    DeleteNode(AsInner(ref));
+                }
+            }
+            m_vecRetired.clear();
+        }
+
+        size_t Size() const
+        {
+            return m_ulSize.load(std::memory_order_acquire);
+        }
+};
@@ -0,0 +1,326 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "leaderboard.h"
+#include "snapshot.h"
+
+// 排行榜快照：沿用快照文件的文件头与分块校验，m_usFlags 为 SNAPSHOT_FLAG_BOARD，没有定长键值，m_uiKeySize、m_uiValueSize 为0
+// 限定了容量的排行榜另设 SNAPSHOT_FLAG_BOARD_EXT，文件头后接 BoardSnapshotHeader 记录容量，之后才是各块；
+// 不限容量时不写扩展头，与早先的版本互相兼容
+// 块负载为按排名从高到低排列的变长记录，每块从零状态开始编码，可以独立解码：
+//   分数：与上一条分数位模式的异或值，1字节末尾零位数(64 表示异或为0) + varint(异或值右移末尾零位)
+//   成员名：varint(与上一条共享的前缀长度) + varint(其余长度) + 其余字节
+// 相邻名次的分数接近，异或后符号、指数和尾数低位大多为0，同分只占1字节，整数分数通常2~3字节；
+// 成员名常带相同前缀(玩家编号、区服前缀)，前缀编码去掉重复部分
+
+const uint32_t BOARD_SNAPSHOT_VERSION = 2;// 排行榜扩展头的格式版本，1 为没有扩展头的早先格式
+
+// 排行榜扩展头
+struct BoardSnapshotHeader
+{
+    uint64_t m_ulCapacity;// 容量，0 为不限
+    uint32_t m_uiVersion; // BOARD_SNAPSHOT_VERSION
+    uint32_t m_uiCrc;     // 以上字段的CRC32C
+};
+
+// 写入 varint，每字节低7位为数据，最高位表示后面还有字节
+inline void BoardSnapshotPutVarint(std::vector<uint8_t>& vecOut, uint64_t ulValue)
+{
+    while (ulValue >= 0x80)
+    {
+        vecOut.push_back(static_cast<uint8_t>(ulValue | 0x80));
+        ulValue >>= 7;
+    }
+    vecOut.push_back(static_cast<uint8_t>(ulValue));
+}
+
+// 读取 varint，越界或超过64位时返回false
+inline bool BoardSnapshotGetVarint(const uint8_t*& pPos, const uint8_t* pEnd, uint64_t& ulValue)
+{
+    ulValue = 0;
+    for (int iShift = 0; iShift < 64; iShift += 7)
+    {
+        if (pPos == pEnd)
+        {
+            return false;
+        }
+        uint8_t ucByte = *pPos++;
+        ulValue |= static_cast<uint64_t>(ucByte & 0x7F) << iShift;
+        if ((ucByte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 排行榜块编码器：逐条追加记录，块满时由调用方取出负载写盘
+class BoardSnapshotEncoder
+{
+    private:
+        std::vector<uint8_t> m_vecPayload;// 当前块负载
+        uint32_t             m_uiEntries = 0;// 当前块条目数
+        uint64_t             m_ulPrevBits = 0;// 上一条分数的位模式
+        std::string          m_strPrevName;  // 上一条成员名
+
+    public:
+        void Append(std::string_view svMember, double dScore)
+        {
+            uint64_t ulBits = 0;
+            memcpy(&ulBits, &dScore, sizeof(ulBits));
+            uint64_t ulXor = ulBits ^ m_ulPrevBits;
+            if (ulXor == 0)
+            {
+                m_vecPayload.push_back(64);
+            }
+            else
+            {
+                int iZeros = __builtin_ctzll(ulXor);
+                m_vecPayload.push_back(static_cast<uint8_t>(iZeros));
+                BoardSnapshotPutVarint(m_vecPayload, ulXor >> iZeros);
+            }
+            m_ulPrevBits = ulBits;
+
+            size_t ulShared = 0;
+            size_t ulMax = std::min(svMember.size(), m_strPrevName.size());
+            while (ulShared < ulMax && svMember[ulShared] == m_strPrevName[ulShared])
+            {
+                ++ulShared;
+            }
+            BoardSnapshotPutVarint(m_vecPayload, ulShared);
+            BoardSnapshotPutVarint(m_vecPayload, svMember.size() - ulShared);
+            m_vecPayload.insert(m_vecPayload.end(), svMember.begin() + static_cast<std::ptrdiff_t>(ulShared), svMember.end());
+            m_strPrevName.assign(svMember);
+            ++m_uiEntries;
+        }
+
+        uint32_t GetEntries() const
+        {
+            return m_uiEntries;
+        }
+
+        const std::vector<uint8_t>& GetPayload() const
+        {
+            return m_vecPayload;
+        }
+
+        // 开始新的一块
+        void Reset()
+        {
+            m_vecPayload.clear();
+            m_uiEntries = 0;
+            m_ulPrevBits = 0;
+            m_strPrevName.clear();
+        }
+};
+
+// 解码一块排行榜记录追加到 vecOut，负载格式不符时返回false
+inline bool DecodeBoardSnapshotBlock(const uint8_t* pPayload, const SnapshotBlockHeader& stBlock, std::vector<RankEntry>& vecOut)
+{
+    const uint8_t* pPos = pPayload;
+    const uint8_t* pEnd = pPayload + stBlock.m_uiBytes;
+    uint64_t ulPrevBits = 0;
+    for (uint32_t i = 0; i < stBlock.m_uiEntries; ++i)
+    {
+        if (pPos == pEnd)
+        {
+            return false;
+        }
+        uint8_t ucZeros = *pPos++;
+        uint64_t ulBits = ulPrevBits;
+        if (ucZeros < 64)
+        {
+            uint64_t ulXor = 0;
+            if (!BoardSnapshotGetVarint(pPos, pEnd, ulXor))
+            {
+                return false;
+            }
+            ulBits ^= ulXor << ucZeros;
+        }
+        else if (ucZeros != 64)
+        {
+            return false;
+        }
+        ulPrevBits = ulBits;
+
+        uint64_t ulShared = 0;
+        uint64_t ulRest = 0;
+        if (!BoardSnapshotGetVarint(pPos, pEnd, ulShared) || !BoardSnapshotGetVarint(pPos, pEnd, ulRest)
+            || ulShared > (i > 0 ? vecOut.back().m_strMember.size() : 0) || ulRest > static_cast<uint64_t>(pEnd - pPos))
+        {
+            return false;
+        }
+        RankEntry stEntry;
+        stEntry.m_strMember.reserve(ulShared + ulRest);
+        if (ulShared > 0)
+        {
+            stEntry.m_strMember.assign(vecOut.back().m_strMember, 0, ulShared);
+        }
+        stEntry.m_strMember.append(reinterpret_cast<const char*>(pPos), ulRest);
+        pPos += ulRest;
+        memcpy(&stEntry.m_dScore, &ulBits, sizeof(ulBits));
+        vecOut.push_back(std::move(stEntry));
+    }
+    return pPos == pEnd;
+}
+
+// 将排行榜写入快照文件，先写临时文件、落盘后再改名并同步目录，返回 Ok 后才能释放排行榜；遍历期间持有排行榜的读锁
+template<typename Access>
+ESnapshotResult SaveBoardSnapshot(BasicLeaderboard<Access>& stBoard, const std::string& strPath, uint32_t uiBlockEntries = SNAPSHOT_BLOCK_ENTRIES)
+{
+    std::string strTmpPath = strPath + ".tmp";
+    FILE* pFile = fopen(strTmpPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return ESnapshotResult::OpenFailed;
+    }
+
+    SnapshotHeader stHeader;
+    memset(&stHeader, 0, sizeof(stHeader));
+    stHeader.m_uiMagic = SNAPSHOT_MAGIC;
+    stHeader.m_usVersion = SNAPSHOT_VERSION;
+    stHeader.m_usFlags = SNAPSHOT_FLAG_BOARD;
+    BoardSnapshotHeader stBoardHeader;
+    memset(&stBoardHeader, 0, sizeof(stBoardHeader));
+    stBoardHeader.m_ulCapacity = stBoard.GetCapacity();
+    if (stBoardHeader.m_ulCapacity != 0)
+    {
+        stHeader.m_usFlags |= SNAPSHOT_FLAG_BOARD_EXT;
+        stBoardHeader.m_uiVersion = BOARD_SNAPSHOT_VERSION;
+        stBoardHeader.m_uiCrc = Crc32c(&stBoardHeader, offsetof(BoardSnapshotHeader, m_uiCrc));
+    }
+    // 先占位，写完所有块后回填
+    bool bOk = fwrite(&stHeader, sizeof(stHeader), 1, pFile) == 1;
+    if ((stHeader.m_usFlags & SNAPSHOT_FLAG_BOARD_EXT) != 0)
+    {
+        bOk = bOk && fwrite(&stBoardHeader, sizeof(stBoardHeader), 1, pFile) == 1;
+    }
+
+    BoardSnapshotEncoder stEncoder;
+    auto FlushBlock = [&]()
+    {
+        const std::vector<uint8_t>& vecPayload = stEncoder.GetPayload();
+        SnapshotBlockHeader stBlock;
+        memset(&stBlock, 0, sizeof(stBlock));
+        stBlock.m_uiEntries = stEncoder.GetEntries();
+        stBlock.m_uiBytes = static_cast<uint32_t>(vecPayload.size());
+        stBlock.m_uiCrc = SnapshotBlockCrc(stBlock, vecPayload.data());
+        bOk = bOk && fwrite(&stBlock, sizeof(stBlock), 1, pFile) == 1;
+        bOk = bOk && fwrite(vecPayload.data(), 1, vecPayload.size(), pFile) == vecPayload.size();
+        stHeader.m_ulCount += stBlock.m_uiEntries;
+        stHeader.m_uiBlockCount++;
+        stEncoder.Reset();
+    };
+
+    stBoard.ForEachRanked([&](std::string_view svMember, double dScore)
+    {
+        stEncoder.Append(svMember, dScore);
+        if (stEncoder.GetEntries() == uiBlockEntries)
+        {
+            FlushBlock();
+        }
+        return bOk;
+    });
+    if (stEncoder.GetEntries() > 0)
+    {
+        FlushBlock();
+    }
+
+    stHeader.m_uiHeaderCrc = Crc32c(&stHeader, offsetof(SnapshotHeader, m_uiHeaderCrc));
+    bOk = bOk && fseek(pFile, 0, SEEK_SET) == 0;
+    bOk = bOk && fwrite(&stHeader, sizeof(stHeader), 1, pFile) == 1;
+    if (!CommitSnapshotFile(pFile, bOk, strTmpPath, strPath))
+    {
+        return ESnapshotResult::WriteFailed;
+    }
+    return ESnapshotResult::Ok;
+}
+
+// 从快照文件装载到空排行榜并恢复容量，不通知分数变更接收者
+// 排行榜快照通常是单个冷榜，在调用线程上顺序校验和解码，不另起校验线程；失败时排行榜保持为空
+template<typename Access>
+ESnapshotResult LoadBoardSnapshot(const std::string& strPath, BasicLeaderboard<Access>& stBoard)
+{
+    SnapshotFile stFile;
+    if (!stFile.Open(strPath))
+    {
+        return ESnapshotResult::OpenFailed;
+    }
+    if (stFile.Size() < sizeof(SnapshotHeader))
+    {
+        return ESnapshotResult::Truncated;
+    }
+
+    SnapshotHeader stHeader;
+    memcpy(&stHeader, stFile.Data(), sizeof(stHeader));
+    if (stHeader.m_uiMagic != SNAPSHOT_MAGIC || stHeader.m_usVersion != SNAPSHOT_VERSION ||
+        stHeader.m_uiHeaderCrc != Crc32c(&stHeader, offsetof(SnapshotHeader, m_uiHeaderCrc)))
+    {
+        return ESnapshotResult::BadHeader;
+    }
+    if ((stHeader.m_usFlags & ~SNAPSHOT_FLAG_BOARD_EXT) != SNAPSHOT_FLAG_BOARD || stHeader.m_uiKeySize != 0 || stHeader.m_uiValueSize != 0)
+    {
+        return ESnapshotResult::TypeMismatch;
+    }
+    size_t ulOffset = sizeof(SnapshotHeader);
+    uint64_t ulCapacity = 0;
+    if ((stHeader.m_usFlags & SNAPSHOT_FLAG_BOARD_EXT) != 0)
+    {
+        if (stFile.Size() < ulOffset + sizeof(BoardSnapshotHeader))
+        {
+            return ESnapshotResult::Truncated;
+        }
+        BoardSnapshotHeader stBoardHeader;
+        memcpy(&stBoardHeader, stFile.Data() + ulOffset, sizeof(stBoardHeader));
+        if (stBoardHeader.m_uiVersion != BOARD_SNAPSHOT_VERSION || stBoardHeader.m_uiCrc != Crc32c(&stBoardHeader, offsetof(BoardSnapshotHeader, m_uiCrc)))
+        {
+            return ESnapshotResult::BadHeader;
+        }
+        ulCapacity = stBoardHeader.m_ulCapacity;
+        ulOffset += sizeof(BoardSnapshotHeader);
+    }
+
+    std::vector<RankEntry> vecEntries;
+    // 条目数来自已校验的文件头，仍按文件大小设上限，避免损坏的文件导致过量预留
+    vecEntries.reserve(static_cast<size_t>(std::min<uint64_t>(stHeader.m_ulCount, stFile.Size())));
+    for (uint32_t i = 0; i < stHeader.m_uiBlockCount; ++i)
+    {
+        if (ulOffset + sizeof(SnapshotBlockHeader) > stFile.Size())
+        {
+            return ESnapshotResult::Truncated;
+        }
+        SnapshotBlockHeader stBlock;
+        const uint8_t* pBlock = stFile.Data() + ulOffset;
+        memcpy(&stBlock, pBlock, sizeof(stBlock));
+        if (ulOffset + sizeof(SnapshotBlockHeader) + stBlock.m_uiBytes > stFile.Size())
+        {
+            return ESnapshotResult::Truncated;
+        }
+        if (SnapshotBlockCrc(stBlock, pBlock + sizeof(stBlock)) != stBlock.m_uiCrc
+            || !DecodeBoardSnapshotBlock(pBlock + sizeof(stBlock), stBlock, vecEntries))
+        {
+            return ESnapshotResult::ChecksumMismatch;
+        }
+        ulOffset += sizeof(SnapshotBlockHeader) + stBlock.m_uiBytes;
+    }
+    if (vecEntries.size() != stHeader.m_ulCount)
+    {
+        return ESnapshotResult::ChecksumMismatch;
+    }
+    // 先恢复容量再装载，装载失败时还原
+    size_t ulOldCapacity = stBoard.GetCapacity();
+    stBoard.SetCapacity(static_cast<size_t>(ulCapacity));
+    if (!stBoard.LoadRanked(vecEntries))
+    {
+        stBoard.SetCapacity(ulOldCapacity);
+        return ESnapshotResult::Unordered;
+    }
+    return ESnapshotResult::Ok;
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GAMERANKING_CRC32C_X86 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define GAMERANKING_CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+// CRC32C(Castagnoli) 校验，优先使用 SSE4.2 / ARMv8 CRC 指令，否则回退到查表实现
+
+// 查表实现使用的 slicing-by-8 表，首次使用时生成
+struct Crc32cTable
+{
+    uint32_t m_uiTable[8][256];// 8张256项的查找表
+
+    Crc32cTable()
+    {
+        const uint32_t uiPoly = 0x82F63B78u;// CRC32C 反射多项式
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t uiCrc = i;
+            for (int j = 0; j < 8; ++j)
+            {
+                uiCrc = (uiCrc >> 1) ^ ((uiCrc & 1) ? uiPoly : 0);
+            }
+            m_uiTable[0][i] = uiCrc;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (int k = 1; k < 8; ++k)
+            {
+                uint32_t uiPrev = m_uiTable[k - 1][i];
+                m_uiTable[k][i] = (uiPrev >> 8) ^ m_uiTable[0][uiPrev & 0xFF];
+            }
+        }
+    }
+
+    static const Crc32cTable& Instance()
+    {
+        static const Crc32cTable stTable;
+        return stTable;
+    }
+};
+
+// 查表方式计算CRC32C，uiCrc 为未取反的中间状态
+inline uint32_t Crc32cUpdateTable(uint32_t uiCrc, const uint8_t* pData, size_t ulLen)
+{
+    const auto& T = Crc32cTable::Instance().m_uiTable;
+    while (ulLen >= 8)
+    {
+        uint32_t uiLow = 0;
+        uint32_t uiHigh = 0;
+        memcpy(&uiLow, pData, 4);
+        memcpy(&uiHigh, pData + 4, 4);
+        uiLow ^= uiCrc;
+        uiCrc = T[7][uiLow & 0xFF] ^ T[6][(uiLow >> 8) & 0xFF] ^ T[5][(uiLow >> 16) & 0xFF] ^ T[4][uiLow >> 24] ^
+                T[3][uiHigh & 0xFF] ^ T[2][(uiHigh >> 8) & 0xFF] ^ T[1][(uiHigh >> 16) & 0xFF] ^ T[0][uiHigh >> 24];
+        pData += 8;
+        ulLen -= 8;
+    }
+    while (ulLen-- > 0)
+    {
+        uiCrc = (uiCrc >> 8) ^ T[0][(uiCrc ^ *pData++) & 0xFF];
+    }
+    return uiCrc;
+}
+
+#if defined(GAMERANKING_CRC32C_X86)
+// SSE4.2 指令计算CRC32C，每次处理8字节
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+inline uint32_t Crc32cUpdateHardware(uint32_t uiCrc, const uint8_t* pData, size_t ulLen)
+{
+    uint64_t ulCrc = uiCrc;
+    while (ulLen >= 8)
+    {
+        uint64_t ulWord = 0;
+        memcpy(&ulWord, pData, 8);
+        ulCrc = _mm_crc32_u64(ulCrc, ulWord);
+        pData += 8;
+        ulLen -= 8;
+    }
+    uint32_t uiResult = static_cast<uint32_t>(ulCrc);
+    while (ulLen-- > 0)
+    {
+        uiResult = _mm_crc32_u8(uiResult, *pData++);
+    }
+    return uiResult;
+}
+
+// 运行时检测CPU是否支持SSE4.2
+inline bool Crc32cHardwareSupported()
+{
+#if defined(_MSC_VER)
+    int aiInfo[4] = { 0 };
+    __cpuid(aiInfo, 1);
+    return (aiInfo[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#elif defined(GAMERANKING_CRC32C_ARM)
+// ARMv8 CRC 指令计算CRC32C，每次处理8字节
+inline uint32_t Crc32cUpdateHardware(uint32_t uiCrc, const uint8_t* pData, size_t ulLen)
+{
+    while (ulLen >= 8)
+    {
+        uint64_t ulWord = 0;
+        memcpy(&ulWord, pData, 8);
+        uiCrc = __crc32cd(uiCrc, ulWord);
+        pData += 8;
+        ulLen -= 8;
+    }
+    while (ulLen-- > 0)
+    {
+        uiCrc = __crc32cb(uiCrc, *pData++);
+    }
+    return uiCrc;
+}
+
+// 编译期已确认支持 ARMv8 CRC 扩展
+inline bool Crc32cHardwareSupported()
+{
+    return true;
+}
+#else
+inline uint32_t Crc32cUpdateHardware(uint32_t uiCrc, const uint8_t* pData, size_t ulLen)
+{
+    return Crc32cUpdateTable(uiCrc, pData, ulLen);
+}
+
+inline bool Crc32cHardwareSupported()
+{
+    return false;
+}
+#endif
+
+// 计算数据的CRC32C，可传入上一段的结果继续累加
+inline uint32_t Crc32c(const void* pData, size_t ulLen, uint32_t uiPrev = 0)
+{
+    static const bool bHardware = Crc32cHardwareSupported();
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    uint32_t uiCrc = ~uiPrev;
+    uiCrc = bHardware ? Crc32cUpdateHardware(uiCrc, pBytes, ulLen) : Crc32cUpdateTable(uiCrc, pBytes, ulLen);
+    return ~uiCrc;
+}
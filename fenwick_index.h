@@ -0,0 +1,730 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "skiplist.h"
+
+// 有界整数分数的排序键：分数为 [0, MAX] 内的整数，排序与 RankKey 相同(分数降序，同分按成员编号升序)
+template<uint32_t MAX>
+struct BoundedRankKey
+{
+    uint32_t m_uiScore = 0; // 分数
+    uint64_t m_ulMember = 0;// 成员编号
+
+    bool operator<(const BoundedRankKey& stOther) const
+    {
+        if (m_uiScore != stOther.m_uiScore)
+        {
+            return m_uiScore > stOther.m_uiScore;
+        }
+        return m_ulMember < stOther.m_ulMember;
+    }
+
+    bool operator==(const BoundedRankKey& stOther) const
+    {
+        return m_uiScore == stOther.m_uiScore && m_ulMember == stOther.m_ulMember;
+    }
+};
+
+// 键的取值域：BOUNDED 为true时键映射到 [0, SLOTS) 内的槽号，键的顺序与槽号顺序一致，同一槽内再按键比较
+// 8 位、16 位整数和 BoundedRankKey 是有界的，其他键类型可以特化本模板
+template<typename K, typename = void>
+struct KeyDomain
+{
+    static constexpr bool BOUNDED = false;
+};
+
+template<typename K>
+struct KeyDomain<K, std::enable_if_t<std::is_integral_v<K> && !std::is_same_v<K, bool> && sizeof(K) <= 2>>
+{
+    static constexpr bool   BOUNDED = true;
+    static constexpr size_t SLOTS = size_t(1) << (8 * sizeof(K));
+
+    static size_t GetSlot(K key)
+    {
+        return static_cast<size_t>(static_cast<int64_t>(key) - static_cast<int64_t>(std::numeric_limits<K>::min()));
+    }
+};
+
+template<uint32_t MAX>
+struct KeyDomain<BoundedRankKey<MAX>>
+{
+    static constexpr bool   BOUNDED = true;
+    static constexpr size_t SLOTS = size_t(MAX) + 1;
+
+    // 分数降序，最高分在0号槽
+    static size_t GetSlot(const BoundedRankKey<MAX>& stKey)
+    {
+        return MAX - stKey.m_uiScore;
+    }
+};
+
+// 有界键的有序索引，接口与 SkipList 相同，用按槽计数代替键比较
+// 每个槽的键数记在树状数组(Fenwick 树)中，排名 = 前面各槽的键数之和 + 槽内位置，O(log S)，与键的个数无关；
+// 同一槽的键按序切成至多 CHUNK_MAX 个一块的小块(桶)，插入删除只移动一块内的元素，槽内定位 O(桶大小 / CHUNK_MAX)；
+// 桶由按槽号分条的锁保护
+// 槽按 槽号 % SHARDS 交错分到各分片的树上，相邻槽的更新落在不同的树上，减少高层计数的争用；查询时累加各分片
+// 计数用原子加减更新，只按槽统计的查询(CountBelowSlot)不加锁
+// 空间：构造时只分配非空槽位图(每槽1位)和页表(每 PAGE_SLOTS 槽一个指针)；
+// 首次插入时分配计数数组，每槽4字节(值域 1000001 时约 4MB)，是每个非空索引的固定开销；
+// 桶按页分配，页内有键时才分配，每页 PAGE_SLOTS 个桶头(32字节)，分数集中在少数区间时只占用几页
+template<typename K, typename V, typename Access = ConcurrentAccess>
+class FenwickIndex
+{
+    static_assert(KeyDomain<K>::BOUNDED, "FenwickIndex requires a bounded key domain");
+
+    private:
+        using Domain = KeyDomain<K>;
+        using Entry = std::pair<K, V>;
+        using Chunk = std::vector<Entry>;// 按键升序，非空，至多 CHUNK_MAX 个
+
+        // 同一槽的键值对，各块首尾相接按键升序
+        struct Bucket
+        {
+            std::vector<Chunk> m_vecChunks;// 各块
+            size_t             m_ulSize = 0;// 键数
+        };
+
+        // 单线程访问时的空锁
+        struct NullLock
+        {
+            void lock() {}
+            void unlock() {}
+        };
+
+        using Lock = std::conditional_t<Access::CONCURRENT, std::mutex, NullLock>;
+
+        // 分条锁，独占缓存行
+        struct alignas(64) Stripe
+        {
+            Lock m_stLock;
+        };
+
+        static constexpr size_t SLOTS = Domain::SLOTS;
+        static constexpr size_t SHARDS = Access::CONCURRENT ? 8 : 1;
+        static constexpr size_t STRIPES = Access::CONCURRENT ? 256 : 1;
+        static constexpr size_t WORDS = (SLOTS + 63) / 64;
+        static constexpr size_t CHUNK_MAX = 128;// 每块的键数上限，超过时对半分开
+        static constexpr size_t ITER_BATCH = 64;// 遍历时每次在锁内复制的键数
+        static constexpr size_t PAGE_SLOTS = SLOTS < 1024 ? SLOTS : 1024;// 每页的槽数
+        static constexpr size_t PAGES = (SLOTS + PAGE_SLOTS - 1) / PAGE_SLOTS;
+        static constexpr size_t TREE_STRIDE = (SLOTS + SHARDS - 1) / SHARDS + 1;// 计数数组中每个分片占的长度
+        static constexpr std::memory_order LOAD_ORDER = Access::CONCURRENT ? std::memory_order_acquire : std::memory_order_relaxed;
+
+        // 一页桶
+        struct Page
+        {
+            Bucket m_astBuckets[PAGE_SLOTS];
+        };
+
+        // 桶内位置：块下标与块内下标
+        struct Cursor
+        {
+            size_t m_ulChunk = 0;
+            size_t m_ulOffset = 0;
+        };
+
+        std::atomic<std::atomic<uint32_t>*>      m_pCounts{ nullptr };// 各分片的树状数组，下标从1开始，首次插入时分配
+        std::unique_ptr<std::atomic<Page*>[]>    m_pPages;    // 各页的桶，页内首次插入时分配
+        std::unique_ptr<std::atomic<uint64_t>[]> m_pOccupied; // 非空槽位图，用于有序遍历时跳过空槽
+        std::unique_ptr<Stripe[]>                m_pStripes;  // 桶的分条锁
+        std::atomic<size_t>                      m_ulSize{ 0 };// 键的个数
+
+        // 分片的槽数
+        static constexpr size_t GetTreeSize(size_t ulShard)
+        {
+            return SLOTS > ulShard ? (SLOTS - ulShard + SHARDS - 1) / SHARDS : 0;
+        }
+
+        static void AtomicAdd(std::atomic<uint32_t>& stCount, uint32_t uiDelta)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                stCount.fetch_add(uiDelta, std::memory_order_relaxed);
+            }
+            else
+            {
+                stCount.store(stCount.load(std::memory_order_relaxed) + uiDelta, std::memory_order_relaxed);
+            }
+        }
+
+        void AddSize(int64_t llDelta)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                m_ulSize.fetch_add(static_cast<size_t>(llDelta), std::memory_order_release);
+            }
+            else
+            {
+                m_ulSize.store(m_ulSize.load(std::memory_order_relaxed) + static_cast<size_t>(llDelta), std::memory_order_relaxed);
+            }
+        }
+
+        // 按需分配原子指针指向的对象：并发分配时只有一个胜出，其余释放自己的
+        template<typename T, typename Fn>
+        static T* GetOrCreate(std::atomic<T*>& stPtr, Fn&& fnCreate)
+        {
+            T* p = stPtr.load(std::memory_order_acquire);
+            if (p != nullptr)
+            {
+                return p;
+            }
+            T* pNew = fnCreate();
+            if (stPtr.compare_exchange_strong(p, pNew, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return pNew;
+            }
+            return p;
+        }
+
+        // 槽的计数加 iDelta(+1 或 -1，减法按无符号回绕)
+        void UpdateCount(size_t ulSlot, int iDelta)
+        {
+            std::atomic<uint32_t>* pCounts = GetOrCreate(m_pCounts, []()
+            {
+                return new std::atomic<uint32_t>[SHARDS * TREE_STRIDE]();
+            });
+            size_t ulShard = ulSlot % SHARDS;
+            std::atomic<uint32_t>* pTree = pCounts + ulShard * TREE_STRIDE;
+            uint32_t uiDelta = static_cast<uint32_t>(iDelta);
+            for (size_t i = ulSlot / SHARDS + 1; i <= GetTreeSize(ulShard); i += i & (~i + 1))
+            {
+                AtomicAdd(pTree[i], uiDelta);
+            }
+        }
+
+        // 分片内前 ulCount 个槽的键数之和
+        uint32_t PrefixCount(const std::atomic<uint32_t>* pCounts, size_t ulShard, size_t ulCount) const
+        {
+            const std::atomic<uint32_t>* pTree = pCounts + ulShard * TREE_STRIDE;
+            uint32_t uiSum = 0;
+            for (size_t i = ulCount; i > 0; i -= i & (~i + 1))
+            {
+                uiSum += pTree[i].load(std::memory_order_relaxed);
+            }
+            return uiSum;
+        }
+
+        void SetOccupied(size_t ulSlot, bool bOccupied)
+        {
+            std::atomic<uint64_t>& stWord = m_pOccupied[ulSlot / 64];
+            uint64_t ulBit = 1ULL << (ulSlot % 64);
+            if constexpr (Access::CONCURRENT)
+            {
+                if (bOccupied)
+                {
+                    stWord.fetch_or(ulBit, std::memory_order_release);
+                }
+                else
+                {
+                    stWord.fetch_and(~ulBit, std::memory_order_release);
+                }
+            }
+            else
+            {
+                uint64_t ulWord = stWord.load(std::memory_order_relaxed);
+                stWord.store(bOccupied ? (ulWord | ulBit) : (ulWord & ~ulBit), std::memory_order_relaxed);
+            }
+        }
+
+        // 不小于 ulSlot 的第一个非空槽，没有时返回 SLOTS
+        size_t NextOccupied(size_t ulSlot) const
+        {
+            if (ulSlot >= SLOTS)
+            {
+                return SLOTS;
+            }
+            size_t ulWord = ulSlot / 64;
+            uint64_t ulBits = m_pOccupied[ulWord].load(LOAD_ORDER) & (~0ULL << (ulSlot % 64));
+            while (ulBits == 0)
+            {
+                if (++ulWord == WORDS)
+                {
+                    return SLOTS;
+                }
+                ulBits = m_pOccupied[ulWord].load(LOAD_ORDER);
+            }
+            return ulWord * 64 + static_cast<size_t>(std::countr_zero(ulBits));
+        }
+
+        // 最后一个非空槽，没有时返回 SLOTS
+        size_t LastOccupied() const
+        {
+            for (size_t ulWord = WORDS; ulWord-- > 0;)
+            {
+                uint64_t ulBits = m_pOccupied[ulWord].load(LOAD_ORDER);
+                if (ulBits != 0)
+                {
+                    return ulWord * 64 + 63 - static_cast<size_t>(std::countl_zero(ulBits));
+                }
+            }
+            return SLOTS;
+        }
+
+        Lock& GetStripe(size_t ulSlot) const
+        {
+            return m_pStripes[ulSlot % STRIPES].m_stLock;
+        }
+
+        // 以下在持有槽的分条锁时调用
+
+        // 槽的桶，所在页未分配时返回空
+        Bucket* FindBucket(size_t ulSlot) const
+        {
+            Page* pPage = m_pPages[ulSlot / PAGE_SLOTS].load(std::memory_order_acquire);
+            return pPage == nullptr ? nullptr : &pPage->m_astBuckets[ulSlot % PAGE_SLOTS];
+        }
+
+        // 槽的桶，所在页未分配时分配；同一页的槽属于不同的分条锁，页由原子指针发布
+        Bucket& GetBucket(size_t ulSlot)
+        {
+            Page* pPage = GetOrCreate(m_pPages[ulSlot / PAGE_SLOTS], []()
+            {
+                return new Page();
+            });
+            return pPage->m_astBuckets[ulSlot % PAGE_SLOTS];
+        }
+
+        static typename Chunk::iterator LowerBound(Chunk& vecChunk, const K& key)
+        {
+            return std::lower_bound(vecChunk.begin(), vecChunk.end(), key, [](const Entry& stEntry, const K& stKey)
+            {
+                return stEntry.first < stKey;
+            });
+        }
+
+        // 第一个不小于 key 的键的位置，bAfter 为true时为第一个大于 key 的键；没有时块下标为块数
+        static Cursor Locate(Bucket& stBucket, const K& key, bool bAfter)
+        {
+            std::vector<Chunk>& vecChunks = stBucket.m_vecChunks;
+            // 第一个末尾键不小于 key 的块
+            auto itChunk = std::partition_point(vecChunks.begin(), vecChunks.end(), [&](const Chunk& vecChunk)
+            {
+                return vecChunk.back().first < key;
+            });
+            Cursor stCursor{ static_cast<size_t>(itChunk - vecChunks.begin()), 0 };
+            if (itChunk == vecChunks.end())
+            {
+                return stCursor;
+            }
+            auto it = LowerBound(*itChunk, key);
+            stCursor.m_ulOffset = static_cast<size_t>(it - itChunk->begin());
+            if (bAfter && it->first == key && ++stCursor.m_ulOffset == itChunk->size())
+            {
+                ++stCursor.m_ulChunk;
+                stCursor.m_ulOffset = 0;
+            }
+            return stCursor;
+        }
+
+        // 位置上的键是否为 key
+        static bool IsAt(Bucket& stBucket, const Cursor& stCursor, const K& key)
+        {
+            return stCursor.m_ulChunk < stBucket.m_vecChunks.size() && stBucket.m_vecChunks[stCursor.m_ulChunk][stCursor.m_ulOffset].first == key;
+        }
+
+        // 槽内位置之前的键数，O(块数)
+        static size_t CountBefore(const Bucket& stBucket, const Cursor& stCursor)
+        {
+            size_t ulCount = stCursor.m_ulOffset;
+            for (size_t i = 0; i < stCursor.m_ulChunk; ++i)
+            {
+                ulCount += stBucket.m_vecChunks[i].size();
+            }
+            return ulCount;
+        }
+
+        // 从槽内第一个不小于 *pFrom(bAfter 时为大于)的键起跳过 ulSkip 个，复制至多 ITER_BATCH 个键值对；pFrom 为空时从槽首开始
+        void CopyBatch(size_t ulSlot, const K* pFrom, bool bAfter, size_t ulSkip, std::vector<Entry>& vecOut)
+        {
+            vecOut.clear();
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket* pBucket = FindBucket(ulSlot);
+            if (pBucket == nullptr)
+            {
+                return;
+            }
+            const std::vector<Chunk>& vecChunks = pBucket->m_vecChunks;
+            Cursor stCursor = pFrom != nullptr ? Locate(*pBucket, *pFrom, bAfter) : Cursor();
+            while (stCursor.m_ulChunk < vecChunks.size() && vecOut.size() < ITER_BATCH)
+            {
+                const Chunk& vecChunk = vecChunks[stCursor.m_ulChunk];
+                size_t ulAvail = vecChunk.size() - stCursor.m_ulOffset;
+                if (ulSkip >= ulAvail)
+                {
+                    ulSkip -= ulAvail;
+                }
+                else
+                {
+                    auto itBegin = vecChunk.begin() + static_cast<std::ptrdiff_t>(stCursor.m_ulOffset + ulSkip);
+                    size_t ulTake = std::min(ITER_BATCH - vecOut.size(), static_cast<size_t>(vecChunk.end() - itBegin));
+                    vecOut.insert(vecOut.end(), itBegin, itBegin + static_cast<std::ptrdiff_t>(ulTake));
+                    ulSkip = 0;
+                }
+                ++stCursor.m_ulChunk;
+                stCursor.m_ulOffset = 0;
+            }
+        }
+
+        // 从 ulSlot 槽开始按键升序遍历，首个槽跳过小于 *pFrom 的键和其后的 ulSkip 个键
+        // 每次在锁内复制一小批，回调在锁外执行，回调中可以修改索引；下一批从上一批最后一个键之后续读，不受并发修改影响
+        template<typename Fn>
+        void ForEachFromSlot(size_t ulSlot, const K* pFrom, size_t ulSkip, Fn&& fn)
+        {
+            std::vector<Entry> vecBatch;
+            vecBatch.reserve(ITER_BATCH);
+            for (ulSlot = NextOccupied(ulSlot); ulSlot < SLOTS; ulSlot = NextOccupied(ulSlot + 1))
+            {
+                K stLast = K();
+                bool bAfter = false;
+                while (true)
+                {
+                    CopyBatch(ulSlot, bAfter ? &stLast : pFrom, bAfter, ulSkip, vecBatch);
+                    pFrom = nullptr;
+                    ulSkip = 0;
+                    for (const Entry& stEntry : vecBatch)
+                    {
+                        if (!fn(stEntry.first, stEntry.second))
+                        {
+                            return;
+                        }
+                    }
+                    if (vecBatch.size() < ITER_BATCH)
+                    {
+                        break;
+                    }
+                    stLast = vecBatch.back().first;
+                    bAfter = true;
+                }
+            }
+        }
+
+    public:
+        FenwickIndex() : m_pPages(std::make_unique<std::atomic<Page*>[]>(PAGES)), m_pOccupied(std::make_unique<std::atomic<uint64_t>[]>(WORDS)),
+            m_pStripes(std::make_unique<Stripe[]>(STRIPES))
+        {
+        }
+
+        FenwickIndex(const FenwickIndex&) = delete;
+        FenwickIndex& operator=(const FenwickIndex&) = delete;
+
+        ~FenwickIndex()
+        {
+            delete[] m_pCounts.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < PAGES; ++i)
+            {
+                delete m_pPages[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        // 插入键值对，键已存在时更新值
+        bool Insert(K key, V value)
+        {
+            size_t ulSlot = Domain::GetSlot(key);
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket& stBucket = GetBucket(ulSlot);
+            std::vector<Chunk>& vecChunks = stBucket.m_vecChunks;
+            Cursor stCursor = Locate(stBucket, key, false);
+            if (IsAt(stBucket, stCursor, key))
+            {
+                vecChunks[stCursor.m_ulChunk][stCursor.m_ulOffset].second = value;
+                return true;
+            }
+            // 大于全部键时追加到最后一块
+            if (stCursor.m_ulChunk == vecChunks.size())
+            {
+                if (vecChunks.empty())
+                {
+                    vecChunks.emplace_back();
+                }
+                stCursor.m_ulChunk = vecChunks.size() - 1;
+                stCursor.m_ulOffset = vecChunks.back().size();
+            }
+            Chunk& vecChunk = vecChunks[stCursor.m_ulChunk];
+            vecChunk.insert(vecChunk.begin() + static_cast<std::ptrdiff_t>(stCursor.m_ulOffset), Entry(key, value));
+            if (vecChunk.size() > CHUNK_MAX)
+            {
+                auto itHalf = vecChunk.begin() + static_cast<std::ptrdiff_t>(vecChunk.size() / 2);
+                Chunk vecTail(std::make_move_iterator(itHalf), std::make_move_iterator(vecChunk.end()));
+                vecChunk.erase(itHalf, vecChunk.end());
+                vecChunks.insert(vecChunks.begin() + static_cast<std::ptrdiff_t>(stCursor.m_ulChunk + 1), std::move(vecTail));
+            }
+            if (++stBucket.m_ulSize == 1)
+            {
+                SetOccupied(ulSlot, true);
+            }
+            // 计数在锁内更新，同一个键的删除一定排在插入的计数之后
+            UpdateCount(ulSlot, 1);
+            AddSize(1);
+            return true;
+        }
+
+        bool Remove(K key)
+        {
+            size_t ulSlot = Domain::GetSlot(key);
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket* pBucket = FindBucket(ulSlot);
+            if (pBucket == nullptr)
+            {
+                return false;
+            }
+            Cursor stCursor = Locate(*pBucket, key, false);
+            if (!IsAt(*pBucket, stCursor, key))
+            {
+                return false;
+            }
+            std::vector<Chunk>& vecChunks = pBucket->m_vecChunks;
+            Chunk& vecChunk = vecChunks[stCursor.m_ulChunk];
+            vecChunk.erase(vecChunk.begin() + static_cast<std::ptrdiff_t>(stCursor.m_ulOffset));
+            size_t ulNext = stCursor.m_ulChunk + 1;
+            if (vecChunk.empty())
+            {
+                vecChunks.erase(vecChunks.begin() + static_cast<std::ptrdiff_t>(stCursor.m_ulChunk));
+            }
+            else if (vecChunk.size() < CHUNK_MAX / 4 && ulNext < vecChunks.size() && vecChunk.size() + vecChunks[ulNext].size() <= CHUNK_MAX / 2)
+            {
+                // 过小的块并入后一块，块数保持在键数的 O(1 / CHUNK_MAX)
+                vecChunk.insert(vecChunk.end(), vecChunks[ulNext].begin(), vecChunks[ulNext].end());
+                vecChunks.erase(vecChunks.begin() + static_cast<std::ptrdiff_t>(ulNext));
+            }
+            if (--pBucket->m_ulSize == 0)
+            {
+                SetOccupied(ulSlot, false);
+            }
+            UpdateCount(ulSlot, -1);
+            AddSize(-1);
+            return true;
+        }
+
+        // 批量插入和删除，键无需有序；与 SkipList 的接口保持一致
+        template<typename It>
+        void InsertSorted(It first, It last)
+        {
+            for (; first != last; ++first)
+            {
+                Insert(first->first, first->second);
+            }
+        }
+
+        template<typename It>
+        size_t RemoveSorted(It first, It last)
+        {
+            size_t ulRemoved = 0;
+            for (; first != last; ++first)
+            {
+                if (Remove(*first))
+                {
+                    ++ulRemoved;
+                }
+            }
+            return ulRemoved;
+        }
+
+        // 删除键在 [lo, hi] 内的全部键，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveRange(const K& lo, const K& hi, Fn&& fn)
+        {
+            std::vector<Entry> vecVictims;
+            ForEachFrom(lo, [&](const K& key, const V& value)
+            {
+                if (hi < key)
+                {
+                    return false;
+                }
+                vecVictims.emplace_back(key, value);
+                return true;
+            });
+            size_t ulRemoved = 0;
+            for (const auto& stEntry : vecVictims)
+            {
+                if (Remove(stEntry.first))
+                {
+                    fn(stEntry.first, stEntry.second);
+                    ++ulRemoved;
+                }
+            }
+            return ulRemoved;
+        }
+
+        size_t RemoveRange(const K& lo, const K& hi)
+        {
+            return RemoveRange(lo, hi, [](const K&, const V&) {});
+        }
+
+        // 删除按键升序的第 ulFirst 到第 ulLast 个键(从0开始，含两端)，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveRankRange(size_t ulFirst, size_t ulLast, Fn&& fn)
+        {
+            if (ulFirst > ulLast)
+            {
+                return 0;
+            }
+            std::vector<Entry> vecVictims;
+            ForEachFromRank(ulFirst, [&](const K& key, const V& value)
+            {
+                vecVictims.emplace_back(key, value);
+                return vecVictims.size() <= ulLast - ulFirst;
+            });
+            size_t ulRemoved = 0;
+            for (const auto& stEntry : vecVictims)
+            {
+                if (Remove(stEntry.first))
+                {
+                    fn(stEntry.first, stEntry.second);
+                    ++ulRemoved;
+                }
+            }
+            return ulRemoved;
+        }
+
+        // 取最大的键，索引为空时返回false
+        bool GetLast(K& key, V& value)
+        {
+            for (size_t ulSlot = LastOccupied(); ulSlot < SLOTS; ulSlot = LastOccupied())
+            {
+                std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+                Bucket* pBucket = FindBucket(ulSlot);
+                if (pBucket != nullptr && pBucket->m_ulSize != 0)
+                {
+                    const Entry& stEntry = pBucket->m_vecChunks.back().back();
+                    key = stEntry.first;
+                    value = stEntry.second;
+                    return true;
+                }
+                // 读到位图后槽被其他线程清空，重新查找
+            }
+            return false;
+        }
+
+        // 删除最大的 ulCount 个键，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveLast(size_t ulCount, Fn&& fn)
+        {
+            size_t ulRemoved = 0;
+            K key = K();
+            V value = V();
+            while (ulRemoved < ulCount && GetLast(key, value))
+            {
+                if (Remove(key))
+                {
+                    fn(key, value);
+                    ++ulRemoved;
+                }
+            }
+            return ulRemoved;
+        }
+
+        bool Contains(K key)
+        {
+            size_t ulSlot = Domain::GetSlot(key);
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket* pBucket = FindBucket(ulSlot);
+            return pBucket != nullptr && IsAt(*pBucket, Locate(*pBucket, key, false), key);
+        }
+
+        V GetValue(K key)
+        {
+            size_t ulSlot = Domain::GetSlot(key);
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket* pBucket = FindBucket(ulSlot);
+            if (pBucket == nullptr)
+            {
+                return V();
+            }
+            Cursor stCursor = Locate(*pBucket, key, false);
+            return IsAt(*pBucket, stCursor, key) ? pBucket->m_vecChunks[stCursor.m_ulChunk][stCursor.m_ulOffset].second : V();
+        }
+
+        // 按键升序遍历，回调返回false时提前结束；键按小批复制出来后在锁外回调
+        template<typename Fn>
+        void ForEach(Fn&& fn)
+        {
+            ForEachFromSlot(0, nullptr, 0, fn);
+        }
+
+        // 从第一个不小于 key 的键开始按升序遍历，回调返回false时提前结束
+        template<typename Fn>
+        void ForEachFrom(const K& key, Fn&& fn)
+        {
+            ForEachFromSlot(Domain::GetSlot(key), &key, 0, fn);
+        }
+
+        // 从按键升序的第 ulRank 个键(从0开始)开始遍历：在计数上二分查找所在的槽，O(log S x SHARDS log S)，与跳过的键数无关
+        template<typename Fn>
+        void ForEachFromRank(size_t ulRank, Fn&& fn)
+        {
+            // 找最后一个 CountBelowSlot(槽) <= ulRank 的槽
+            size_t ulLow = 0;
+            size_t ulHigh = SLOTS;
+            while (ulHigh - ulLow > 1)
+            {
+                size_t ulMid = ulLow + (ulHigh - ulLow) / 2;
+                if (CountBelowSlot(ulMid) <= ulRank)
+                {
+                    ulLow = ulMid;
+                }
+                else
+                {
+                    ulHigh = ulMid;
+                }
+            }
+            // 并发修改时计数可能已变化，跳过数不小于0
+            size_t ulBelow = CountBelowSlot(ulLow);
+            ForEachFromSlot(ulLow, nullptr, ulRank > ulBelow ? ulRank - ulBelow : 0, fn);
+        }
+
+        // 获取键的排名(严格小于该键的键数)：前面各槽的计数加槽内位置
+        size_t GetRank(const K& key)
+        {
+            size_t ulSlot = Domain::GetSlot(key);
+            size_t ulRank = CountBelowSlot(ulSlot);
+            std::lock_guard<Lock> stLock(GetStripe(ulSlot));
+            Bucket* pBucket = FindBucket(ulSlot);
+            if (pBucket != nullptr)
+            {
+                ulRank += CountBefore(*pBucket, Locate(*pBucket, key, false));
+            }
+            return ulRank;
+        }
+
+        // 槽号小于 ulSlot 的键数，不加锁，O(SHARDS x log S)
+        size_t CountBelowSlot(size_t ulSlot) const
+        {
+            const std::atomic<uint32_t>* pCounts = m_pCounts.load(std::memory_order_acquire);
+            if (pCounts == nullptr)
+            {
+                return 0;
+            }
+            ulSlot = std::min(ulSlot, SLOTS);
+            uint32_t uiCount = 0;
+            for (size_t ulShard = 0; ulShard < SHARDS && ulShard < ulSlot; ++ulShard)
+            {
+                uiCount += PrefixCount(pCounts, ulShard, (ulSlot - ulShard + SHARDS - 1) / SHARDS);
+            }
+            return uiCount;
+        }
+
+        // 没有退休节点，保持与 SkipList 的接口一致
+        void ReclaimRetired()
+        {
+        }
+
+        size_t Size() const
+        {
+            return m_ulSize.load(LOAD_ORDER);
+        }
+};
+
+// 按键的取值域在编译期选择有序索引：有界键用树状数组计数的索引，其他键用跳表
+template<typename K, typename V, typename Access = ConcurrentAccess>
+using OrderedIndex = std::conditional_t<KeyDomain<K>::BOUNDED, FenwickIndex<K, V, Access>, SkipList<K, V, Access>>;
@@ -0,0 +1,440 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "crc32c.h"
+#include "leaderboard.h"
+#include "snapshot.h"
+
+// 冻结榜文件格式：文件即内存映像，只读映射后直接查询，不需要解码和装载
+//   FrozenBoardHeader，补齐到64字节
+//   排序键 uint64_t[n + 1]：按 Eytzinger(BFS)顺序排列的树，下标从1开始，下标0不用；起始于缓存行边界
+//   分数 double[n]：按排名从高到低
+//   成员名偏移 uint64_t[n + 1]：按排名从高到低，第 i 名的成员名为 [off[i], off[i + 1])
+//   成员名散列表 FrozenSlot[m]：m 为2的幂，线性探查，装填率不超过一半
+//   成员名 char[]：按排名从高到低首尾相接
+// 每段起始于64字节边界；m_uiPayloadCrc 覆盖文件头之后的全部字节
+
+const uint32_t FROZEN_BOARD_MAGIC = 0x5A465247;// "GRFZ"
+const uint16_t FROZEN_BOARD_VERSION = 1;
+
+// 冻结榜文件头
+struct FrozenBoardHeader
+{
+    uint32_t m_uiMagic;     // 魔数
+    uint16_t m_usVersion;   // 格式版本
+    uint16_t m_usReserved;  // 保留
+    uint64_t m_ulCount;     // 成员数
+    uint64_t m_ulSlots;     // 散列表槽数
+    uint64_t m_ulNameBytes; // 成员名总字节数
+    uint64_t m_ulFileBytes; // 文件总字节数
+    uint32_t m_uiPayloadCrc;// 文件头之后全部字节的CRC32C
+    uint32_t m_uiHeaderCrc; // 以上字段的CRC32C
+};
+
+// 成员名散列表的槽
+struct FrozenSlot
+{
+    uint32_t m_uiRank;// 排名 + 1，0为空槽
+    uint32_t m_uiHash;// 成员名的CRC32C，先比较散列值，相同时才读成员名
+};
+
+// 已结束赛季的只读排行榜，由 BasicLeaderboard 冻结而来，或只读映射冻结榜文件
+// 排序键按 Eytzinger 顺序排列：节点 k 的子节点为 2k、2k + 1，查找时无分支地向下走，每层预取三层以下的整条缓存行，
+// 下沉到叶子后由节点下标直接算出中序位置即排名，不需要另存排名；按成员名查排名是一次散列表查找，总共几次缓存未命中
+// 冻结后不可修改，查询不加锁，可被任意多个线程并发读
+class FrozenBoard
+{
+    private:
+        static constexpr size_t LINE_BYTES = 64;
+        static constexpr size_t LINE_KEYS = LINE_BYTES / sizeof(uint64_t);
+
+        // 映像的一条缓存行；按它分配，映像起始于缓存行边界，各段的64字节对齐在内存中同样成立
+        struct alignas(LINE_BYTES) ImageLine
+        {
+            uint8_t m_aucBytes[LINE_BYTES];
+        };
+
+        // 各段在映像中的偏移
+        struct Layout
+        {
+            size_t m_ulKeys;
+            size_t m_ulScores;
+            size_t m_ulNameOffsets;
+            size_t m_ulSlots;
+            size_t m_ulNames;
+            size_t m_ulFileBytes;
+        };
+
+        std::unique_ptr<SnapshotFile> m_pFile;// 映射的冻结榜文件
+        std::unique_ptr<ImageLine[]> m_pLines;// 冻结得到的内存映像，按缓存行对齐
+        const uint8_t*          m_pImage = nullptr;
+        const uint64_t*         m_pKeys = nullptr;
+        const double*           m_pScores = nullptr;
+        const uint64_t*         m_pNameOffsets = nullptr;
+        const FrozenSlot*       m_pSlots = nullptr;
+        const char*             m_pNames = nullptr;
+        size_t                  m_ulCount = 0;
+        size_t                  m_ulSlots = 0;
+
+        static size_t AlignLine(size_t ulBytes)
+        {
+            return (ulBytes + LINE_BYTES - 1) & ~(LINE_BYTES - 1);
+        }
+
+        static Layout ComputeLayout(size_t ulCount, size_t ulSlots, size_t ulNameBytes)
+        {
+            Layout stLayout;
+            stLayout.m_ulKeys = AlignLine(sizeof(FrozenBoardHeader));
+            stLayout.m_ulScores = AlignLine(stLayout.m_ulKeys + (ulCount + 1) * sizeof(uint64_t));
+            stLayout.m_ulNameOffsets = AlignLine(stLayout.m_ulScores + ulCount * sizeof(double));
+            stLayout.m_ulSlots = AlignLine(stLayout.m_ulNameOffsets + (ulCount + 1) * sizeof(uint64_t));
+            stLayout.m_ulNames = AlignLine(stLayout.m_ulSlots + ulSlots * sizeof(FrozenSlot));
+            stLayout.m_ulFileBytes = AlignLine(stLayout.m_ulNames + ulNameBytes);
+            return stLayout;
+        }
+
+        // 分数转换为按排名升序的无符号数：分数越高键越小；+0 与 -0 比较相等，统一编码
+        static uint64_t ScoreKey(double dScore)
+        {
+            double dNormalized = dScore == 0 ? 0.0 : dScore;
+            uint64_t ulBits = std::bit_cast<uint64_t>(dNormalized);
+            ulBits = (ulBits >> 63) != 0 ? ~ulBits : (ulBits | (1ULL << 63));
+            return ~ulBits;
+        }
+
+        static void Prefetch(const void* p)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#elif defined(_MSC_VER)
+            _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#endif
+        }
+
+        // Eytzinger 下标 k(1..n) 对应的中序位置(0..n-1)
+        // 先按满二叉树算出位置，再减去最后一层缺失的、中序排在它之前的节点数
+        static size_t SortedPosition(size_t k, size_t ulCount)
+        {
+            size_t ulLevels = std::bit_width(ulCount);
+            size_t ulDepth = std::bit_width(k) - 1;
+            size_t ulPos = ((2 * (k - (size_t(1) << ulDepth)) + 1) << (ulLevels - 1 - ulDepth)) - 1;
+            // 满树中最后一层第 j 个节点的中序位置为 2j，实际只有前 ulLast 个存在
+            size_t ulLast = ulCount - ((size_t(1) << (ulLevels - 1)) - 1);
+            size_t ulBefore = (ulPos + 1) / 2;
+            return ulBefore > ulLast ? ulPos - (ulBefore - ulLast) : ulPos;
+        }
+
+        // 排序键小于 ulKey(INCLUSIVE 为true时不大于)的成员数
+        template<bool INCLUSIVE>
+        size_t CountBefore(uint64_t ulKey) const
+        {
+            const uint64_t* pKeys = m_pKeys;
+            size_t k = 1;
+            while (k <= m_ulCount)
+            {
+                // 三层以下的8个后代 8k..8k+7 正好是一条缓存行，越界的预取不会出错
+                Prefetch(pKeys + k * LINE_KEYS);
+                k = 2 * k + (INCLUSIVE ? pKeys[k] <= ulKey : pKeys[k] < ulKey);
+            }
+            // 去掉最后一段连续的右转，回到第一个不满足条件的祖先；全部右转时为0，即所有键都满足
+            k >>= std::countr_one(k) + 1;
+            return k == 0 ? m_ulCount : SortedPosition(k, m_ulCount);
+        }
+
+        std::string_view MemberAt(size_t ulPos) const
+        {
+            return std::string_view(m_pNames + m_pNameOffsets[ulPos], m_pNameOffsets[ulPos + 1] - m_pNameOffsets[ulPos]);
+        }
+
+        bool FindMember(std::string_view svMember, size_t& ulPos) const
+        {
+            if (m_ulSlots == 0)
+            {
+                return false;
+            }
+            uint32_t uiHash = Crc32c(svMember.data(), svMember.size());
+            size_t ulMask = m_ulSlots - 1;
+            for (size_t i = uiHash & ulMask;; i = (i + 1) & ulMask)
+            {
+                const FrozenSlot& stSlot = m_pSlots[i];
+                if (stSlot.m_uiRank == 0)
+                {
+                    return false;
+                }
+                if (stSlot.m_uiHash == uiHash && MemberAt(stSlot.m_uiRank - 1) == svMember)
+                {
+                    ulPos = stSlot.m_uiRank - 1;
+                    return true;
+                }
+            }
+        }
+
+        // 按文件头定位各段
+        void Attach(const uint8_t* pImage)
+        {
+            const FrozenBoardHeader* pHeader = reinterpret_cast<const FrozenBoardHeader*>(pImage);
+            m_ulCount = static_cast<size_t>(pHeader->m_ulCount);
+            m_ulSlots = static_cast<size_t>(pHeader->m_ulSlots);
+            Layout stLayout = ComputeLayout(m_ulCount, m_ulSlots, static_cast<size_t>(pHeader->m_ulNameBytes));
+            m_pImage = pImage;
+            m_pKeys = reinterpret_cast<const uint64_t*>(pImage + stLayout.m_ulKeys);
+            m_pScores = reinterpret_cast<const double*>(pImage + stLayout.m_ulScores);
+            m_pNameOffsets = reinterpret_cast<const uint64_t*>(pImage + stLayout.m_ulNameOffsets);
+            m_pSlots = reinterpret_cast<const FrozenSlot*>(pImage + stLayout.m_ulSlots);
+            m_pNames = reinterpret_cast<const char*>(pImage + stLayout.m_ulNames);
+        }
+
+        void Reset()
+        {
+            m_pFile.reset();
+            m_pLines.reset();
+            m_pImage = nullptr;
+            m_pKeys = nullptr;
+            m_pScores = nullptr;
+            m_pNameOffsets = nullptr;
+            m_pSlots = nullptr;
+            m_pNames = nullptr;
+            m_ulCount = 0;
+            m_ulSlots = 0;
+        }
+
+    public:
+        FrozenBoard() = default;
+        FrozenBoard(const FrozenBoard&) = delete;
+        FrozenBoard& operator=(const FrozenBoard&) = delete;
+
+        // 冻结排行榜的当前内容(按换算后的分数)，替换之前冻结或映射的内容；遍历期间持有排行榜的读锁
+        // 成员数达到 2^32 - 1 时散列表的排名放不下，返回false且保持为空
+        template<typename Access>
+        bool Freeze(BasicLeaderboard<Access>& stBoard)
+        {
+            Reset();
+            std::vector<double> vecScores;
+            std::vector<uint64_t> vecNameOffsets;
+            std::string strNames;
+            vecScores.reserve(stBoard.Size());
+            vecNameOffsets.reserve(stBoard.Size() + 1);
+            stBoard.ForEachRanked([&](std::string_view svMember, double dScore)
+            {
+                vecNameOffsets.push_back(strNames.size());
+                strNames.append(svMember);
+                vecScores.push_back(dScore == 0 ? 0.0 : dScore);
+                return true;
+            });
+            vecNameOffsets.push_back(strNames.size());
+            size_t ulCount = vecScores.size();
+            if (ulCount >= std::numeric_limits<uint32_t>::max())
+            {
+                return false;
+            }
+            size_t ulSlots = ulCount == 0 ? 0 : std::bit_ceil(ulCount * 2);
+            Layout stLayout = ComputeLayout(ulCount, ulSlots, strNames.size());
+            // 值初始化为全0，散列表的空槽和各段之间的填充都是0
+            m_pLines = std::make_unique<ImageLine[]>(stLayout.m_ulFileBytes / LINE_BYTES);
+            uint8_t* pImage = m_pLines[0].m_aucBytes;
+
+            FrozenBoardHeader stHeader;
+            memset(&stHeader, 0, sizeof(stHeader));
+            stHeader.m_uiMagic = FROZEN_BOARD_MAGIC;
+            stHeader.m_usVersion = FROZEN_BOARD_VERSION;
+            stHeader.m_ulCount = ulCount;
+            stHeader.m_ulSlots = ulSlots;
+            stHeader.m_ulNameBytes = strNames.size();
+            stHeader.m_ulFileBytes = stLayout.m_ulFileBytes;
+
+            // 中序遍历 Eytzinger 树，依次填入按排名排列的排序键
+            uint64_t* pKeys = reinterpret_cast<uint64_t*>(pImage + stLayout.m_ulKeys);
+            size_t ulNext = 0;
+            auto FillKeys = [&](auto& self, size_t k) -> void
+            {
+                if (k > ulCount)
+                {
+                    return;
+                }
+                self(self, 2 * k);
+                pKeys[k] = ScoreKey(vecScores[ulNext++]);
+                self(self, 2 * k + 1);
+            };
+            FillKeys(FillKeys, 1);
+            if (ulCount > 0)
+            {
+                memcpy(pImage + stLayout.m_ulScores, vecScores.data(), ulCount * sizeof(double));
+            }
+            memcpy(pImage + stLayout.m_ulNameOffsets, vecNameOffsets.data(), (ulCount + 1) * sizeof(uint64_t));
+            memcpy(pImage + stLayout.m_ulNames, strNames.data(), strNames.size());
+
+            FrozenSlot* pSlots = reinterpret_cast<FrozenSlot*>(pImage + stLayout.m_ulSlots);
+            for (size_t ulPos = 0; ulPos < ulCount; ++ulPos)
+            {
+                uint32_t uiHash = Crc32c(strNames.data() + vecNameOffsets[ulPos], vecNameOffsets[ulPos + 1] - vecNameOffsets[ulPos]);
+                size_t i = uiHash & (ulSlots - 1);
+                while (pSlots[i].m_uiRank != 0)
+                {
+                    i = (i + 1) & (ulSlots - 1);
+                }
+                pSlots[i].m_uiRank = static_cast<uint32_t>(ulPos + 1);
+                pSlots[i].m_uiHash = uiHash;
+            }
+
+            stHeader.m_uiPayloadCrc = Crc32c(pImage + sizeof(stHeader), stLayout.m_ulFileBytes - sizeof(stHeader));
+            stHeader.m_uiHeaderCrc = Crc32c(&stHeader, offsetof(FrozenBoardHeader, m_uiHeaderCrc));
+            memcpy(pImage, &stHeader, sizeof(stHeader));
+            Attach(pImage);
+            return true;
+        }
+
+        // 将冻结的映像写入文件，先写临时文件、落盘后再改名并同步目录，返回 Ok 后掉电也不会只剩半个文件
+        ESnapshotResult Save(const std::string& strPath) const
+        {
+            if (m_pImage == nullptr)
+            {
+                return ESnapshotResult::WriteFailed;
+            }
+            const FrozenBoardHeader* pHeader = reinterpret_cast<const FrozenBoardHeader*>(m_pImage);
+            std::string strTmpPath = strPath + ".tmp";
+            FILE* pFile = fopen(strTmpPath.c_str(), "wb");
+            if (pFile == nullptr)
+            {
+                return ESnapshotResult::OpenFailed;
+            }
+            size_t ulBytes = static_cast<size_t>(pHeader->m_ulFileBytes);
+            bool bOk = fwrite(m_pImage, 1, ulBytes, pFile) == ulBytes;
+            if (!CommitSnapshotFile(pFile, bOk, strTmpPath, strPath))
+            {
+                return ESnapshotResult::WriteFailed;
+            }
+            return ESnapshotResult::Ok;
+        }
+
+        // 只读映射冻结榜文件，替换之前的内容；失败时保持为空
+        // bVerify 为true时校验全部内容的校验和，会完整读一遍文件；为false时只校验文件头和各段大小，按需调入页面，调用方需信任文件内容
+        ESnapshotResult Open(const std::string& strPath, bool bVerify = true)
+        {
+            Reset();
+            auto pFile = std::make_unique<SnapshotFile>();
+            if (!pFile->Open(strPath, true))
+            {
+                return ESnapshotResult::OpenFailed;
+            }
+            if (pFile->Size() < sizeof(FrozenBoardHeader))
+            {
+                return ESnapshotResult::Truncated;
+            }
+            FrozenBoardHeader stHeader;
+            memcpy(&stHeader, pFile->Data(), sizeof(stHeader));
+            if (stHeader.m_uiMagic != FROZEN_BOARD_MAGIC || stHeader.m_usVersion != FROZEN_BOARD_VERSION ||
+                stHeader.m_uiHeaderCrc != Crc32c(&stHeader, offsetof(FrozenBoardHeader, m_uiHeaderCrc)))
+            {
+                return ESnapshotResult::BadHeader;
+            }
+            // 各段大小由已校验的文件头算出，仍与文件大小核对，避免计数异常导致越界
+            if (stHeader.m_ulCount >= std::numeric_limits<uint32_t>::max() || stHeader.m_ulSlots > pFile->Size() ||
+                stHeader.m_ulNameBytes > pFile->Size() || (stHeader.m_ulSlots & (stHeader.m_ulSlots - 1)) != 0 ||
+                stHeader.m_ulSlots < stHeader.m_ulCount * 2)
+            {
+                return ESnapshotResult::BadHeader;
+            }
+            Layout stLayout = ComputeLayout(static_cast<size_t>(stHeader.m_ulCount), static_cast<size_t>(stHeader.m_ulSlots),
+                static_cast<size_t>(stHeader.m_ulNameBytes));
+            if (stLayout.m_ulFileBytes != stHeader.m_ulFileBytes || pFile->Size() < stLayout.m_ulFileBytes)
+            {
+                return ESnapshotResult::Truncated;
+            }
+            if (bVerify && Crc32c(pFile->Data() + sizeof(stHeader), stLayout.m_ulFileBytes - sizeof(stHeader)) != stHeader.m_uiPayloadCrc)
+            {
+                return ESnapshotResult::ChecksumMismatch;
+            }
+            // 映射起始于页边界；不支持 mmap 时读入的缓冲区未必按缓存行对齐，复制到对齐的映像
+            if (reinterpret_cast<uintptr_t>(pFile->Data()) % LINE_BYTES != 0)
+            {
+                m_pLines = std::make_unique<ImageLine[]>(stLayout.m_ulFileBytes / LINE_BYTES);
+                memcpy(m_pLines[0].m_aucBytes, pFile->Data(), stLayout.m_ulFileBytes);
+                Attach(m_pLines[0].m_aucBytes);
+                return ESnapshotResult::Ok;
+            }
+            m_pFile = std::move(pFile);
+            Attach(m_pFile->Data());
+            return ESnapshotResult::Ok;
+        }
+
+        // 获取成员分数
+        bool GetScore(std::string_view svMember, double& dScore) const
+        {
+            size_t ulPos = 0;
+            if (!FindMember(svMember, ulPos))
+            {
+                return false;
+            }
+            dScore = m_pScores[ulPos];
+            return true;
+        }
+
+        // 获取成员排名，bReverse 为true时按分数从高到低排名(0为榜首)；同分成员保持冻结时的先后
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank) const
+        {
+            size_t ulPos = 0;
+            if (!FindMember(svMember, ulPos))
+            {
+                return false;
+            }
+            ulRank = bReverse ? ulPos : m_ulCount - 1 - ulPos;
+            return true;
+        }
+
+        // 按排名区间查询，bReverse 为true时按分数从高到低
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut) const
+        {
+            vecOut.clear();
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, m_ulCount, ulFirst, ulLast))
+            {
+                return;
+            }
+            vecOut.reserve(ulLast - ulFirst + 1);
+            for (size_t ulRank = ulFirst; ulRank <= ulLast; ++ulRank)
+            {
+                size_t ulPos = bReverse ? ulRank : m_ulCount - 1 - ulRank;
+                vecOut.push_back(RankEntry{ std::string(MemberAt(ulPos)), m_pScores[ulPos] });
+            }
+        }
+
+        // 分数高于 dScore 的成员数，即取得该分数时的名次(0为榜首)；O(log n)，无分支
+        size_t CountAbove(double dScore) const
+        {
+            return CountBefore<false>(ScoreKey(dScore));
+        }
+
+        // 统计分数在 [stMin, stMax] 内的成员数
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax) const
+        {
+            // 不低于(开区间时高于)下界的成员数，减去高于(开区间时不低于)上界的成员数
+            size_t ulFromMin = stMin.m_bExclusive ? CountBefore<false>(ScoreKey(stMin.m_dValue)) : CountBefore<true>(ScoreKey(stMin.m_dValue));
+            size_t ulAboveMax = stMax.m_bExclusive ? CountBefore<true>(ScoreKey(stMax.m_dValue)) : CountBefore<false>(ScoreKey(stMax.m_dValue));
+            return ulFromMin > ulAboveMax ? ulFromMin - ulAboveMax : 0;
+        }
+
+        // 映像的字节数，未冻结时为0
+        size_t ImageBytes() const
+        {
+            return m_pImage == nullptr ? 0 : static_cast<size_t>(reinterpret_cast<const FrozenBoardHeader*>(m_pImage)->m_ulFileBytes);
+        }
+
+        size_t Size() const
+        {
+            return m_ulCount;
+        }
+};
@@ -3,10 +3,477 @@
 
 #include "gameranking.h"
 
+#include <atomic>
+#include <csignal>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+
 using namespace std;
 
-int main()
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+
+#include "art_index.h"
+#include "numa_arena.h"
+#include "server.h"
+#include "shard_server.h"
+#include "shm_ring.h"
+#include "snapshot.h"
+#if defined(GAMERANKING_IO_URING)
+#include "uring_server.h"
+#endif
+
+// 收到 SIGINT/SIGTERM 后置位，事件循环据此退出
+static atomic<bool> g_bStop(false);
+
+static void HandleStopSignal(int)
+{
+	g_bStop.store(true);
+}
+
+static void PrintUsage(const char* szProgram)
+{
+	cout << "usage: " << szProgram << " [--bind addr] [--port port] [--io-engine auto|epoll|io_uring] [--shards n] [--event-shm name] [--cold-dir dir] [--cold-idle seconds]" << endl;
+	cout << "       " << szProgram << " --tail-events name" << endl;
+	cout << "       " << szProgram << " --numa-bench [members]" << endl;
+	cout << "       " << szProgram << " --index-bench [members]" << endl;
+	cout << "       " << szProgram << " --snapshot-bench [entries]" << endl;
+}
+
+static const char* GetScoreEventName(EScoreEvent eType)
+{
+	switch (eType)
+	{
+	case EScoreEvent::Added:
+		return "added";
+	case EScoreEvent::Updated:
+		return "updated";
+	case EScoreEvent::Removed:
+		return "removed";
+	}
+	return "unknown";
+}
+
+// 在另一个进程中读取服务器发布的分数变更事件并逐行输出，直到收到退出信号
+static int TailEvents(const char* szName)
+{
+	ShmEventReader stReader;
+	if (!stReader.Open(szName, false))
+	{
+		return 1;
+	}
+	ShmEvent stEvent;
+	while (!g_bStop.load())
+	{
+		EShmRead eResult = stReader.Read(stEvent);
+		if (eResult == EShmRead::Ok)
+		{
+			cout << stEvent.m_ulSeq << ' ' << stEvent.m_llTimeNs << ' ' << GetScoreEventName(stEvent.m_eType) << ' ' << stEvent.m_strBoard << ' '
+				<< stEvent.m_strMember << ' ' << stEvent.m_dOldScore << ' ' << stEvent.m_dNewScore << (stEvent.m_bTruncated ? " truncated" : "") << '\n';
+		}
+		else if (eResult == EShmRead::Overrun)
+		{
+			cout << "overrun, lost " << stReader.GetLost() << " events so far" << endl;
+		}
+		else
+		{
+			cout.flush();
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+	return 0;
+}
+
+// 在绑定到 iCpu 的线程上执行 fn 并等待结束
+template<typename Fn>
+static void RunOnCpu(int iCpu, Fn&& fn)
+{
+	thread stThread([iCpu, &fn]()
+	{
+		cpu_set_t stCpu;
+		CPU_ZERO(&stCpu);
+		CPU_SET(iCpu, &stCpu);
+		pthread_setaffinity_np(pthread_self(), sizeof(stCpu), &stCpu);
+		fn();
+	});
+	stThread.join();
+}
+
+// 测量每个内存节点上的跳表被各节点的核访问时的延迟：沿第0层遍历是逐跳的相关访存，每跳耗时即一次本地或远端访存；
+// 随机查找反映实际查询的代价
+static int NumaBench(size_t ulMembers)
+{
+	vector<int> vecNodes = GetNumaNodes();
+	cout << "numa nodes: " << vecNodes.size() << ", members: " << ulMembers << endl;
+	vector<uint64_t> vecKeys(ulMembers);
+	mt19937_64 stRandom(12345);
+	for (uint64_t& ulKey : vecKeys)
+	{
+		ulKey = stRandom();
+	}
+	for (int iMemNode : vecNodes)
+	{
+		vector<int> vecMemCpus = GetNumaNodeCpus(iMemNode);
+		if (vecMemCpus.empty())
+		{
+			continue;
+		}
+		NumaArena stArena(iMemNode);
+		SkipList<uint64_t, uint64_t, SingleThreadAccess> stList;
+		stList.SetArena(&stArena);
+		// 在本节点的核上建表，mbind 不可用时首次访问也会把页分配在本节点
+		RunOnCpu(vecMemCpus[0], [&]()
+		{
+			for (uint64_t ulKey : vecKeys)
+			{
+				stList.Insert(ulKey, ulKey);
+			}
+		});
+		for (int iCpuNode : vecNodes)
+		{
+			vector<int> vecCpus = GetNumaNodeCpus(iCpuNode);
+			if (vecCpus.empty())
+			{
+				continue;
+			}
+			double dHopNs = 0;
+			double dFindNs = 0;
+			RunOnCpu(vecCpus[0], [&]()
+			{
+				size_t ulHops = 0;
+				uint64_t ulSum = 0;
+				auto stStart = chrono::steady_clock::now();
+				stList.ForEach([&](const uint64_t&, const uint64_t& ulValue)
+				{
+					ulSum += ulValue;
+					++ulHops;
+					return true;
+				});
+				auto stWalked = chrono::steady_clock::now();
+				size_t ulFinds = min<size_t>(ulMembers, 1000000);
+				for (size_t i = 0; i < ulFinds; ++i)
+				{
+					ulSum += stList.Contains(vecKeys[(i * 7919) % vecKeys.size()]) ? 1 : 0;
+				}
+				auto stFound = chrono::steady_clock::now();
+				dHopNs = chrono::duration<double, nano>(stWalked - stStart).count() / max<size_t>(ulHops, 1);
+				dFindNs = chrono::duration<double, nano>(stFound - stWalked).count() / max<size_t>(ulFinds, 1);
+				// 防止遍历和查找被优化掉
+				volatile uint64_t ulSink = ulSum;
+				(void)ulSink;
+			});
+			cout << "memory node " << iMemNode << (stArena.IsBound() ? " (mbind)" : " (first touch)") << ", cpu node " << iCpuNode
+				<< (iCpuNode == iMemNode ? " local " : " remote") << ": " << dHopNs << " ns/hop, " << dFindNs << " ns/find" << endl;
+		}
+	}
+	return 0;
+}
+
+// 在同一组键上测量有序索引的插入、随机查找、有序遍历和排名的平均耗时
+template<typename Index, typename K>
+static void BenchIndex(const char* szName, const vector<K>& vecKeys)
+{
+	Index stIndex;
+	auto stStart = chrono::steady_clock::now();
+	for (size_t i = 0; i < vecKeys.size(); ++i)
+	{
+		stIndex.Insert(vecKeys[i], i);
+	}
+	auto stInserted = chrono::steady_clock::now();
+	uint64_t ulSum = 0;
+	size_t ulFinds = min<size_t>(vecKeys.size(), 1000000);
+	for (size_t i = 0; i < ulFinds; ++i)
+	{
+		ulSum += stIndex.Contains(vecKeys[(i * 7919) % vecKeys.size()]) ? 1 : 0;
+	}
+	auto stFound = chrono::steady_clock::now();
+	stIndex.ForEach([&](const K&, const uint64_t& ulValue)
+	{
+		ulSum += ulValue;
+		return true;
+	});
+	auto stWalked = chrono::steady_clock::now();
+	size_t ulRanks = ulFinds;
+	for (size_t i = 0; i < ulRanks; ++i)
+	{
+		ulSum += stIndex.GetRank(vecKeys[(i * 7919) % vecKeys.size()]);
+	}
+	auto stRanked = chrono::steady_clock::now();
+	// 防止查找和遍历被优化掉
+	volatile uint64_t ulSink = ulSum;
+	(void)ulSink;
+	size_t ulCount = max<size_t>(vecKeys.size(), 1);
+	cout << szName << ": insert " << chrono::duration<double, nano>(stInserted - stStart).count() / ulCount
+		<< " ns, find " << chrono::duration<double, nano>(stFound - stInserted).count() / max<size_t>(ulFinds, 1)
+		<< " ns, walk " << chrono::duration<double, nano>(stWalked - stFound).count() / ulCount
+		<< " ns/key, rank " << chrono::duration<double, nano>(stRanked - stWalked).count() / max<size_t>(ulRanks, 1) << " ns" << endl;
+}
+
+// 比较跳表与 ART 索引：随机 64 位键，以及按积分近似正态分布(均值 1500、标准差 300)、成员编号连续的排行榜键
+static int IndexBench(size_t ulMembers)
+{
+	cout << "members: " << ulMembers << endl;
+	mt19937_64 stRandom(12345);
+	vector<uint64_t> vecUniform(ulMembers);
+	for (uint64_t& ulKey : vecUniform)
+	{
+		ulKey = stRandom();
+	}
+	normal_distribution<double> stScore(1500, 300);
+	vector<RankKey> vecRankKeys(ulMembers);
+	for (size_t i = 0; i < ulMembers; ++i)
+	{
+		vecRankKeys[i] = RankKey{ round(stScore(stRandom)), i };
+	}
+	BenchIndex<SkipList<uint64_t, uint64_t>>("skiplist uint64  ", vecUniform);
+	BenchIndex<ArtIndex<uint64_t, uint64_t>>("art      uint64  ", vecUniform);
+	BenchIndex<SkipList<RankKey, uint64_t>>("skiplist rank key", vecRankKeys);
+	BenchIndex<ArtIndex<RankKey, uint64_t>>("art      rank key", vecRankKeys);
+	return 0;
+}
+
+// 测量快照装载中块校验的开销：同一个快照文件分别跳过校验和并行校验装载，各取三次中最快的一次
+static int SnapshotBench(size_t ulEntries)
 {
-	cout << "Hello CMake." << endl;
+	const string strPath = (filesystem::temp_directory_path() / ("gameranking-snapshot-bench-" + to_string(random_device()()) + ".snap")).string();
+	{
+		SkipList<uint64_t, uint64_t, SingleThreadAccess> stList;
+		BulkCursor<uint64_t, uint64_t> stCursor;
+		stList.BeginBulkLoad(stCursor);
+		for (uint64_t i = 0; i < ulEntries; ++i)
+		{
+			stList.AppendSorted(stCursor, i * 2, i);
+		}
+		stList.EndBulkLoad(stCursor);
+		ESnapshotResult eResult = SaveSnapshot(stList, strPath);
+		if (eResult != ESnapshotResult::Ok)
+		{
+			cerr << "save snapshot failed: " << SnapshotResultString(eResult) << endl;
+			return 1;
+		}
+	}
+	// 两种装载交替进行，避免页缓存和内存分配器的状态偏向其中一种
+	auto LoadMs = [&](bool bVerify)
+	{
+		SkipList<uint64_t, uint64_t, SingleThreadAccess> stList;
+		auto stStart = chrono::steady_clock::now();
+		ESnapshotResult eResult = LoadSnapshot(strPath, stList, 0, bVerify);
+		double dMs = chrono::duration<double, milli>(chrono::steady_clock::now() - stStart).count();
+		if (eResult != ESnapshotResult::Ok || stList.Size() != ulEntries)
+		{
+			cerr << "load snapshot failed: " << SnapshotResultString(eResult) << endl;
+			return -1.0;
+		}
+		return dMs;
+	};
+	double dPlainMs = 0;
+	double dVerifiedMs = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		double dPlain = LoadMs(false);
+		double dVerified = LoadMs(true);
+		if (dPlain < 0 || dVerified < 0)
+		{
+			remove(strPath.c_str());
+			return 1;
+		}
+		dPlainMs = i == 0 ? dPlain : min(dPlainMs, dPlain);
+		dVerifiedMs = i == 0 ? dVerified : min(dVerifiedMs, dVerified);
+	}
+	remove(strPath.c_str());
+	cout << "entries: " << ulEntries << ", threads: " << thread::hardware_concurrency() << endl;
+	cout << "load without verify " << dPlainMs << " ms, with verify " << dVerifiedMs << " ms, overhead "
+		<< (dVerifiedMs - dPlainMs) / dPlainMs * 100 << "%" << endl;
 	return 0;
 }
+
+template<typename Server>
+static int RunServer(const ServerConfig& stConfig, RankingService& stService, const char* szEngine)
+{
+	Server stServer(stConfig, stService);
+	if (!stServer.Start())
+	{
+		return 1;
+	}
+	cout << "gameranking listening on " << stConfig.m_strBindAddr << ":" << stConfig.m_usPort << " (" << szEngine << ")" << endl;
+	stServer.Run(g_bStop);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	ServerConfig stConfig;
+	const char* szTailEvents = nullptr;
+	size_t ulBenchMembers = 0;
+	size_t ulIndexBenchMembers = 0;
+	size_t ulSnapshotBenchEntries = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc)
+		{
+			stConfig.m_strBindAddr = argv[++i];
+		}
+		else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+		{
+			stConfig.m_usPort = static_cast<uint16_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--io-engine") == 0 && i + 1 < argc)
+		{
+			const char* szEngine = argv[++i];
+			if (strcmp(szEngine, "auto") == 0)
+			{
+				stConfig.m_eIoEngine = EIoEngine::Auto;
+			}
+			else if (strcmp(szEngine, "epoll") == 0)
+			{
+				stConfig.m_eIoEngine = EIoEngine::Epoll;
+			}
+			else if (strcmp(szEngine, "io_uring") == 0)
+			{
+				stConfig.m_eIoEngine = EIoEngine::IoUring;
+			}
+			else
+			{
+				PrintUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--event-shm") == 0 && i + 1 < argc)
+		{
+			stConfig.m_strEventShm = argv[++i];
+		}
+		else if (strcmp(argv[i], "--cold-dir") == 0 && i + 1 < argc)
+		{
+			stConfig.m_strColdDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--cold-idle") == 0 && i + 1 < argc)
+		{
+			stConfig.m_uiColdIdleSeconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--tail-events") == 0 && i + 1 < argc)
+		{
+			szTailEvents = argv[++i];
+		}
+		else if (strcmp(argv[i], "--numa-bench") == 0)
+		{
+			ulBenchMembers = 1000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				ulBenchMembers = strtoull(argv[++i], nullptr, 10);
+			}
+		}
+		else if (strcmp(argv[i], "--index-bench") == 0)
+		{
+			ulIndexBenchMembers = 1000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				ulIndexBenchMembers = strtoull(argv[++i], nullptr, 10);
+			}
+		}
+		else if (strcmp(argv[i], "--snapshot-bench") == 0)
+		{
+			ulSnapshotBenchEntries = 10000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				ulSnapshotBenchEntries = strtoull(argv[++i], nullptr, 10);
+			}
+		}
+		else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc)
+		{
+			// 0 表示每个可用核一个分片
+			stConfig.m_iShards = atoi(argv[++i]);
+			if (stConfig.m_iShards <= 0)
+			{
+				stConfig.m_iShards = static_cast<int>(thread::hardware_concurrency());
+			}
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, HandleStopSignal);
+	signal(SIGTERM, HandleStopSignal);
+
+	if (szTailEvents != nullptr)
+	{
+		return TailEvents(szTailEvents);
+	}
+	if (ulBenchMembers > 0)
+	{
+		return NumaBench(ulBenchMembers);
+	}
+	if (ulIndexBenchMembers > 0)
+	{
+		return IndexBench(ulIndexBenchMembers);
+	}
+	if (ulSnapshotBenchEntries > 0)
+	{
+		return SnapshotBench(ulSnapshotBenchEntries);
+	}
+
+	if (stConfig.m_iShards > 1)
+	{
+		// 分片服务器每个分片各自用 epoll 处理自己的连接，没有 io_uring 实现；明确要求 io_uring 时报错而不是悄悄改用 epoll
+		if (stConfig.m_eIoEngine == EIoEngine::IoUring)
+		{
+			cerr << "--io-engine io_uring is not supported with --shards, use --io-engine epoll or auto" << endl;
+			return 1;
+		}
+		ShardedRankingServer stServer(stConfig);
+		if (!stServer.Start())
+		{
+			return 1;
+		}
+		cout << "gameranking listening on " << stConfig.m_strBindAddr << ":" << stConfig.m_usPort << " (" << stServer.GetShardCount() << " shards, epoll)" << endl;
+		stServer.Run(g_bStop);
+		return 0;
+	}
+
+	ShmEventRing stEventRing;
+	RankingService stService;
+	if (!stConfig.m_strEventShm.empty())
+	{
+		if (!stEventRing.Create(stConfig.m_strEventShm, stConfig.m_ulEventShmCapacity))
+		{
+			return 1;
+		}
+		stService.SetEventSink(&stEventRing);
+	}
+	if (!stConfig.m_strColdDir.empty() && !stService.SetColdTier(stConfig.m_strColdDir, stConfig.m_uiColdIdleSeconds))
+	{
+		return 1;
+	}
+	if (stConfig.m_eIoEngine != EIoEngine::Epoll)
+	{
+#if defined(GAMERANKING_IO_URING)
+		if (UringRankingServer::IsSupported())
+		{
+			return RunServer<UringRankingServer>(stConfig, stService, "io_uring");
+		}
+#endif
+		if (stConfig.m_eIoEngine == EIoEngine::IoUring)
+		{
+			cerr << "io_uring is not available, use --io-engine epoll" << endl;
+			return 1;
+		}
+	}
+	return RunServer<RankingServer>(stConfig, stService, "epoll");
+}
+#else
+int main()
+{
+	cout << "gameranking server requires Linux (epoll)." << endl;
+	return 1;
+}
+#endif
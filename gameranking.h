@@ -5,4 +5,5 @@
 
 #include <iostream>
 
-// TODO: 在此处引用程序需要的其他标头。
+#include "skiplist.h"
+#include "snapshot.h"
@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "fenwick_index.h"
+#include "leaderboard.h"
+
+// 整数分数排行榜：分数为 [0, MAX] 内的整数(如 0~1000000 的段位分)
+// 排序键 BoundedRankKey 的值域有界，OrderedIndex 在编译期选用按分数计数的树状数组索引，
+// 成员排名为 O(log S)，不随排名深度增长；按分数的排名和百分位只读原子计数，不加锁
+// 写操作持有独占锁，读操作持有共享锁，与 BasicLeaderboard 相同；超出上限的分数按上限计
+template<uint32_t MAX, typename Access>
+class BasicIntLeaderboard
+{
+    private:
+        // 成员信息，下标即成员编号
+        struct MemberEntry
+        {
+            std::string m_strName; // 成员名
+            uint32_t    m_uiScore; // 当前分数
+            bool        m_bPresent;// 是否在榜
+        };
+
+        using Key = BoundedRankKey<MAX>;
+        using Mutex = std::conditional_t<Access::CONCURRENT, std::shared_mutex, NullSharedMutex>;
+
+        OrderedIndex<Key, uint64_t, Access> m_stRank;// 按分数排序的索引，值为成员编号
+        mutable Mutex               m_stMutex;// 保护成员表
+        std::unordered_map<std::string, uint64_t, StringHash, std::equal_to<>> m_mapMemberId;// 成员名到编号
+        std::vector<MemberEntry>    m_vecMembers;// 成员信息
+        std::vector<uint64_t>       m_vecFreeIds;// 已删除成员空出的编号
+
+        bool FindMember(std::string_view svMember, uint64_t& ulId) const
+        {
+            auto it = m_mapMemberId.find(svMember);
+            if (it == m_mapMemberId.end())
+            {
+                return false;
+            }
+            ulId = it->second;
+            return true;
+        }
+
+        // 分配成员编号，优先复用空出的编号
+        uint64_t AllocMember(std::string_view svMember, uint32_t uiScore)
+        {
+            uint64_t ulId = 0;
+            if (!m_vecFreeIds.empty())
+            {
+                ulId = m_vecFreeIds.back();
+                m_vecFreeIds.pop_back();
+                m_vecMembers[ulId] = MemberEntry{ std::string(svMember), uiScore, true };
+            }
+            else
+            {
+                ulId = m_vecMembers.size();
+                m_vecMembers.push_back(MemberEntry{ std::string(svMember), uiScore, true });
+            }
+            m_mapMemberId.emplace(m_vecMembers[ulId].m_strName, ulId);
+            return ulId;
+        }
+
+        // 调整已有成员的分数：先摘除旧键再插入新键
+        void MoveMember(uint64_t ulId, uint32_t uiScore)
+        {
+            MemberEntry& stEntry = m_vecMembers[ulId];
+            m_stRank.Remove(Key{ stEntry.m_uiScore, ulId });
+            m_stRank.Insert(Key{ uiScore, ulId }, ulId);
+            stEntry.m_uiScore = uiScore;
+        }
+
+    public:
+        BasicIntLeaderboard() = default;
+        BasicIntLeaderboard(const BasicIntLeaderboard&) = delete;
+        BasicIntLeaderboard& operator=(const BasicIntLeaderboard&) = delete;
+
+        // 设置成员分数
+        EAddResult Add(std::string_view svMember, uint32_t uiScore, const AddOptions& stOptions = AddOptions())
+        {
+            uiScore = std::min(uiScore, MAX);
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                if (stOptions.m_bXx)
+                {
+                    return EAddResult::Unchanged;
+                }
+                ulId = AllocMember(svMember, uiScore);
+                m_stRank.Insert(Key{ uiScore, ulId }, ulId);
+                return EAddResult::Added;
+            }
+            if (stOptions.m_bNx)
+            {
+                return EAddResult::Unchanged;
+            }
+            uint32_t uiOld = m_vecMembers[ulId].m_uiScore;
+            bool bAllowed = (!stOptions.m_bGt || uiScore > uiOld) && (!stOptions.m_bLt || uiScore < uiOld);
+            if (!bAllowed || uiScore == uiOld)
+            {
+                return EAddResult::Unchanged;
+            }
+            MoveMember(ulId, uiScore);
+            return EAddResult::Updated;
+        }
+
+        // 成员分数增加 llDelta，成员不存在时视为0分新增；结果截断到 [0, MAX]
+        void IncrBy(std::string_view svMember, int64_t llDelta, uint32_t& uiNewScore)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            bool bFound = FindMember(svMember, ulId);
+            int64_t llScore = (bFound ? static_cast<int64_t>(m_vecMembers[ulId].m_uiScore) : 0) + llDelta;
+            uiNewScore = static_cast<uint32_t>(std::clamp<int64_t>(llScore, 0, MAX));
+            if (!bFound)
+            {
+                ulId = AllocMember(svMember, uiNewScore);
+                m_stRank.Insert(Key{ uiNewScore, ulId }, ulId);
+            }
+            else if (uiNewScore != m_vecMembers[ulId].m_uiScore)
+            {
+                MoveMember(ulId, uiNewScore);
+            }
+        }
+
+        // 删除成员
+        bool Remove(std::string_view svMember)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberId.find(svMember);
+            if (it == m_mapMemberId.end())
+            {
+                return false;
+            }
+            uint64_t ulId = it->second;
+            m_mapMemberId.erase(it);
+            MemberEntry& stEntry = m_vecMembers[ulId];
+            m_stRank.Remove(Key{ stEntry.m_uiScore, ulId });
+            stEntry.m_bPresent = false;
+            stEntry.m_strName.clear();
+            m_vecFreeIds.push_back(ulId);
+            return true;
+        }
+
+        // 获取成员分数
+        bool GetScore(std::string_view svMember, uint32_t& uiScore) const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                return false;
+            }
+            uiScore = m_vecMembers[ulId].m_uiScore;
+            return true;
+        }
+
+        // 获取成员排名，bReverse 为true时按分数从高到低排名(0为榜首)；O(log S)
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                return false;
+            }
+            size_t ulRevRank = m_stRank.GetRank(Key{ m_vecMembers[ulId].m_uiScore, ulId });
+            ulRank = bReverse ? ulRevRank : m_stRank.Size() - 1 - ulRevRank;
+            return true;
+        }
+
+        // 按排名区间查询，bReverse 为true时按分数从高到低；起始位置由计数直接定位，不逐个跳过
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            vecOut.clear();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            size_t ulSize = m_stRank.Size();
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, ulSize, ulFirst, ulLast))
+            {
+                return;
+            }
+            // 索引按分数降序存放，升序查询换算成索引中的下标区间后再翻转
+            size_t ulTake = ulLast - ulFirst + 1;
+            vecOut.reserve(ulTake);
+            m_stRank.ForEachFromRank(bReverse ? ulFirst : ulSize - 1 - ulLast, [&](const Key& stKey, const uint64_t& ulId)
+            {
+                vecOut.push_back(RankEntry{ m_vecMembers[ulId].m_strName, static_cast<double>(stKey.m_uiScore) });
+                return --ulTake > 0;
+            });
+            if (!bReverse)
+            {
+                std::reverse(vecOut.begin(), vecOut.end());
+            }
+        }
+
+        // 分数高于 uiScore 的成员数，即取得该分数时的名次(0为榜首)；不加锁，O(log S)
+        size_t CountAbove(uint32_t uiScore) const
+        {
+            return uiScore >= MAX ? 0 : m_stRank.CountBelowSlot(MAX - uiScore);
+        }
+
+        // 分数低于 uiScore 的成员所占的比例(0~1)，榜为空时为0；不加锁，与并发写入之间只保证近似
+        double GetPercentile(uint32_t uiScore) const
+        {
+            size_t ulSize = m_stRank.Size();
+            if (ulSize == 0 || uiScore == 0)
+            {
+                return 0;
+            }
+            // 分数不低于 uiScore 的成员在前 MAX - uiScore + 1 个槽
+            size_t ulNotBelow = uiScore > MAX ? 0 : m_stRank.CountBelowSlot(MAX - uiScore + 1);
+            return ulNotBelow >= ulSize ? 0 : static_cast<double>(ulSize - ulNotBelow) / static_cast<double>(ulSize);
+        }
+
+        size_t Size() const
+        {
+            return m_stRank.Size();
+        }
+};
+
+// 多线程共享的整数分数排行榜
+template<uint32_t MAX>
+using IntLeaderboard = BasicIntLeaderboard<MAX, ConcurrentAccess>;
+// 只由一个线程访问的整数分数排行榜
+template<uint32_t MAX>
+using LocalIntLeaderboard = BasicIntLeaderboard<MAX, SingleThreadAccess>;
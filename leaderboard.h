@@ -0,0 +1,1108 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "rank_index.h"
+#include "spsc_queue.h"
+
+// 支持 string_view 直接查找的字符串哈希
+struct StringHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view svText) const
+    {
+        return std::hash<std::string_view>()(svText);
+    }
+};
+
+// 分数区间端点
+struct ScoreBound
+{
+    double m_dValue = 0;       // 端点值
+    bool   m_bExclusive = false;// 是否为开区间
+};
+
+// ZADD 选项
+struct AddOptions
+{
+    bool m_bNx = false;// 只新增，不更新已有成员
+    bool m_bXx = false;// 只更新已有成员，不新增
+    bool m_bGt = false;// 新分数大于旧分数时才更新
+    bool m_bLt = false;// 新分数小于旧分数时才更新
+};
+
+// Add 的执行结果
+enum class EAddResult
+{
+    Unchanged,// 未做修改
+    Added,    // 新增成员
+    Updated,  // 更新了已有成员的分数
+};
+
+// 批量写操作类型
+enum class EWriteOp
+{
+    Add,   // ZADD
+    IncrBy,// ZINCRBY
+    Remove,// ZREM
+};
+
+// 批量写操作
+struct WriteOp
+{
+    EWriteOp         m_eOp;      // 操作类型
+    std::string_view m_svMember; // 成员名
+    double           m_dScore;   // Add 为分数，IncrBy 为增量
+    AddOptions       m_stOptions;// Add 的选项
+};
+
+// 批量写操作结果
+struct WriteResult
+{
+    EAddResult m_eAdd;  // Add 的结果
+    bool       m_bOk;   // IncrBy 结果不是 NaN / Remove 删除成功
+    double     m_dScore;// IncrBy 后的分数
+};
+
+// 排名区间查询结果
+struct RankEntry
+{
+    std::string m_strMember;// 成员名
+    double      m_dScore;   // 分数
+};
+
+// 榜首窗口变化事件类型
+enum class ERankEvent
+{
+    Enter,// 进入窗口
+    Exit, // 离开窗口
+    Move, // 在窗口内排名或分数变化
+};
+
+// 榜首窗口变化事件，排名按分数从高到低、从0开始
+struct RankEvent
+{
+    ERankEvent  m_eType = ERankEvent::Enter;// 事件类型
+    uint64_t    m_ulSeq = 0;     // 订阅内的事件序号，从1开始连续递增，出现空缺说明有事件因队列满被丢弃
+    std::string m_strMember;     // 成员名
+    double      m_dScore = 0;    // 变化后的分数，Exit 为离开前的分数
+    size_t      m_ulOldRank = 0; // 变化前的排名，Enter 无意义
+    size_t      m_ulNewRank = 0; // 变化后的排名，Exit 无意义
+};
+
+// 对排行榜前 N 名的订阅：写线程在写操作触及窗口时比较窗口前后的成员，把事件放入本订阅的无锁队列
+// 队列只有写线程(持有排行榜独占锁)一个生产者和订阅者一个消费者；队列满时丢弃事件，订阅者根据序号空缺重新拉取榜单
+class RankSubscription
+{
+    private:
+        template<typename Access>
+        friend class BasicLeaderboard;
+
+        // 窗口快照中的成员
+        struct WindowEntry
+        {
+            uint64_t    m_ulId;     // 成员编号
+            std::string m_strName;  // 成员名，编号可能被复用，比较时同时比较名字
+            double      m_dScore;   // 分数
+            double      m_dKey;     // 跳表键中的分数，未做分数变换时与 m_dScore 相同
+        };
+
+        const size_t m_ulWindow;               // 窗口大小
+        SpscQueue<RankEvent> m_stQueue;        // 事件队列
+        std::vector<WindowEntry> m_vecWindow;  // 上次发布事件时的窗口，只由写线程访问
+        uint64_t     m_ulSeq = 0;              // 最近生成的事件序号，只由写线程访问
+        std::atomic<uint64_t> m_ulDropped;     // 因队列满丢弃的事件数
+
+        void Publish(RankEvent&& stEvent)
+        {
+            stEvent.m_ulSeq = ++m_ulSeq;
+            if (!m_stQueue.TryPush(std::move(stEvent)))
+            {
+                m_ulDropped.store(m_ulDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        RankSubscription(size_t ulWindow, size_t ulCapacity) : m_ulWindow(ulWindow), m_stQueue(ulCapacity), m_ulDropped(0)
+        {
+        }
+
+        RankSubscription(const RankSubscription&) = delete;
+        RankSubscription& operator=(const RankSubscription&) = delete;
+
+        // 订阅者调用，取出下一个事件，没有事件时返回false
+        bool Poll(RankEvent& stEvent)
+        {
+            return m_stQueue.TryPop(stEvent);
+        }
+
+        size_t GetWindow() const
+        {
+            return m_ulWindow;
+        }
+
+        uint64_t GetDropped() const
+        {
+            return m_ulDropped.load(std::memory_order_relaxed);
+        }
+};
+
+// 将 Redis 风格的排名区间(负数表示倒数)换算为正向下标并截断到有效范围，区间为空时返回false
+inline bool NormalizeRankRange(int64_t llStart, int64_t llStop, size_t ulSize, size_t& ulFirst, size_t& ulLast)
+{
+    int64_t llSize = static_cast<int64_t>(ulSize);
+    if (llStart < 0)
+    {
+        llStart += llSize;
+    }
+    if (llStop < 0)
+    {
+        llStop += llSize;
+    }
+    if (llStart < 0)
+    {
+        llStart = 0;
+    }
+    if (llStart > llStop || llStart >= llSize)
+    {
+        return false;
+    }
+    if (llStop >= llSize)
+    {
+        llStop = llSize - 1;
+    }
+    ulFirst = static_cast<size_t>(llStart);
+    ulLast = static_cast<size_t>(llStop);
+    return true;
+}
+
+// 分数变更类型
+enum class EScoreEvent : uint8_t
+{
+    Added = 1,// 新增成员
+    Updated,  // 分数变化
+    Removed,  // 删除成员
+};
+
+// 一次分数变更
+struct ScoreEvent
+{
+    EScoreEvent      m_eType;     // 变更类型
+    std::string_view m_svBoard;   // 排行榜名
+    std::string_view m_svMember;  // 成员名
+    double           m_dOldScore; // 变更前分数，Added 为0
+    double           m_dNewScore; // 变更后分数，Removed 为删除前分数
+};
+
+// 分数变更的接收者，在写操作持有排行榜独占锁时同步调用，实现不能阻塞
+// 同一接收者可以挂在多个排行榜上，但这些排行榜的写操作不能并发执行
+class ScoreEventSink
+{
+    public:
+        virtual ~ScoreEventSink() = default;
+        virtual void OnScoreEvent(const ScoreEvent& stEvent) = 0;
+};
+
+// 单线程排行榜使用的空锁
+struct NullSharedMutex
+{
+    void lock() {}
+    void unlock() {}
+    void lock_shared() {}
+    void unlock_shared() {}
+};
+
+// 排行榜：成员名到分数的映射加按分数排序的索引(小榜为紧凑数组，大榜为跳表)
+// 写操作持有独占锁，读操作持有共享锁，因此写操作结束时可以直接回收跳表的退休节点
+// 成员表和跳表中存的是原始分数，对外的分数为 原始分数 x m_dScale + m_dOffset，读时换算、写时反算，
+// 全榜加分或衰减只需修改这两个系数；系数为正，换算单调，排名不变
+// 精度：写入时保存换算结果最接近写入值的原始分数，能精确换算时读回原值(整数分数加整数偏移、按 2 的幂缩放等)；
+// 否则读回值与写入值之差不超过相邻原始分数换算结果间距的一半，约为 m_dScale 个原始分数 ulp，
+// 偏移与分数量级相差悬殊(如偏移 1e6、分数 0.1)时原始分数的 ulp 大，误差随之变大
+// 可以限定容量只保留前 N 名(历史最佳榜)：满员后第 N 名的分数作为准入分数原子发布，低于它的新成员只需共享锁即被拒绝，榜内成员的降分照常执行，
+// 挤出榜的成员从低分一端删除；被删除的成员不再记得，因此限定容量适合只升不降的分数
+// Access 为 SingleThreadAccess 时只能由一个线程访问，锁和跳表的原子操作都省去
+template<typename Access>
+class BasicLeaderboard
+{
+    private:
+        // 成员信息，下标即成员编号
+        struct MemberEntry
+        {
+            std::string m_strName;  // 成员名
+            double      m_dScore;   // 当前分数(原始分数)
+            bool        m_bPresent; // 是否在榜
+        };
+
+        using Mutex = std::conditional_t<Access::CONCURRENT, std::shared_mutex, NullSharedMutex>;
+
+        RankIndex<Access>           m_stRank;// 按分数排序的索引，成员少时为紧凑数组，多时为跳表，值为成员编号
+        mutable Mutex               m_stMutex;// 保护成员表，并作为跳表节点回收的屏障
+        std::unordered_map<std::string, uint64_t, StringHash, std::equal_to<>> m_mapMemberId;// 成员名到编号
+        std::vector<MemberEntry>    m_vecMembers;// 成员信息
+        std::vector<uint64_t>       m_vecFreeIds;// 已删除成员空出的编号
+        std::atomic<uint64_t>       m_ulTopVersion{ 0 };// 榜首区间版本号，监视区间内有键变化时加一
+        std::atomic<double>         m_dTopThreshold{ std::numeric_limits<double>::infinity() };// 监视的最低分数，无人监视时为正无穷
+        std::atomic<double>         m_dAdmitScore{ -std::numeric_limits<double>::infinity() };// 准入分数(对外的分数)，未满员或不限容量时为负无穷
+
+        // 以下只在持有独占锁时访问
+        std::vector<std::shared_ptr<RankSubscription>> m_vecSubscriptions;// 榜首窗口订阅
+        double                      m_dWatchThreshold = std::numeric_limits<double>::infinity();// 各订阅窗口最后一名中最低的分数，无订阅时为正无穷
+        bool                        m_bWatchDirty = false;// 本次写操作是否触及订阅窗口
+        ScoreEventSink*             m_pEventSink = nullptr;// 分数变更接收者
+        double                      m_dScale = 1;// 分数变换的倍数，恒为正
+        double                      m_dOffset = 0;// 分数变换的偏移
+        size_t                      m_ulCapacity = 0;// 容量，0 为不限
+        std::string                 m_strEventBoard;// 发给接收者的排行榜名
+        std::vector<RankSubscription::WindowEntry> m_vecWatchWindow;// 发布事件时的当前窗口
+        std::vector<bool>           m_vecWatchKept;// 发布事件时旧窗口各成员是否仍在窗口中
+
+        // 批量写期间延迟到最后统一执行的跳表修改，记录每个成员在批量开始前的键
+        struct PendingWrites
+        {
+            std::unordered_map<uint64_t, std::pair<bool, double>> m_mapOrigin;// 成员编号 -> (原来是否在跳表中, 原分数)
+        };
+
+        // 原始分数换算为对外的分数；未做变换时原样返回，-0 等特殊值保持不变
+        double ToScore(double dRaw) const
+        {
+            return m_dScale == 1 && m_dOffset == 0 ? dRaw : dRaw * m_dScale + m_dOffset;
+        }
+
+        // 对外的分数反算为原始分数
+        double ToRaw(double dScore) const
+        {
+            return m_dScale == 1 && m_dOffset == 0 ? dScore : (dScore - m_dOffset) / m_dScale;
+        }
+
+        // double 与保序的无符号数互转：无符号数的大小顺序与 double 的数值顺序一致，相邻的数对应相邻的可表示值
+        static uint64_t ToOrdered(double dValue)
+        {
+            uint64_t ulBits = std::bit_cast<uint64_t>(dValue);
+            return (ulBits >> 63) != 0 ? ~ulBits : (ulBits | (1ULL << 63));
+        }
+
+        static double FromOrdered(uint64_t ulOrdered)
+        {
+            return std::bit_cast<double>((ulOrdered >> 63) != 0 ? (ulOrdered & ~(1ULL << 63)) : ~ulOrdered);
+        }
+
+        // 原始分数换算后不超过 dScore 的最大原始分数；换算单调不减，从反算结果出发倍增步长找到两端后二分，
+        // 偏移使大片原始分数换算为同一个值时(如偏移 500 时原始分数 0 附近的全部非规格化数)也只需 O(64) 次换算
+        double GetRawUpperBound(double dScore) const
+        {
+            double dRaw = ToRaw(dScore);
+            if ((m_dScale == 1 && m_dOffset == 0) || dRaw != dRaw)
+            {
+                return dRaw;
+            }
+            const double dInf = std::numeric_limits<double>::infinity();
+            const uint64_t ulMin = ToOrdered(-dInf);
+            const uint64_t ulMax = ToOrdered(dInf);
+            auto fnFits = [&](uint64_t ulOrdered) { return ToScore(FromOrdered(ulOrdered)) <= dScore; };
+            // ulLow 满足条件，ulHigh 不满足或为 ulMax + 1；负无穷换算后仍为负无穷，总是满足
+            uint64_t ulLow = ToOrdered(dRaw);
+            uint64_t ulHigh = ulLow;
+            uint64_t ulStep = 1;
+            if (fnFits(ulLow))
+            {
+                while (true)
+                {
+                    if (ulMax - ulLow < ulStep)
+                    {
+                        ulHigh = ulMax + 1;
+                        break;
+                    }
+                    if (!fnFits(ulLow + ulStep))
+                    {
+                        ulHigh = ulLow + ulStep;
+                        break;
+                    }
+                    ulLow += ulStep;
+                    ulStep *= 2;
+                }
+            }
+            else
+            {
+                while (true)
+                {
+                    if (ulHigh - ulMin <= ulStep)
+                    {
+                        ulLow = ulMin;
+                        break;
+                    }
+                    if (fnFits(ulHigh - ulStep))
+                    {
+                        ulLow = ulHigh - ulStep;
+                        break;
+                    }
+                    ulHigh -= ulStep;
+                    ulStep *= 2;
+                }
+            }
+            while (ulHigh - ulLow > 1)
+            {
+                uint64_t ulMid = ulLow + (ulHigh - ulLow) / 2;
+                if (fnFits(ulMid))
+                {
+                    ulLow = ulMid;
+                }
+                else
+                {
+                    ulHigh = ulMid;
+                }
+            }
+            return FromOrdered(ulLow);
+        }
+
+        // 写入时保存的原始分数：取换算结果最接近 dScore 的原始分数，换算能精确得到 dScore 时读回的就是写入值
+        // 直接反算可能差一个 ulp，例如系数 0.9 时写入 100 读回 100.00000000000001
+        double ToStoredRaw(double dScore) const
+        {
+            if ((m_dScale == 1 && m_dOffset == 0) || !std::isfinite(dScore))
+            {
+                return ToRaw(dScore);
+            }
+            double dLow = GetRawUpperBound(dScore);
+            double dLowScore = ToScore(dLow);
+            if (dLowScore == dScore)
+            {
+                return dLow;
+            }
+            double dHigh = FromOrdered(ToOrdered(dLow) + 1);
+            return dScore - dLowScore <= ToScore(dHigh) - dScore ? dLow : dHigh;
+        }
+
+        // 分数区间 [stMin, stMax] 换算为原始分数的闭区间 [dLow, dHigh]，区间为空时返回false
+        bool GetRawRange(const ScoreBound& stMin, const ScoreBound& stMax, double& dLow, double& dHigh) const
+        {
+            const double dInf = std::numeric_limits<double>::infinity();
+            // 开区间端点换成相邻的可表示值后按闭区间处理
+            if ((stMax.m_bExclusive && stMax.m_dValue == -dInf) || (stMin.m_bExclusive && stMin.m_dValue == dInf))
+            {
+                return false;
+            }
+            dHigh = GetRawUpperBound(stMax.m_bExclusive ? std::nextafter(stMax.m_dValue, -dInf) : stMax.m_dValue);
+            double dMin = stMin.m_bExclusive ? std::nextafter(stMin.m_dValue, dInf) : stMin.m_dValue;
+            // 换算后不小于 dMin 的最小原始分数，即换算后小于 dMin 的最大原始分数的下一个值
+            dLow = dMin == -dInf ? -dInf : std::nextafter(GetRawUpperBound(std::nextafter(dMin, -dInf)), dInf);
+            return dLow <= dHigh;
+        }
+
+        // 成员的键已从索引中删除后清理成员表，用于区间删除
+        void DropMember(uint64_t ulId)
+        {
+            MemberEntry& stEntry = m_vecMembers[ulId];
+            m_mapMemberId.erase(m_mapMemberId.find(stEntry.m_strName));
+            NoteKeyChange(stEntry.m_dScore);
+            EmitScoreEvent(EScoreEvent::Removed, stEntry.m_strName, stEntry.m_dScore, stEntry.m_dScore);
+            stEntry.m_bPresent = false;
+            stEntry.m_strName.clear();
+            m_vecFreeIds.push_back(ulId);
+        }
+
+        // 参数为原始分数，通知接收者时换算为对外的分数
+        void EmitScoreEvent(EScoreEvent eType, std::string_view svMember, double dOld, double dNew)
+        {
+            if (m_pEventSink != nullptr)
+            {
+                double dOldScore = eType == EScoreEvent::Added ? 0 : ToScore(dOld);
+                m_pEventSink->OnScoreEvent(ScoreEvent{ eType, m_strEventBoard, svMember, dOldScore, ToScore(dNew) });
+            }
+        }
+
+        // 查找成员编号，不存在返回false
+        bool FindMember(std::string_view svMember, uint64_t& ulId) const
+        {
+            auto it = m_mapMemberId.find(svMember);
+            if (it == m_mapMemberId.end())
+            {
+                return false;
+            }
+            ulId = it->second;
+            return true;
+        }
+
+        // 分配成员编号，优先复用空出的编号
+        uint64_t AllocMember(std::string_view svMember, double dScore)
+        {
+            uint64_t ulId = 0;
+            if (!m_vecFreeIds.empty())
+            {
+                ulId = m_vecFreeIds.back();
+                m_vecFreeIds.pop_back();
+                m_vecMembers[ulId] = MemberEntry{ std::string(svMember), dScore, true };
+            }
+            else
+            {
+                ulId = m_vecMembers.size();
+                m_vecMembers.push_back(MemberEntry{ std::string(svMember), dScore, true });
+            }
+            m_mapMemberId.emplace(m_vecMembers[ulId].m_strName, ulId);
+            return ulId;
+        }
+
+        // 跳表中插入或删除了该分数的键，不低于监视分数时榜首区间可能变化
+        // 版本号加一后监视失效，直到下次 GetTopRange 重新设置，期间的写入只需一次比较
+        void NoteKeyChange(double dScore)
+        {
+            if (dScore >= m_dTopThreshold.load(std::memory_order_relaxed))
+            {
+                m_dTopThreshold.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+                m_ulTopVersion.fetch_add(1, std::memory_order_release);
+            }
+            if (dScore >= m_dWatchThreshold)
+            {
+                m_bWatchDirty = true;
+            }
+        }
+
+        // 比较订阅的新旧窗口并发布事件：先按旧排名发布离开，再按新排名发布进入和移动
+        static void DiffWindow(RankSubscription& stSub, const std::vector<RankSubscription::WindowEntry>& vecNew, size_t ulCount,
+            std::vector<bool>& vecKept)
+        {
+            const auto& vecOld = stSub.m_vecWindow;
+            vecKept.assign(vecOld.size(), false);
+            std::vector<size_t> vecOldRank(ulCount, SIZE_MAX);
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                // 窗口只有几十名，直接线性查找
+                for (size_t j = 0; j < vecOld.size(); ++j)
+                {
+                    if (!vecKept[j] && vecOld[j].m_ulId == vecNew[i].m_ulId && vecOld[j].m_strName == vecNew[i].m_strName)
+                    {
+                        vecKept[j] = true;
+                        vecOldRank[i] = j;
+                        break;
+                    }
+                }
+            }
+            for (size_t j = 0; j < vecOld.size(); ++j)
+            {
+                if (!vecKept[j])
+                {
+                    stSub.Publish(RankEvent{ ERankEvent::Exit, 0, vecOld[j].m_strName, vecOld[j].m_dScore, j, 0 });
+                }
+            }
+            for (size_t i = 0; i < ulCount; ++i)
+            {
+                size_t j = vecOldRank[i];
+                if (j == SIZE_MAX)
+                {
+                    stSub.Publish(RankEvent{ ERankEvent::Enter, 0, vecNew[i].m_strName, vecNew[i].m_dScore, 0, i });
+                }
+                else if (j != i || vecOld[j].m_dScore != vecNew[i].m_dScore)
+                {
+                    stSub.Publish(RankEvent{ ERankEvent::Move, 0, vecNew[i].m_strName, vecNew[i].m_dScore, j, i });
+                }
+            }
+            stSub.m_vecWindow.assign(vecNew.begin(), vecNew.begin() + ulCount);
+        }
+
+        // 写入触及订阅窗口后调用：取出最大窗口内的成员，逐个订阅比较并发布事件，再重新计算监视分数
+        void PublishRankEvents()
+        {
+            size_t ulMaxWindow = 0;
+            for (const auto& pSub : m_vecSubscriptions)
+            {
+                ulMaxWindow = std::max(ulMaxWindow, pSub->m_ulWindow);
+            }
+            m_vecWatchWindow.clear();
+            if (ulMaxWindow > 0)
+            {
+                m_stRank.ForEach([&](const RankKey& stKey, const uint64_t& ulId)
+                {
+                    m_vecWatchWindow.push_back(RankSubscription::WindowEntry{ ulId, m_vecMembers[ulId].m_strName, ToScore(stKey.m_dScore), stKey.m_dScore });
+                    return m_vecWatchWindow.size() < ulMaxWindow;
+                });
+            }
+            double dThreshold = std::numeric_limits<double>::infinity();
+            for (const auto& pSub : m_vecSubscriptions)
+            {
+                size_t ulCount = std::min(pSub->m_ulWindow, m_vecWatchWindow.size());
+                DiffWindow(*pSub, m_vecWatchWindow, ulCount, m_vecWatchKept);
+                // 窗口未满时任何插入都会进入窗口；监视分数与跳表键比较，取原始分数
+                dThreshold = std::min(dThreshold, ulCount < pSub->m_ulWindow ? -std::numeric_limits<double>::infinity() : m_vecWatchWindow[ulCount - 1].m_dKey);
+            }
+            m_dWatchThreshold = dThreshold;
+        }
+
+        // 满员时以第 N 名的分数作为准入分数，否则为负无穷
+        void PublishAdmitScore()
+        {
+            double dAdmit = -std::numeric_limits<double>::infinity();
+            RankKey stLast{ 0, 0 };
+            if (m_ulCapacity != 0 && m_stRank.Size() >= m_ulCapacity && m_stRank.GetLast(stLast))
+            {
+                dAdmit = ToScore(stLast.m_dScore);
+            }
+            m_dAdmitScore.store(dAdmit, std::memory_order_relaxed);
+        }
+
+        // 限定容量时删除超出容量的最低分成员(索引中键最大的一端)，并重新发布准入分数
+        void TrimToCapacity()
+        {
+            if (m_ulCapacity == 0)
+            {
+                return;
+            }
+            size_t ulSize = m_stRank.Size();
+            if (ulSize > m_ulCapacity)
+            {
+                m_stRank.RemoveLast(ulSize - m_ulCapacity, [this](const RankKey&, const uint64_t& ulId)
+                {
+                    DropMember(ulId);
+                });
+            }
+            PublishAdmitScore();
+        }
+
+        // 写操作结束时调用：按容量删除挤出榜的成员，写入触及订阅窗口时发布事件，然后回收跳表的退休节点
+        void FinishWrite()
+        {
+            TrimToCapacity();
+            if (m_bWatchDirty)
+            {
+                m_bWatchDirty = false;
+                PublishRankEvents();
+            }
+            m_stRank.ReclaimRetired();
+        }
+
+        // 修改成员在跳表中的键，批量写时只记录修改前的状态
+        void ChangeKey(uint64_t ulId, bool bHadOld, double dOld, bool bHasNew, double dNew, PendingWrites* pPending)
+        {
+            if (pPending != nullptr)
+            {
+                pPending->m_mapOrigin.emplace(ulId, std::make_pair(bHadOld, dOld));
+                return;
+            }
+            if (bHadOld)
+            {
+                m_stRank.Remove(RankKey{ dOld, ulId });
+                NoteKeyChange(dOld);
+            }
+            if (bHasNew)
+            {
+                m_stRank.Insert(RankKey{ dNew, ulId }, ulId);
+                NoteKeyChange(dNew);
+            }
+        }
+
+        // 调整已有成员的分数：先摘除旧键再插入新键
+        void MoveMember(uint64_t ulId, double dScore, PendingWrites* pPending)
+        {
+            MemberEntry& stEntry = m_vecMembers[ulId];
+            ChangeKey(ulId, true, stEntry.m_dScore, true, dScore, pPending);
+            stEntry.m_dScore = dScore;
+        }
+
+        // 以下为持有独占锁时的写操作，pPending 非空时跳表修改延迟执行；参数和返回的分数为对外的分数
+        EAddResult AddLocked(std::string_view svMember, double dScore, const AddOptions& stOptions, PendingWrites* pPending)
+        {
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                // 低于准入分数的新成员不会进榜；榜内成员降分照常执行，满员时成员数不变，降到最后一名也仍在榜内
+                if (stOptions.m_bXx || dScore < m_dAdmitScore.load(std::memory_order_relaxed))
+                {
+                    return EAddResult::Unchanged;
+                }
+                double dRaw = ToStoredRaw(dScore);
+                ulId = AllocMember(svMember, dRaw);
+                ChangeKey(ulId, false, 0, true, dRaw, pPending);
+                EmitScoreEvent(EScoreEvent::Added, svMember, 0, dRaw);
+                return EAddResult::Added;
+            }
+            if (stOptions.m_bNx)
+            {
+                return EAddResult::Unchanged;
+            }
+            double dRaw = ToStoredRaw(dScore);
+            double dOld = m_vecMembers[ulId].m_dScore;
+            bool bAllowed = (!stOptions.m_bGt || dRaw > dOld) && (!stOptions.m_bLt || dRaw < dOld);
+            if (!bAllowed || dRaw == dOld)
+            {
+                return EAddResult::Unchanged;
+            }
+            MoveMember(ulId, dRaw, pPending);
+            EmitScoreEvent(EScoreEvent::Updated, svMember, dOld, dRaw);
+            return EAddResult::Updated;
+        }
+
+        bool IncrByLocked(std::string_view svMember, double dDelta, double& dNewScore, PendingWrites* pPending)
+        {
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                // 新成员低于准入分数时不进榜，与加入后随即挤出的结果相同，省去新增和删除两次索引修改与分数事件
+                if (dDelta < m_dAdmitScore.load(std::memory_order_relaxed))
+                {
+                    dNewScore = dDelta;
+                    return true;
+                }
+                double dRaw = ToStoredRaw(dDelta);
+                dNewScore = ToScore(dRaw);
+                ulId = AllocMember(svMember, dRaw);
+                ChangeKey(ulId, false, 0, true, dRaw, pPending);
+                EmitScoreEvent(EScoreEvent::Added, svMember, 0, dRaw);
+                return true;
+            }
+            double dOld = m_vecMembers[ulId].m_dScore;
+            dNewScore = ToScore(dOld) + dDelta;
+            if (dNewScore != dNewScore)
+            {
+                return false;
+            }
+            // 返回保存后读回的分数，与随后 GetScore 的结果一致
+            double dRaw = ToStoredRaw(dNewScore);
+            dNewScore = ToScore(dRaw);
+            if (dRaw != dOld)
+            {
+                MoveMember(ulId, dRaw, pPending);
+                EmitScoreEvent(EScoreEvent::Updated, svMember, dOld, dRaw);
+            }
+            return true;
+        }
+
+        bool RemoveLocked(std::string_view svMember, PendingWrites* pPending)
+        {
+            auto it = m_mapMemberId.find(svMember);
+            if (it == m_mapMemberId.end())
+            {
+                return false;
+            }
+            uint64_t ulId = it->second;
+            m_mapMemberId.erase(it);
+            MemberEntry& stEntry = m_vecMembers[ulId];
+            ChangeKey(ulId, true, stEntry.m_dScore, false, 0, pPending);
+            EmitScoreEvent(EScoreEvent::Removed, svMember, stEntry.m_dScore, stEntry.m_dScore);
+            stEntry.m_bPresent = false;
+            stEntry.m_strName.clear();
+            m_vecFreeIds.push_back(ulId);
+            return true;
+        }
+
+        // 将批量写期间记录的修改按键排序后统一提交到跳表，相邻键共享查找路径
+        void FlushPending(PendingWrites& stPending)
+        {
+            std::vector<RankKey> vecRemoves;
+            std::vector<std::pair<RankKey, uint64_t>> vecInserts;
+            for (const auto& stPair : stPending.m_mapOrigin)
+            {
+                uint64_t ulId = stPair.first;
+                bool bHadOld = stPair.second.first;
+                double dOld = stPair.second.second;
+                const MemberEntry& stEntry = m_vecMembers[ulId];
+                if (bHadOld && stEntry.m_bPresent && stEntry.m_dScore == dOld)
+                {
+                    continue;
+                }
+                if (bHadOld)
+                {
+                    vecRemoves.push_back(RankKey{ dOld, ulId });
+                    NoteKeyChange(dOld);
+                }
+                if (stEntry.m_bPresent)
+                {
+                    vecInserts.emplace_back(RankKey{ stEntry.m_dScore, ulId }, ulId);
+                    NoteKeyChange(stEntry.m_dScore);
+                }
+            }
+            std::sort(vecRemoves.begin(), vecRemoves.end());
+            std::sort(vecInserts.begin(), vecInserts.end(), [](const std::pair<RankKey, uint64_t>& a, const std::pair<RankKey, uint64_t>& b)
+            {
+                return a.first < b.first;
+            });
+            m_stRank.RemoveSorted(vecRemoves.begin(), vecRemoves.end());
+            m_stRank.InsertSorted(vecInserts.begin(), vecInserts.end());
+        }
+
+    public:
+        BasicLeaderboard() = default;
+        BasicLeaderboard(const BasicLeaderboard&) = delete;
+        BasicLeaderboard& operator=(const BasicLeaderboard&) = delete;
+
+        // 设置成员分数；限定容量时低于准入分数的新成员只加共享锁确认不在榜内就返回 Unchanged，不与读者互斥
+        EAddResult Add(std::string_view svMember, double dScore, const AddOptions& stOptions = AddOptions())
+        {
+            if (dScore < m_dAdmitScore.load(std::memory_order_relaxed))
+            {
+                std::shared_lock<Mutex> stShared(m_stMutex);
+                uint64_t ulId = 0;
+                if (!FindMember(svMember, ulId))
+                {
+                    return EAddResult::Unchanged;
+                }
+            }
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            EAddResult eResult = AddLocked(svMember, dScore, stOptions, nullptr);
+            FinishWrite();
+            return eResult;
+        }
+
+        // 成员分数增加 dDelta，成员不存在时视为0分新增；结果为 NaN 时不做修改返回false
+        // 限定容量时低于准入分数的新成员不进榜，仍返回true，dNewScore 为 dDelta
+        bool IncrBy(std::string_view svMember, double dDelta, double& dNewScore)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            bool bOk = IncrByLocked(svMember, dDelta, dNewScore, nullptr);
+            FinishWrite();
+            return bOk;
+        }
+
+        // 删除成员
+        bool Remove(std::string_view svMember)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            bool bRemoved = RemoveLocked(svMember, nullptr);
+            FinishWrite();
+            return bRemoved;
+        }
+
+        // 在一次加锁内按顺序执行一批写操作，结果与逐条执行相同
+        // 成员表按顺序即时更新，跳表修改合并为每个成员至多一删一插，排序后批量提交
+        // 限定容量时每条写入后的挤出和准入分数都影响下一条，跳表修改不延迟，逐条按容量挤出
+        void ApplyBatch(const std::vector<WriteOp>& vecOps, std::vector<WriteResult>& vecResults)
+        {
+            vecResults.resize(vecOps.size());
+            PendingWrites stPending;
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            PendingWrites* pPending = m_ulCapacity == 0 ? &stPending : nullptr;
+            for (size_t i = 0; i < vecOps.size(); ++i)
+            {
+                const WriteOp& stOp = vecOps[i];
+                WriteResult& stResult = vecResults[i];
+                stResult = WriteResult{ EAddResult::Unchanged, false, 0 };
+                switch (stOp.m_eOp)
+                {
+                case EWriteOp::Add:
+                    stResult.m_eAdd = AddLocked(stOp.m_svMember, stOp.m_dScore, stOp.m_stOptions, pPending);
+                    stResult.m_bOk = true;
+                    break;
+                case EWriteOp::IncrBy:
+                    stResult.m_bOk = IncrByLocked(stOp.m_svMember, stOp.m_dScore, stResult.m_dScore, pPending);
+                    break;
+                case EWriteOp::Remove:
+                    stResult.m_bOk = RemoveLocked(stOp.m_svMember, pPending);
+                    break;
+                }
+                if (pPending == nullptr)
+                {
+                    TrimToCapacity();
+                }
+            }
+            FlushPending(stPending);
+            FinishWrite();
+        }
+
+        // 删除分数在 [stMin, stMax] 内的全部成员，返回删除的个数(ZREMRANGEBYSCORE)
+        // 索引中一次定位、整段摘除，O(log n + k)
+        size_t RemoveRangeByScore(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            double dLow = 0;
+            double dHigh = 0;
+            if (!GetRawRange(stMin, stMax, dLow, dHigh))
+            {
+                return 0;
+            }
+            // 降序排列下区间从 {dHigh, 0} 开始，到 {dLow, 最大编号} 结束
+            size_t ulRemoved = m_stRank.RemoveRange(RankKey{ dHigh, 0 }, RankKey{ dLow, UINT64_MAX }, [this](const RankKey&, const uint64_t& ulId)
+            {
+                DropMember(ulId);
+            });
+            FinishWrite();
+            return ulRemoved;
+        }
+
+        // 删除按分数从低到高排名在 [llStart, llStop] 内的成员，负数表示倒数，返回删除的个数(ZREMRANGEBYRANK)
+        // 例如只保留前 N 名：RemoveRangeByRank(0, -N - 1)
+        size_t RemoveRangeByRank(int64_t llStart, int64_t llStop)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            size_t ulSize = m_stRank.Size();
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, ulSize, ulFirst, ulLast))
+            {
+                return 0;
+            }
+            // 索引按分数降序存放，换算成索引中的下标区间
+            size_t ulRemoved = m_stRank.RemoveRankRange(ulSize - 1 - ulLast, ulSize - 1 - ulFirst, [this](const RankKey&, const uint64_t& ulId)
+            {
+                DropMember(ulId);
+            });
+            FinishWrite();
+            return ulRemoved;
+        }
+
+        // 订阅分数最高的 ulWindow 名的变化，事件队列容量为 ulCapacity
+        // 订阅后立即收到当前窗口内每个成员的进入事件；只有触及窗口的写操作才会比较窗口，窗口外的写入只多一次比较
+        std::shared_ptr<RankSubscription> Subscribe(size_t ulWindow, size_t ulCapacity)
+        {
+            auto pSub = std::make_shared<RankSubscription>(std::max<size_t>(ulWindow, 1), ulCapacity);
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            m_vecSubscriptions.push_back(pSub);
+            PublishRankEvents();
+            return pSub;
+        }
+
+        // 取消订阅，之后写操作不再向其发布事件
+        void Unsubscribe(const std::shared_ptr<RankSubscription>& pSub)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = std::find(m_vecSubscriptions.begin(), m_vecSubscriptions.end(), pSub);
+            if (it == m_vecSubscriptions.end())
+            {
+                return;
+            }
+            m_vecSubscriptions.erase(it);
+            // 其余订阅的窗口没有变化，重新比较只会得到新的监视分数
+            PublishRankEvents();
+        }
+
+        // 设置分数变更接收者，之后每次成员新增、分数变化和删除都会同步通知；传入空指针取消
+        void SetEventSink(ScoreEventSink* pSink, std::string_view svBoard)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            m_pEventSink = pSink;
+            m_strEventBoard.assign(svBoard);
+        }
+
+        // 把跳表节点改为从 pArena 分配，使排行榜的数据落在内存池所在的 NUMA 节点；只能在排行榜为空时调用
+        bool SetArena(NodeArena* pArena)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            return m_stRank.SetArena(pArena);
+        }
+
+        // 装载按排名从高到低排列的成员，只能在排行榜为空时调用，用于从快照恢复，不通知分数变更接收者；分数为对外的分数
+        // 成员名被移走；排行榜非空、成员名重复或分数未按非递增排列时返回false，此时排行榜保持为空
+        bool LoadRanked(std::vector<RankEntry>& vecEntries)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            if (!m_vecMembers.empty())
+            {
+                return false;
+            }
+            // 限定容量时只装载前 N 名
+            if (m_ulCapacity != 0 && vecEntries.size() > m_ulCapacity)
+            {
+                vecEntries.resize(m_ulCapacity);
+            }
+            // 编号按排名顺序分配，同分成员的先后与快照中一致，跳表键整体有序
+            std::vector<std::pair<RankKey, uint64_t>> vecKeys;
+            vecKeys.reserve(vecEntries.size());
+            m_vecMembers.reserve(vecEntries.size());
+            m_mapMemberId.reserve(vecEntries.size());
+            for (RankEntry& stEntry : vecEntries)
+            {
+                uint64_t ulId = m_vecMembers.size();
+                double dRaw = ToStoredRaw(stEntry.m_dScore);
+                bool bOrdered = vecKeys.empty() || !(dRaw > vecKeys.back().first.m_dScore);
+                m_vecMembers.push_back(MemberEntry{ std::move(stEntry.m_strMember), dRaw, true });
+                if (!bOrdered || !m_mapMemberId.emplace(m_vecMembers.back().m_strName, ulId).second)
+                {
+                    m_mapMemberId.clear();
+                    m_vecMembers.clear();
+                    return false;
+                }
+                vecKeys.emplace_back(RankKey{ dRaw, ulId }, ulId);
+            }
+            m_stRank.InsertSorted(vecKeys.begin(), vecKeys.end());
+            PublishAdmitScore();
+            return true;
+        }
+
+        // 把全部成员的分数变为 分数 x dScale + dOffset，例如全榜加分(1, 500)、衰减(0.9, 0)，耗时与成员数无关
+        // 只修改换算系数，排名不变，不通知分数变更接收者；榜首区间版本号加一，订阅者收到窗口内各成员的分数变化
+        // 多次变换累积到系数上，分数精度随之下降；转为冷榜再装回等经过快照的操作会把变换固化到分数中
+        // dScale 不是有限正数或 dOffset 不是有限数时返回false
+        bool ApplyTransform(double dScale, double dOffset)
+        {
+            if (!(dScale > 0) || !std::isfinite(dScale) || !std::isfinite(dOffset))
+            {
+                return false;
+            }
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            // 累积后的系数下溢为0或溢出时拒绝，保持原系数
+            double dNewScale = m_dScale * dScale;
+            double dNewOffset = m_dOffset * dScale + dOffset;
+            if (!(dNewScale > 0) || !std::isfinite(dNewScale) || !std::isfinite(dNewOffset))
+            {
+                return false;
+            }
+            m_dScale = dNewScale;
+            m_dOffset = dNewOffset;
+            m_dTopThreshold.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+            m_ulTopVersion.fetch_add(1, std::memory_order_release);
+            PublishAdmitScore();
+            if (!m_vecSubscriptions.empty())
+            {
+                PublishRankEvents();
+            }
+            return true;
+        }
+
+        // 限定只保留分数最高的 ulCapacity 名，0 为不限；超出的最低分成员立即删除，并通知分数变更接收者
+        // 满员后低于第 N 名的设置和新成员的增量写入被拒绝，榜内成员的增量写入照常执行，结果挤出榜时随即删除
+        // 容量随排行榜快照保存，冷榜装回后仍然有效
+        void SetCapacity(size_t ulCapacity)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            m_ulCapacity = ulCapacity;
+            PublishAdmitScore();
+            FinishWrite();
+        }
+
+        size_t GetCapacity() const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_ulCapacity;
+        }
+
+        // 当前的准入分数，未满员或不限容量时为负无穷；只读一次原子变量，可作为调用方对新成员的预先过滤
+        double GetAdmitScore() const
+        {
+            return m_dAdmitScore.load(std::memory_order_relaxed);
+        }
+
+        // 获取成员分数
+        bool GetScore(std::string_view svMember, double& dScore) const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                return false;
+            }
+            dScore = ToScore(m_vecMembers[ulId].m_dScore);
+            return true;
+        }
+
+        // 获取成员排名，bReverse 为true时按分数从高到低排名(0为榜首)
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            uint64_t ulId = 0;
+            if (!FindMember(svMember, ulId))
+            {
+                return false;
+            }
+            size_t ulRevRank = m_stRank.GetRank(RankKey{ m_vecMembers[ulId].m_dScore, ulId });
+            ulRank = bReverse ? ulRevRank : m_stRank.Size() - 1 - ulRevRank;
+            return true;
+        }
+
+        // 按排名区间查询，bReverse 为true时按分数从高到低
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            vecOut.clear();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            size_t ulSize = m_stRank.Size();
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, ulSize, ulFirst, ulLast))
+            {
+                return;
+            }
+            // 跳表按分数降序存放，升序查询换算成跳表中的下标区间后再翻转；起点沿跨度定位，不逐个跳过
+            size_t ulTake = ulLast - ulFirst + 1;
+            vecOut.reserve(ulTake);
+            m_stRank.ForEachFromRank(bReverse ? ulFirst : ulSize - 1 - ulLast, [&](const RankKey& stKey, const uint64_t& ulId)
+            {
+                vecOut.push_back(RankEntry{ m_vecMembers[ulId].m_strName, ToScore(stKey.m_dScore) });
+                return --ulTake > 0;
+            });
+            if (!bReverse)
+            {
+                std::reverse(vecOut.begin(), vecOut.end());
+            }
+        }
+
+        // 按排名从高到低遍历全部成员，回调参数为 (成员名, 分数)，返回false时提前结束；遍历期间持有读锁，回调中不能修改排行榜
+        template<typename Fn>
+        void ForEachRanked(Fn&& fn)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            m_stRank.ForEach([&](const RankKey& stKey, const uint64_t& ulId)
+            {
+                return fn(std::string_view(m_vecMembers[ulId].m_strName), ToScore(stKey.m_dScore));
+            });
+        }
+
+        // 查询分数最高的 ulK 名(从高到低)并开始监视这一区间，返回当前的榜首区间版本号
+        // 之后插入或删除分数不低于第 ulK 名的键时版本号会改变，版本号不变则查询结果仍然有效
+        uint64_t GetTopRange(size_t ulK, std::vector<RankEntry>& vecOut)
+        {
+            vecOut.clear();
+            if (ulK == 0)
+            {
+                return m_ulTopVersion.load(std::memory_order_acquire);
+            }
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            vecOut.reserve(std::min(ulK, m_stRank.Size()));
+            double dLastKey = 0;
+            m_stRank.ForEach([&](const RankKey& stKey, const uint64_t& ulId)
+            {
+                vecOut.push_back(RankEntry{ m_vecMembers[ulId].m_strName, ToScore(stKey.m_dScore) });
+                dLastKey = stKey.m_dScore;
+                return vecOut.size() < ulK;
+            });
+            // 不足 ulK 名时任何插入都会进入区间；写操作持有独占锁，不会与这里交错
+            // 有多个不同 ulK 的监视者时取最低的分数，保证每个监视者的区间变化都会改变版本号；监视分数为原始分数
+            double dThreshold = vecOut.size() < ulK ? -std::numeric_limits<double>::infinity() : dLastKey;
+            double dCurrent = m_dTopThreshold.load(std::memory_order_relaxed);
+            while (dThreshold < dCurrent && !m_dTopThreshold.compare_exchange_weak(dCurrent, dThreshold, std::memory_order_relaxed))
+            {
+            }
+            return m_ulTopVersion.load(std::memory_order_acquire);
+        }
+
+        // 当前的榜首区间版本号，不加锁
+        uint64_t GetTopVersion() const
+        {
+            return m_ulTopVersion.load(std::memory_order_acquire);
+        }
+
+        // 统计分数在 [stMin, stMax] 内的成员数：区间两端键的排名之差，跳表按各层跨度计算排名，O(log n)
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            double dLow = 0;
+            double dHigh = 0;
+            if (!GetRawRange(stMin, stMax, dLow, dHigh))
+            {
+                return 0;
+            }
+            // 降序排列下区间从 {dHigh, 0} 开始，到 {dLow, 最大编号} 结束，成员编号不会取到最大值
+            return m_stRank.GetRank(RankKey{ dLow, UINT64_MAX }) - m_stRank.GetRank(RankKey{ dHigh, 0 });
+        }
+
+        // 在榜成员数
+        size_t Size() const
+        {
+            return m_stRank.Size();
+        }
+};
+
+// 多线程共享的排行榜
+using Leaderboard = BasicLeaderboard<ConcurrentAccess>;
+// 只由一个线程访问的排行榜
+using LocalLeaderboard = BasicLeaderboard<SingleThreadAccess>;
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 败者树：k 路归并时每取出一个元素只需沿叶到根比较 log2(k) 次
+// 内部节点记录该处比较的败者，m_vecTree[0] 记录总的胜者；叶子 i 对应节点 i+k
+// Beats(a, b) 为true表示路 a 的当前元素应排在路 b 之前，已耗尽的路必须输给任何未耗尽的路
+template<typename Beats>
+class LoserTree
+{
+    private:
+        size_t m_ulWays;               // 路数
+        Beats  m_stBeats;              // 比较两路的当前元素
+        std::vector<size_t> m_vecTree; // 0 为胜者，1..k-1 为各内部节点的败者
+
+        // 建立以 ulNode 为根的子树，返回子树的胜者
+        size_t Build(size_t ulNode)
+        {
+            if (ulNode >= m_ulWays)
+            {
+                return ulNode - m_ulWays;
+            }
+            size_t ulLeft = Build(ulNode * 2);
+            size_t ulRight = Build(ulNode * 2 + 1);
+            if (m_stBeats(ulLeft, ulRight))
+            {
+                m_vecTree[ulNode] = ulRight;
+                return ulLeft;
+            }
+            m_vecTree[ulNode] = ulLeft;
+            return ulRight;
+        }
+
+    public:
+        LoserTree(size_t ulWays, Beats stBeats) : m_ulWays(ulWays), m_stBeats(std::move(stBeats)), m_vecTree(ulWays > 0 ? ulWays : 1, 0)
+        {
+            if (m_ulWays > 0)
+            {
+                m_vecTree[0] = Build(1);
+            }
+        }
+
+        // 当前胜者所在的路，路数为0时不可调用
+        size_t Winner() const
+        {
+            return m_vecTree[0];
+        }
+
+        // 胜者所在的路前进到下一个元素(或耗尽)后调用，沿叶到根重新比赛
+        void Replay()
+        {
+            size_t ulWinner = m_vecTree[0];
+            for (size_t ulNode = (ulWinner + m_ulWays) / 2; ulNode > 0; ulNode /= 2)
+            {
+                if (m_stBeats(m_vecTree[ulNode], ulWinner))
+                {
+                    std::swap(m_vecTree[ulNode], ulWinner);
+                }
+            }
+            m_vecTree[0] = ulWinner;
+        }
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 有界无锁多生产者单消费者队列
+// 每个槽位带一个序号：生产者用 CAS 抢占尾部位置后写入数据，再发布序号；消费者看到序号就绪才取出
+// 生产者之间只竞争尾部下标这一个原子变量，写入数据互不干扰；队列满时入队失败，由调用方决定丢弃或重试
+template<typename T>
+class MpscQueue
+{
+    private:
+        // 槽位：序号等于位置时可写，等于位置+1时可读
+        struct Cell
+        {
+            std::atomic<size_t> m_ulSeq;// 槽位序号
+            T                   m_stValue;// 数据
+        };
+
+        std::unique_ptr<Cell[]> m_pCells;// 环形缓冲区
+        const size_t m_ulMask;           // 容量-1，容量为2的幂
+
+        alignas(64) std::atomic<size_t> m_ulTail;// 生产者抢占到的位置
+        alignas(64) size_t m_ulHead;             // 消费者读到的位置
+        std::atomic<size_t> m_ulPublishedHead;   // 消费者读到的位置，供其他线程统计队列长度
+
+        static size_t RoundUpPowerOfTwo(size_t ulValue)
+        {
+            size_t ulResult = 1;
+            while (ulResult < ulValue)
+            {
+                ulResult <<= 1;
+            }
+            return ulResult;
+        }
+
+    public:
+        explicit MpscQueue(size_t ulCapacity) : m_pCells(new Cell[RoundUpPowerOfTwo(ulCapacity)]),
+            m_ulMask(RoundUpPowerOfTwo(ulCapacity) - 1), m_ulTail(0), m_ulHead(0), m_ulPublishedHead(0)
+        {
+            for (size_t i = 0; i <= m_ulMask; ++i)
+            {
+                m_pCells[i].m_ulSeq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        // 任意线程调用，队列满时返回false且不移动 stValue
+        bool TryPush(T&& stValue)
+        {
+            size_t ulPos = m_ulTail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& stCell = m_pCells[ulPos & m_ulMask];
+                size_t ulSeq = stCell.m_ulSeq.load(std::memory_order_acquire);
+                intptr_t lDiff = static_cast<intptr_t>(ulSeq) - static_cast<intptr_t>(ulPos);
+                if (lDiff == 0)
+                {
+                    if (m_ulTail.compare_exchange_weak(ulPos, ulPos + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    {
+                        stCell.m_stValue = std::move(stValue);
+                        stCell.m_ulSeq.store(ulPos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (lDiff < 0)
+                {
+                    // 槽位还没被消费者取走，队列已满
+                    return false;
+                }
+                else
+                {
+                    ulPos = m_ulTail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 仅消费者调用，队列空或队首槽位尚未写完时返回false
+        bool TryPop(T& stValue)
+        {
+            Cell& stCell = m_pCells[m_ulHead & m_ulMask];
+            if (stCell.m_ulSeq.load(std::memory_order_acquire) != m_ulHead + 1)
+            {
+                return false;
+            }
+            stValue = std::move(stCell.m_stValue);
+            stCell.m_ulSeq.store(m_ulHead + m_ulMask + 1, std::memory_order_release);
+            ++m_ulHead;
+            m_ulPublishedHead.store(m_ulHead, std::memory_order_release);
+            return true;
+        }
+
+        // 仅消费者调用，是否已没有生产者抢占过的位置
+        // 与生产者的 CAS 都是顺序一致的，用于在休眠前确认不会漏掉唤醒
+        bool Empty() const
+        {
+            return m_ulTail.load(std::memory_order_seq_cst) == m_ulHead;
+        }
+
+        // 当前队列长度，任意线程可调用，结果只是某一时刻的近似
+        size_t Size() const
+        {
+            size_t ulHead = m_ulPublishedHead.load(std::memory_order_acquire);
+            size_t ulTail = m_ulTail.load(std::memory_order_acquire);
+            return ulTail > ulHead ? ulTail - ulHead : 0;
+        }
+
+        size_t Capacity() const
+        {
+            return m_ulMask + 1;
+        }
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "skiplist.h"
+
+// 从 /sys 读出的 CPU 列表，格式如 "0-3,8-11"
+inline std::vector<int> ParseCpuList(const std::string& strList)
+{
+    std::vector<int> vecCpus;
+    size_t ulPos = 0;
+    while (ulPos < strList.size())
+    {
+        size_t ulEnd = strList.find(',', ulPos);
+        if (ulEnd == std::string::npos)
+        {
+            ulEnd = strList.size();
+        }
+        std::string strItem = strList.substr(ulPos, ulEnd - ulPos);
+        size_t ulDash = strItem.find('-');
+        if (!strItem.empty() && strItem[0] >= '0' && strItem[0] <= '9')
+        {
+            int iFirst = atoi(strItem.c_str());
+            int iLast = ulDash == std::string::npos ? iFirst : atoi(strItem.c_str() + ulDash + 1);
+            for (int i = iFirst; i <= iLast; ++i)
+            {
+                vecCpus.push_back(i);
+            }
+        }
+        ulPos = ulEnd + 1;
+    }
+    return vecCpus;
+}
+
+// 在线的 NUMA 节点编号；内核不支持 NUMA 时视为只有节点0
+inline std::vector<int> GetNumaNodes()
+{
+    std::ifstream stFile("/sys/devices/system/node/online");
+    std::string strList;
+    std::getline(stFile, strList);
+    std::vector<int> vecNodes = ParseCpuList(strList);
+    if (vecNodes.empty())
+    {
+        vecNodes.push_back(0);
+    }
+    return vecNodes;
+}
+
+// 节点上的 CPU 编号
+inline std::vector<int> GetNumaNodeCpus(int iNode)
+{
+    std::ifstream stFile("/sys/devices/system/node/node" + std::to_string(iNode) + "/cpulist");
+    std::string strList;
+    std::getline(stFile, strList);
+    return ParseCpuList(strList);
+}
+
+// CPU 所在的节点，查不到时返回0
+inline int GetCpuNumaNode(int iCpu)
+{
+    for (int iNode : GetNumaNodes())
+    {
+        for (int iNodeCpu : GetNumaNodeCpus(iNode))
+        {
+            if (iNodeCpu == iCpu)
+            {
+                return iNode;
+            }
+        }
+    }
+    return 0;
+}
+
+// 绑定到一个 NUMA 节点的跳表节点内存池
+// 每次向内核映射一大块内存，映射后立即用 mbind 限定在该节点上分配物理页，块内按大小分档切分，
+// 释放的节点挂到同档的空闲链表复用；mbind 不可用(单节点内核、容器限制)时退化为首次访问分配，
+// 此时由绑定在该节点上的线程写入节点即可让物理页落在本地
+// 内存只在内存池析构时归还，使用它的跳表必须先析构
+class NumaArena : public NodeArena
+{
+    private:
+        static constexpr size_t ALIGN = 16;       // 分配粒度
+        static constexpr size_t MAX_BLOCK = 4096; // 内存池负责的最大块，更大的直接向系统申请
+
+        const int    m_iNode;       // 绑定的节点
+        const size_t m_ulChunkBytes;// 每次映射的大小
+        std::mutex   m_stMutex;     // 并发跳表的多个写线程可能同时分配
+        std::vector<std::pair<void*, size_t>> m_vecChunks;// 已映射的块
+        char*        m_pCursor = nullptr;// 当前块中未切分部分的起点
+        char*        m_pLimit = nullptr; // 当前块的末尾
+        std::vector<void*> m_vecFree;    // 各档的空闲链表头，链表指针存放在空闲块开头
+        bool         m_bBound = true;    // 所有块是否都成功绑定到节点
+        size_t       m_ulInUse = 0;      // 已分配未释放的字节数
+
+        bool MapChunk()
+        {
+            void* pChunk = mmap(nullptr, m_ulChunkBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pChunk == MAP_FAILED)
+            {
+                return false;
+            }
+            // 节点掩码按 unsigned long 组织，maxnode 为掩码的位数
+            unsigned long aulMask[4] = {};
+            if (m_iNode >= 0 && m_iNode < static_cast<int>(sizeof(aulMask) * 8))
+            {
+                aulMask[m_iNode / (sizeof(unsigned long) * 8)] |= 1UL << (m_iNode % (sizeof(unsigned long) * 8));
+                if (syscall(SYS_mbind, pChunk, m_ulChunkBytes, MPOL_BIND, aulMask, sizeof(aulMask) * 8, 0) != 0)
+                {
+                    m_bBound = false;
+                }
+            }
+            m_vecChunks.emplace_back(pChunk, m_ulChunkBytes);
+            m_pCursor = static_cast<char*>(pChunk);
+            m_pLimit = m_pCursor + m_ulChunkBytes;
+            return true;
+        }
+
+    public:
+        explicit NumaArena(int iNode, size_t ulChunkBytes = 2 << 20) : m_iNode(iNode), m_ulChunkBytes(ulChunkBytes),
+            m_vecFree(MAX_BLOCK / ALIGN + 1, nullptr)
+        {
+        }
+
+        NumaArena(const NumaArena&) = delete;
+        NumaArena& operator=(const NumaArena&) = delete;
+
+        ~NumaArena() override
+        {
+            for (auto& stChunk : m_vecChunks)
+            {
+                munmap(stChunk.first, stChunk.second);
+            }
+        }
+
+        void* Allocate(size_t ulBytes) override
+        {
+            size_t ulRounded = (ulBytes + ALIGN - 1) & ~(ALIGN - 1);
+            if (ulRounded > MAX_BLOCK)
+            {
+                return ::operator new(ulBytes);
+            }
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            m_ulInUse += ulRounded;
+            void*& pFree = m_vecFree[ulRounded / ALIGN];
+            if (pFree != nullptr)
+            {
+                void* pBlock = pFree;
+                pFree = *static_cast<void**>(pBlock);
+                return pBlock;
+            }
+            if (m_pCursor == nullptr || static_cast<size_t>(m_pLimit - m_pCursor) < ulRounded)
+            {
+                if (!MapChunk())
+                {
+                    m_ulInUse -= ulRounded;
+                    throw std::bad_alloc();
+                }
+            }
+            void* pBlock = m_pCursor;
+            m_pCursor += ulRounded;
+            return pBlock;
+        }
+
+        void Deallocate(void* pBlock, size_t ulBytes) override
+        {
+            size_t ulRounded = (ulBytes + ALIGN - 1) & ~(ALIGN - 1);
+            if (ulRounded > MAX_BLOCK)
+            {
+                ::operator delete(pBlock);
+                return;
+            }
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            m_ulInUse -= ulRounded;
+            void*& pFree = m_vecFree[ulRounded / ALIGN];
+            *static_cast<void**>(pBlock) = pFree;
+            pFree = pBlock;
+        }
+
+        int GetNode() const
+        {
+            return m_iNode;
+        }
+
+        // 是否所有内存都由 mbind 限定在节点上；为false时依赖首次访问分配
+        bool IsBound()
+        {
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            return m_bBound;
+        }
+
+        // 已映射的字节数和正在使用的字节数
+        void GetUsage(size_t& ulMapped, size_t& ulInUse)
+        {
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            ulMapped = m_vecChunks.size() * m_ulChunkBytes;
+            ulInUse = m_ulInUse;
+        }
+};
@@ -0,0 +1,476 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "leaderboard.h"
+
+// 分区目录中的一项
+struct PartitionInfo
+{
+    double   m_dLow;   // 分数下界(含)
+    double   m_dHigh;  // 分数上界(不含)，最高分区为正无穷
+    size_t   m_ulCount;// 成员数
+    uint64_t m_ulWrites;// 上次选热点分区以来的写入次数
+};
+
+// 按分数区间分区的排行榜：每个分区是一个独立的跳表排行榜，负责一段连续的分数区间，
+// 分区目录记录各分区的区间和成员数。分数从高到低的全局排名 = 更高分区的成员数之和 + 分区内排名，
+// 前N名只需访问最高的一两个分区，按分数统计时完全落在区间内的分区直接取成员数
+// 分区从低分到高分排列；成员分数跨越分区边界时从旧分区移到新分区
+// 整个排行榜由一把读写锁保护，分区内部使用单线程策略；Access 为 SingleThreadAccess 时锁也省去
+// 分区边界按有限分数划分，分数和增量必须是有限值，NaN 与正负无穷一律拒绝
+template<typename Access>
+class RangePartitionedBoard
+{
+    private:
+        using Mutex = std::conditional_t<Access::CONCURRENT, std::shared_mutex, NullSharedMutex>;
+
+        // 拆分时日志积压少于该值才进入切换，切换只重放这么多成员
+        static constexpr size_t SPLIT_CUTOVER_LOG = 256;
+        // 追赶轮数上限，写入太快追不上时也直接切换
+        static constexpr int SPLIT_MAX_CATCHUP = 8;
+        // 拆分时每次持读锁复制的成员数，写入最多等待复制这么多成员
+        static constexpr size_t SPLIT_COPY_CHUNK = 4096;
+
+        // 分区
+        struct Partition
+        {
+            double           m_dLow = 0;  // 分数下界(含)
+            LocalLeaderboard m_stBoard;   // 本分区的成员
+            uint64_t         m_ulWrites = 0;// 写入次数，受写锁保护
+        };
+
+        mutable Mutex m_stMutex;// 保护分区目录和成员表
+        std::vector<std::unique_ptr<Partition>> m_vecPartitions;// 各分区，按下界升序
+        std::unordered_map<std::string, double, StringHash, std::equal_to<>> m_mapMemberScore;// 成员名到分数，分数决定所在分区
+
+        // 以下只由拆分线程和持有写锁的写入方访问
+        Mutex      m_stSplitMutex;           // 同一时刻只进行一个拆分
+        Partition* m_pSplitSource = nullptr; // 正在拆分的分区
+        std::vector<std::string> m_vecSplitLog;// 拆分期间在源分区内写入过的成员
+
+        // 分数所属的分区：下界不超过该分数的最后一个分区
+        size_t FindPartition(double dScore) const
+        {
+            auto it = std::upper_bound(m_vecPartitions.begin() + 1, m_vecPartitions.end(), dScore,
+                [](double dValue, const std::unique_ptr<Partition>& pPartition)
+                {
+                    return dValue < pPartition->m_dLow;
+                });
+            return static_cast<size_t>(it - m_vecPartitions.begin()) - 1;
+        }
+
+        // 分区 ulIndex 之上(分数更高)的所有分区的成员数
+        size_t CountAbove(size_t ulIndex) const
+        {
+            size_t ulCount = 0;
+            for (size_t i = ulIndex + 1; i < m_vecPartitions.size(); ++i)
+            {
+                ulCount += m_vecPartitions[i]->m_stBoard.Size();
+            }
+            return ulCount;
+        }
+
+        double GetHigh(size_t ulIndex) const
+        {
+            return ulIndex + 1 < m_vecPartitions.size() ? m_vecPartitions[ulIndex + 1]->m_dLow : std::numeric_limits<double>::infinity();
+        }
+
+        // 写入成员的新分数，bHadOld 为false时是新增；持有写锁时调用
+        void SetScore(std::string_view svMember, bool bHadOld, double dOld, double dScore)
+        {
+            size_t ulNew = FindPartition(dScore);
+            Partition& stNew = *m_vecPartitions[ulNew];
+            if (bHadOld)
+            {
+                Partition& stOld = *m_vecPartitions[FindPartition(dOld)];
+                if (&stOld != &stNew)
+                {
+                    stOld.m_stBoard.Remove(svMember);
+                    LogSplitWrite(stOld, svMember);
+                }
+            }
+            stNew.m_stBoard.Add(svMember, dScore);
+            ++stNew.m_ulWrites;
+            LogSplitWrite(stNew, svMember);
+        }
+
+        // 拆分期间源分区的写入记入日志，切换前重放到新分区
+        void LogSplitWrite(const Partition& stPartition, std::string_view svMember)
+        {
+            if (&stPartition == m_pSplitSource)
+            {
+                m_vecSplitLog.emplace_back(svMember);
+            }
+        }
+
+        // 按日志把成员在新分区中的状态改为与成员表一致，dHigh 为源分区上界；持有读锁或写锁时调用
+        void ReplaySplitLog(const std::vector<std::string>& vecLog, double dHigh, Partition& stLower, Partition& stUpper) const
+        {
+            for (const std::string& strMember : vecLog)
+            {
+                stLower.m_stBoard.Remove(strMember);
+                stUpper.m_stBoard.Remove(strMember);
+                auto it = m_mapMemberScore.find(strMember);
+                if (it == m_mapMemberScore.end() || it->second < stLower.m_dLow || it->second >= dHigh)
+                {
+                    continue;
+                }
+                (it->second < stUpper.m_dLow ? stLower : stUpper).m_stBoard.Add(strMember, it->second);
+            }
+        }
+
+    public:
+        // vecSplits 为分区边界，n 个边界划分出 n+1 个分区；边界值属于它上方的分区
+        explicit RangePartitionedBoard(std::vector<double> vecSplits)
+        {
+            std::sort(vecSplits.begin(), vecSplits.end());
+            vecSplits.erase(std::unique(vecSplits.begin(), vecSplits.end()), vecSplits.end());
+            m_vecPartitions.push_back(std::make_unique<Partition>());
+            m_vecPartitions.back()->m_dLow = -std::numeric_limits<double>::infinity();
+            for (double dSplit : vecSplits)
+            {
+                m_vecPartitions.push_back(std::make_unique<Partition>());
+                m_vecPartitions.back()->m_dLow = dSplit;
+            }
+        }
+
+        RangePartitionedBoard(const RangePartitionedBoard&) = delete;
+        RangePartitionedBoard& operator=(const RangePartitionedBoard&) = delete;
+
+        // 设置成员分数，选项语义与 ZADD 相同；分数不是有限值时不做修改返回 Unchanged
+        EAddResult Add(std::string_view svMember, double dScore, const AddOptions& stOptions = AddOptions())
+        {
+            if (!std::isfinite(dScore))
+            {
+                return EAddResult::Unchanged;
+            }
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberScore.find(svMember);
+            if (it == m_mapMemberScore.end())
+            {
+                if (stOptions.m_bXx)
+                {
+                    return EAddResult::Unchanged;
+                }
+                SetScore(svMember, false, 0, dScore);
+                m_mapMemberScore.emplace(svMember, dScore);
+                return EAddResult::Added;
+            }
+            if (stOptions.m_bNx)
+            {
+                return EAddResult::Unchanged;
+            }
+            double dOld = it->second;
+            bool bAllowed = (!stOptions.m_bGt || dScore > dOld) && (!stOptions.m_bLt || dScore < dOld);
+            if (!bAllowed || dScore == dOld)
+            {
+                return EAddResult::Unchanged;
+            }
+            SetScore(svMember, true, dOld, dScore);
+            it->second = dScore;
+            return EAddResult::Updated;
+        }
+
+        // 成员分数增加 dDelta，成员不存在时视为0分新增；增量或结果不是有限值时不做修改返回false
+        bool IncrBy(std::string_view svMember, double dDelta, double& dNewScore)
+        {
+            if (!std::isfinite(dDelta))
+            {
+                return false;
+            }
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberScore.find(svMember);
+            if (it == m_mapMemberScore.end())
+            {
+                dNewScore = dDelta;
+                SetScore(svMember, false, 0, dNewScore);
+                m_mapMemberScore.emplace(svMember, dNewScore);
+                return true;
+            }
+            double dOld = it->second;
+            dNewScore = dOld + dDelta;
+            if (!std::isfinite(dNewScore))
+            {
+                return false;
+            }
+            if (dNewScore != dOld)
+            {
+                SetScore(svMember, true, dOld, dNewScore);
+                it->second = dNewScore;
+            }
+            return true;
+        }
+
+        // 删除成员
+        bool Remove(std::string_view svMember)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberScore.find(svMember);
+            if (it == m_mapMemberScore.end())
+            {
+                return false;
+            }
+            Partition& stPartition = *m_vecPartitions[FindPartition(it->second)];
+            stPartition.m_stBoard.Remove(svMember);
+            ++stPartition.m_ulWrites;
+            LogSplitWrite(stPartition, svMember);
+            m_mapMemberScore.erase(it);
+            return true;
+        }
+
+        // 获取成员分数，不访问分区
+        bool GetScore(std::string_view svMember, double& dScore) const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberScore.find(svMember);
+            if (it == m_mapMemberScore.end())
+            {
+                return false;
+            }
+            dScore = it->second;
+            return true;
+        }
+
+        // 获取成员排名，bReverse 为true时按分数从高到低排名(0为榜首)
+        // 更高分区的成员数之和加上分区内排名，只访问成员所在的一个分区
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapMemberScore.find(svMember);
+            if (it == m_mapMemberScore.end())
+            {
+                return false;
+            }
+            size_t ulIndex = FindPartition(it->second);
+            size_t ulLocal = 0;
+            m_vecPartitions[ulIndex]->m_stBoard.GetRank(svMember, true, ulLocal);
+            size_t ulRevRank = CountAbove(ulIndex) + ulLocal;
+            ulRank = bReverse ? ulRevRank : m_mapMemberScore.size() - 1 - ulRevRank;
+            return true;
+        }
+
+        // 按排名区间查询，bReverse 为true时按分数从高到低；整段落在区间外的分区按成员数直接跳过
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            vecOut.clear();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, m_mapMemberScore.size(), ulFirst, ulLast))
+            {
+                return;
+            }
+            std::vector<RankEntry> vecPart;
+            size_t ulBase = 0;// 当前分区之前(按查询方向)的成员数
+            for (size_t i = 0; i < m_vecPartitions.size() && ulBase <= ulLast; ++i)
+            {
+                LocalLeaderboard& stBoard = m_vecPartitions[bReverse ? m_vecPartitions.size() - 1 - i : i]->m_stBoard;
+                size_t ulSize = stBoard.Size();
+                if (ulBase + ulSize > ulFirst)
+                {
+                    size_t ulLocalFirst = ulFirst > ulBase ? ulFirst - ulBase : 0;
+                    size_t ulLocalLast = std::min(ulLast - ulBase, ulSize - 1);
+                    stBoard.GetRange(static_cast<int64_t>(ulLocalFirst), static_cast<int64_t>(ulLocalLast), bReverse, vecPart);
+                    vecOut.insert(vecOut.end(), std::make_move_iterator(vecPart.begin()), std::make_move_iterator(vecPart.end()));
+                }
+                ulBase += ulSize;
+            }
+        }
+
+        // 统计分数在 [stMin, stMax] 内的成员数，完全落在区间内的分区直接取成员数
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            size_t ulCount = 0;
+            for (size_t i = 0; i < m_vecPartitions.size(); ++i)
+            {
+                double dLow = m_vecPartitions[i]->m_dLow;
+                double dHigh = GetHigh(i);
+                LocalLeaderboard& stBoard = m_vecPartitions[i]->m_stBoard;
+                if (stBoard.Size() == 0 || dHigh <= stMin.m_dValue || dLow > stMax.m_dValue)
+                {
+                    continue;
+                }
+                // 分区不含上界，上界不超过 stMax 时分区内的分数都小于 stMax
+                bool bLowInside = dLow > stMin.m_dValue || (dLow == stMin.m_dValue && !stMin.m_bExclusive);
+                bool bHighInside = dHigh <= stMax.m_dValue;
+                ulCount += bLowInside && bHighInside ? stBoard.Size() : stBoard.Count(stMin, stMax);
+            }
+            return ulCount;
+        }
+
+        // 在榜成员数
+        size_t Size() const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_mapMemberScore.size();
+        }
+
+        // 分区目录：各分区的分数区间和成员数，按分数从低到高
+        std::vector<PartitionInfo> GetDirectory() const
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            std::vector<PartitionInfo> vecInfo;
+            for (size_t i = 0; i < m_vecPartitions.size(); ++i)
+            {
+                const Partition& stPartition = *m_vecPartitions[i];
+                vecInfo.push_back(PartitionInfo{ stPartition.m_dLow, GetHigh(i), stPartition.m_stBoard.Size(), stPartition.m_ulWrites });
+            }
+            return vecInfo;
+        }
+
+        // 在线拆分分区：按中位数分数把分区一分为二，拆分期间读写照常进行
+        // 1. 持读锁选出新边界并开始记录源分区的写入日志
+        // 2. 按排名分块复制源分区，每块持一次读锁，写入最多等待复制一块；块与块之间的写入会让排名移动，
+        //    每条日志至多让未写入的成员移动一名，下一块从回退日志增量后的位置开始，不会漏掉成员，重复复制的成员分数相同
+        // 3. 持读锁分几轮重放日志追赶写入，直到积压足够少
+        // 4. 持写锁重放最后的日志并替换分区目录，切换只涉及积压的少量成员
+        // 新分区是独立的跳表排行榜，切换前可以在任意线程上建立
+        // 所有成员分数相同、无法按分数拆开时返回false
+        bool SplitPartition(size_t ulIndex)
+        {
+            std::lock_guard<Mutex> stSplitLock(m_stSplitMutex);
+            std::vector<RankEntry> vecEntries;
+            double dHigh = 0;// 源分区上界，拆分期间目录不变
+            Partition* pSource = nullptr;
+            auto pLower = std::make_unique<Partition>();
+            auto pUpper = std::make_unique<Partition>();
+            {
+                std::shared_lock<Mutex> stLock(m_stMutex);
+                if (ulIndex >= m_vecPartitions.size())
+                {
+                    return false;
+                }
+                pSource = m_vecPartitions[ulIndex].get();
+                LocalLeaderboard& stSource = pSource->m_stBoard;
+                size_t ulSize = stSource.Size();
+                if (ulSize == 0)
+                {
+                    return false;
+                }
+                // 中位数分数作为新边界；与最低分相同时取第一个更高的分数，保证两边都有成员
+                stSource.GetRange(static_cast<int64_t>(ulSize / 2), static_cast<int64_t>(ulSize / 2), false, vecEntries);
+                double dSplit = vecEntries[0].m_dScore;
+                stSource.GetRange(0, 0, false, vecEntries);
+                if (vecEntries[0].m_dScore == dSplit)
+                {
+                    ScoreBound stMin{ -std::numeric_limits<double>::infinity(), false };
+                    ScoreBound stMax{ dSplit, false };
+                    size_t ulNotAbove = stSource.Count(stMin, stMax);
+                    if (ulNotAbove >= ulSize)
+                    {
+                        return false;
+                    }
+                    stSource.GetRange(static_cast<int64_t>(ulNotAbove), static_cast<int64_t>(ulNotAbove), false, vecEntries);
+                    dSplit = vecEntries[0].m_dScore;
+                }
+                dHigh = GetHigh(ulIndex);
+                pLower->m_dLow = pSource->m_dLow;
+                pUpper->m_dLow = dSplit;
+                // 写入方持写锁时才读这两个成员，持读锁修改不会与其冲突
+                m_pSplitSource = pSource;
+                m_vecSplitLog.clear();
+            }
+
+            // 复制顺序为分数升序、同分按原排名，新分区中同分成员的相对顺序不变
+            size_t ulCursor = 0;
+            size_t ulLogSeen = 0;
+            size_t ulChunk = SPLIT_COPY_CHUNK;
+            for (;;)
+            {
+                {
+                    std::shared_lock<Mutex> stLock(m_stMutex);
+                    size_t ulGrowth = m_vecSplitLog.size() - ulLogSeen;
+                    ulLogSeen = m_vecSplitLog.size();
+                    if (ulGrowth >= ulChunk)
+                    {
+                        // 写入太快，回退抵消了整块进度，加大块长保证复制终止
+                        ulChunk *= 2;
+                    }
+                    ulCursor -= std::min(ulCursor, ulGrowth);
+                    if (ulCursor >= pSource->m_stBoard.Size())
+                    {
+                        break;
+                    }
+                    pSource->m_stBoard.GetRange(static_cast<int64_t>(ulCursor), static_cast<int64_t>(ulCursor + ulChunk - 1), false, vecEntries);
+                }
+                ulCursor += vecEntries.size();
+                for (const RankEntry& stEntry : vecEntries)
+                {
+                    (stEntry.m_dScore < pUpper->m_dLow ? *pLower : *pUpper).m_stBoard.Add(stEntry.m_strMember, stEntry.m_dScore);
+                }
+            }
+            vecEntries.clear();
+
+            std::vector<std::string> vecLog;
+            for (int iRound = 0; iRound < SPLIT_MAX_CATCHUP; ++iRound)
+            {
+                std::shared_lock<Mutex> stLock(m_stMutex);
+                if (m_vecSplitLog.size() < SPLIT_CUTOVER_LOG)
+                {
+                    break;
+                }
+                vecLog.clear();
+                vecLog.swap(m_vecSplitLog);
+                ReplaySplitLog(vecLog, dHigh, *pLower, *pUpper);
+            }
+
+            std::unique_ptr<Partition> pRetired;
+            {
+                std::unique_lock<Mutex> stLock(m_stMutex);
+                ReplaySplitLog(m_vecSplitLog, dHigh, *pLower, *pUpper);
+                size_t ulSource = FindPartition(pLower->m_dLow);
+                pRetired = std::move(m_vecPartitions[ulSource]);
+                pLower->m_ulWrites = pRetired->m_ulWrites / 2;
+                pUpper->m_ulWrites = pRetired->m_ulWrites - pLower->m_ulWrites;
+                m_vecPartitions[ulSource] = std::move(pLower);
+                m_vecPartitions.insert(m_vecPartitions.begin() + static_cast<std::ptrdiff_t>(ulSource) + 1, std::move(pUpper));
+                m_pSplitSource = nullptr;
+                m_vecSplitLog.clear();
+            }
+            // 旧分区在锁外释放
+            return true;
+        }
+
+        // 拆分热点分区：选出上次调用以来写入最多且成员数不少于 ulMinSize 的分区拆分，并清零各分区的写入计数
+        // 由后台线程定期调用；没有合适的分区或拆分失败时返回false
+        bool SplitHottest(size_t ulMinSize)
+        {
+            size_t ulHot = 0;
+            uint64_t ulMaxWrites = 0;
+            {
+                std::unique_lock<Mutex> stLock(m_stMutex);
+                for (size_t i = 0; i < m_vecPartitions.size(); ++i)
+                {
+                    Partition& stPartition = *m_vecPartitions[i];
+                    if (stPartition.m_ulWrites > ulMaxWrites && stPartition.m_stBoard.Size() >= std::max<size_t>(ulMinSize, 2))
+                    {
+                        ulHot = i;
+                        ulMaxWrites = stPartition.m_ulWrites;
+                    }
+                    stPartition.m_ulWrites = 0;
+                }
+            }
+            // 其他线程先完成拆分时下标会指向相邻分区，拆分它同样合法
+            return ulMaxWrites > 0 && SplitPartition(ulHot);
+        }
+};
+
+// 多线程共享的分区排行榜
+using PartitionedLeaderboard = RangePartitionedBoard<ConcurrentAccess>;
+// 只由一个线程访问的分区排行榜
+using LocalPartitionedLeaderboard = RangePartitionedBoard<SingleThreadAccess>;
@@ -0,0 +1,390 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GAMERANKING_RANK_INDEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "skiplist.h"
+
+// 排行榜排序键：分数降序，分数相同按成员编号升序
+// 降序排列使榜首位于跳表头部，前N名查询只需从头遍历
+struct RankKey
+{
+    double   m_dScore = 0;  // 分数
+    uint64_t m_ulMember = 0;// 成员编号
+
+    bool operator<(const RankKey& stOther) const
+    {
+        if (m_dScore != stOther.m_dScore)
+        {
+            return m_dScore > stOther.m_dScore;
+        }
+        return m_ulMember < stOther.m_ulMember;
+    }
+
+    bool operator==(const RankKey& stOther) const
+    {
+        return m_dScore == stOther.m_dScore && m_ulMember == stOther.m_ulMember;
+    }
+};
+
+// 统计数组中大于 dValue 的元素个数，SSE2 每次比较两个分数，用掩码计数，没有分支
+inline size_t CountGreater(const double* pdValues, size_t ulCount, double dValue)
+{
+    size_t ulResult = 0;
+    size_t i = 0;
+#if defined(GAMERANKING_RANK_INDEX_SSE2)
+    static const uint8_t s_aucBits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };// 4位掩码中1的个数
+    const __m128d stKey = _mm_set1_pd(dValue);
+    for (; i + 4 <= ulCount; i += 4)
+    {
+        int iMaskLow = _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(pdValues + i), stKey));
+        int iMaskHigh = _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(pdValues + i + 2), stKey));
+        ulResult += s_aucBits[iMaskLow | (iMaskHigh << 2)];
+    }
+#endif
+    for (; i < ulCount; ++i)
+    {
+        ulResult += pdValues[i] > dValue ? 1 : 0;
+    }
+    return ulResult;
+}
+
+// 排行榜的排名索引：成员不多时存成紧凑的有序数组，超过 COMPACT_MAX 个后转为跳表，之后不再转回
+// 大量只有几十名成员的小排行榜(公会、对局、好友圈)若各持有一个跳表，头尾哨兵节点的 MAXLEVEL+1 层指针、
+// 填充和随机数生成器状态就有好几KB；有序数组只占成员数 x 16 字节，分数单独连续存放，定位时用 SIMD 扫描
+// 对外提供排行榜用到的跳表接口，值必须等于键中的成员编号(紧凑形式只存一份)；
+// 有序数组没有无锁读，修改必须与读取互斥(排行榜的读写锁保证这一点)，只有 Size 可以不加锁读取，
+// 它通过 m_pPublished 而不是 m_pList 得知是否已转为跳表
+template<typename Access>
+class RankIndex
+{
+    public:
+        // 紧凑数组最多容纳的成员数
+        static constexpr size_t COMPACT_MAX = 128;
+
+    private:
+        using List = SkipList<RankKey, uint64_t, Access>;
+
+        std::vector<double>   m_vecScores;// 紧凑形式：按排序键升序(分数降序)排列的分数
+        std::vector<uint64_t> m_vecIds;   // 紧凑形式：与分数一一对应的成员编号
+        std::unique_ptr<List> m_pList;    // 转为跳表后的索引，之前为空
+        NodeArena*            m_pArena = nullptr;// 转为跳表时使用的节点内存池
+        std::atomic<size_t>   m_ulCompactSize{ 0 };// 紧凑形式的成员数，供不加锁读取
+        std::atomic<const List*> m_pPublished{ nullptr };// 装好数据后发布的跳表，供不加锁读取
+
+        // 紧凑形式中严格小于 stKey 的键数，即 stKey 应在的位置
+        size_t LowerBound(const RankKey& stKey) const
+        {
+            size_t ulPos = CountGreater(m_vecScores.data(), m_vecScores.size(), stKey.m_dScore);
+            while (ulPos < m_vecScores.size() && m_vecScores[ulPos] == stKey.m_dScore && m_vecIds[ulPos] < stKey.m_ulMember)
+            {
+                ++ulPos;
+            }
+            return ulPos;
+        }
+
+        void PublishCompactSize()
+        {
+            m_ulCompactSize.store(m_vecScores.size(), std::memory_order_relaxed);
+        }
+
+        // 按序追加到新跳表，O(n)；之后释放紧凑数组
+        // 先发布装好的跳表再把紧凑成员数清零，不加锁的 Size 读到清零时一定也能读到跳表
+        void Promote()
+        {
+            auto pList = std::make_unique<List>();
+            if (m_pArena != nullptr)
+            {
+                pList->SetArena(m_pArena);
+            }
+            BulkCursor<RankKey, uint64_t> stCursor;
+            pList->BeginBulkLoad(stCursor);
+            for (size_t i = 0; i < m_vecScores.size(); ++i)
+            {
+                pList->AppendSorted(stCursor, RankKey{ m_vecScores[i], m_vecIds[i] }, m_vecIds[i]);
+            }
+            pList->EndBulkLoad(stCursor);
+            m_pList = std::move(pList);
+            m_pPublished.store(m_pList.get(), std::memory_order_release);
+            std::vector<double>().swap(m_vecScores);
+            std::vector<uint64_t>().swap(m_vecIds);
+            m_ulCompactSize.store(0, std::memory_order_release);
+        }
+
+        // 删除紧凑形式中 [ulBegin, ulEnd) 的键
+        template<typename Fn>
+        size_t EraseCompact(size_t ulBegin, size_t ulEnd, Fn&& fn)
+        {
+            for (size_t i = ulBegin; i < ulEnd; ++i)
+            {
+                fn(RankKey{ m_vecScores[i], m_vecIds[i] }, m_vecIds[i]);
+            }
+            m_vecScores.erase(m_vecScores.begin() + static_cast<std::ptrdiff_t>(ulBegin), m_vecScores.begin() + static_cast<std::ptrdiff_t>(ulEnd));
+            m_vecIds.erase(m_vecIds.begin() + static_cast<std::ptrdiff_t>(ulBegin), m_vecIds.begin() + static_cast<std::ptrdiff_t>(ulEnd));
+            PublishCompactSize();
+            return ulEnd - ulBegin;
+        }
+
+    public:
+        RankIndex() = default;
+        RankIndex(const RankIndex&) = delete;
+        RankIndex& operator=(const RankIndex&) = delete;
+
+        // 是否已转为跳表
+        bool IsPromoted() const
+        {
+            return m_pList != nullptr;
+        }
+
+        // 插入键，键已存在时更新值
+        bool Insert(const RankKey& stKey, uint64_t ulValue)
+        {
+            if (m_pList == nullptr && m_vecScores.size() >= COMPACT_MAX)
+            {
+                Promote();
+            }
+            if (m_pList != nullptr)
+            {
+                return m_pList->Insert(stKey, ulValue);
+            }
+            size_t ulPos = LowerBound(stKey);
+            if (ulPos < m_vecScores.size() && m_vecScores[ulPos] == stKey.m_dScore && m_vecIds[ulPos] == stKey.m_ulMember)
+            {
+                return true;
+            }
+            m_vecScores.insert(m_vecScores.begin() + static_cast<std::ptrdiff_t>(ulPos), stKey.m_dScore);
+            m_vecIds.insert(m_vecIds.begin() + static_cast<std::ptrdiff_t>(ulPos), stKey.m_ulMember);
+            PublishCompactSize();
+            return true;
+        }
+
+        bool Remove(const RankKey& stKey)
+        {
+            if (m_pList != nullptr)
+            {
+                return m_pList->Remove(stKey);
+            }
+            size_t ulPos = LowerBound(stKey);
+            if (ulPos == m_vecScores.size() || m_vecScores[ulPos] != stKey.m_dScore || m_vecIds[ulPos] != stKey.m_ulMember)
+            {
+                return false;
+            }
+            m_vecScores.erase(m_vecScores.begin() + static_cast<std::ptrdiff_t>(ulPos));
+            m_vecIds.erase(m_vecIds.begin() + static_cast<std::ptrdiff_t>(ulPos));
+            PublishCompactSize();
+            return true;
+        }
+
+        // 批量插入，元素为 (键, 值)，键需按升序排列
+        // 空的紧凑索引一次装入超过 COMPACT_MAX 个键时(从快照恢复)，新建的跳表逐层直接追加，O(n)
+        template<typename It>
+        void InsertSorted(It first, It last)
+        {
+            if (m_pList == nullptr && m_vecScores.size() + static_cast<size_t>(std::distance(first, last)) > COMPACT_MAX)
+            {
+                bool bEmpty = m_vecScores.empty();
+                Promote();
+                if (bEmpty)
+                {
+                    BulkCursor<RankKey, uint64_t> stCursor;
+                    m_pList->BeginBulkLoad(stCursor);
+                    for (; first != last; ++first)
+                    {
+                        m_pList->AppendSorted(stCursor, first->first, first->second);
+                    }
+                    m_pList->EndBulkLoad(stCursor);
+                    return;
+                }
+            }
+            if (m_pList != nullptr)
+            {
+                m_pList->InsertSorted(first, last);
+                return;
+            }
+            for (; first != last; ++first)
+            {
+                Insert(first->first, first->second);
+            }
+        }
+
+        // 批量删除，键需按升序排列，返回实际删除的个数
+        template<typename It>
+        size_t RemoveSorted(It first, It last)
+        {
+            if (m_pList != nullptr)
+            {
+                return m_pList->RemoveSorted(first, last);
+            }
+            size_t ulRemoved = 0;
+            for (; first != last; ++first)
+            {
+                ulRemoved += Remove(*first) ? 1 : 0;
+            }
+            return ulRemoved;
+        }
+
+        // 删除键在 [stLo, stHi] 内的全部键，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveRange(const RankKey& stLo, const RankKey& stHi, Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                return m_pList->RemoveRange(stLo, stHi, fn);
+            }
+            size_t ulBegin = LowerBound(stLo);
+            size_t ulEnd = ulBegin;
+            while (ulEnd < m_vecScores.size() && !(stHi < RankKey{ m_vecScores[ulEnd], m_vecIds[ulEnd] }))
+            {
+                ++ulEnd;
+            }
+            return EraseCompact(ulBegin, ulEnd, fn);
+        }
+
+        // 删除按键升序的第 ulFirst 到第 ulLast 个键(从0开始，含两端)，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveRankRange(size_t ulFirst, size_t ulLast, Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                return m_pList->RemoveRankRange(ulFirst, ulLast, fn);
+            }
+            if (ulFirst > ulLast || ulFirst >= m_vecScores.size())
+            {
+                return 0;
+            }
+            return EraseCompact(ulFirst, ulLast < m_vecScores.size() ? ulLast + 1 : m_vecScores.size(), fn);
+        }
+
+        // 取最大的键，索引为空时返回false
+        bool GetLast(RankKey& stKey)
+        {
+            if (m_pList != nullptr)
+            {
+                uint64_t ulValue = 0;
+                return m_pList->GetLast(stKey, ulValue);
+            }
+            if (m_vecScores.empty())
+            {
+                return false;
+            }
+            stKey = RankKey{ m_vecScores.back(), m_vecIds.back() };
+            return true;
+        }
+
+        // 删除最大的 ulCount 个键，对每个删除的键调用 fn(键, 值)，返回删除的个数
+        template<typename Fn>
+        size_t RemoveLast(size_t ulCount, Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                return m_pList->RemoveLast(ulCount, fn);
+            }
+            size_t ulSize = m_vecScores.size();
+            return EraseCompact(ulSize - std::min(ulCount, ulSize), ulSize, fn);
+        }
+
+        // 按键升序遍历，回调返回false时提前结束
+        template<typename Fn>
+        void ForEach(Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                m_pList->ForEach(fn);
+                return;
+            }
+            for (size_t i = 0; i < m_vecScores.size(); ++i)
+            {
+                if (!fn(RankKey{ m_vecScores[i], m_vecIds[i] }, m_vecIds[i]))
+                {
+                    return;
+                }
+            }
+        }
+
+        // 从第一个不小于 stKey 的键开始按升序遍历，回调返回false时提前结束
+        template<typename Fn>
+        void ForEachFrom(const RankKey& stKey, Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                m_pList->ForEachFrom(stKey, fn);
+                return;
+            }
+            for (size_t i = LowerBound(stKey); i < m_vecScores.size(); ++i)
+            {
+                if (!fn(RankKey{ m_vecScores[i], m_vecIds[i] }, m_vecIds[i]))
+                {
+                    return;
+                }
+            }
+        }
+
+        // 从按键升序的第 ulRank 个键(从0开始)起按升序遍历，回调返回false时提前结束
+        template<typename Fn>
+        void ForEachFromRank(size_t ulRank, Fn&& fn)
+        {
+            if (m_pList != nullptr)
+            {
+                m_pList->ForEachFromRank(ulRank, fn);
+                return;
+            }
+            for (size_t i = ulRank; i < m_vecScores.size(); ++i)
+            {
+                if (!fn(RankKey{ m_vecScores[i], m_vecIds[i] }, m_vecIds[i]))
+                {
+                    return;
+                }
+            }
+        }
+
+        // 严格小于 stKey 的键数
+        size_t GetRank(const RankKey& stKey)
+        {
+            return m_pList != nullptr ? m_pList->GetRank(stKey) : LowerBound(stKey);
+        }
+
+        // 可以不加锁调用：紧凑成员数读到转换时的清零说明跳表已发布，再读一次发布指针即可
+        size_t Size() const
+        {
+            const List* pList = m_pPublished.load(std::memory_order_acquire);
+            if (pList == nullptr)
+            {
+                size_t ulSize = m_ulCompactSize.load(std::memory_order_acquire);
+                pList = m_pPublished.load(std::memory_order_acquire);
+                if (pList == nullptr)
+                {
+                    return ulSize;
+                }
+            }
+            return pList->Size();
+        }
+
+        // 回收跳表中已摘除的节点，紧凑形式无需回收
+        void ReclaimRetired()
+        {
+            if (m_pList != nullptr)
+            {
+                m_pList->ReclaimRetired();
+            }
+        }
+
+        // 设置转为跳表后的节点内存池，只能在索引为空时调用
+        bool SetArena(NodeArena* pArena)
+        {
+            if (Size() != 0)
+            {
+                return false;
+            }
+            m_pArena = pArena;
+            return m_pList == nullptr || m_pList->SetArena(pArena);
+        }
+};
@@ -0,0 +1,940 @@
+#include "ranking_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "board_snapshot.h"
+#include "resp.h"
+
+// 命令表，按名字线性查找，命令数量很少
+const RankingService::CommandEntry RankingService::s_astCommands[] =
+{
+    { "PING",             &RankingService::CmdPing,             -1, false, EWriteCommand::None },
+    { "ZADD",             &RankingService::CmdZAdd,             -4, true,  EWriteCommand::ZAdd },
+    { "ZINCRBY",          &RankingService::CmdZIncrBy,           4, true,  EWriteCommand::ZIncrBy },
+    { "ZRANK",            &RankingService::CmdZRank,             3, true,  EWriteCommand::None },
+    { "ZREVRANK",         &RankingService::CmdZRevRank,          3, true,  EWriteCommand::None },
+    { "ZSCORE",           &RankingService::CmdZScore,            3, true,  EWriteCommand::None },
+    { "ZRANGE",           &RankingService::CmdZRange,           -4, true,  EWriteCommand::None },
+    { "ZREVRANGE",        &RankingService::CmdZRevRange,        -4, true,  EWriteCommand::None },
+    { "ZCOUNT",           &RankingService::CmdZCount,            4, true,  EWriteCommand::None },
+    { "ZREM",             &RankingService::CmdZRem,             -3, true,  EWriteCommand::ZRem },
+    { "ZCARD",            &RankingService::CmdZCard,             2, true,  EWriteCommand::None },
+    { "ZREMRANGEBYSCORE", &RankingService::CmdZRemRangeByScore,  4, true,  EWriteCommand::None },
+    { "ZREMRANGEBYRANK",  &RankingService::CmdZRemRangeByRank,   4, true,  EWriteCommand::None },
+    { "ZTRANSFORM",       &RankingService::CmdZTransform,        4, true,  EWriteCommand::None },
+    { "ZCAPACITY",        &RankingService::CmdZCapacity,        -2, true,  EWriteCommand::None },
+};
+
+static const char* const ERR_NOT_FLOAT = "ERR value is not a valid float";
+static const char* const ERR_NOT_INTEGER = "ERR value is not an integer or out of range";
+static const char* const ERR_SYNTAX = "ERR syntax error";
+
+// 解析 ZCOUNT 的区间端点，"(" 前缀表示开区间
+static bool ParseScoreBound(std::string_view svArg, ScoreBound& stBound)
+{
+    stBound.m_bExclusive = !svArg.empty() && svArg[0] == '(';
+    if (stBound.m_bExclusive)
+    {
+        svArg.remove_prefix(1);
+    }
+    return RespParseDouble(svArg, stBound.m_dValue);
+}
+
+// 单调时钟的毫秒数，用于判断排行榜闲置时间
+static int64_t GetSteadyMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* const COLD_FILE_SUFFIX = ".board";
+// 冷榜文件名为排行榜名的十六进制编码，名字最长 COLD_NAME_MAX 字节，保证文件名不超过常见文件系统的 255 字节限制
+static const size_t COLD_NAME_MAX = 120;
+
+static std::string EncodeColdFileName(std::string_view svName)
+{
+    static const char s_szHex[] = "0123456789abcdef";
+    if (svName.empty() || svName.size() > COLD_NAME_MAX)
+    {
+        return std::string();
+    }
+    std::string strFile;
+    strFile.reserve(svName.size() * 2 + strlen(COLD_FILE_SUFFIX));
+    for (char c : svName)
+    {
+        strFile.push_back(s_szHex[static_cast<uint8_t>(c) >> 4]);
+        strFile.push_back(s_szHex[static_cast<uint8_t>(c) & 0xF]);
+    }
+    strFile.append(COLD_FILE_SUFFIX);
+    return strFile;
+}
+
+static bool DecodeColdFileName(std::string_view svFile, std::string& strName)
+{
+    size_t ulSuffix = strlen(COLD_FILE_SUFFIX);
+    if (svFile.size() <= ulSuffix || svFile.substr(svFile.size() - ulSuffix) != COLD_FILE_SUFFIX || (svFile.size() - ulSuffix) % 2 != 0)
+    {
+        return false;
+    }
+    auto HexValue = [](char c)
+    {
+        return c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1);
+    };
+    strName.clear();
+    for (size_t i = 0; i + ulSuffix < svFile.size(); i += 2)
+    {
+        int iHigh = HexValue(svFile[i]);
+        int iLow = HexValue(svFile[i + 1]);
+        if (iHigh < 0 || iLow < 0)
+        {
+            return false;
+        }
+        strName.push_back(static_cast<char>(iHigh << 4 | iLow));
+    }
+    return true;
+}
+
+const RankingService::CommandEntry* RankingService::LookupCommand(std::string_view svName)
+{
+    for (const CommandEntry& stEntry : s_astCommands)
+    {
+        if (RespEqualsIgnoreCase(svName, stEntry.m_szName))
+        {
+            return &stEntry;
+        }
+    }
+    return nullptr;
+}
+
+bool RankingService::CheckArity(const CommandEntry& stEntry, const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    int iArgc = static_cast<int>(vecArgs.size());
+    if ((stEntry.m_iArity > 0 && iArgc != stEntry.m_iArity) || (stEntry.m_iArity < 0 && iArgc < -stEntry.m_iArity))
+    {
+        std::string strError = "ERR wrong number of arguments for '";
+        strError.append(vecArgs[0]);
+        strError += "' command";
+        RespAppendError(strOut, strError);
+        return false;
+    }
+    return true;
+}
+
+bool RankingService::GetCommandBoard(const std::vector<std::string_view>& vecArgs, std::string_view& svBoard)
+{
+    const CommandEntry* pEntry = vecArgs.empty() ? nullptr : LookupCommand(vecArgs[0]);
+    if (pEntry == nullptr || !pEntry->m_bBoard || vecArgs.size() < 2)
+    {
+        return false;
+    }
+    svBoard = vecArgs[1];
+    return true;
+}
+
+bool RankingService::Execute(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    if (vecArgs.empty())
+    {
+        return true;
+    }
+    if (RespEqualsIgnoreCase(vecArgs[0], "QUIT"))
+    {
+        RespAppendSimple(strOut, "OK");
+        return false;
+    }
+    const CommandEntry* pEntry = LookupCommand(vecArgs[0]);
+    if (pEntry == nullptr)
+    {
+        std::string strError = "ERR unknown command '";
+        strError.append(vecArgs[0].substr(0, 128));
+        strError += "'";
+        RespAppendError(strOut, strError);
+        return true;
+    }
+    if (CheckArity(*pEntry, vecArgs, strOut))
+    {
+        (this->*pEntry->m_pfnHandler)(vecArgs, strOut);
+    }
+    return true;
+}
+
+bool RankingService::Execute(const std::vector<std::string_view>& vecArgs, ReplyBuffer& stReplies)
+{
+    size_t ulSlot = stReplies.m_vecSlots.size();
+    stReplies.m_vecSlots.emplace_back();
+    const CommandEntry* pEntry = vecArgs.empty() ? nullptr : LookupCommand(vecArgs[0]);
+    if (pEntry != nullptr && pEntry->m_pfnHandler == &RankingService::CmdZRevRange && vecArgs.size() >= 2)
+    {
+        std::shared_ptr<const std::string> pTopReply = GetTopReply(vecArgs);
+        if (pTopReply != nullptr)
+        {
+            stReplies.SetShared(ulSlot, std::move(pTopReply));
+            return true;
+        }
+    }
+    size_t ulOffset = stReplies.m_strData.size();
+    bool bKeepOpen = Execute(vecArgs, stReplies.m_strData);
+    stReplies.SetReply(ulSlot, ulOffset);
+    return bKeepOpen;
+}
+
+bool RankingService::ExecuteBatch(const CommandBatch& stBatch, ReplyBuffer& stReplies)
+{
+    stReplies.Reset(stBatch.m_ulCount);
+    m_vecBoardCommands.clear();
+
+    // QUIT 之后的命令不再执行
+    bool bKeepOpen = true;
+    size_t ulCount = stBatch.m_ulCount;
+    for (size_t i = 0; i < stBatch.m_ulCount; ++i)
+    {
+        if (!stBatch.m_vecCommands[i].empty() && RespEqualsIgnoreCase(stBatch.m_vecCommands[i][0], "QUIT"))
+        {
+            ulCount = i + 1;
+            bKeepOpen = false;
+            break;
+        }
+    }
+    stReplies.m_vecSlots.resize(ulCount);
+
+    // 与排行榜无关或参数有误的命令直接执行，其余按排行榜分组
+    for (size_t i = 0; i < ulCount; ++i)
+    {
+        const std::vector<std::string_view>& vecArgs = stBatch.m_vecCommands[i];
+        const CommandEntry* pEntry = vecArgs.empty() ? nullptr : LookupCommand(vecArgs[0]);
+        if (pEntry != nullptr && pEntry->m_bBoard && vecArgs.size() >= 2)
+        {
+            m_vecBoardCommands.push_back(i);
+            continue;
+        }
+        size_t ulOffset = stReplies.m_strData.size();
+        Execute(vecArgs, stReplies.m_strData);
+        stReplies.SetReply(i, ulOffset);
+    }
+    std::stable_sort(m_vecBoardCommands.begin(), m_vecBoardCommands.end(), [&](size_t a, size_t b)
+    {
+        return stBatch.m_vecCommands[a][1] < stBatch.m_vecCommands[b][1];
+    });
+
+    // 逐个排行榜执行，连续的写命令累积后一次提交，遇到读命令先提交之前的写
+    m_vecWriteOps.clear();
+    m_vecWriteReplies.clear();
+    std::string_view svCurrBoard;
+    for (size_t ulIndex : m_vecBoardCommands)
+    {
+        const std::vector<std::string_view>& vecArgs = stBatch.m_vecCommands[ulIndex];
+        const CommandEntry* pEntry = LookupCommand(vecArgs[0]);
+        if (vecArgs[1] != svCurrBoard)
+        {
+            FlushWrites(svCurrBoard, stReplies);
+            svCurrBoard = vecArgs[1];
+        }
+
+        size_t ulOffset = stReplies.m_strData.size();
+        if (CheckArity(*pEntry, vecArgs, stReplies.m_strData))
+        {
+            if (pEntry->m_eWrite != EWriteCommand::None)
+            {
+                PendingWriteReply stPending{ ulIndex, m_vecWriteOps.size(), 0, pEntry->m_eWrite, false };
+                if (ParseWriteOps(pEntry->m_eWrite, vecArgs, m_vecWriteOps, stPending.m_bCh, stReplies.m_strData))
+                {
+                    stPending.m_ulOpCount = m_vecWriteOps.size() - stPending.m_ulFirstOp;
+                    m_vecWriteReplies.push_back(stPending);
+                    continue;
+                }
+            }
+            else
+            {
+                FlushWrites(svCurrBoard, stReplies);
+                if (pEntry->m_pfnHandler == &RankingService::CmdZRevRange)
+                {
+                    std::shared_ptr<const std::string> pTopReply = GetTopReply(vecArgs);
+                    if (pTopReply != nullptr)
+                    {
+                        stReplies.SetShared(ulIndex, std::move(pTopReply));
+                        continue;
+                    }
+                }
+                ulOffset = stReplies.m_strData.size();
+                (this->*pEntry->m_pfnHandler)(vecArgs, stReplies.m_strData);
+            }
+        }
+        stReplies.SetReply(ulIndex, ulOffset);
+    }
+    FlushWrites(svCurrBoard, stReplies);
+    return bKeepOpen;
+}
+
+void RankingService::FlushWrites(std::string_view svBoard, ReplyBuffer& stReplies)
+{
+    if (m_vecWriteReplies.empty())
+    {
+        return;
+    }
+    bool bCreate = false;
+    for (const WriteOp& stOp : m_vecWriteOps)
+    {
+        bCreate = bCreate || stOp.m_eOp != EWriteOp::Remove;
+    }
+    LocalLeaderboard* pBoard = bCreate ? GetOrCreateBoard(svBoard) : FindBoard(svBoard);
+    if (pBoard != nullptr)
+    {
+        pBoard->ApplyBatch(m_vecWriteOps, m_vecWriteResults);
+    }
+    else
+    {
+        // 排行榜不存在时只有 ZREM，全部视为未删除
+        m_vecWriteResults.assign(m_vecWriteOps.size(), WriteResult{ EAddResult::Unchanged, false, 0 });
+    }
+    for (const PendingWriteReply& stPending : m_vecWriteReplies)
+    {
+        size_t ulOffset = stReplies.m_strData.size();
+        AppendWriteReply(stPending.m_eWrite, m_vecWriteResults.data() + stPending.m_ulFirstOp, stPending.m_ulOpCount, stPending.m_bCh, stReplies.m_strData);
+        stReplies.SetReply(stPending.m_ulCommand, ulOffset);
+    }
+    m_vecWriteOps.clear();
+    m_vecWriteReplies.clear();
+}
+
+bool RankingService::ParseWriteOps(EWriteCommand eWrite, const std::vector<std::string_view>& vecArgs, std::vector<WriteOp>& vecOps, bool& bCh, std::string& strOut)
+{
+    bCh = false;
+    if (eWrite == EWriteCommand::ZIncrBy)
+    {
+        // ZINCRBY key increment member
+        double dDelta = 0;
+        if (!RespParseDouble(vecArgs[2], dDelta))
+        {
+            RespAppendError(strOut, ERR_NOT_FLOAT);
+            return false;
+        }
+        vecOps.push_back(WriteOp{ EWriteOp::IncrBy, vecArgs[3], dDelta, AddOptions() });
+        return true;
+    }
+    if (eWrite == EWriteCommand::ZRem)
+    {
+        // ZREM key member [member ...]
+        for (size_t i = 2; i < vecArgs.size(); ++i)
+        {
+            vecOps.push_back(WriteOp{ EWriteOp::Remove, vecArgs[i], 0, AddOptions() });
+        }
+        return true;
+    }
+
+    // ZADD key [NX|XX] [GT|LT] [CH] score member [score member ...]
+    AddOptions stOptions;
+    size_t ulPos = 2;
+    for (; ulPos < vecArgs.size(); ++ulPos)
+    {
+        if (RespEqualsIgnoreCase(vecArgs[ulPos], "NX"))
+        {
+            stOptions.m_bNx = true;
+        }
+        else if (RespEqualsIgnoreCase(vecArgs[ulPos], "XX"))
+        {
+            stOptions.m_bXx = true;
+        }
+        else if (RespEqualsIgnoreCase(vecArgs[ulPos], "GT"))
+        {
+            stOptions.m_bGt = true;
+        }
+        else if (RespEqualsIgnoreCase(vecArgs[ulPos], "LT"))
+        {
+            stOptions.m_bLt = true;
+        }
+        else if (RespEqualsIgnoreCase(vecArgs[ulPos], "CH"))
+        {
+            bCh = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+    size_t ulPairs = vecArgs.size() - ulPos;
+    if (ulPairs == 0 || ulPairs % 2 != 0)
+    {
+        RespAppendError(strOut, ERR_SYNTAX);
+        return false;
+    }
+    if ((stOptions.m_bNx && stOptions.m_bXx) || (stOptions.m_bGt && stOptions.m_bLt) || (stOptions.m_bNx && (stOptions.m_bGt || stOptions.m_bLt)))
+    {
+        RespAppendError(strOut, "ERR GT, LT, and/or NX options at the same time are not compatible");
+        return false;
+    }
+
+    // 先校验全部分数，保证命令要么整体执行要么整体失败
+    size_t ulFirst = vecOps.size();
+    for (size_t i = ulPos; i < vecArgs.size(); i += 2)
+    {
+        double dScore = 0;
+        if (!RespParseDouble(vecArgs[i], dScore))
+        {
+            vecOps.resize(ulFirst);
+            RespAppendError(strOut, ERR_NOT_FLOAT);
+            return false;
+        }
+        vecOps.push_back(WriteOp{ EWriteOp::Add, vecArgs[i + 1], dScore, stOptions });
+    }
+    return true;
+}
+
+void RankingService::AppendWriteReply(EWriteCommand eWrite, const WriteResult* pResults, size_t ulCount, bool bCh, std::string& strOut)
+{
+    if (eWrite == EWriteCommand::ZIncrBy)
+    {
+        if (!pResults[0].m_bOk)
+        {
+            RespAppendError(strOut, "ERR resulting score is not a number (NaN)");
+            return;
+        }
+        RespAppendDouble(strOut, pResults[0].m_dScore);
+        return;
+    }
+    int64_t llCount = 0;
+    for (size_t i = 0; i < ulCount; ++i)
+    {
+        if (eWrite == EWriteCommand::ZRem)
+        {
+            llCount += pResults[i].m_bOk ? 1 : 0;
+        }
+        else if (pResults[i].m_eAdd == EAddResult::Added || (bCh && pResults[i].m_eAdd == EAddResult::Updated))
+        {
+            ++llCount;
+        }
+    }
+    RespAppendInteger(strOut, llCount);
+}
+
+void RankingService::ExecuteWrite(EWriteCommand eWrite, const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    m_vecWriteOps.clear();
+    bool bCh = false;
+    if (!ParseWriteOps(eWrite, vecArgs, m_vecWriteOps, bCh, strOut))
+    {
+        return;
+    }
+    LocalLeaderboard* pBoard = eWrite == EWriteCommand::ZRem ? FindBoard(vecArgs[1]) : GetOrCreateBoard(vecArgs[1]);
+    if (pBoard == nullptr)
+    {
+        RespAppendInteger(strOut, 0);
+        m_vecWriteOps.clear();
+        return;
+    }
+    pBoard->ApplyBatch(m_vecWriteOps, m_vecWriteResults);
+    AppendWriteReply(eWrite, m_vecWriteResults.data(), m_vecWriteResults.size(), bCh, strOut);
+    m_vecWriteOps.clear();
+}
+
+LocalLeaderboard* RankingService::FindBoard(std::string_view svName)
+{
+    BoardEntry* pEntry = FindEntry(svName);
+    return pEntry == nullptr ? nullptr : pEntry->m_pBoard.get();
+}
+
+LocalLeaderboard* RankingService::GetOrCreateBoard(std::string_view svName)
+{
+    LocalLeaderboard* pBoard = FindBoard(svName);
+    if (pBoard != nullptr)
+    {
+        return pBoard;
+    }
+    auto it = m_mapBoards.emplace(std::string(svName), std::make_unique<BoardEntry>()).first;
+    BoardEntry& stEntry = *it->second;
+    stEntry.m_pName = &it->first;
+    stEntry.m_pBoard.reset(new LocalLeaderboard());
+    InitBoard(*stEntry.m_pBoard, svName);
+    if (!m_strColdDir.empty())
+    {
+        stEntry.m_llLastAccess = GetSteadyMs();
+        stEntry.m_itHot = m_lstHot.insert(m_lstHot.begin(), &stEntry);
+    }
+    return stEntry.m_pBoard.get();
+}
+
+RankingService::BoardEntry* RankingService::FindEntry(std::string_view svName)
+{
+    auto it = m_mapBoards.find(svName);
+    if (it == m_mapBoards.end())
+    {
+        return nullptr;
+    }
+    BoardEntry& stEntry = *it->second;
+    if (!m_strColdDir.empty())
+    {
+        if (stEntry.m_pBoard == nullptr)
+        {
+            LoadColdBoard(stEntry);
+        }
+        else
+        {
+            m_lstHot.splice(m_lstHot.begin(), m_lstHot, stEntry.m_itHot);
+        }
+        stEntry.m_llLastAccess = GetSteadyMs();
+    }
+    return &stEntry;
+}
+
+void RankingService::InitBoard(LocalLeaderboard& stBoard, std::string_view svName)
+{
+    if (m_pArena != nullptr)
+    {
+        stBoard.SetArena(m_pArena);
+    }
+    if (m_pEventSink != nullptr)
+    {
+        stBoard.SetEventSink(m_pEventSink, svName);
+    }
+}
+
+void RankingService::SetEventSink(ScoreEventSink* pSink)
+{
+    m_pEventSink = pSink;
+    for (auto& stPair : m_mapBoards)
+    {
+        // 冷榜装回时再设置
+        if (stPair.second->m_pBoard != nullptr)
+        {
+            stPair.second->m_pBoard->SetEventSink(pSink, stPair.first);
+        }
+    }
+}
+
+void RankingService::SetNodeArena(NodeArena* pArena)
+{
+    m_pArena = pArena;
+}
+
+bool RankingService::SetColdTier(const std::string& strDir, uint32_t uiIdleSeconds, std::function<bool(std::string_view)> fnOwns)
+{
+    std::error_code stError;
+    std::filesystem::create_directories(strDir, stError);
+    if (!std::filesystem::is_directory(strDir, stError))
+    {
+        std::cerr << "cold board dir " << strDir << " is not available" << std::endl;
+        return false;
+    }
+    m_strColdDir = strDir;
+    m_llColdIdleMs = static_cast<int64_t>(uiIdleSeconds) * 1000;
+
+    // 已有的排行榜都视为刚访问过
+    int64_t llNow = GetSteadyMs();
+    m_lstHot.clear();
+    for (auto& stPair : m_mapBoards)
+    {
+        BoardEntry& stEntry = *stPair.second;
+        if (stEntry.m_pBoard != nullptr)
+        {
+            stEntry.m_llLastAccess = llNow;
+            stEntry.m_itHot = m_lstHot.insert(m_lstHot.end(), &stEntry);
+        }
+    }
+
+    // 登记目录中的冷榜文件，内存中已有同名排行榜时以内存为准，文件在下次转出时覆盖
+    for (const auto& stFile : std::filesystem::directory_iterator(strDir, stError))
+    {
+        std::string strFile = stFile.path().filename().string();
+        std::string strName;
+        if (!DecodeColdFileName(strFile, strName) || (fnOwns && !fnOwns(strName)) || m_mapBoards.count(strName) != 0)
+        {
+            continue;
+        }
+        auto it = m_mapBoards.emplace(std::move(strName), std::make_unique<BoardEntry>()).first;
+        it->second->m_pName = &it->first;
+        ++m_ulColdCount;
+    }
+    return true;
+}
+
+size_t RankingService::EvictIdleBoards()
+{
+    if (m_strColdDir.empty())
+    {
+        return 0;
+    }
+    int64_t llNow = GetSteadyMs();
+    size_t ulEvicted = 0;
+    // 表尾是最久未访问的排行榜，遇到未超时的即可停止
+    for (size_t i = 0; i < COLD_EVICT_BATCH && !m_lstHot.empty(); ++i)
+    {
+        BoardEntry& stEntry = *m_lstHot.back();
+        if (llNow - stEntry.m_llLastAccess < m_llColdIdleMs)
+        {
+            break;
+        }
+        if (stEntry.m_pBoard->Size() == 0 && stEntry.m_pBoard->GetCapacity() == 0)
+        {
+            // 空榜与不存在的排行榜对外没有区别，直接删掉；设置了容量的空榜要保留容量，照常写成冷榜
+            m_lstHot.pop_back();
+            m_mapBoards.erase(m_mapBoards.find(*stEntry.m_pName));
+            ++ulEvicted;
+            continue;
+        }
+        if (!EvictBoard(stEntry))
+        {
+            // 写不出去的排行榜留在内存，重新计时，避免每次都重试；写盘失败多半是磁盘或目录的问题，本轮不再继续
+            stEntry.m_llLastAccess = llNow;
+            m_lstHot.splice(m_lstHot.begin(), m_lstHot, stEntry.m_itHot);
+            break;
+        }
+        ++ulEvicted;
+    }
+    return ulEvicted;
+}
+
+size_t RankingService::GetColdBoardCount() const
+{
+    return m_ulColdCount;
+}
+
+std::string RankingService::GetColdPath(std::string_view svName) const
+{
+    std::string strFile = EncodeColdFileName(svName);
+    return strFile.empty() ? std::string() : m_strColdDir + "/" + strFile;
+}
+
+bool RankingService::EvictBoard(BoardEntry& stEntry)
+{
+    std::string strPath = GetColdPath(*stEntry.m_pName);
+    if (strPath.empty())
+    {
+        return false;
+    }
+    // 文件和目录都已落盘才释放排行榜，否则掉电后内存和磁盘上都没有这个排行榜
+    ESnapshotResult eResult = SaveBoardSnapshot(*stEntry.m_pBoard, strPath);
+    if (eResult != ESnapshotResult::Ok)
+    {
+        std::cerr << "evict board " << *stEntry.m_pName << ": " << SnapshotResultString(eResult) << std::endl;
+        return false;
+    }
+    m_lstHot.erase(stEntry.m_itHot);
+    stEntry.m_pBoard.reset();
+    // 装回的排行榜版本号从头计数，旧缓存不能再用版本号判断是否有效
+    stEntry.m_stTopCache = TopReplyCache();
+    ++m_ulColdCount;
+    return true;
+}
+
+void RankingService::LoadColdBoard(BoardEntry& stEntry)
+{
+    // 先设置内存池，装载完再设置接收者，装回不产生分数事件
+    stEntry.m_pBoard.reset(new LocalLeaderboard());
+    if (m_pArena != nullptr)
+    {
+        stEntry.m_pBoard->SetArena(m_pArena);
+    }
+    std::string strPath = GetColdPath(*stEntry.m_pName);
+    ESnapshotResult eResult = LoadBoardSnapshot(strPath, *stEntry.m_pBoard);
+    if (eResult == ESnapshotResult::Ok)
+    {
+        // 之后的修改只在内存中，留着旧文件会在重启后恢复出过期的数据
+        remove(strPath.c_str());
+    }
+    else
+    {
+        std::cerr << "load cold board " << *stEntry.m_pName << ": " << SnapshotResultString(eResult) << std::endl;
+        rename(strPath.c_str(), (strPath + ".bad").c_str());
+    }
+    if (m_pEventSink != nullptr)
+    {
+        stEntry.m_pBoard->SetEventSink(m_pEventSink, *stEntry.m_pName);
+    }
+    stEntry.m_itHot = m_lstHot.insert(m_lstHot.begin(), &stEntry);
+    --m_ulColdCount;
+}
+
+void RankingService::CmdPing(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    if (vecArgs.size() > 2)
+    {
+        RespAppendError(strOut, "ERR wrong number of arguments for 'ping' command");
+    }
+    else if (vecArgs.size() == 2)
+    {
+        RespAppendBulk(strOut, vecArgs[1]);
+    }
+    else
+    {
+        RespAppendSimple(strOut, "PONG");
+    }
+}
+
+// ZADD key [NX|XX] [GT|LT] [CH] score member [score member ...]
+void RankingService::CmdZAdd(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ExecuteWrite(EWriteCommand::ZAdd, vecArgs, strOut);
+}
+
+// ZINCRBY key increment member
+void RankingService::CmdZIncrBy(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ExecuteWrite(EWriteCommand::ZIncrBy, vecArgs, strOut);
+}
+
+void RankingService::ReplyRank(const std::vector<std::string_view>& vecArgs, bool bReverse, std::string& strOut)
+{
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    size_t ulRank = 0;
+    if (pBoard == nullptr || !pBoard->GetRank(vecArgs[2], bReverse, ulRank))
+    {
+        RespAppendNull(strOut);
+        return;
+    }
+    RespAppendInteger(strOut, static_cast<int64_t>(ulRank));
+}
+
+// ZRANK key member
+void RankingService::CmdZRank(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ReplyRank(vecArgs, false, strOut);
+}
+
+// ZREVRANK key member
+void RankingService::CmdZRevRank(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ReplyRank(vecArgs, true, strOut);
+}
+
+// ZSCORE key member
+void RankingService::CmdZScore(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    double dScore = 0;
+    if (pBoard == nullptr || !pBoard->GetScore(vecArgs[2], dScore))
+    {
+        RespAppendNull(strOut);
+        return;
+    }
+    RespAppendDouble(strOut, dScore);
+}
+
+std::shared_ptr<const std::string> RankingService::GetTopReply(const std::vector<std::string_view>& vecArgs)
+{
+    int64_t llStart = 0;
+    int64_t llStop = 0;
+    bool bWithScores = vecArgs.size() == 5 && RespEqualsIgnoreCase(vecArgs[4], "WITHSCORES");
+    if ((vecArgs.size() != 4 && !bWithScores) || !RespParseInteger(vecArgs[2], llStart) || !RespParseInteger(vecArgs[3], llStop)
+        || llStart < 0 || llStart > llStop || llStop >= static_cast<int64_t>(TOP_CACHE_SIZE))
+    {
+        return nullptr;
+    }
+    BoardEntry* pEntry = FindEntry(vecArgs[1]);
+    if (pEntry == nullptr)
+    {
+        return nullptr;
+    }
+
+    // 榜首区间版本号不变说明没有写入触及前 TOP_CACHE_SIZE 名，缓存的回复仍然有效
+    LocalLeaderboard& stBoard = *pEntry->m_pBoard;
+    TopReplyCache& stCache = pEntry->m_stTopCache;
+    if (stCache.m_ulVersion != stBoard.GetTopVersion())
+    {
+        stCache.m_vecReplies.clear();
+    }
+    for (const TopReply& stReply : stCache.m_vecReplies)
+    {
+        if (stReply.m_llStart == llStart && stReply.m_llStop == llStop && stReply.m_bWithScores == bWithScores)
+        {
+            return stReply.m_pReply;
+        }
+    }
+
+    // 监视整个 TOP_CACHE_SIZE 区间，同一版本内其他小区间的回复也能从缓存生成
+    stCache.m_ulVersion = stBoard.GetTopRange(TOP_CACHE_SIZE, m_vecTopEntries);
+    size_t ulFirst = std::min(static_cast<size_t>(llStart), m_vecTopEntries.size());
+    size_t ulLast = std::min(static_cast<size_t>(llStop) + 1, m_vecTopEntries.size());
+    auto pReply = std::make_shared<std::string>();
+    RespAppendArrayHeader(*pReply, (ulLast - ulFirst) * (bWithScores ? 2 : 1));
+    for (size_t i = ulFirst; i < ulLast; ++i)
+    {
+        RespAppendBulk(*pReply, m_vecTopEntries[i].m_strMember);
+        if (bWithScores)
+        {
+            RespAppendDouble(*pReply, m_vecTopEntries[i].m_dScore);
+        }
+    }
+    // 旧回复可能仍被待发送的 ReplyBuffer 引用，替换而不是原地修改
+    TopReply stReply{ llStart, llStop, bWithScores, std::move(pReply) };
+    if (stCache.m_vecReplies.size() < TOP_CACHE_SLOTS)
+    {
+        stCache.m_vecReplies.push_back(std::move(stReply));
+        return stCache.m_vecReplies.back().m_pReply;
+    }
+    TopReply& stSlot = stCache.m_vecReplies[stCache.m_ulNextSlot];
+    stCache.m_ulNextSlot = (stCache.m_ulNextSlot + 1) % TOP_CACHE_SLOTS;
+    stSlot = std::move(stReply);
+    return stSlot.m_pReply;
+}
+
+void RankingService::ReplyRange(const std::vector<std::string_view>& vecArgs, bool bReverse, std::string& strOut)
+{
+    if (bReverse)
+    {
+        // 只有回复写入字符串的 Execute 会走到这里(ReplyBuffer 接口在调用处理函数前已查过缓存并引用共享回复)，需要复制一次
+        std::shared_ptr<const std::string> pTopReply = GetTopReply(vecArgs);
+        if (pTopReply != nullptr)
+        {
+            strOut.append(*pTopReply);
+            return;
+        }
+    }
+
+    int64_t llStart = 0;
+    int64_t llStop = 0;
+    bool bWithScores = false;
+    if (vecArgs.size() == 5 && RespEqualsIgnoreCase(vecArgs[4], "WITHSCORES"))
+    {
+        bWithScores = true;
+    }
+    else if (vecArgs.size() != 4)
+    {
+        RespAppendError(strOut, ERR_SYNTAX);
+        return;
+    }
+    if (!RespParseInteger(vecArgs[2], llStart) || !RespParseInteger(vecArgs[3], llStop))
+    {
+        RespAppendError(strOut, ERR_NOT_INTEGER);
+        return;
+    }
+
+    std::vector<RankEntry> vecEntries;
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    if (pBoard != nullptr)
+    {
+        pBoard->GetRange(llStart, llStop, bReverse, vecEntries);
+    }
+    RespAppendArrayHeader(strOut, vecEntries.size() * (bWithScores ? 2 : 1));
+    for (const RankEntry& stEntry : vecEntries)
+    {
+        RespAppendBulk(strOut, stEntry.m_strMember);
+        if (bWithScores)
+        {
+            RespAppendDouble(strOut, stEntry.m_dScore);
+        }
+    }
+}
+
+// ZRANGE key start stop [WITHSCORES]
+void RankingService::CmdZRange(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ReplyRange(vecArgs, false, strOut);
+}
+
+// ZREVRANGE key start stop [WITHSCORES]
+void RankingService::CmdZRevRange(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ReplyRange(vecArgs, true, strOut);
+}
+
+// ZCOUNT key min max
+void RankingService::CmdZCount(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ScoreBound stMin;
+    ScoreBound stMax;
+    if (!ParseScoreBound(vecArgs[2], stMin) || !ParseScoreBound(vecArgs[3], stMax))
+    {
+        RespAppendError(strOut, "ERR min or max is not a float");
+        return;
+    }
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    RespAppendInteger(strOut, pBoard == nullptr ? 0 : static_cast<int64_t>(pBoard->Count(stMin, stMax)));
+}
+
+// ZREM key member [member ...]
+void RankingService::CmdZRem(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ExecuteWrite(EWriteCommand::ZRem, vecArgs, strOut);
+}
+
+// ZCARD key
+void RankingService::CmdZCard(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    RespAppendInteger(strOut, pBoard == nullptr ? 0 : static_cast<int64_t>(pBoard->Size()));
+}
+
+// ZREMRANGEBYSCORE key min max
+void RankingService::CmdZRemRangeByScore(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    ScoreBound stMin;
+    ScoreBound stMax;
+    if (!ParseScoreBound(vecArgs[2], stMin) || !ParseScoreBound(vecArgs[3], stMax))
+    {
+        RespAppendError(strOut, "ERR min or max is not a float");
+        return;
+    }
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    RespAppendInteger(strOut, pBoard == nullptr ? 0 : static_cast<int64_t>(pBoard->RemoveRangeByScore(stMin, stMax)));
+}
+
+// ZREMRANGEBYRANK key start stop
+void RankingService::CmdZRemRangeByRank(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    int64_t llStart = 0;
+    int64_t llStop = 0;
+    if (!RespParseInteger(vecArgs[2], llStart) || !RespParseInteger(vecArgs[3], llStop))
+    {
+        RespAppendError(strOut, ERR_NOT_INTEGER);
+        return;
+    }
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    RespAppendInteger(strOut, pBoard == nullptr ? 0 : static_cast<int64_t>(pBoard->RemoveRangeByRank(llStart, llStop)));
+}
+
+// ZTRANSFORM key scale offset：全榜分数变为 分数 x scale + offset，scale 须为正；排行榜不存在时报错
+void RankingService::CmdZTransform(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    double dScale = 0;
+    double dOffset = 0;
+    if (!RespParseDouble(vecArgs[2], dScale) || !RespParseDouble(vecArgs[3], dOffset))
+    {
+        RespAppendError(strOut, ERR_NOT_FLOAT);
+        return;
+    }
+    LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+    if (pBoard == nullptr)
+    {
+        // 不存在的排行榜多半是名字写错，不能回复 OK 让调用方以为已变换
+        RespAppendError(strOut, "ERR no such key");
+        return;
+    }
+    if (!pBoard->ApplyTransform(dScale, dOffset))
+    {
+        RespAppendError(strOut, "ERR scale must be positive and the result finite");
+        return;
+    }
+    RespAppendSimple(strOut, "OK");
+}
+
+// ZCAPACITY key [capacity]：读取或设置只保留前 N 名的容量，0 为不限；设置时超出的最低分成员立即删除
+void RankingService::CmdZCapacity(const std::vector<std::string_view>& vecArgs, std::string& strOut)
+{
+    if (vecArgs.size() > 3)
+    {
+        RespAppendError(strOut, ERR_SYNTAX);
+        return;
+    }
+    if (vecArgs.size() == 2)
+    {
+        LocalLeaderboard* pBoard = FindBoard(vecArgs[1]);
+        RespAppendInteger(strOut, pBoard == nullptr ? 0 : static_cast<int64_t>(pBoard->GetCapacity()));
+        return;
+    }
+    int64_t llCapacity = 0;
+    if (!RespParseInteger(vecArgs[2], llCapacity) || llCapacity < 0)
+    {
+        RespAppendError(strOut, ERR_NOT_INTEGER);
+        return;
+    }
+    // 容量是排行榜的设置，对不存在的排行榜设置非零容量时先建空榜
+    LocalLeaderboard* pBoard = llCapacity == 0 ? FindBoard(vecArgs[1]) : GetOrCreateBoard(vecArgs[1]);
+    if (pBoard != nullptr)
+    {
+        pBoard->SetCapacity(static_cast<size_t>(llCapacity));
+    }
+    RespAppendSimple(strOut, "OK");
+}
@@ -0,0 +1,289 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "leaderboard.h"
+#include "resp.h"
+
+// 一批待执行的命令，参数指向连接的输入缓冲区，外层数组跨批次复用以避免反复分配
+struct CommandBatch
+{
+    std::vector<std::vector<std::string_view>> m_vecCommands;// 各命令的参数
+    size_t m_ulCount = 0;// 本批命令数
+
+    // 取出下一条命令的参数数组
+    std::vector<std::string_view>& Next()
+    {
+        if (m_ulCount == m_vecCommands.size())
+        {
+            m_vecCommands.emplace_back();
+        }
+        std::vector<std::string_view>& vecArgs = m_vecCommands[m_ulCount++];
+        vecArgs.clear();
+        return vecArgs;
+    }
+
+    // 撤销最近一次 Next
+    void Pop()
+    {
+        --m_ulCount;
+    }
+};
+
+// 从缓冲区中解析出所有完整的命令追加到 stBatch，ulConsumed 返回已解析的字节数
+// 返回 Error 表示遇到协议错误，此前解析出的命令仍然有效；命令参数直接引用 pData
+inline ERespParse ParseCommandBatch(const char* pData, size_t ulLen, CommandBatch& stBatch, size_t& ulConsumed)
+{
+    ulConsumed = 0;
+    while (ulConsumed < ulLen)
+    {
+        size_t ulUsed = 0;
+        std::vector<std::string_view>& vecArgs = stBatch.Next();
+        ERespParse eResult = ParseRespCommand(pData + ulConsumed, ulLen - ulConsumed, vecArgs, ulUsed);
+        if (eResult != ERespParse::Ok)
+        {
+            stBatch.Pop();
+            return eResult == ERespParse::Error ? ERespParse::Error : ERespParse::Ok;
+        }
+        ulConsumed += ulUsed;
+        if (vecArgs.empty())
+        {
+            stBatch.Pop();
+        }
+    }
+    return ERespParse::Ok;
+}
+
+// 一条回复在 ReplyBuffer 中的位置
+struct ReplySlot
+{
+    size_t m_ulOffset = 0;// 在 m_strData 或共享回复中的偏移
+    size_t m_ulLength = 0;// 长度
+    int    m_iShared = -1;// 共享回复下标，-1 表示位于 m_strData
+};
+
+// 一批命令的回复：回复写入同一块缓冲区，按命令顺序记录各自区间，发送时直接组成 iovec
+// 缓存的回复不复制，只持有其引用，发送时直接从缓存发出
+struct ReplyBuffer
+{
+    std::string m_strData;// 回复内容，按执行顺序追加
+    std::vector<ReplySlot> m_vecSlots;// 各命令回复的位置
+    std::vector<std::shared_ptr<const std::string>> m_vecShared;// 引用的共享回复，持有引用保证发送前不被释放
+
+    // 清空回复并预留 ulCount 条命令的位置
+    void Reset(size_t ulCount)
+    {
+        m_strData.clear();
+        m_vecSlots.assign(ulCount, ReplySlot());
+        m_vecShared.clear();
+    }
+
+    // 第 ulSlot 条命令的回复为 m_strData 中从 ulOffset 开始到末尾的部分
+    void SetReply(size_t ulSlot, size_t ulOffset)
+    {
+        m_vecSlots[ulSlot] = ReplySlot{ ulOffset, m_strData.size() - ulOffset, -1 };
+    }
+
+    // 第 ulSlot 条命令的回复直接引用共享回复
+    void SetShared(size_t ulSlot, std::shared_ptr<const std::string> pReply)
+    {
+        m_vecSlots[ulSlot] = ReplySlot{ 0, pReply->size(), static_cast<int>(m_vecShared.size()) };
+        m_vecShared.push_back(std::move(pReply));
+    }
+
+    std::string_view GetReply(size_t ulSlot) const
+    {
+        const ReplySlot& stSlot = m_vecSlots[ulSlot];
+        const std::string& strBase = stSlot.m_iShared < 0 ? m_strData : *m_vecShared[stSlot.m_iShared];
+        return std::string_view(strBase.data() + stSlot.m_ulOffset, stSlot.m_ulLength);
+    }
+
+    // 按命令顺序把全部回复追加到 strOut
+    void AppendTo(std::string& strOut) const
+    {
+        for (size_t i = 0; i < m_vecSlots.size(); ++i)
+        {
+            strOut.append(GetReply(i));
+        }
+    }
+};
+
+// 排行榜命令服务：按 Redis 有序集合命令的语义操作各个排行榜，与网络层无关
+// 执行命令时复用成员缓冲区，同一实例只能由一个线程调用 Execute/ExecuteBatch，
+// 因此排行榜使用单线程策略，多核时每个分片各持有一个实例
+class RankingService
+{
+    public:
+        // 缓存序列化回复的榜首名次数，0 <= start <= stop < TOP_CACHE_SIZE 的 ZREVRANGE key start stop [WITHSCORES] 使用缓存
+        static constexpr size_t TOP_CACHE_SIZE = 100;
+        // 每个排行榜缓存的榜首回复个数，按 (start, stop, WITHSCORES) 区分，满了轮流替换
+        static constexpr size_t TOP_CACHE_SLOTS = 8;
+        // 单次 EvictIdleBoards 最多转出的冷榜数
+        static constexpr size_t COLD_EVICT_BATCH = 16;
+
+        RankingService() = default;
+        RankingService(const RankingService&) = delete;
+        RankingService& operator=(const RankingService&) = delete;
+
+        // 执行一条命令，回复追加到 strOut；返回false表示回复后应关闭连接
+        // 命中榜首缓存时省去序列化，但仍要把缓存的回复整段复制到 strOut；服务器都走下面两个 ReplyBuffer 接口，
+        // 这个接口留给测试对照和逐条调用的场合
+        bool Execute(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        // 同上，回复作为新的一条记录在 stReplies 末尾，命中榜首缓存时只引用缓存的回复而不复制
+        bool Execute(const std::vector<std::string_view>& vecArgs, ReplyBuffer& stReplies);
+
+        // 执行一批流水线命令：按排行榜分组，同一排行榜上连续的写命令合并为一次批量写
+        // 同一排行榜上的命令保持原有顺序，回复按命令顺序记录在 stReplies 中
+        bool ExecuteBatch(const CommandBatch& stBatch, ReplyBuffer& stReplies);
+
+        // 设置分数变更接收者，已有和之后创建的排行榜都会通知它；传入空指针取消
+        void SetEventSink(ScoreEventSink* pSink);
+
+        // 设置之后新建排行榜的跳表节点内存池，内存池需比本实例活得更久；已有排行榜不受影响
+        void SetNodeArena(NodeArena* pArena);
+
+        // 开启冷榜分层：闲置超过 uiIdleSeconds 秒的排行榜压缩成排行榜快照写到 strDir 下并释放内存，下次访问时映射文件装回
+        // 目录中已有的冷榜文件(上次运行留下的)登记为冷榜，可以直接访问；fnOwns 非空时只登记它认领的排行榜，
+        // 多个分片共用一个目录时各自登记属于自己的排行榜；目录无法创建时返回false
+        bool SetColdTier(const std::string& strDir, uint32_t uiIdleSeconds, std::function<bool(std::string_view)> fnOwns = nullptr);
+        // 把闲置超时的排行榜转为冷榜，返回本次转出的个数；由执行命令的线程定期调用，未开启分层时什么也不做
+        // 每次最多转出 COLD_EVICT_BATCH 个，写盘的停顿分摊到多次调用
+        size_t EvictIdleBoards();
+        // 冷榜个数
+        size_t GetColdBoardCount() const;
+        // 命令是否操作某个排行榜，是则通过 svBoard 返回排行榜名；分片服务器据此把命令路由到排行榜所在的分片
+        static bool GetCommandBoard(const std::vector<std::string_view>& vecArgs, std::string_view& svBoard);
+
+    private:
+        using CommandHandler = void (RankingService::*)(const std::vector<std::string_view>&, std::string&);
+
+        // 可以合并批量执行的写命令
+        enum class EWriteCommand
+        {
+            None,
+            ZAdd,
+            ZIncrBy,
+            ZRem,
+        };
+
+        // 命令表项
+        struct CommandEntry
+        {
+            const char*    m_szName;   // 命令名
+            CommandHandler m_pfnHandler;// 处理函数
+            int            m_iArity;   // 参数个数(含命令名)，负数表示至少 -m_iArity 个
+            bool           m_bBoard;   // 第二个参数是否为排行榜名
+            EWriteCommand  m_eWrite;   // 写命令类型
+        };
+
+        // 批量写中等待回复的命令
+        struct PendingWriteReply
+        {
+            size_t        m_ulCommand;// 命令下标
+            size_t        m_ulFirstOp;// 第一个写操作下标
+            size_t        m_ulOpCount;// 写操作个数
+            EWriteCommand m_eWrite;   // 写命令类型
+            bool          m_bCh;      // ZADD 的 CH 选项
+        };
+
+        // 一个榜首区间的序列化回复
+        struct TopReply
+        {
+            int64_t m_llStart = 0;       // 起始名次
+            int64_t m_llStop = 0;        // 结束名次
+            bool    m_bWithScores = false;// 是否带分数
+            std::shared_ptr<const std::string> m_pReply;// 回复内容
+        };
+
+        // 榜首区间的序列化回复，排行榜的榜首区间版本号不变时可以直接复用
+        struct TopReplyCache
+        {
+            uint64_t m_ulVersion = 0;     // 生成时的榜首区间版本号
+            size_t   m_ulNextSlot = 0;    // 缓存满时下一个替换的位置
+            std::vector<TopReply> m_vecReplies;// 已生成的回复，版本号变化时全部作废
+        };
+
+        // 排行榜及其榜首回复缓存
+        struct BoardEntry
+        {
+            std::unique_ptr<LocalLeaderboard> m_pBoard;// 排行榜，转为冷榜后为空
+            TopReplyCache      m_stTopCache;     // 榜首回复缓存
+            const std::string* m_pName = nullptr;// 排行榜名，指向 m_mapBoards 中的键
+            int64_t            m_llLastAccess = 0;// 最近一次访问的时间(毫秒)，开启分层时维护
+            std::list<BoardEntry*>::iterator m_itHot;// 在热榜链表中的位置，开启分层且不是冷榜时有效
+        };
+
+        static const CommandEntry s_astCommands[];
+
+        std::unordered_map<std::string, std::unique_ptr<BoardEntry>, StringHash, std::equal_to<>> m_mapBoards;// 排行榜名到排行榜
+        std::vector<RankEntry>         m_vecTopEntries;   // 重新生成榜首回复时复用的缓冲区
+        ScoreEventSink*                m_pEventSink = nullptr;// 分数变更接收者
+        NodeArena*                     m_pArena = nullptr;// 新建排行榜的节点内存池
+        // 冷榜分层，m_strColdDir 为空表示未开启
+        std::string                    m_strColdDir;      // 冷榜文件目录
+        int64_t                        m_llColdIdleMs = 0;// 闲置多久转为冷榜
+        std::list<BoardEntry*>         m_lstHot;          // 内存中的排行榜，按最近访问时间从新到旧排列
+        size_t                         m_ulColdCount = 0; // 冷榜个数
+
+        // 批量执行时复用的缓冲区
+        std::vector<size_t>            m_vecBoardCommands;// 需要按排行榜分组的命令下标
+        std::vector<WriteOp>           m_vecWriteOps;     // 当前批量写的操作
+        std::vector<WriteResult>       m_vecWriteResults; // 当前批量写的结果
+        std::vector<PendingWriteReply> m_vecWriteReplies; // 当前批量写中等待回复的命令
+
+        static const CommandEntry* LookupCommand(std::string_view svName);
+        // 检查参数个数，不符合时写入错误回复并返回false
+        static bool CheckArity(const CommandEntry& stEntry, const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        // 将写命令解析为写操作，参数有误时写入错误回复并返回false
+        static bool ParseWriteOps(EWriteCommand eWrite, const std::vector<std::string_view>& vecArgs, std::vector<WriteOp>& vecOps, bool& bCh, std::string& strOut);
+        // 根据写操作结果生成回复
+        static void AppendWriteReply(EWriteCommand eWrite, const WriteResult* pResults, size_t ulCount, bool bCh, std::string& strOut);
+        // 执行单条写命令
+        void ExecuteWrite(EWriteCommand eWrite, const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        // 将累积的批量写提交到排行榜并填写各命令的回复
+        void FlushWrites(std::string_view svBoard, ReplyBuffer& stReplies);
+
+        // 命令为 ZREVRANGE key start stop [WITHSCORES] 且 0 <= start <= stop < TOP_CACHE_SIZE 时返回榜首缓存中的回复，
+        // 必要时重新生成；否则返回空
+        std::shared_ptr<const std::string> GetTopReply(const std::vector<std::string_view>& vecArgs);
+
+        // 查找排行榜项，冷榜先装回内存并记录访问时间，不存在返回空
+        BoardEntry* FindEntry(std::string_view svName);
+        // 为新的排行榜对象设置节点内存池和分数变更接收者
+        void InitBoard(LocalLeaderboard& stBoard, std::string_view svName);
+        // 冷榜文件路径：排行榜名的十六进制编码，名字过长无法作为文件名时返回空
+        std::string GetColdPath(std::string_view svName) const;
+        // 把排行榜写成冷榜文件并释放，失败时保持原样返回false
+        bool EvictBoard(BoardEntry& stEntry);
+        // 从冷榜文件装回排行榜，文件损坏时改名保留并以空榜继续
+        void LoadColdBoard(BoardEntry& stEntry);
+        // 查找排行榜，不存在返回空
+        LocalLeaderboard* FindBoard(std::string_view svName);
+        // 查找排行榜，不存在则创建
+        LocalLeaderboard* GetOrCreateBoard(std::string_view svName);
+
+        void CmdPing(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZAdd(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZIncrBy(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRank(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRevRank(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZScore(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRange(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRevRange(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZCount(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRem(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZCard(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRemRangeByScore(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZRemRangeByRank(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZTransform(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+        void CmdZCapacity(const std::vector<std::string_view>& vecArgs, std::string& strOut);
+
+        void ReplyRank(const std::vector<std::string_view>& vecArgs, bool bReverse, std::string& strOut);
+        void ReplyRange(const std::vector<std::string_view>& vecArgs, bool bReverse, std::string& strOut);
+};
@@ -0,0 +1,245 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <strings.h>
+
+// Redis RESP 协议的解析与回复编码，只覆盖排行榜服务用到的子集
+
+const size_t RESP_MAX_ARGS = 1024 * 1024;          // 单条命令最大参数个数
+const size_t RESP_MAX_BULK = 512 * 1024 * 1024;    // 单个参数最大字节数
+const size_t RESP_MAX_INLINE = 64 * 1024;          // 内联命令最大长度
+
+// 命令解析结果
+enum class ERespParse
+{
+    Ok,         // 解析出一条完整命令
+    Incomplete, // 数据不完整，需要继续读取
+    Error,      // 协议错误
+};
+
+// 从 pData 中解析一行整数，形如 "123\r\n"
+inline ERespParse RespParseLine(const char* pData, size_t ulLen, size_t& ulPos, int64_t& llValue)
+{
+    const char* pEnd = static_cast<const char*>(memchr(pData + ulPos, '\r', ulLen - ulPos));
+    if (pEnd == nullptr || pEnd + 1 >= pData + ulLen)
+    {
+        return ERespParse::Incomplete;
+    }
+    if (pEnd[1] != '\n')
+    {
+        return ERespParse::Error;
+    }
+    auto stResult = std::from_chars(pData + ulPos, pEnd, llValue);
+    if (stResult.ec != std::errc() || stResult.ptr != pEnd)
+    {
+        return ERespParse::Error;
+    }
+    ulPos = static_cast<size_t>(pEnd - pData) + 2;
+    return ERespParse::Ok;
+}
+
+// 解析一条命令，参数以 string_view 形式指向输入缓冲区
+// 支持多条批量格式(*N\r\n$len\r\n...)与内联格式(空格分隔的一行)
+inline ERespParse ParseRespCommand(const char* pData, size_t ulLen, std::vector<std::string_view>& vecArgs, size_t& ulConsumed)
+{
+    vecArgs.clear();
+    if (ulLen == 0)
+    {
+        return ERespParse::Incomplete;
+    }
+
+    if (pData[0] != '*')
+    {
+        // 内联命令
+        const char* pEnd = static_cast<const char*>(memchr(pData, '\n', ulLen));
+        if (pEnd == nullptr)
+        {
+            return ulLen > RESP_MAX_INLINE ? ERespParse::Error : ERespParse::Incomplete;
+        }
+        ulConsumed = static_cast<size_t>(pEnd - pData) + 1;
+        const char* pLineEnd = (pEnd > pData && pEnd[-1] == '\r') ? pEnd - 1 : pEnd;
+        const char* pCurr = pData;
+        while (pCurr < pLineEnd)
+        {
+            while (pCurr < pLineEnd && (*pCurr == ' ' || *pCurr == '\t'))
+            {
+                ++pCurr;
+            }
+            const char* pStart = pCurr;
+            while (pCurr < pLineEnd && *pCurr != ' ' && *pCurr != '\t')
+            {
+                ++pCurr;
+            }
+            if (pCurr > pStart)
+            {
+                vecArgs.emplace_back(pStart, static_cast<size_t>(pCurr - pStart));
+            }
+        }
+        return ERespParse::Ok;
+    }
+
+    size_t ulPos = 1;
+    int64_t llCount = 0;
+    ERespParse eResult = RespParseLine(pData, ulLen, ulPos, llCount);
+    if (eResult != ERespParse::Ok)
+    {
+        return eResult;
+    }
+    if (llCount < 0 || static_cast<size_t>(llCount) > RESP_MAX_ARGS)
+    {
+        return ERespParse::Error;
+    }
+
+    for (int64_t i = 0; i < llCount; ++i)
+    {
+        if (ulPos >= ulLen)
+        {
+            return ERespParse::Incomplete;
+        }
+        if (pData[ulPos] != '$')
+        {
+            return ERespParse::Error;
+        }
+        ++ulPos;
+        int64_t llBulkLen = 0;
+        eResult = RespParseLine(pData, ulLen, ulPos, llBulkLen);
+        if (eResult != ERespParse::Ok)
+        {
+            return eResult;
+        }
+        if (llBulkLen < 0 || static_cast<size_t>(llBulkLen) > RESP_MAX_BULK)
+        {
+            return ERespParse::Error;
+        }
+        if (ulPos + static_cast<size_t>(llBulkLen) + 2 > ulLen)
+        {
+            return ERespParse::Incomplete;
+        }
+        vecArgs.emplace_back(pData + ulPos, static_cast<size_t>(llBulkLen));
+        ulPos += static_cast<size_t>(llBulkLen);
+        if (pData[ulPos] != '\r' || pData[ulPos + 1] != '\n')
+        {
+            return ERespParse::Error;
+        }
+        ulPos += 2;
+    }
+    ulConsumed = ulPos;
+    return ERespParse::Ok;
+}
+
+// 回复编码
+inline void RespAppendSimple(std::string& strOut, std::string_view svText)
+{
+    strOut += '+';
+    strOut.append(svText);
+    strOut += "\r\n";
+}
+
+inline void RespAppendError(std::string& strOut, std::string_view svText)
+{
+    strOut += '-';
+    strOut.append(svText);
+    strOut += "\r\n";
+}
+
+inline void RespAppendInteger(std::string& strOut, int64_t llValue)
+{
+    char szBuf[24];
+    auto stResult = std::to_chars(szBuf, szBuf + sizeof(szBuf), llValue);
+    strOut += ':';
+    strOut.append(szBuf, stResult.ptr);
+    strOut += "\r\n";
+}
+
+inline void RespAppendBulk(std::string& strOut, std::string_view svData)
+{
+    char szBuf[24];
+    auto stResult = std::to_chars(szBuf, szBuf + sizeof(szBuf), svData.size());
+    strOut += '$';
+    strOut.append(szBuf, stResult.ptr);
+    strOut += "\r\n";
+    strOut.append(svData);
+    strOut += "\r\n";
+}
+
+inline void RespAppendNull(std::string& strOut)
+{
+    strOut += "$-1\r\n";
+}
+
+inline void RespAppendArrayHeader(std::string& strOut, size_t ulCount)
+{
+    char szBuf[24];
+    auto stResult = std::to_chars(szBuf, szBuf + sizeof(szBuf), ulCount);
+    strOut += '*';
+    strOut.append(szBuf, stResult.ptr);
+    strOut += "\r\n";
+}
+
+// 分数以最短往返精度的字符串形式返回，与 Redis 一致使用 inf/-inf
+inline void RespAppendDouble(std::string& strOut, double dValue)
+{
+    char szBuf[32];
+    size_t ulLen = 0;
+    if (dValue == HUGE_VAL)
+    {
+        ulLen = 3;
+        memcpy(szBuf, "inf", 3);
+    }
+    else if (dValue == -HUGE_VAL)
+    {
+        ulLen = 4;
+        memcpy(szBuf, "-inf", 4);
+    }
+    else
+    {
+        auto stResult = std::to_chars(szBuf, szBuf + sizeof(szBuf), dValue);
+        ulLen = static_cast<size_t>(stResult.ptr - szBuf);
+    }
+    RespAppendBulk(strOut, std::string_view(szBuf, ulLen));
+}
+
+// 解析分数参数，接受 inf/+inf/-inf，拒绝 NaN 与多余字符
+inline bool RespParseDouble(std::string_view svArg, double& dValue)
+{
+    if (svArg.empty() || svArg.size() > 64)
+    {
+        return false;
+    }
+    char szBuf[65];
+    memcpy(szBuf, svArg.data(), svArg.size());
+    szBuf[svArg.size()] = '\0';
+    if (strcasecmp(szBuf, "inf") == 0 || strcasecmp(szBuf, "+inf") == 0)
+    {
+        dValue = HUGE_VAL;
+        return true;
+    }
+    if (strcasecmp(szBuf, "-inf") == 0)
+    {
+        dValue = -HUGE_VAL;
+        return true;
+    }
+    char* pEnd = nullptr;
+    dValue = strtod(szBuf, &pEnd);
+    return pEnd == szBuf + svArg.size() && dValue == dValue;
+}
+
+inline bool RespParseInteger(std::string_view svArg, int64_t& llValue)
+{
+    auto stResult = std::from_chars(svArg.data(), svArg.data() + svArg.size(), llValue);
+    return stResult.ec == std::errc() && stResult.ptr == svArg.data() + svArg.size();
+}
+
+// 不区分大小写比较命令名
+inline bool RespEqualsIgnoreCase(std::string_view svArg, const char* szName)
+{
+    size_t ulLen = strlen(szName);
+    return svArg.size() == ulLen && strncasecmp(svArg.data(), szName, ulLen) == 0;
+}
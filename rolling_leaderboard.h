@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "leaderboard.h"
+
+// 滑动窗口配置
+struct RollingConfig
+{
+    int64_t  m_llWindowMs = 86400000;// 窗口长度(毫秒)，默认最近24小时
+    uint32_t m_uiBuckets = 96;       // 窗口切成的时间桶数，桶越多过期越平滑，每个活跃成员多占 8 字节/桶
+};
+
+// 滑动窗口累计排行榜：成员的分数是最近一个窗口内得分之和，例如"最近24小时"榜
+// 每个成员按时间桶记录得分(环形数组)，分数为各桶之和；桶滑出窗口时从分数中减去
+// 成员只在最老的非空桶到期时登记到时间轮上，时间推进到该桶时才处理它：扣除到期的桶，
+// 把新分数写回排行榜(排行榜在写锁内先摘除旧键再插入新键，读者看不到中间状态)，再按下一个非空桶重新登记
+// 同一时间桶到期的成员合并成一次批量写，窗口维护的代价与窗口内活跃的成员数成正比，与历史数据总量无关
+// 时间在每次读写时惰性推进，不需要后台线程；整个排行榜由一把读写锁保护，Access 为 SingleThreadAccess 时锁也省去
+template<typename Access>
+class RollingSumBoard
+{
+    private:
+        using Mutex = std::conditional_t<Access::CONCURRENT, std::shared_mutex, NullSharedMutex>;
+
+        static constexpr int64_t NO_BUCKET = std::numeric_limits<int64_t>::min();
+
+        // 成员的时间桶
+        struct RollingMember
+        {
+            std::unique_ptr<double[]> m_pBuckets;// 各桶得分，按 桶序号 % 桶数 存放
+            int64_t m_llOldest = NO_BUCKET;      // 最老的非空桶，NO_BUCKET 表示没有得分；不为空时已登记在时间轮上
+        };
+
+        using MemberMap = std::unordered_map<std::string, RollingMember, StringHash, std::equal_to<>>;
+
+        const RollingConfig            m_stConfig;  // 配置
+        const int64_t                  m_llBucketMs;// 每桶时长
+        const std::function<int64_t()> m_fnClock;   // 当前时间(毫秒)
+        mutable Mutex                  m_stMutex;   // 保护以下全部状态
+        LocalLeaderboard               m_stBoard;   // 按窗口内得分之和排序
+        MemberMap                      m_mapMembers;// 窗口内有得分的成员
+        std::vector<std::vector<typename MemberMap::value_type*>> m_vecWheel;// 时间轮，成员按最老非空桶的到期桶登记在 到期桶 % 槽数 上
+        std::atomic<int64_t>           m_llCurrent; // 时间轮已推进到的桶
+        // 推进时间轮时复用的缓冲区
+        std::vector<WriteOp>           m_vecOps;
+        std::vector<WriteResult>       m_vecResults;
+        std::vector<typename MemberMap::value_type*> m_vecDue;// 本次到期的成员
+
+        static int64_t GetSteadyMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static RollingConfig Normalize(RollingConfig stConfig)
+        {
+            stConfig.m_uiBuckets = std::max<uint32_t>(stConfig.m_uiBuckets, 1);
+            stConfig.m_llWindowMs = std::max<int64_t>(stConfig.m_llWindowMs, stConfig.m_uiBuckets);
+            return stConfig;
+        }
+
+        int64_t GetBucket(int64_t llNowMs) const
+        {
+            int64_t llBucket = llNowMs / m_llBucketMs;
+            return llNowMs % m_llBucketMs < 0 ? llBucket - 1 : llBucket;
+        }
+
+        double& BucketAt(RollingMember& stMember, int64_t llBucket)
+        {
+            int64_t llSlot = llBucket % static_cast<int64_t>(m_stConfig.m_uiBuckets);
+            return stMember.m_pBuckets[llSlot < 0 ? llSlot + m_stConfig.m_uiBuckets : llSlot];
+        }
+
+        // 桶 llBucket 在时间推进到 llBucket + 桶数 时滑出窗口
+        void Schedule(typename MemberMap::value_type* pMember)
+        {
+            int64_t llDue = pMember->second.m_llOldest + m_stConfig.m_uiBuckets;
+            int64_t llSlot = llDue % static_cast<int64_t>(m_vecWheel.size());
+            m_vecWheel[llSlot < 0 ? llSlot + m_vecWheel.size() : llSlot].push_back(pMember);
+        }
+
+        // 推进时间轮到 llNow 所在的桶，处理其间到期的成员；持有独占锁时调用
+        // 登记距离当前最多 桶数 个桶，槽数比桶数多一，每个槽同一时刻只有一个到期桶的成员；
+        // 时间跳过一整圈时每个槽只需处理一次
+        void AdvanceLocked(int64_t llNow)
+        {
+            int64_t llCurrent = m_llCurrent.load(std::memory_order_relaxed);
+            if (llNow <= llCurrent)
+            {
+                return;
+            }
+            const int64_t llSlots = static_cast<int64_t>(m_vecWheel.size());
+            int64_t llLast = std::min(llNow, llCurrent + llSlots);
+            m_vecDue.clear();
+            for (int64_t llBucket = llCurrent + 1; llBucket <= llLast; ++llBucket)
+            {
+                int64_t llSlot = llBucket % llSlots;
+                auto& vecSlot = m_vecWheel[llSlot < 0 ? llSlot + llSlots : llSlot];
+                m_vecDue.insert(m_vecDue.end(), vecSlot.begin(), vecSlot.end());
+                vecSlot.clear();
+            }
+            m_llCurrent.store(llNow, std::memory_order_release);
+            if (m_vecDue.empty())
+            {
+                return;
+            }
+
+            // 扣除滑出窗口的桶，剩余桶重新求和，避免反复加减累积浮点误差
+            const int64_t llFirstLive = llNow - m_stConfig.m_uiBuckets + 1;
+            m_vecOps.clear();
+            size_t ulDead = 0;
+            for (auto* pMember : m_vecDue)
+            {
+                RollingMember& stMember = pMember->second;
+                // 写入只落在推进后的当前桶，此时与它同槽的旧桶都已清零，过期的桶只在 [最老非空桶, 窗口起点) 内
+                int64_t llExpired = std::min<int64_t>(llFirstLive - stMember.m_llOldest, m_stConfig.m_uiBuckets);
+                for (int64_t i = 0; i < llExpired; ++i)
+                {
+                    BucketAt(stMember, stMember.m_llOldest + i) = 0;
+                }
+                double dSum = 0;
+                stMember.m_llOldest = NO_BUCKET;
+                for (int64_t llBucket = llFirstLive; llBucket <= llNow; ++llBucket)
+                {
+                    double dPoints = BucketAt(stMember, llBucket);
+                    if (dPoints != 0 && stMember.m_llOldest == NO_BUCKET)
+                    {
+                        stMember.m_llOldest = llBucket;
+                    }
+                    dSum += dPoints;
+                }
+                if (stMember.m_llOldest == NO_BUCKET)
+                {
+                    m_vecOps.push_back(WriteOp{ EWriteOp::Remove, pMember->first, 0, AddOptions() });
+                    ++ulDead;
+                }
+                else
+                {
+                    m_vecOps.push_back(WriteOp{ EWriteOp::Add, pMember->first, dSum, AddOptions() });
+                    Schedule(pMember);
+                }
+            }
+            // 写操作引用成员表中的名字，批量写完成后才能删除成员
+            m_stBoard.ApplyBatch(m_vecOps, m_vecResults);
+            if (ulDead > 0)
+            {
+                for (auto* pMember : m_vecDue)
+                {
+                    if (pMember->second.m_llOldest == NO_BUCKET)
+                    {
+                        m_mapMembers.erase(m_mapMembers.find(pMember->first));
+                    }
+                }
+            }
+        }
+
+        // 读操作前调用：时间轮落后时先取独占锁推进
+        void CatchUp()
+        {
+            int64_t llNow = GetBucket(m_fnClock());
+            if (llNow > m_llCurrent.load(std::memory_order_acquire))
+            {
+                std::unique_lock<Mutex> stLock(m_stMutex);
+                AdvanceLocked(llNow);
+            }
+        }
+
+    public:
+        // fnClock 返回当前的毫秒时间，为空时使用单调时钟
+        explicit RollingSumBoard(const RollingConfig& stConfig, std::function<int64_t()> fnClock = nullptr)
+            : m_stConfig(Normalize(stConfig)), m_llBucketMs(m_stConfig.m_llWindowMs / m_stConfig.m_uiBuckets),
+            m_fnClock(fnClock ? std::move(fnClock) : std::function<int64_t()>(GetSteadyMs)),
+            m_vecWheel(m_stConfig.m_uiBuckets + 1), m_llCurrent(GetBucket(m_fnClock()))
+        {
+        }
+
+        RollingSumBoard(const RollingSumBoard&) = delete;
+        RollingSumBoard& operator=(const RollingSumBoard&) = delete;
+
+        // 成员在当前时间桶得到 dPoints 分(可为负)，dNewSum 返回窗口内的新总分；dPoints 为 NaN 或无穷时返回false
+        bool AddPoints(std::string_view svMember, double dPoints, double& dNewSum)
+        {
+            if (!std::isfinite(dPoints))
+            {
+                return false;
+            }
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            int64_t llNow = GetBucket(m_fnClock());
+            AdvanceLocked(llNow);
+            // 时钟回拨时计入已推进到的桶
+            llNow = m_llCurrent.load(std::memory_order_relaxed);
+            auto it = m_mapMembers.find(svMember);
+            if (it == m_mapMembers.end())
+            {
+                it = m_mapMembers.emplace(std::string(svMember), RollingMember()).first;
+                it->second.m_pBuckets.reset(new double[m_stConfig.m_uiBuckets]());
+            }
+            RollingMember& stMember = it->second;
+            BucketAt(stMember, llNow) += dPoints;
+            if (stMember.m_llOldest == NO_BUCKET)
+            {
+                stMember.m_llOldest = llNow;
+                Schedule(&*it);
+            }
+            double dOld = 0;
+            m_stBoard.GetScore(svMember, dOld);
+            dNewSum = dOld + dPoints;
+            m_stBoard.Add(it->first, dNewSum);
+            return true;
+        }
+
+        bool AddPoints(std::string_view svMember, double dPoints)
+        {
+            double dNewSum = 0;
+            return AddPoints(svMember, dPoints, dNewSum);
+        }
+
+        // 删除成员及其窗口内的全部得分；时间轮上的登记留到到期时发现没有得分再清理
+        bool Remove(std::string_view svMember)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            AdvanceLocked(GetBucket(m_fnClock()));
+            auto it = m_mapMembers.find(svMember);
+            if (it == m_mapMembers.end())
+            {
+                return false;
+            }
+            std::fill(it->second.m_pBuckets.get(), it->second.m_pBuckets.get() + m_stConfig.m_uiBuckets, 0.0);
+            return m_stBoard.Remove(svMember);
+        }
+
+        // 推进到当前时间并处理到期的桶；读写都会自动推进，长时间无人访问时可由定时器调用以及时释放内存
+        void Expire()
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            AdvanceLocked(GetBucket(m_fnClock()));
+        }
+
+        bool GetScore(std::string_view svMember, double& dScore)
+        {
+            CatchUp();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_stBoard.GetScore(svMember, dScore);
+        }
+
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            CatchUp();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_stBoard.GetRank(svMember, bReverse, ulRank);
+        }
+
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            CatchUp();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            m_stBoard.GetRange(llStart, llStop, bReverse, vecOut);
+        }
+
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            CatchUp();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_stBoard.Count(stMin, stMax);
+        }
+
+        size_t Size()
+        {
+            CatchUp();
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_stBoard.Size();
+        }
+
+        // 记录着时间桶的成员数，包括已删除但还没到期清理的成员
+        size_t GetActiveCount()
+        {
+            std::shared_lock<Mutex> stLock(m_stMutex);
+            return m_mapMembers.size();
+        }
+};
+
+// 多线程共享的滑动窗口排行榜
+using RollingLeaderboard = RollingSumBoard<ConcurrentAccess>;
+// 只由一个线程访问的滑动窗口排行榜
+using LocalRollingLeaderboard = RollingSumBoard<SingleThreadAccess>;
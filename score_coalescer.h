@@ -0,0 +1,266 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "leaderboard.h"
+
+// 同一成员多次更新的合并方式
+enum class ECoalesceMode
+{
+    Last,// 取最后一次，刷新时覆盖写入
+    Max, // 取最大值，刷新时只在高于榜上分数时写入(ZADD GT)
+    Sum, // 累加，刷新时增加到榜上分数(ZINCRBY)
+};
+
+// 合并阶段配置
+struct CoalescerConfig
+{
+    ECoalesceMode m_eMode = ECoalesceMode::Last;// 合并方式
+    uint32_t      m_uiWindowMs = 50;            // 刷新间隔(毫秒)
+    size_t        m_ulMaxPending = 4096;        // 待刷新成员数达到该值时提前刷新
+    size_t        m_ulStripes = 64;             // 分段数，分段越多并发更新的锁冲突越少
+};
+
+// 合并阶段统计，各项只是某一时刻的近似
+struct CoalescerStats
+{
+    size_t   m_ulPending = 0;// 待刷新的成员数
+    uint64_t m_ulUpdates = 0;// 收到的更新数
+    uint64_t m_ulFlushed = 0;// 刷新写入排行榜的操作数
+    uint64_t m_ulFlushes = 0;// 有写入的刷新次数
+};
+
+// 排行榜前的更新合并窗口：活跃玩家每秒产生大量分数变化，但排名只关心最新或最好的一次
+// 更新先按成员名哈希到分段，在分段锁保护下合并进该成员的待刷新值；后台线程每隔一个窗口，
+// 或待刷新成员数达到上限时，把所有分段换出并用一次 ApplyBatch 写入排行榜，跳表写入次数降为每窗口每成员一次
+// Stop 之后的更新只有再调用 Flush 才会写入
+// 排行榜在 Stop 返回之前必须保持有效
+class ScoreCoalescer
+{
+    private:
+        // 分段：各自的锁和待刷新值，独占缓存行避免相邻分段的锁互相干扰
+        struct alignas(64) Stripe
+        {
+            std::mutex m_stMutex;// 分段锁
+            std::unordered_map<std::string, double, StringHash, std::equal_to<>> m_mapPending;// 成员名到待刷新值
+            uint64_t   m_ulUpdates = 0;// 本分段收到的更新数
+        };
+
+        Leaderboard&              m_stBoard;   // 目标排行榜
+        const CoalescerConfig     m_stConfig;  // 配置
+        std::unique_ptr<Stripe[]> m_pStripes;  // 各分段
+        alignas(64) std::atomic<size_t> m_ulPending;// 待刷新成员数
+        std::mutex                m_stFlushMutex;// 保证同一时刻只有一个刷新，刷新线程也在此等待
+        std::condition_variable   m_stWakeCond;// 达到上限或停止时唤醒刷新线程
+        bool                      m_bStop = false;// 是否停止，受 m_stFlushMutex 保护
+        std::thread               m_stFlusher; // 刷新线程
+        std::atomic<uint64_t>     m_ulFlushed; // 刷新写入的操作数
+        std::atomic<uint64_t>     m_ulFlushes; // 有写入的刷新次数
+
+        // 以下只在持有 m_stFlushMutex 时使用，跨刷新复用
+        std::vector<std::unordered_map<std::string, double, StringHash, std::equal_to<>>> m_vecFlushing;// 从各分段换出的待刷新值
+        std::vector<WriteOp>      m_vecOps;    // 刷新的写操作
+        std::vector<WriteResult>  m_vecResults;// 写操作结果，合并阶段不关心
+
+        Stripe& GetStripe(std::string_view svMember)
+        {
+            return m_pStripes[StringHash()(svMember) % m_stConfig.m_ulStripes];
+        }
+
+        static CoalescerConfig Normalize(CoalescerConfig stConfig)
+        {
+            stConfig.m_ulMaxPending = std::max<size_t>(stConfig.m_ulMaxPending, 1);
+            stConfig.m_ulStripes = std::max<size_t>(stConfig.m_ulStripes, 1);
+            return stConfig;
+        }
+
+        // 持有 m_stFlushMutex 时调用
+        void FlushLocked()
+        {
+            m_vecOps.clear();
+            for (size_t i = 0; i < m_stConfig.m_ulStripes; ++i)
+            {
+                Stripe& stStripe = m_pStripes[i];
+                auto& mapFlushing = m_vecFlushing[i];
+                {
+                    std::lock_guard<std::mutex> stLock(stStripe.m_stMutex);
+                    if (stStripe.m_mapPending.empty())
+                    {
+                        continue;
+                    }
+                    // 换出后分段拿到的是上一次清空的表，保留了桶数组，不必重新分配
+                    mapFlushing.swap(stStripe.m_mapPending);
+                }
+                m_ulPending.fetch_sub(mapFlushing.size(), std::memory_order_relaxed);
+                for (auto& stPair : mapFlushing)
+                {
+                    WriteOp stOp{ EWriteOp::Add, stPair.first, stPair.second, AddOptions() };
+                    if (m_stConfig.m_eMode == ECoalesceMode::Max)
+                    {
+                        stOp.m_stOptions.m_bGt = true;
+                    }
+                    else if (m_stConfig.m_eMode == ECoalesceMode::Sum)
+                    {
+                        stOp.m_eOp = EWriteOp::IncrBy;
+                    }
+                    m_vecOps.push_back(stOp);
+                }
+            }
+            if (m_vecOps.empty())
+            {
+                return;
+            }
+            // 写操作引用换出表中的成员名，写入完成后才能清空
+            m_stBoard.ApplyBatch(m_vecOps, m_vecResults);
+            m_ulFlushed.fetch_add(m_vecOps.size(), std::memory_order_relaxed);
+            m_ulFlushes.fetch_add(1, std::memory_order_relaxed);
+            for (auto& mapFlushing : m_vecFlushing)
+            {
+                mapFlushing.clear();
+            }
+        }
+
+        void RunFlusher()
+        {
+            std::unique_lock<std::mutex> stLock(m_stFlushMutex);
+            const auto stWindow = std::chrono::milliseconds(m_stConfig.m_uiWindowMs);
+            auto stDeadline = std::chrono::steady_clock::now() + stWindow;
+            while (!m_bStop)
+            {
+                m_stWakeCond.wait_until(stLock, stDeadline, [this]()
+                {
+                    return m_bStop || m_ulPending.load(std::memory_order_relaxed) >= m_stConfig.m_ulMaxPending;
+                });
+                FlushLocked();
+                stDeadline = std::chrono::steady_clock::now() + stWindow;
+            }
+        }
+
+    public:
+        ScoreCoalescer(Leaderboard& stBoard, const CoalescerConfig& stConfig) : m_stBoard(stBoard), m_stConfig(Normalize(stConfig)),
+            m_pStripes(new Stripe[m_stConfig.m_ulStripes]), m_ulPending(0), m_ulFlushed(0), m_ulFlushes(0),
+            m_vecFlushing(m_stConfig.m_ulStripes)
+        {
+        }
+
+        ScoreCoalescer(const ScoreCoalescer&) = delete;
+        ScoreCoalescer& operator=(const ScoreCoalescer&) = delete;
+
+        ~ScoreCoalescer()
+        {
+            Stop();
+        }
+
+        // 启动后台刷新线程；不启动时只能由调用方调用 Flush 写入排行榜，Stop 之后可以再次启动
+        void Start()
+        {
+            {
+                std::lock_guard<std::mutex> stLock(m_stFlushMutex);
+                m_bStop = false;
+            }
+            m_stFlusher = std::thread([this]() { RunFlusher(); });
+        }
+
+        // 停止刷新线程并把剩余的更新全部写入排行榜
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> stLock(m_stFlushMutex);
+                m_bStop = true;
+            }
+            m_stWakeCond.notify_one();
+            if (m_stFlusher.joinable())
+            {
+                m_stFlusher.join();
+            }
+            Flush();
+        }
+
+        // 任意线程调用，把一次分数更新合并进该成员的待刷新值，分数为 NaN 时返回false
+        // 累加模式下的增量还必须是有限值：+inf 与 -inf 相加得到 NaN，会在刷新时整批写入失败
+        bool Update(std::string_view svMember, double dValue)
+        {
+            if (std::isnan(dValue) || (m_stConfig.m_eMode == ECoalesceMode::Sum && !std::isfinite(dValue)))
+            {
+                return false;
+            }
+            Stripe& stStripe = GetStripe(svMember);
+            bool bWake = false;
+            {
+                std::lock_guard<std::mutex> stLock(stStripe.m_stMutex);
+                ++stStripe.m_ulUpdates;
+                auto it = stStripe.m_mapPending.find(svMember);
+                if (it == stStripe.m_mapPending.end())
+                {
+                    stStripe.m_mapPending.emplace(svMember, dValue);
+                    // 在分段锁内计数，保证刷新换出该分段后扣减时已经计入
+                    // 只在待刷新数恰好达到上限时唤醒一次，之后的更新不再争用刷新锁
+                    bWake = m_ulPending.fetch_add(1, std::memory_order_relaxed) + 1 == m_stConfig.m_ulMaxPending;
+                }
+                else
+                {
+                    switch (m_stConfig.m_eMode)
+                    {
+                    case ECoalesceMode::Last:
+                        it->second = dValue;
+                        break;
+                    case ECoalesceMode::Max:
+                        it->second = std::max(it->second, dValue);
+                        break;
+                    case ECoalesceMode::Sum:
+                        it->second += dValue;
+                        break;
+                    }
+                }
+            }
+            if (bWake)
+            {
+                {
+                    std::lock_guard<std::mutex> stLock(m_stFlushMutex);
+                }
+                m_stWakeCond.notify_one();
+            }
+            return true;
+        }
+
+        // 立即把所有待刷新的更新写入排行榜
+        void Flush()
+        {
+            std::lock_guard<std::mutex> stLock(m_stFlushMutex);
+            FlushLocked();
+        }
+
+        // 待刷新的成员数
+        size_t GetPending() const
+        {
+            return m_ulPending.load(std::memory_order_relaxed);
+        }
+
+        CoalescerStats GetStats()
+        {
+            CoalescerStats stStats;
+            stStats.m_ulPending = m_ulPending.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < m_stConfig.m_ulStripes; ++i)
+            {
+                std::lock_guard<std::mutex> stLock(m_pStripes[i].m_stMutex);
+                stStats.m_ulUpdates += m_pStripes[i].m_ulUpdates;
+            }
+            stStats.m_ulFlushed = m_ulFlushed.load(std::memory_order_relaxed);
+            stStats.m_ulFlushes = m_ulFlushes.load(std::memory_order_relaxed);
+            return stStats;
+        }
+};
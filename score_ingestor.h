@@ -0,0 +1,333 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "leaderboard.h"
+#include "mpsc_queue.h"
+
+// 一次待写入的分数更新
+struct ScoreUpdate
+{
+    Leaderboard* m_pBoard = nullptr;   // 目标排行榜
+    std::string  m_strMember;          // 成员名
+    double       m_dValue = 0;         // Add 为分数，IncrBy 为增量
+    EWriteOp     m_eOp = EWriteOp::Add;// 操作类型
+};
+
+// 写入阶段的统计，各项只是某一时刻的近似
+struct IngestStats
+{
+    size_t   m_ulQueueDepth = 0;// 各写线程队列中尚未处理的更新数
+    size_t   m_ulCapacity = 0;  // 各写线程队列容量之和
+    uint64_t m_ulRejected = 0;  // 队列满被拒绝的更新数
+    uint64_t m_ulDrained = 0;   // 写线程取出的更新数
+    uint64_t m_ulApplied = 0;   // 合并后实际写入排行榜的操作数
+    uint64_t m_ulBatches = 0;   // 写线程处理的批次数
+};
+
+// 排行榜写入阶段：网络线程把更新放入写线程的无锁队列后立即返回，由专门的写线程批量取出，
+// 同一批中同一排行榜同一成员的多次更新先合并为一次，再按排行榜调用 ApplyBatch 写入跳表
+// 排行榜按地址哈希固定交给一个写线程，同一排行榜的更新按入队顺序生效；
+// 连续的 IncrBy 合并为一次增量相加，浮点舍入可能与逐次累加略有差异
+// 提交的排行榜在 Stop 返回之前必须保持有效
+class ScoreIngestor
+{
+    private:
+        // 合并查找键：排行榜和成员名，成员名引用本批更新中的字符串
+        struct CoalesceKey
+        {
+            Leaderboard*     m_pBoard;  // 排行榜
+            std::string_view m_svMember;// 成员名
+
+            bool operator==(const CoalesceKey& stOther) const
+            {
+                return m_pBoard == stOther.m_pBoard && m_svMember == stOther.m_svMember;
+            }
+        };
+
+        struct CoalesceKeyHash
+        {
+            size_t operator()(const CoalesceKey& stKey) const
+            {
+                return std::hash<std::string_view>()(stKey.m_svMember) ^ (std::hash<const void*>()(stKey.m_pBoard) * 31);
+            }
+        };
+
+        // 写线程及其队列，合并用的容器跨批次复用
+        struct Writer
+        {
+            MpscQueue<ScoreUpdate> m_stQueue;  // 待写入的更新
+            std::thread            m_stThread; // 写线程
+            alignas(64) std::atomic<uint32_t> m_uiSignal;// 唤醒计数，写线程在上面等待
+            std::atomic<bool>      m_bSleeping;// 写线程是否即将或正在等待
+            alignas(64) std::atomic<uint64_t> m_ulDrained;// 取出的更新数
+            std::atomic<uint64_t>  m_ulApplied;// 写入排行榜的操作数
+            std::atomic<uint64_t>  m_ulBatches;// 处理的批次数
+
+            std::vector<ScoreUpdate> m_vecBatch;// 本批取出的更新
+            std::unordered_map<CoalesceKey, size_t, CoalesceKeyHash> m_mapIndex;// 成员到其操作在所属排行榜操作列表中的下标
+            std::unordered_map<Leaderboard*, size_t> m_mapGroups;// 排行榜到分组下标
+            std::vector<std::pair<Leaderboard*, std::vector<WriteOp>>> m_vecGroups;// 按排行榜分组的操作
+            size_t                   m_ulGroups = 0;// 本批使用的分组数
+            std::vector<WriteResult> m_vecResults;// ApplyBatch 的结果，写入阶段不关心
+
+            explicit Writer(size_t ulCapacity) : m_stQueue(ulCapacity), m_uiSignal(0), m_bSleeping(false),
+                m_ulDrained(0), m_ulApplied(0), m_ulBatches(0)
+            {
+            }
+        };
+
+        std::vector<std::unique_ptr<Writer>> m_vecWriters;// 各写线程
+        const size_t m_ulMaxBatch;                        // 每批最多取出的更新数
+        std::atomic<bool> m_bStop;                        // 是否停止接收更新
+        std::atomic<bool> m_bClosed;                      // 停止后所有进行中的提交都已结束，写线程清空队列后即可退出
+        std::atomic<uint32_t> m_uiSubmitting;             // 正在入队的提交数
+        alignas(64) std::atomic<uint64_t> m_ulRejected;   // 队列满被拒绝的更新数
+
+        Writer& GetWriter(const Leaderboard* pBoard)
+        {
+            return *m_vecWriters[std::hash<const void*>()(pBoard) % m_vecWriters.size()];
+        }
+
+        // 把后到的更新合并进同一成员已有的操作，无法等价合并时返回false，由调用方另起一个操作
+        static bool Merge(WriteOp& stOp, const ScoreUpdate& stUpdate)
+        {
+            switch (stUpdate.m_eOp)
+            {
+            case EWriteOp::Add:
+            case EWriteOp::Remove:
+                // 覆盖写和删除与之前的操作无关
+                stOp = WriteOp{ stUpdate.m_eOp, stOp.m_svMember, stUpdate.m_dValue, AddOptions() };
+                return true;
+            case EWriteOp::IncrBy:
+                if (stOp.m_eOp == EWriteOp::Remove)
+                {
+                    // 删除后再增加等于以增量为分数重新加入
+                    if (std::isnan(stUpdate.m_dValue))
+                    {
+                        return false;
+                    }
+                    stOp = WriteOp{ EWriteOp::Add, stOp.m_svMember, stUpdate.m_dValue, AddOptions() };
+                    return true;
+                }
+                {
+                    // 相加得到 NaN 时逐次执行会拒绝后一次增量，合并后则会把两次都丢掉
+                    double dSum = stOp.m_dScore + stUpdate.m_dValue;
+                    if (std::isnan(dSum))
+                    {
+                        return false;
+                    }
+                    stOp.m_dScore = dSum;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void ApplyBatch(Writer& stWriter)
+        {
+            stWriter.m_mapIndex.clear();
+            stWriter.m_mapGroups.clear();
+            stWriter.m_ulGroups = 0;
+            for (const ScoreUpdate& stUpdate : stWriter.m_vecBatch)
+            {
+                auto itGroup = stWriter.m_mapGroups.find(stUpdate.m_pBoard);
+                if (itGroup == stWriter.m_mapGroups.end())
+                {
+                    if (stWriter.m_ulGroups == stWriter.m_vecGroups.size())
+                    {
+                        stWriter.m_vecGroups.emplace_back();
+                    }
+                    stWriter.m_vecGroups[stWriter.m_ulGroups].first = stUpdate.m_pBoard;
+                    stWriter.m_vecGroups[stWriter.m_ulGroups].second.clear();
+                    itGroup = stWriter.m_mapGroups.emplace(stUpdate.m_pBoard, stWriter.m_ulGroups++).first;
+                }
+                std::vector<WriteOp>& vecOps = stWriter.m_vecGroups[itGroup->second].second;
+
+                CoalesceKey stKey{ stUpdate.m_pBoard, stUpdate.m_strMember };
+                auto itIndex = stWriter.m_mapIndex.find(stKey);
+                if (itIndex != stWriter.m_mapIndex.end() && Merge(vecOps[itIndex->second], stUpdate))
+                {
+                    continue;
+                }
+                vecOps.push_back(WriteOp{ stUpdate.m_eOp, stUpdate.m_strMember, stUpdate.m_dValue, AddOptions() });
+                stWriter.m_mapIndex[stKey] = vecOps.size() - 1;
+            }
+
+            uint64_t ulApplied = 0;
+            for (size_t i = 0; i < stWriter.m_ulGroups; ++i)
+            {
+                auto& stGroup = stWriter.m_vecGroups[i];
+                stGroup.first->ApplyBatch(stGroup.second, stWriter.m_vecResults);
+                ulApplied += stGroup.second.size();
+            }
+            stWriter.m_ulDrained.store(stWriter.m_ulDrained.load(std::memory_order_relaxed) + stWriter.m_vecBatch.size(), std::memory_order_relaxed);
+            stWriter.m_ulApplied.store(stWriter.m_ulApplied.load(std::memory_order_relaxed) + ulApplied, std::memory_order_relaxed);
+            stWriter.m_ulBatches.store(stWriter.m_ulBatches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void RunWriter(Writer& stWriter)
+        {
+            for (;;)
+            {
+                ScoreUpdate stUpdate;
+                while (stWriter.m_vecBatch.size() < m_ulMaxBatch && stWriter.m_stQueue.TryPop(stUpdate))
+                {
+                    stWriter.m_vecBatch.push_back(std::move(stUpdate));
+                }
+                if (!stWriter.m_vecBatch.empty())
+                {
+                    ApplyBatch(stWriter);
+                    stWriter.m_vecBatch.clear();
+                    continue;
+                }
+
+                // 先声明将要等待再检查队列，与生产者入队后检查等待标志配对，不会漏掉唤醒
+                uint32_t uiSignal = stWriter.m_uiSignal.load(std::memory_order_acquire);
+                stWriter.m_bSleeping.store(true, std::memory_order_seq_cst);
+                // 先读关闭标志再检查队列：读到关闭时所有被接受的更新都已入队，队列为空即可退出
+                bool bClosed = m_bClosed.load(std::memory_order_seq_cst);
+                if (!stWriter.m_stQueue.Empty())
+                {
+                    // 有生产者已抢占位置但尚未写完，稍后重试
+                    stWriter.m_bSleeping.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+                if (bClosed)
+                {
+                    break;
+                }
+                stWriter.m_uiSignal.wait(uiSignal, std::memory_order_acquire);
+                stWriter.m_bSleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // 把更新放入排行榜所属写线程的队列，必要时唤醒写线程；队列满时返回false
+        bool Enqueue(Leaderboard& stBoard, std::string_view svMember, EWriteOp eOp, double dValue)
+        {
+            Writer& stWriter = GetWriter(&stBoard);
+            ScoreUpdate stUpdate;
+            stUpdate.m_pBoard = &stBoard;
+            stUpdate.m_strMember.assign(svMember);
+            stUpdate.m_dValue = dValue;
+            stUpdate.m_eOp = eOp;
+            if (!stWriter.m_stQueue.TryPush(std::move(stUpdate)))
+            {
+                m_ulRejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (stWriter.m_bSleeping.load(std::memory_order_seq_cst))
+            {
+                stWriter.m_uiSignal.fetch_add(1, std::memory_order_release);
+                stWriter.m_uiSignal.notify_one();
+            }
+            return true;
+        }
+
+    public:
+        // iWriters 个写线程，每个写线程一个容量为 ulCapacity 的队列，每批最多取出 ulMaxBatch 个更新
+        ScoreIngestor(int iWriters, size_t ulCapacity, size_t ulMaxBatch) : m_ulMaxBatch(ulMaxBatch > 0 ? ulMaxBatch : 1),
+            m_bStop(false), m_bClosed(false), m_uiSubmitting(0), m_ulRejected(0)
+        {
+            for (int i = 0; i < (iWriters > 0 ? iWriters : 1); ++i)
+            {
+                m_vecWriters.push_back(std::make_unique<Writer>(ulCapacity));
+            }
+        }
+
+        ScoreIngestor(const ScoreIngestor&) = delete;
+        ScoreIngestor& operator=(const ScoreIngestor&) = delete;
+
+        ~ScoreIngestor()
+        {
+            Stop();
+        }
+
+        // 启动写线程
+        void Start()
+        {
+            m_bStop.store(false, std::memory_order_seq_cst);
+            m_bClosed.store(false, std::memory_order_seq_cst);
+            for (auto& pWriter : m_vecWriters)
+            {
+                Writer* pRaw = pWriter.get();
+                pRaw->m_stThread = std::thread([this, pRaw]() { RunWriter(*pRaw); });
+            }
+        }
+
+        // 停止接收更新，等进行中的提交入队完成、写线程处理完队列中剩余的更新后退出
+        // Stop 返回后 Submit 一律返回false，之前返回true的更新都已写入排行榜
+        void Stop()
+        {
+            m_bStop.store(true, std::memory_order_seq_cst);
+            // 与 Submit 先登记再检查停止标志配对：要么提交看到停止，要么这里等它入队完成
+            while (m_uiSubmitting.load(std::memory_order_seq_cst) != 0)
+            {
+                std::this_thread::yield();
+            }
+            m_bClosed.store(true, std::memory_order_seq_cst);
+            for (auto& pWriter : m_vecWriters)
+            {
+                pWriter->m_uiSignal.fetch_add(1, std::memory_order_release);
+                pWriter->m_uiSignal.notify_one();
+            }
+            for (auto& pWriter : m_vecWriters)
+            {
+                if (pWriter->m_stThread.joinable())
+                {
+                    pWriter->m_stThread.join();
+                }
+            }
+        }
+
+        // 任意线程调用，把更新放入排行榜所属写线程的队列
+        // 队列满或已停止时返回false，调用方应据此限流(例如暂停读取该连接)而不是无限重试
+        bool Submit(Leaderboard& stBoard, std::string_view svMember, EWriteOp eOp, double dValue)
+        {
+            m_uiSubmitting.fetch_add(1, std::memory_order_seq_cst);
+            if (m_bStop.load(std::memory_order_seq_cst))
+            {
+                m_uiSubmitting.fetch_sub(1, std::memory_order_seq_cst);
+                return false;
+            }
+            bool bAccepted = Enqueue(stBoard, svMember, eOp, dValue);
+            m_uiSubmitting.fetch_sub(1, std::memory_order_seq_cst);
+            return bAccepted;
+        }
+
+        // 所有写线程队列中尚未处理的更新数，用于背压判断
+        size_t GetQueueDepth() const
+        {
+            size_t ulDepth = 0;
+            for (const auto& pWriter : m_vecWriters)
+            {
+                ulDepth += pWriter->m_stQueue.Size();
+            }
+            return ulDepth;
+        }
+
+        IngestStats GetStats() const
+        {
+            IngestStats stStats;
+            for (const auto& pWriter : m_vecWriters)
+            {
+                stStats.m_ulQueueDepth += pWriter->m_stQueue.Size();
+                stStats.m_ulCapacity += pWriter->m_stQueue.Capacity();
+                stStats.m_ulDrained += pWriter->m_ulDrained.load(std::memory_order_relaxed);
+                stStats.m_ulApplied += pWriter->m_ulApplied.load(std::memory_order_relaxed);
+                stStats.m_ulBatches += pWriter->m_ulBatches.load(std::memory_order_relaxed);
+            }
+            stStats.m_ulRejected = m_ulRejected.load(std::memory_order_relaxed);
+            return stStats;
+        }
+};
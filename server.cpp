@@ -0,0 +1,389 @@
+#include "server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "resp.h"
+
+const int SERVER_MAX_EVENTS = 256;          // 单次 epoll_wait 最多返回的事件数
+const size_t SERVER_READ_CHUNK = 16 * 1024; // 单次读取的字节数
+const size_t SERVER_MAX_READ_PER_EVENT = 1024 * 1024;// 一次读事件最多读取的字节数，余下的留给下一轮事件循环，限制一批命令产生的回复量
+const size_t SERVER_MAX_QUERY = 1024 * 1024 * 1024;// 单连接未解析数据上限
+const int SERVER_MAX_IOV = 1024;            // 单次 writev 的 iovec 个数上限(IOV_MAX)
+
+static bool SetNonBlocking(int iFd)
+{
+    int iFlags = fcntl(iFd, F_GETFL, 0);
+    return iFlags >= 0 && fcntl(iFd, F_SETFL, iFlags | O_NONBLOCK) == 0;
+}
+
+RankingServer::RankingServer(const ServerConfig& stConfig, RankingService& stService) : m_stConfig(stConfig), m_stService(stService)
+{
+}
+
+RankingServer::~RankingServer()
+{
+    for (auto& stPair : m_mapConnections)
+    {
+        close(stPair.first);
+    }
+    if (m_iListenFd >= 0)
+    {
+        close(m_iListenFd);
+    }
+    if (m_iEpollFd >= 0)
+    {
+        close(m_iEpollFd);
+    }
+}
+
+int CreateListenSocket(const ServerConfig& stConfig, bool bReusePort)
+{
+    int iFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (iFd < 0)
+    {
+        std::cerr << "socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    int iOn = 1;
+    setsockopt(iFd, SOL_SOCKET, SO_REUSEADDR, &iOn, sizeof(iOn));
+    if (bReusePort && setsockopt(iFd, SOL_SOCKET, SO_REUSEPORT, &iOn, sizeof(iOn)) != 0)
+    {
+        std::cerr << "setsockopt SO_REUSEPORT: " << strerror(errno) << std::endl;
+        close(iFd);
+        return -1;
+    }
+
+    sockaddr_in stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sin_family = AF_INET;
+    stAddr.sin_port = htons(stConfig.m_usPort);
+    if (inet_pton(AF_INET, stConfig.m_strBindAddr.c_str(), &stAddr.sin_addr) != 1)
+    {
+        std::cerr << "invalid bind address: " << stConfig.m_strBindAddr << std::endl;
+        close(iFd);
+        return -1;
+    }
+    if (bind(iFd, reinterpret_cast<sockaddr*>(&stAddr), sizeof(stAddr)) != 0 ||
+        listen(iFd, stConfig.m_iBacklog) != 0 || !SetNonBlocking(iFd))
+    {
+        std::cerr << "listen on " << stConfig.m_strBindAddr << ":" << stConfig.m_usPort << ": " << strerror(errno) << std::endl;
+        close(iFd);
+        return -1;
+    }
+    return iFd;
+}
+
+bool RankingServer::Start()
+{
+    m_iListenFd = CreateListenSocket(m_stConfig);
+    if (m_iListenFd < 0)
+    {
+        return false;
+    }
+
+    m_iEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_iEpollFd < 0)
+    {
+        std::cerr << "epoll_create1: " << strerror(errno) << std::endl;
+        return false;
+    }
+    epoll_event stEvent;
+    memset(&stEvent, 0, sizeof(stEvent));
+    stEvent.events = EPOLLIN;
+    stEvent.data.fd = m_iListenFd;
+    if (epoll_ctl(m_iEpollFd, EPOLL_CTL_ADD, m_iListenFd, &stEvent) != 0)
+    {
+        std::cerr << "epoll_ctl: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void RankingServer::Run(const std::atomic<bool>& bStop)
+{
+    epoll_event astEvents[SERVER_MAX_EVENTS];
+    while (!bStop.load(std::memory_order_relaxed))
+    {
+        // 超时用于定期检查退出标志
+        int iCount = epoll_wait(m_iEpollFd, astEvents, SERVER_MAX_EVENTS, 100);
+        if (iCount < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait: " << strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < iCount; ++i)
+        {
+            int iFd = astEvents[i].data.fd;
+            if (iFd == m_iListenFd)
+            {
+                Accept();
+                continue;
+            }
+            auto it = m_mapConnections.find(iFd);
+            if (it == m_mapConnections.end())
+            {
+                continue;
+            }
+            Connection& stConn = *it->second;
+            bool bKeep = true;
+            if (astEvents[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            {
+                bKeep = HandleRead(stConn);
+            }
+            if (bKeep && (astEvents[i].events & EPOLLOUT))
+            {
+                bKeep = HandleWrite(stConn);
+            }
+            if (!bKeep)
+            {
+                CloseConnection(iFd);
+            }
+        }
+        // 闲置的排行榜转为冷榜，未开启分层时直接返回
+        m_stService.EvictIdleBoards();
+    }
+}
+
+void RankingServer::Accept()
+{
+    while (true)
+    {
+        int iFd = accept4(m_iListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (iFd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                std::cerr << "accept: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        int iOn = 1;
+        setsockopt(iFd, IPPROTO_TCP, TCP_NODELAY, &iOn, sizeof(iOn));
+
+        epoll_event stEvent;
+        memset(&stEvent, 0, sizeof(stEvent));
+        stEvent.events = EPOLLIN;
+        stEvent.data.fd = iFd;
+        if (epoll_ctl(m_iEpollFd, EPOLL_CTL_ADD, iFd, &stEvent) != 0)
+        {
+            close(iFd);
+            continue;
+        }
+        std::unique_ptr<Connection> pConn(new Connection());
+        pConn->m_iFd = iFd;
+        m_mapConnections[iFd] = std::move(pConn);
+    }
+}
+
+bool RankingServer::HandleRead(Connection& stConn)
+{
+    // 读到 EAGAIN 或读满一次读事件的上限为止，客户端持续发送时不会一直读下去
+    const size_t ulStart = stConn.m_strIn.size();
+    while (true)
+    {
+        size_t ulOld = stConn.m_strIn.size();
+        stConn.m_strIn.resize(ulOld + SERVER_READ_CHUNK);
+        ssize_t lRead = read(stConn.m_iFd, &stConn.m_strIn[ulOld], SERVER_READ_CHUNK);
+        if (lRead > 0)
+        {
+            stConn.m_strIn.resize(ulOld + static_cast<size_t>(lRead));
+            if (static_cast<size_t>(lRead) < SERVER_READ_CHUNK || stConn.m_strIn.size() - ulStart >= SERVER_MAX_READ_PER_EVENT)
+            {
+                break;
+            }
+            continue;
+        }
+        stConn.m_strIn.resize(ulOld);
+        if (lRead == 0)
+        {
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            break;
+        }
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    // 一次解析出缓冲区中所有完整的命令
+    m_stBatch.m_ulCount = 0;
+    size_t ulConsumed = 0;
+    bool bProtocolError = ParseCommandBatch(stConn.m_strIn.data(), stConn.m_strIn.size(), m_stBatch, ulConsumed) == ERespParse::Error;
+    stConn.m_ulInPos = ulConsumed;
+
+    // 整批执行后一次发送全部回复，参数引用输入缓冲区，发送前不能丢弃已解析的数据
+    bool bKeep = true;
+    if (m_stBatch.m_ulCount > 0)
+    {
+        if (!m_stService.ExecuteBatch(m_stBatch, m_stReplies))
+        {
+            stConn.m_bClosing = true;
+        }
+        bKeep = SendReplies(stConn);
+    }
+    if (bProtocolError && !stConn.m_bClosing)
+    {
+        RespAppendError(stConn.m_strOut, "ERR Protocol error");
+        stConn.m_bClosing = true;
+    }
+    stConn.m_strIn.erase(0, stConn.m_ulInPos);
+    stConn.m_ulInPos = 0;
+    if (!bKeep || stConn.m_strIn.size() > SERVER_MAX_QUERY)
+    {
+        return false;
+    }
+    return HandleWrite(stConn);
+}
+
+bool RankingServer::SendReplies(Connection& stConn)
+{
+    const size_t ulSlots = m_stReplies.m_vecSlots.size();
+    size_t ulSlot = 0;
+
+    // 之前还有没发完的数据时不能插队，直接按命令顺序追加到待发送缓冲区
+    if (stConn.m_ulOutPos < stConn.m_strOut.size())
+    {
+        m_stReplies.AppendTo(stConn.m_strOut);
+        return true;
+    }
+    stConn.m_strOut.clear();
+    stConn.m_ulOutPos = 0;
+
+    iovec astIov[SERVER_MAX_IOV];
+    while (ulSlot < ulSlots)
+    {
+        // 按命令顺序组装 iovec，缓冲区中相邻的回复合并为一段，缓存的回复直接指向缓存
+        int iIovCount = 0;
+        size_t ulTotal = 0;
+        for (; ulSlot < ulSlots; ++ulSlot)
+        {
+            std::string_view svReply = m_stReplies.GetReply(ulSlot);
+            if (svReply.empty())
+            {
+                continue;
+            }
+            const char* pBase = svReply.data();
+            if (iIovCount > 0 && static_cast<const char*>(astIov[iIovCount - 1].iov_base) + astIov[iIovCount - 1].iov_len == pBase)
+            {
+                astIov[iIovCount - 1].iov_len += svReply.size();
+            }
+            else if (iIovCount == SERVER_MAX_IOV)
+            {
+                break;
+            }
+            else
+            {
+                astIov[iIovCount].iov_base = const_cast<char*>(pBase);
+                astIov[iIovCount].iov_len = svReply.size();
+                ++iIovCount;
+            }
+            ulTotal += svReply.size();
+        }
+        if (iIovCount == 0)
+        {
+            break;
+        }
+
+        ssize_t lWritten = writev(stConn.m_iFd, astIov, iIovCount);
+        while (lWritten < 0 && errno == EINTR)
+        {
+            lWritten = writev(stConn.m_iFd, astIov, iIovCount);
+        }
+        if (lWritten < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            return false;
+        }
+        size_t ulWritten = lWritten > 0 ? static_cast<size_t>(lWritten) : 0;
+        if (ulWritten == ulTotal)
+        {
+            continue;
+        }
+
+        // 没发完：把本轮剩余部分和后续回复按顺序转入待发送缓冲区，等可写事件
+        for (int i = 0; i < iIovCount; ++i)
+        {
+            if (ulWritten >= astIov[i].iov_len)
+            {
+                ulWritten -= astIov[i].iov_len;
+                continue;
+            }
+            stConn.m_strOut.append(static_cast<const char*>(astIov[i].iov_base) + ulWritten, astIov[i].iov_len - ulWritten);
+            ulWritten = 0;
+        }
+        for (; ulSlot < ulSlots; ++ulSlot)
+        {
+            stConn.m_strOut.append(m_stReplies.GetReply(ulSlot));
+        }
+        return true;
+    }
+    return true;
+}
+
+bool RankingServer::HandleWrite(Connection& stConn)
+{
+    while (stConn.m_ulOutPos < stConn.m_strOut.size())
+    {
+        ssize_t lWritten = write(stConn.m_iFd, stConn.m_strOut.data() + stConn.m_ulOutPos, stConn.m_strOut.size() - stConn.m_ulOutPos);
+        if (lWritten > 0)
+        {
+            stConn.m_ulOutPos += static_cast<size_t>(lWritten);
+            continue;
+        }
+        if (lWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            UpdateInterest(stConn, true);
+            return true;
+        }
+        if (lWritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return false;
+    }
+    stConn.m_strOut.clear();
+    stConn.m_ulOutPos = 0;
+    UpdateInterest(stConn, false);
+    return !stConn.m_bClosing;
+}
+
+void RankingServer::UpdateInterest(Connection& stConn, bool bWantWrite)
+{
+    // 客户端只发不收时回复会在 m_strOut 中无限堆积，超过上限后不再读取新命令，由 TCP 流控让客户端停下
+    bool bReadPaused = stConn.m_strOut.size() - stConn.m_ulOutPos > m_stConfig.m_ulMaxPendingOutput;
+    if (stConn.m_bWantWrite == bWantWrite && stConn.m_bReadPaused == bReadPaused)
+    {
+        return;
+    }
+    epoll_event stEvent;
+    memset(&stEvent, 0, sizeof(stEvent));
+    stEvent.events = (bReadPaused ? 0u : static_cast<uint32_t>(EPOLLIN)) | (bWantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    stEvent.data.fd = stConn.m_iFd;
+    epoll_ctl(m_iEpollFd, EPOLL_CTL_MOD, stConn.m_iFd, &stEvent);
+    stConn.m_bWantWrite = bWantWrite;
+    stConn.m_bReadPaused = bReadPaused;
+}
+
+void RankingServer::CloseConnection(int iFd)
+{
+    epoll_ctl(m_iEpollFd, EPOLL_CTL_DEL, iFd, nullptr);
+    close(iFd);
+    m_mapConnections.erase(iFd);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ranking_service.h"
+
+// 网络 I/O 引擎
+enum class EIoEngine
+{
+    Auto,   // 内核支持时使用 io_uring，否则使用 epoll
+    Epoll,  // epoll 就绪通知 + read/writev
+    IoUring,// io_uring 多发 accept/recv + 提供缓冲区
+};
+
+// 服务器配置
+struct ServerConfig
+{
+    std::string m_strBindAddr = "0.0.0.0";// 监听地址
+    uint16_t    m_usPort = 6379;          // 监听端口，默认与 Redis 相同便于直接使用现有客户端
+    int         m_iBacklog = 511;         // listen 队列长度
+    EIoEngine   m_eIoEngine = EIoEngine::Auto;// I/O 引擎
+    int         m_iShards = 1;            // 分片数，大于1时每核一个分片，排行榜按名字分布到各分片
+    std::string m_strEventShm;            // 分数变更事件环的共享内存名，为空不发布；多分片时各分片加后缀 .分片号
+    size_t      m_ulEventShmCapacity = 65536;// 事件环槽位数
+    std::string m_strColdDir;             // 冷榜文件目录，为空不分层；闲置的排行榜写到这里并释放内存，访问时再装回
+    uint32_t    m_uiColdIdleSeconds = 3600;// 排行榜闲置多久转为冷榜
+    size_t      m_ulShardQueueCapacity = 4096;// 分片间队列容量，队列满时消息暂存在发送方
+    size_t      m_ulMaxPendingOutput = 64 * 1024 * 1024;// 单连接待发送回复上限，超过后暂停读取该连接，发送到上限以下再恢复
+};
+
+// 创建非阻塞的监听套接字，bReusePort 为true时多个套接字可绑定同一端口，由内核分配连接；失败时输出原因并返回-1
+int CreateListenSocket(const ServerConfig& stConfig, bool bReusePort = false);
+
+// 基于 epoll 的单线程 RESP 服务器，一次读事件中的所有流水线命令交给 RankingService 批量执行
+class RankingServer
+{
+    private:
+        // 客户端连接
+        struct Connection
+        {
+            int         m_iFd = -1;          // 套接字
+            std::string m_strIn;             // 未解析的输入数据
+            size_t      m_ulInPos = 0;       // 已解析到的位置
+            std::string m_strOut;            // 待发送的回复
+            size_t      m_ulOutPos = 0;      // 已发送到的位置
+            bool        m_bWantWrite = false;// 是否已注册可写事件
+            bool        m_bReadPaused = false;// 待发送回复超过上限，已停止关注可读事件
+            bool        m_bClosing = false;  // 回复发完后关闭
+        };
+
+        const ServerConfig m_stConfig;     // 配置
+        RankingService&    m_stService;    // 命令服务
+        int                m_iListenFd = -1;// 监听套接字
+        int                m_iEpollFd = -1; // epoll 实例
+        std::unordered_map<int, std::unique_ptr<Connection>> m_mapConnections;// 套接字到连接
+        CommandBatch       m_stBatch;      // 解析出的流水线命令，跨读事件复用
+        ReplyBuffer        m_stReplies;    // 批量执行的回复，跨读事件复用
+
+        void Accept();
+        // 读取并执行命令，返回false表示连接应关闭
+        bool HandleRead(Connection& stConn);
+        // 发送回复，返回false表示连接应关闭
+        bool HandleWrite(Connection& stConn);
+        // 用一次 writev 发送一批回复，未发完的部分转入连接的待发送缓冲区
+        bool SendReplies(Connection& stConn);
+        void CloseConnection(int iFd);
+        // 更新关注的事件：bWantWrite 为是否等待可写，待发送回复超过上限时不再关注可读
+        void UpdateInterest(Connection& stConn, bool bWantWrite);
+
+    public:
+        RankingServer(const ServerConfig& stConfig, RankingService& stService);
+        RankingServer(const RankingServer&) = delete;
+        RankingServer& operator=(const RankingServer&) = delete;
+        ~RankingServer();
+
+        // 绑定监听端口，失败时输出原因并返回false
+        bool Start();
+        // 运行事件循环直到 bStop 被置位
+        void Run(const std::atomic<bool>& bStop);
+};
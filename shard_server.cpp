@@ -0,0 +1,624 @@
+#include "shard_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "resp.h"
+
+const int SHARD_MAX_EVENTS = 256;           // 单次 epoll_wait 最多返回的事件数
+const size_t SHARD_READ_CHUNK = 16 * 1024;  // 单次读取的字节数
+const size_t SHARD_MAX_READ_PER_EVENT = 1024 * 1024;// 一次读事件最多读取的字节数，余下的留给下一轮事件循环
+const size_t SHARD_MAX_QUERY = 1024 * 1024 * 1024;// 单连接未解析数据上限
+
+RankingShard::RankingShard(ShardedRankingServer& stServer, int iIndex) : m_stServer(stServer), m_iIndex(iIndex), m_bSleeping(false)
+{
+}
+
+RankingShard::~RankingShard()
+{
+    for (auto& stPair : m_mapConnections)
+    {
+        close(stPair.first);
+    }
+    for (int iFd : { m_iListenFd, m_iEpollFd, m_iEventFd })
+    {
+        if (iFd >= 0)
+        {
+            close(iFd);
+        }
+    }
+}
+
+bool RankingShard::Start(const ServerConfig& stConfig)
+{
+    int iShards = m_stServer.GetShardCount();
+    m_ulMaxPendingOutput = stConfig.m_ulMaxPendingOutput;
+    m_vecOutbox.resize(iShards);
+    m_vecTargets.assign(iShards, nullptr);
+    m_vecWake.assign(iShards, false);
+
+    // 事件环只有一个写入者，每个分片各用一个
+    if (!stConfig.m_strEventShm.empty())
+    {
+        if (!m_stEventRing.Create(stConfig.m_strEventShm + "." + std::to_string(m_iIndex), stConfig.m_ulEventShmCapacity))
+        {
+            return false;
+        }
+        m_stService.SetEventSink(&m_stEventRing);
+    }
+
+    // 分片的排行榜只在分片线程上访问，跳表节点放到该线程所在核的节点上，查找的每一跳都访问本地内存
+    int iCpu = m_stServer.GetShardCpu(m_iIndex);
+    if (iCpu >= 0 && GetNumaNodes().size() > 1)
+    {
+        m_pArena.reset(new NumaArena(GetCpuNumaNode(iCpu)));
+        m_stService.SetNodeArena(m_pArena.get());
+    }
+
+    // 各分片共用冷榜目录，只登记路由到本分片的排行榜
+    if (!stConfig.m_strColdDir.empty())
+    {
+        auto fnOwns = [this](std::string_view svBoard)
+        {
+            return m_stServer.GetBoardShard(svBoard) == m_iIndex;
+        };
+        if (!m_stService.SetColdTier(stConfig.m_strColdDir, stConfig.m_uiColdIdleSeconds, fnOwns))
+        {
+            return false;
+        }
+    }
+
+    m_iListenFd = CreateListenSocket(stConfig, true);
+    if (m_iListenFd < 0)
+    {
+        return false;
+    }
+    m_iEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_iEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_iEpollFd < 0 || m_iEventFd < 0)
+    {
+        std::cerr << "epoll_create1/eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    for (int iFd : { m_iListenFd, m_iEventFd })
+    {
+        epoll_event stEvent;
+        memset(&stEvent, 0, sizeof(stEvent));
+        stEvent.events = EPOLLIN;
+        stEvent.data.fd = iFd;
+        if (epoll_ctl(m_iEpollFd, EPOLL_CTL_ADD, iFd, &stEvent) != 0)
+        {
+            std::cerr << "epoll_ctl: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void RankingShard::Run(const std::atomic<bool>& bStop)
+{
+    epoll_event astEvents[SHARD_MAX_EVENTS];
+    while (!bStop.load(std::memory_order_relaxed))
+    {
+        // 先声明即将阻塞再检查队列，与 Wake 中先入队再检查标志配对，保证不会错过唤醒
+        m_bSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool bBusy = HasInboundWork();
+        for (const auto& vecOut : m_vecOutbox)
+        {
+            bBusy = bBusy || !vecOut.empty();
+        }
+        int iCount = epoll_wait(m_iEpollFd, astEvents, SHARD_MAX_EVENTS, bBusy ? 0 : 100);
+        m_bSleeping.store(false, std::memory_order_relaxed);
+        if (iCount < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait: " << strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < iCount; ++i)
+        {
+            int iFd = astEvents[i].data.fd;
+            if (iFd == m_iListenFd)
+            {
+                Accept();
+                continue;
+            }
+            if (iFd == m_iEventFd)
+            {
+                uint64_t ulValue;
+                while (read(m_iEventFd, &ulValue, sizeof(ulValue)) > 0);
+                continue;
+            }
+            auto it = m_mapConnections.find(iFd);
+            if (it == m_mapConnections.end())
+            {
+                continue;
+            }
+            Connection& stConn = *it->second;
+            bool bKeep = true;
+            if (astEvents[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            {
+                bKeep = HandleRead(stConn);
+            }
+            if (bKeep && (astEvents[i].events & EPOLLOUT) && m_mapConnections.count(iFd) != 0)
+            {
+                bKeep = HandleWrite(stConn);
+            }
+            if (!bKeep && m_mapConnections.count(iFd) != 0)
+            {
+                CloseConnection(stConn);
+            }
+        }
+        DrainInbox();
+        FlushOutbox();
+        m_stService.EvictIdleBoards();
+    }
+}
+
+void RankingShard::Wake()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_bSleeping.load(std::memory_order_relaxed))
+    {
+        uint64_t ulOne = 1;
+        ssize_t lIgnored = write(m_iEventFd, &ulOne, sizeof(ulOne));
+        (void)lIgnored;
+    }
+}
+
+bool RankingShard::HasInboundWork() const
+{
+    for (int i = 0; i < m_stServer.GetShardCount(); ++i)
+    {
+        if (i != m_iIndex && !m_stServer.GetQueue(i, m_iIndex).Empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RankingShard::DrainInbox()
+{
+    for (int i = 0; i < m_stServer.GetShardCount(); ++i)
+    {
+        if (i == m_iIndex)
+        {
+            continue;
+        }
+        SpscQueue<ShardRequest*>& stQueue = m_stServer.GetQueue(i, m_iIndex);
+        ShardRequest* pRequest = nullptr;
+        while (stQueue.TryPop(pRequest))
+        {
+            // 发起方是自己说明是送回的结果，否则是请本分片执行的命令
+            if (pRequest->m_iOrigin == m_iIndex)
+            {
+                Complete(pRequest);
+            }
+            else
+            {
+                Execute(pRequest);
+            }
+        }
+    }
+}
+
+void RankingShard::Send(int iTarget, ShardRequest* pRequest)
+{
+    std::vector<ShardRequest*>& vecOut = m_vecOutbox[iTarget];
+    if (!vecOut.empty() || !m_stServer.GetQueue(m_iIndex, iTarget).TryPush(pRequest))
+    {
+        // 队列满时暂存，保持发往同一分片的消息有序
+        vecOut.push_back(pRequest);
+        return;
+    }
+    m_vecWake[iTarget] = true;
+}
+
+void RankingShard::FlushOutbox()
+{
+    for (int i = 0; i < m_stServer.GetShardCount(); ++i)
+    {
+        std::vector<ShardRequest*>& vecOut = m_vecOutbox[i];
+        size_t ulSent = 0;
+        SpscQueue<ShardRequest*>& stQueue = m_stServer.GetQueue(m_iIndex, i);
+        while (ulSent < vecOut.size() && stQueue.TryPush(vecOut[ulSent]))
+        {
+            ++ulSent;
+        }
+        if (ulSent > 0)
+        {
+            vecOut.erase(vecOut.begin(), vecOut.begin() + static_cast<std::ptrdiff_t>(ulSent));
+            m_vecWake[i] = true;
+        }
+        // 每轮对每个目标分片最多唤醒一次
+        if (m_vecWake[i])
+        {
+            m_vecWake[i] = false;
+            m_stServer.GetShard(i).Wake();
+        }
+    }
+}
+
+ShardRequest* RankingShard::AllocRequest()
+{
+    if (m_vecFreeRequests.empty())
+    {
+        m_vecRequestPool.emplace_back(new ShardRequest());
+        m_vecRequestPool.back()->m_iOrigin = m_iIndex;
+        return m_vecRequestPool.back().get();
+    }
+    ShardRequest* pRequest = m_vecFreeRequests.back();
+    m_vecFreeRequests.pop_back();
+    return pRequest;
+}
+
+void RankingShard::FreeRequest(ShardRequest* pRequest)
+{
+    pRequest->m_pConnection = nullptr;
+    m_vecFreeRequests.push_back(pRequest);
+}
+
+void RankingShard::Accept()
+{
+    while (true)
+    {
+        int iFd = accept4(m_iListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (iFd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                std::cerr << "accept: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        int iOn = 1;
+        setsockopt(iFd, IPPROTO_TCP, TCP_NODELAY, &iOn, sizeof(iOn));
+
+        epoll_event stEvent;
+        memset(&stEvent, 0, sizeof(stEvent));
+        stEvent.events = EPOLLIN;
+        stEvent.data.fd = iFd;
+        if (epoll_ctl(m_iEpollFd, EPOLL_CTL_ADD, iFd, &stEvent) != 0)
+        {
+            close(iFd);
+            continue;
+        }
+        std::unique_ptr<Connection> pConn(new Connection());
+        pConn->m_iFd = iFd;
+        m_mapConnections[iFd] = std::move(pConn);
+    }
+}
+
+bool RankingShard::HandleRead(Connection& stConn)
+{
+    // 有命令在执行时参数还引用着 m_strIn，新数据先放到 m_strNext
+    std::string& strBuffer = stConn.m_ulPending > 0 ? stConn.m_strNext : stConn.m_strIn;
+    const size_t ulStart = strBuffer.size();
+    while (true)
+    {
+        size_t ulOld = strBuffer.size();
+        strBuffer.resize(ulOld + SHARD_READ_CHUNK);
+        ssize_t lRead = read(stConn.m_iFd, &strBuffer[ulOld], SHARD_READ_CHUNK);
+        if (lRead > 0)
+        {
+            strBuffer.resize(ulOld + static_cast<size_t>(lRead));
+            if (static_cast<size_t>(lRead) < SHARD_READ_CHUNK || strBuffer.size() - ulStart >= SHARD_MAX_READ_PER_EVENT)
+            {
+                break;
+            }
+            continue;
+        }
+        strBuffer.resize(ulOld);
+        if (lRead == 0)
+        {
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            break;
+        }
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+    if (stConn.m_strIn.size() + stConn.m_strNext.size() > SHARD_MAX_QUERY)
+    {
+        return false;
+    }
+    if (stConn.m_ulPending == 0 && !stConn.m_bClosing)
+    {
+        Dispatch(stConn);
+    }
+    return true;
+}
+
+void RankingShard::Dispatch(Connection& stConn)
+{
+    CommandBatch& stBatch = stConn.m_stBatch;
+    stBatch.m_ulCount = 0;
+    size_t ulConsumed = 0;
+    stConn.m_bProtocolError = ParseCommandBatch(stConn.m_strIn.data(), stConn.m_strIn.size(), stBatch, ulConsumed) == ERespParse::Error;
+    stConn.m_ulInPos = ulConsumed;
+
+    // QUIT 之后的命令不再执行
+    for (size_t i = 0; i < stBatch.m_ulCount; ++i)
+    {
+        if (RespEqualsIgnoreCase(stBatch.m_vecCommands[i][0], "QUIT"))
+        {
+            stBatch.m_ulCount = i + 1;
+            stConn.m_bProtocolError = false;
+            break;
+        }
+    }
+
+    // 按排行榜所在分片拆分，与排行榜无关的命令在本分片执行
+    stConn.m_vecReplyRefs.resize(stBatch.m_ulCount);
+    for (size_t i = 0; i < stBatch.m_ulCount; ++i)
+    {
+        const std::vector<std::string_view>& vecArgs = stBatch.m_vecCommands[i];
+        std::string_view svBoard;
+        int iTarget = RankingService::GetCommandBoard(vecArgs, svBoard) ? m_stServer.GetBoardShard(svBoard) : m_iIndex;
+        ShardRequest*& pRequest = m_vecTargets[iTarget];
+        if (pRequest == nullptr)
+        {
+            pRequest = AllocRequest();
+            pRequest->m_pConnection = &stConn;
+            pRequest->m_stBatch.m_ulCount = 0;
+            pRequest->m_vecIndexes.clear();
+            stConn.m_vecRequests.push_back(pRequest);
+        }
+        pRequest->m_stBatch.Next() = vecArgs;
+        stConn.m_vecReplyRefs[i] = std::make_pair(pRequest, pRequest->m_vecIndexes.size());
+        pRequest->m_vecIndexes.push_back(i);
+    }
+
+    // 先发出远程请求，再执行本地请求，让各分片并行执行
+    stConn.m_ulPending = stConn.m_vecRequests.size() + 1;
+    ShardRequest* pLocal = nullptr;
+    for (int i = 0; i < m_stServer.GetShardCount(); ++i)
+    {
+        ShardRequest* pRequest = m_vecTargets[i];
+        if (pRequest == nullptr)
+        {
+            continue;
+        }
+        m_vecTargets[i] = nullptr;
+        if (i == m_iIndex)
+        {
+            pLocal = pRequest;
+        }
+        else
+        {
+            Send(i, pRequest);
+        }
+    }
+    if (pLocal != nullptr)
+    {
+        Execute(pLocal);
+    }
+    // 计数多加的一次保证全部分发完之前不会提前完成
+    if (--stConn.m_ulPending == 0)
+    {
+        Finish(stConn);
+    }
+}
+
+void RankingShard::Execute(ShardRequest* pRequest)
+{
+    m_stService.ExecuteBatch(pRequest->m_stBatch, pRequest->m_stReplies);
+    if (pRequest->m_iOrigin == m_iIndex)
+    {
+        Complete(pRequest);
+    }
+    else
+    {
+        Send(pRequest->m_iOrigin, pRequest);
+    }
+}
+
+void RankingShard::Complete(ShardRequest* pRequest)
+{
+    Connection& stConn = *static_cast<Connection*>(pRequest->m_pConnection);
+    if (--stConn.m_ulPending == 0)
+    {
+        Finish(stConn);
+    }
+}
+
+void RankingShard::Finish(Connection& stConn)
+{
+    auto itClosing = m_mapClosing.find(&stConn);
+    if (itClosing != m_mapClosing.end())
+    {
+        // 连接已关闭，只回收请求
+        for (ShardRequest* pRequest : stConn.m_vecRequests)
+        {
+            FreeRequest(pRequest);
+        }
+        m_mapClosing.erase(itClosing);
+        return;
+    }
+
+    // 按命令顺序收集各分片的回复
+    const CommandBatch& stBatch = stConn.m_stBatch;
+    for (size_t i = 0; i < stBatch.m_ulCount; ++i)
+    {
+        const ShardRequest* pRequest = stConn.m_vecReplyRefs[i].first;
+        stConn.m_strOut.append(pRequest->m_stReplies.GetReply(stConn.m_vecReplyRefs[i].second));
+        if (RespEqualsIgnoreCase(stBatch.m_vecCommands[i][0], "QUIT"))
+        {
+            stConn.m_bClosing = true;
+        }
+    }
+    if (stConn.m_bProtocolError && !stConn.m_bClosing)
+    {
+        RespAppendError(stConn.m_strOut, "ERR Protocol error");
+        stConn.m_bClosing = true;
+    }
+    for (ShardRequest* pRequest : stConn.m_vecRequests)
+    {
+        FreeRequest(pRequest);
+    }
+    stConn.m_vecRequests.clear();
+    stConn.m_stBatch.m_ulCount = 0;
+
+    stConn.m_strIn.erase(0, stConn.m_ulInPos);
+    stConn.m_ulInPos = 0;
+    bool bMoreInput = !stConn.m_strNext.empty();
+    stConn.m_strIn.append(stConn.m_strNext);
+    stConn.m_strNext.clear();
+
+    if (!HandleWrite(stConn))
+    {
+        CloseConnection(stConn);
+        return;
+    }
+    // 执行期间收到的数据可能含有后续的完整命令，没有新数据时剩下的只是不完整的命令
+    if (!stConn.m_bClosing && bMoreInput)
+    {
+        Dispatch(stConn);
+    }
+}
+
+bool RankingShard::HandleWrite(Connection& stConn)
+{
+    while (stConn.m_ulOutPos < stConn.m_strOut.size())
+    {
+        ssize_t lWritten = write(stConn.m_iFd, stConn.m_strOut.data() + stConn.m_ulOutPos, stConn.m_strOut.size() - stConn.m_ulOutPos);
+        if (lWritten > 0)
+        {
+            stConn.m_ulOutPos += static_cast<size_t>(lWritten);
+            continue;
+        }
+        if (lWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            UpdateInterest(stConn, true);
+            return true;
+        }
+        if (lWritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return false;
+    }
+    stConn.m_strOut.clear();
+    stConn.m_ulOutPos = 0;
+    UpdateInterest(stConn, false);
+    // 回复发完再关闭，还有命令在执行时等回复到齐
+    return !stConn.m_bClosing || stConn.m_ulPending > 0;
+}
+
+void RankingShard::UpdateInterest(Connection& stConn, bool bWantWrite)
+{
+    // 与单线程服务器相同，回复堆积超过上限后不再读取新命令
+    bool bReadPaused = stConn.m_strOut.size() - stConn.m_ulOutPos > m_ulMaxPendingOutput;
+    if (stConn.m_bWantWrite == bWantWrite && stConn.m_bReadPaused == bReadPaused)
+    {
+        return;
+    }
+    epoll_event stEvent;
+    memset(&stEvent, 0, sizeof(stEvent));
+    stEvent.events = (bReadPaused ? 0u : static_cast<uint32_t>(EPOLLIN)) | (bWantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    stEvent.data.fd = stConn.m_iFd;
+    epoll_ctl(m_iEpollFd, EPOLL_CTL_MOD, stConn.m_iFd, &stEvent);
+    stConn.m_bWantWrite = bWantWrite;
+    stConn.m_bReadPaused = bReadPaused;
+}
+
+void RankingShard::CloseConnection(Connection& stConn)
+{
+    int iFd = stConn.m_iFd;
+    epoll_ctl(m_iEpollFd, EPOLL_CTL_DEL, iFd, nullptr);
+    close(iFd);
+    auto it = m_mapConnections.find(iFd);
+    if (stConn.m_ulPending > 0)
+    {
+        // 其他分片还在执行它的命令，参数引用着它的输入缓冲区，等结果送回后再释放
+        m_mapClosing[&stConn] = std::move(it->second);
+    }
+    m_mapConnections.erase(it);
+}
+
+ShardedRankingServer::ShardedRankingServer(const ServerConfig& stConfig) : m_stConfig(stConfig)
+{
+}
+
+bool ShardedRankingServer::Start()
+{
+    int iShards = m_stConfig.m_iShards > 0 ? m_stConfig.m_iShards : 1;
+    // 依次绑定到进程可用的各个核，核数少于分片数时轮流复用；分片启动时按所在核选择内存节点
+    cpu_set_t stAllowed;
+    CPU_ZERO(&stAllowed);
+    std::vector<int> vecCpus;
+    if (sched_getaffinity(0, sizeof(stAllowed), &stAllowed) == 0)
+    {
+        for (int i = 0; i < CPU_SETSIZE; ++i)
+        {
+            if (CPU_ISSET(i, &stAllowed))
+            {
+                vecCpus.push_back(i);
+            }
+        }
+    }
+    m_vecShardCpus.clear();
+    for (int i = 0; i < iShards && !vecCpus.empty(); ++i)
+    {
+        m_vecShardCpus.push_back(vecCpus[i % vecCpus.size()]);
+    }
+    for (int i = 0; i < iShards * iShards; ++i)
+    {
+        m_vecQueues.emplace_back(new SpscQueue<ShardRequest*>(m_stConfig.m_ulShardQueueCapacity));
+    }
+    for (int i = 0; i < iShards; ++i)
+    {
+        m_vecShards.emplace_back(new RankingShard(*this, i));
+    }
+    for (auto& pShard : m_vecShards)
+    {
+        if (!pShard->Start(m_stConfig))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShardedRankingServer::Run(const std::atomic<bool>& bStop)
+{
+    std::vector<std::thread> vecThreads;
+    for (int i = 0; i < GetShardCount(); ++i)
+    {
+        vecThreads.emplace_back([this, i, &bStop]()
+        {
+            m_vecShards[i]->Run(bStop);
+        });
+        if (GetShardCpu(i) >= 0)
+        {
+            cpu_set_t stCpu;
+            CPU_ZERO(&stCpu);
+            CPU_SET(GetShardCpu(i), &stCpu);
+            pthread_setaffinity_np(vecThreads.back().native_handle(), sizeof(stCpu), &stCpu);
+        }
+    }
+    for (std::thread& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+}
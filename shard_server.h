@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "numa_arena.h"
+#include "ranking_service.h"
+#include "server.h"
+#include "shm_ring.h"
+#include "spsc_queue.h"
+
+class ShardedRankingServer;
+
+// 发往排行榜所在分片执行的一组命令，执行后原对象带着回复送回发起分片
+// 命令参数引用发起连接的输入缓冲区，回复送回之前该缓冲区不会被修改
+struct ShardRequest
+{
+    int                 m_iOrigin = 0;        // 发起分片
+    void*               m_pConnection = nullptr;// 发起连接
+    CommandBatch        m_stBatch;            // 本分片要执行的命令
+    std::vector<size_t> m_vecIndexes;         // 各命令在连接本批命令中的下标
+    ReplyBuffer         m_stReplies;          // 执行结果
+};
+
+// 一个分片：独占一个核的线程，负责自己接受的连接的网络读写，并独占哈希到自己的排行榜
+// 排行榜只被本分片线程访问，使用单线程策略；分片之间通过 SPSC 队列传递请求和回复，用 eventfd 唤醒
+class RankingShard
+{
+    private:
+        // 客户端连接
+        struct Connection
+        {
+            int          m_iFd = -1;           // 套接字
+            std::string  m_strIn;              // 未解析的输入数据，有命令在执行时不能修改
+            size_t       m_ulInPos = 0;        // 本批命令解析到的位置
+            std::string  m_strNext;            // 命令执行期间新收到的数据
+            std::string  m_strOut;             // 待发送的回复
+            size_t       m_ulOutPos = 0;       // 已发送到的位置
+            CommandBatch m_stBatch;            // 本批命令
+            std::vector<std::pair<ShardRequest*, size_t>> m_vecReplyRefs;// 各命令的回复所在请求及槽位
+            std::vector<ShardRequest*> m_vecRequests;// 本批命令拆分出的请求
+            size_t       m_ulPending = 0;      // 尚未返回的请求数
+            bool         m_bProtocolError = false;// 本批命令之后遇到协议错误
+            bool         m_bWantWrite = false; // 是否已注册可写事件
+            bool         m_bReadPaused = false;// 待发送回复超过上限，已停止关注可读事件
+            bool         m_bClosing = false;   // 回复发完后关闭
+        };
+
+        ShardedRankingServer& m_stServer;      // 所属服务器
+        const int          m_iIndex;           // 分片编号
+        ShmEventRing       m_stEventRing;      // 本分片排行榜的分数变更事件环，须比 m_stService 后析构
+        std::unique_ptr<NumaArena> m_pArena;   // 多 NUMA 节点时分配本分片跳表节点的内存池，绑定到分片所在核的节点，须比 m_stService 后析构
+        RankingService     m_stService;        // 本分片独占的排行榜
+        int                m_iListenFd = -1;   // 监听套接字(SO_REUSEPORT，由内核在分片间分配连接)
+        int                m_iEpollFd = -1;    // epoll 实例
+        int                m_iEventFd = -1;    // 其他分片投递消息后的唤醒通知
+        size_t             m_ulMaxPendingOutput = 0;// 单连接待发送回复上限
+        alignas(64) std::atomic<bool> m_bSleeping;// 是否即将或正在阻塞在 epoll_wait
+        std::unordered_map<int, std::unique_ptr<Connection>> m_mapConnections;// 套接字到连接
+        std::unordered_map<Connection*, std::unique_ptr<Connection>> m_mapClosing;// 已关闭但仍有请求在途的连接
+        std::vector<std::unique_ptr<ShardRequest>> m_vecRequestPool;// 本分片分配的全部请求
+        std::vector<ShardRequest*> m_vecFreeRequests;// 空闲请求
+        std::vector<std::vector<ShardRequest*>> m_vecOutbox;// 目标分片队列满时暂存的消息
+        std::vector<ShardRequest*> m_vecTargets;// 拆分命令时各目标分片的请求，按分片下标
+        std::vector<bool>  m_vecWake;          // 本轮需要唤醒的分片
+
+        void Accept();
+        bool HandleRead(Connection& stConn);
+        bool HandleWrite(Connection& stConn);
+        // 更新关注的事件：bWantWrite 为是否等待可写，待发送回复超过上限时不再关注可读
+        void UpdateInterest(Connection& stConn, bool bWantWrite);
+        void CloseConnection(Connection& stConn);
+
+        // 解析连接输入中的完整命令，按排行榜所在分片拆分为请求并分发
+        void Dispatch(Connection& stConn);
+        // 在本分片执行请求，然后送回发起分片
+        void Execute(ShardRequest* pRequest);
+        // 发起分片收到执行结果
+        void Complete(ShardRequest* pRequest);
+        // 本批命令的回复全部到齐，按命令顺序写出回复并继续处理后续输入
+        void Finish(Connection& stConn);
+        void Send(int iTarget, ShardRequest* pRequest);
+        void FlushOutbox();
+        void DrainInbox();
+        bool HasInboundWork() const;
+
+        ShardRequest* AllocRequest();
+        void FreeRequest(ShardRequest* pRequest);
+
+    public:
+        RankingShard(ShardedRankingServer& stServer, int iIndex);
+        RankingShard(const RankingShard&) = delete;
+        RankingShard& operator=(const RankingShard&) = delete;
+        ~RankingShard();
+
+        bool Start(const ServerConfig& stConfig);
+        void Run(const std::atomic<bool>& bStop);
+        // 其他分片投递消息后调用，目标分片正在阻塞时写 eventfd 唤醒
+        void Wake();
+};
+
+// 每核一个分片的 RESP 服务器：排行榜按名字哈希固定归属一个分片，连接由接受它的分片负责读写，
+// 命令按排行榜转发到归属分片执行，各排行榜的数据只在一个核上被访问，避免缓存行在核间来回迁移
+class ShardedRankingServer
+{
+    private:
+        const ServerConfig m_stConfig;// 配置
+        std::vector<std::unique_ptr<RankingShard>> m_vecShards;// 各分片
+        std::vector<std::unique_ptr<SpscQueue<ShardRequest*>>> m_vecQueues;// 分片间队列，下标为 来源*分片数+目标
+        std::vector<int> m_vecShardCpus;// 各分片线程绑定的核，取不到可用核时为空
+
+    public:
+        explicit ShardedRankingServer(const ServerConfig& stConfig);
+        ShardedRankingServer(const ShardedRankingServer&) = delete;
+        ShardedRankingServer& operator=(const ShardedRankingServer&) = delete;
+
+        // 创建各分片并绑定监听端口，失败时输出原因并返回false
+        bool Start();
+        // 每个分片一个线程并绑定到一个核，运行直到 bStop 被置位
+        void Run(const std::atomic<bool>& bStop);
+
+        int GetShardCount() const
+        {
+            return static_cast<int>(m_vecShards.size());
+        }
+
+        // 分片线程绑定的核，不绑定时返回-1
+        int GetShardCpu(int iIndex) const
+        {
+            return m_vecShardCpus.empty() ? -1 : m_vecShardCpus[iIndex];
+        }
+
+        RankingShard& GetShard(int iIndex)
+        {
+            return *m_vecShards[iIndex];
+        }
+
+        SpscQueue<ShardRequest*>& GetQueue(int iFrom, int iTo)
+        {
+            return *m_vecQueues[iFrom * GetShardCount() + iTo];
+        }
+
+        // 排行榜所在的分片
+        int GetBoardShard(std::string_view svBoard) const
+        {
+            return static_cast<int>(std::hash<std::string_view>()(svBoard) % m_vecShards.size());
+        }
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "leaderboard.h"
+#include "loser_tree.h"
+
+// 按成员名哈希分片的排行榜：每个分片是一个独立加锁的跳表排行榜，不同分片上的写入互不争用
+// 全局排名区间由各分片的有序游标经败者树 k 路归并得出，游标按需分块读取，前N名每个分片只读出大约 N/分片数 名
+// 同分成员按分片下标、分片内顺序排列；各分片分别加锁，跨分片的查询不是同一时刻的快照
+template<typename Access>
+class HashShardedBoard
+{
+    private:
+        using Board = BasicLeaderboard<Access>;
+
+        // 游标每次至少读出的条数
+        static constexpr size_t MIN_CHUNK = 16;
+
+        // 分片的有序游标，缓冲用完时再向分片读取下一块，块大小逐次翻倍
+        struct ShardCursor
+        {
+            Board*                 m_pBoard = nullptr;
+            std::vector<RankEntry> m_vecBuffer;   // 已读出的一块
+            size_t                 m_ulPos = 0;   // 缓冲中的当前位置
+            size_t                 m_ulNextRank = 0;// 下一块在分片中的起始排名
+            size_t                 m_ulChunk = MIN_CHUNK;// 下一块的大小
+            bool                   m_bReverse = true;
+            bool                   m_bDrained = false;// 分片已读完
+
+            bool Valid() const
+            {
+                return m_ulPos < m_vecBuffer.size();
+            }
+
+            const RankEntry& Current() const
+            {
+                return m_vecBuffer[m_ulPos];
+            }
+
+            void Fetch()
+            {
+                m_ulPos = 0;
+                m_vecBuffer.clear();
+                if (m_bDrained)
+                {
+                    return;
+                }
+                m_pBoard->GetRange(static_cast<int64_t>(m_ulNextRank), static_cast<int64_t>(m_ulNextRank + m_ulChunk - 1), m_bReverse, m_vecBuffer);
+                m_bDrained = m_vecBuffer.size() < m_ulChunk;
+                m_ulNextRank += m_vecBuffer.size();
+                m_ulChunk *= 2;
+            }
+
+            void Next()
+            {
+                if (++m_ulPos == m_vecBuffer.size())
+                {
+                    Fetch();
+                }
+            }
+        };
+
+        size_t                   m_ulShards;// 分片数
+        std::unique_ptr<Board[]> m_pShards; // 各分片
+
+        size_t GetShardIndex(std::string_view svMember) const
+        {
+            return StringHash()(svMember) % m_ulShards;
+        }
+
+        Board& GetShard(std::string_view svMember)
+        {
+            return m_pShards[GetShardIndex(svMember)];
+        }
+
+    public:
+        explicit HashShardedBoard(size_t ulShards) : m_ulShards(std::max<size_t>(ulShards, 1)), m_pShards(new Board[m_ulShards])
+        {
+        }
+
+        HashShardedBoard(const HashShardedBoard&) = delete;
+        HashShardedBoard& operator=(const HashShardedBoard&) = delete;
+
+        EAddResult Add(std::string_view svMember, double dScore, const AddOptions& stOptions = AddOptions())
+        {
+            return GetShard(svMember).Add(svMember, dScore, stOptions);
+        }
+
+        bool IncrBy(std::string_view svMember, double dDelta, double& dNewScore)
+        {
+            return GetShard(svMember).IncrBy(svMember, dDelta, dNewScore);
+        }
+
+        bool Remove(std::string_view svMember)
+        {
+            return GetShard(svMember).Remove(svMember);
+        }
+
+        bool GetScore(std::string_view svMember, double& dScore)
+        {
+            return GetShard(svMember).GetScore(svMember, dScore);
+        }
+
+        // 精确的全局排名：本分片内排名加上其他分片中排在前面的成员数，bReverse 为true时按分数从高到低
+        // 其他分片的计数是两次按跳表各层跨度的排名查询之差，合计 O(分片数 * log n)，与排名大小无关
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            size_t ulIndex = GetShardIndex(svMember);
+            Board& stShard = m_pShards[ulIndex];
+            double dScore = 0;
+            size_t ulRevRank = 0;
+            if (!stShard.GetScore(svMember, dScore) || !stShard.GetRank(svMember, true, ulRevRank))
+            {
+                return false;
+            }
+            const ScoreBound stTop{ std::numeric_limits<double>::infinity(), false };
+            size_t ulTotal = stShard.Size();
+            for (size_t i = 0; i < m_ulShards; ++i)
+            {
+                if (i == ulIndex)
+                {
+                    continue;
+                }
+                // 同分成员按分片下标排列，下标更小的分片中的同分成员排在前面
+                ScoreBound stMin{ dScore, i > ulIndex };
+                ulRevRank += m_pShards[i].Count(stMin, stTop);
+                ulTotal += m_pShards[i].Size();
+            }
+            ulRank = bReverse ? ulRevRank : ulTotal - 1 - ulRevRank;
+            return true;
+        }
+
+        // 近似的全局排名：只在成员所在分片查询排名，按各分片成员数的比例放大
+        // 成员按哈希均匀分布时各分片的分数分布相近，误差随分片成员数增大而减小，代价约为精确查询的 1/分片数
+        bool GetApproxRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            Board& stShard = GetShard(svMember);
+            size_t ulLocal = 0;
+            if (!stShard.GetRank(svMember, bReverse, ulLocal))
+            {
+                return false;
+            }
+            size_t ulLocalSize = std::max<size_t>(stShard.Size(), 1);
+            size_t ulTotal = Size();
+            ulRank = static_cast<size_t>(static_cast<double>(ulLocal) * static_cast<double>(ulTotal) / static_cast<double>(ulLocalSize));
+            ulRank = std::min(ulRank, ulTotal > 0 ? ulTotal - 1 : 0);
+            return true;
+        }
+
+        // 按全局排名区间查询，bReverse 为true时按分数从高到低
+        // 败者树归并各分片游标，跳过 ulFirst 名后取出区间内的成员
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            vecOut.clear();
+            size_t ulFirst = 0;
+            size_t ulLast = 0;
+            if (!NormalizeRankRange(llStart, llStop, Size(), ulFirst, ulLast))
+            {
+                return;
+            }
+            // 每个分片最多贡献 ulLast+1 名；成员按哈希均匀分布时各分片的份额近似二项分布，
+            // 首块读取平均份额加两倍标准差，多数分片一块即可
+            size_t ulNeed = ulLast + 1;
+            double dShare = static_cast<double>(ulNeed) / static_cast<double>(m_ulShards);
+            size_t ulChunk = std::min(ulNeed, std::max(MIN_CHUNK, static_cast<size_t>(dShare + 2 * std::sqrt(dShare)) + 1));
+            std::vector<ShardCursor> vecCursors(m_ulShards);
+            for (size_t i = 0; i < m_ulShards; ++i)
+            {
+                ShardCursor& stCursor = vecCursors[i];
+                stCursor.m_pBoard = &m_pShards[i];
+                stCursor.m_ulChunk = ulChunk;
+                stCursor.m_bReverse = bReverse;
+                stCursor.Fetch();
+            }
+            // 降序时同分按分片下标升序，升序时反过来，两个方向互为逆序
+            LoserTree stTree(m_ulShards, [&vecCursors, bReverse](size_t ulA, size_t ulB)
+            {
+                const ShardCursor& stA = vecCursors[ulA];
+                const ShardCursor& stB = vecCursors[ulB];
+                if (!stA.Valid() || !stB.Valid())
+                {
+                    return stA.Valid();
+                }
+                double dA = stA.Current().m_dScore;
+                double dB = stB.Current().m_dScore;
+                if (dA != dB)
+                {
+                    return bReverse ? dA > dB : dA < dB;
+                }
+                return bReverse ? ulA < ulB : ulA > ulB;
+            });
+            vecOut.reserve(ulLast - ulFirst + 1);
+            for (size_t ulRank = 0; ulRank <= ulLast; ++ulRank)
+            {
+                ShardCursor& stCursor = vecCursors[stTree.Winner()];
+                if (!stCursor.Valid())
+                {
+                    // 查询期间有成员被删除，所有分片都已读完
+                    break;
+                }
+                if (ulRank >= ulFirst)
+                {
+                    vecOut.push_back(stCursor.Current());
+                }
+                stCursor.Next();
+                stTree.Replay();
+            }
+        }
+
+        // 分数最高的 ulK 名(从高到低)
+        void GetTop(size_t ulK, std::vector<RankEntry>& vecOut)
+        {
+            if (ulK == 0)
+            {
+                vecOut.clear();
+                return;
+            }
+            GetRange(0, static_cast<int64_t>(ulK) - 1, true, vecOut);
+        }
+
+        // 统计分数在 [stMin, stMax] 内的成员数
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            size_t ulCount = 0;
+            for (size_t i = 0; i < m_ulShards; ++i)
+            {
+                ulCount += m_pShards[i].Count(stMin, stMax);
+            }
+            return ulCount;
+        }
+
+        // 在榜成员数
+        size_t Size() const
+        {
+            size_t ulSize = 0;
+            for (size_t i = 0; i < m_ulShards; ++i)
+            {
+                ulSize += m_pShards[i].Size();
+            }
+            return ulSize;
+        }
+
+        size_t GetShardCount() const
+        {
+            return m_ulShards;
+        }
+};
+
+// 多线程共享的哈希分片排行榜
+using ShardedLeaderboard = HashShardedBoard<ConcurrentAccess>;
+// 只由一个线程访问的哈希分片排行榜
+using LocalShardedLeaderboard = HashShardedBoard<SingleThreadAccess>;
@@ -0,0 +1,335 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "leaderboard.h"
+
+// 共享内存事件环的文件格式
+const uint64_t SHM_RING_MAGIC = 0x474E4952474B4E52ULL;// "RNKGRING"
+const uint32_t SHM_RING_VERSION = 1;
+const size_t SHM_RING_BOARD_LEN = 32; // 排行榜名最多保存的字节数
+const size_t SHM_RING_MEMBER_LEN = 48;// 成员名最多保存的字节数
+const uint64_t SHM_RING_BUSY = 1ULL << 63;// 槽位序号的高位：写入者正在改写该槽位
+
+// 事件环头部，位于共享内存开头
+struct ShmRingHeader
+{
+    uint64_t m_ulMagic;     // SHM_RING_MAGIC
+    uint32_t m_uiVersion;   // SHM_RING_VERSION
+    uint32_t m_uiRecordSize;// sizeof(ShmEventRecord)，读者据此确认布局一致
+    uint64_t m_ulCapacity;  // 槽位数，2的幂
+    alignas(64) std::atomic<uint64_t> m_ulLastSeq;// 最近写完的事件序号，从1开始
+};
+
+// 定长事件记录，独占两条缓存行；名字超长时截断并置 m_ucTruncated
+struct alignas(64) ShmEventRecord
+{
+    std::atomic<uint64_t> m_ulSeq;// 本槽位事件的序号，带 SHM_RING_BUSY 表示正在改写
+    uint8_t  m_ucType;            // EScoreEvent
+    uint8_t  m_ucBoardLen;        // 排行榜名长度
+    uint8_t  m_ucMemberLen;       // 成员名长度
+    uint8_t  m_ucTruncated;       // 名字是否被截断
+    uint8_t  m_aucReserved[4];
+    int64_t  m_llTimeNs;          // 写入时间(CLOCK_REALTIME 纳秒)
+    double   m_dOldScore;         // 变更前分数
+    double   m_dNewScore;         // 变更后分数
+    char     m_szBoard[SHM_RING_BOARD_LEN];  // 排行榜名，不以0结尾
+    char     m_szMember[SHM_RING_MEMBER_LEN];// 成员名，不以0结尾
+};
+
+static_assert(sizeof(ShmEventRecord) == 128, "ShmEventRecord layout changed");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory ring needs address-free 64-bit atomics");
+
+// 读者取到的事件，名字已复制出来
+struct ShmEvent
+{
+    uint64_t    m_ulSeq = 0;     // 事件序号
+    EScoreEvent m_eType = EScoreEvent::Added;// 变更类型
+    bool        m_bTruncated = false;// 名字是否被截断
+    int64_t     m_llTimeNs = 0;  // 写入时间
+    double      m_dOldScore = 0; // 变更前分数
+    double      m_dNewScore = 0; // 变更后分数
+    std::string m_strBoard;      // 排行榜名
+    std::string m_strMember;     // 成员名
+};
+
+// 把分数变更写入 POSIX 共享内存中的单生产者多消费者环
+// 写入者从不等待读者：环满后直接覆盖最旧的槽位，每个槽位像顺序锁一样先标记改写中、写数据、再发布序号，
+// 读者按序号读取，读前读后序号不一致或已被更新的事件覆盖即说明落后太多，跳到仍然有效的位置继续
+// 只能有一个线程写入，挂在多个排行榜上时这些排行榜的写操作必须在同一线程执行
+class ShmEventRing : public ScoreEventSink
+{
+    private:
+        std::string     m_strName;          // 共享内存名
+        void*           m_pMap = nullptr;   // 映射地址
+        size_t          m_ulMapSize = 0;    // 映射长度
+        ShmRingHeader*  m_pHeader = nullptr;// 头部
+        ShmEventRecord* m_pRecords = nullptr;// 槽位数组
+        uint64_t        m_ulMask = 0;       // 槽位数-1
+        uint64_t        m_ulSeq = 0;        // 最近写入的序号
+
+    public:
+        ShmEventRing() = default;
+        ShmEventRing(const ShmEventRing&) = delete;
+        ShmEventRing& operator=(const ShmEventRing&) = delete;
+
+        ~ShmEventRing()
+        {
+            Close();
+        }
+
+        // 创建(或重建)名为 strName 的共享内存，容量向上取为2的幂，失败时输出原因并返回false
+        bool Create(const std::string& strName, size_t ulCapacity)
+        {
+            size_t ulSlots = 1;
+            while (ulSlots < ulCapacity)
+            {
+                ulSlots <<= 1;
+            }
+            shm_unlink(strName.c_str());
+            int iFd = shm_open(strName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+            if (iFd < 0)
+            {
+                std::cerr << "shm_open " << strName << " failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            size_t ulSize = sizeof(ShmRingHeader) + ulSlots * sizeof(ShmEventRecord);
+            if (ftruncate(iFd, static_cast<off_t>(ulSize)) != 0)
+            {
+                std::cerr << "ftruncate " << strName << " failed: " << strerror(errno) << std::endl;
+                close(iFd);
+                shm_unlink(strName.c_str());
+                return false;
+            }
+            void* pMap = mmap(nullptr, ulSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+            close(iFd);
+            if (pMap == MAP_FAILED)
+            {
+                std::cerr << "mmap " << strName << " failed: " << strerror(errno) << std::endl;
+                shm_unlink(strName.c_str());
+                return false;
+            }
+
+            // ftruncate 得到的内存全为0，即所有槽位序号为0(空)；最后写魔数，读者看到魔数时头部已完整
+            m_strName = strName;
+            m_pMap = pMap;
+            m_ulMapSize = ulSize;
+            m_pHeader = static_cast<ShmRingHeader*>(pMap);
+            m_pRecords = reinterpret_cast<ShmEventRecord*>(static_cast<char*>(pMap) + sizeof(ShmRingHeader));
+            m_ulMask = ulSlots - 1;
+            m_ulSeq = 0;
+            m_pHeader->m_uiVersion = SHM_RING_VERSION;
+            m_pHeader->m_uiRecordSize = sizeof(ShmEventRecord);
+            m_pHeader->m_ulCapacity = ulSlots;
+            m_pHeader->m_ulLastSeq.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_pHeader->m_ulMagic = SHM_RING_MAGIC;
+            return true;
+        }
+
+        // 解除映射并删除共享内存，已打开的读者仍可读完映射中的数据
+        void Close()
+        {
+            if (m_pMap != nullptr)
+            {
+                munmap(m_pMap, m_ulMapSize);
+                shm_unlink(m_strName.c_str());
+                m_pMap = nullptr;
+            }
+        }
+
+        const std::string& GetName() const
+        {
+            return m_strName;
+        }
+
+        void OnScoreEvent(const ScoreEvent& stEvent) override
+        {
+            uint64_t ulSeq = ++m_ulSeq;
+            ShmEventRecord& stRecord = m_pRecords[ulSeq & m_ulMask];
+            stRecord.m_ulSeq.store(ulSeq | SHM_RING_BUSY, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            timespec stNow;
+            clock_gettime(CLOCK_REALTIME, &stNow);
+            size_t ulBoardLen = std::min(stEvent.m_svBoard.size(), SHM_RING_BOARD_LEN);
+            size_t ulMemberLen = std::min(stEvent.m_svMember.size(), SHM_RING_MEMBER_LEN);
+            stRecord.m_ucType = static_cast<uint8_t>(stEvent.m_eType);
+            stRecord.m_ucBoardLen = static_cast<uint8_t>(ulBoardLen);
+            stRecord.m_ucMemberLen = static_cast<uint8_t>(ulMemberLen);
+            stRecord.m_ucTruncated = ulBoardLen < stEvent.m_svBoard.size() || ulMemberLen < stEvent.m_svMember.size();
+            stRecord.m_llTimeNs = static_cast<int64_t>(stNow.tv_sec) * 1000000000LL + stNow.tv_nsec;
+            stRecord.m_dOldScore = stEvent.m_dOldScore;
+            stRecord.m_dNewScore = stEvent.m_dNewScore;
+            memcpy(stRecord.m_szBoard, stEvent.m_svBoard.data(), ulBoardLen);
+            memcpy(stRecord.m_szMember, stEvent.m_svMember.data(), ulMemberLen);
+
+            stRecord.m_ulSeq.store(ulSeq, std::memory_order_release);
+            m_pHeader->m_ulLastSeq.store(ulSeq, std::memory_order_release);
+        }
+};
+
+// 读取结果
+enum class EShmRead
+{
+    Ok,     // 读到一个事件
+    Empty,  // 没有新事件
+    Overrun,// 落后太多，部分事件已被覆盖，已跳到仍然有效的位置
+};
+
+// 事件环的读者，可以在其他进程中打开，任意多个读者互不影响
+class ShmEventReader
+{
+    private:
+        void*                 m_pMap = nullptr;   // 映射地址
+        size_t                m_ulMapSize = 0;    // 映射长度
+        const ShmRingHeader*  m_pHeader = nullptr;// 头部
+        const ShmEventRecord* m_pRecords = nullptr;// 槽位数组
+        uint64_t              m_ulMask = 0;       // 槽位数-1
+        uint64_t              m_ulNext = 1;       // 下一个要读的序号
+        uint64_t              m_ulLost = 0;       // 因落后被覆盖而丢失的事件数
+
+        // 跳到仍未被覆盖的最旧事件，再给写入者留出一半容量的余量，避免刚跳过去又被覆盖
+        void SkipOverrun()
+        {
+            uint64_t ulLast = m_pHeader->m_ulLastSeq.load(std::memory_order_acquire);
+            uint64_t ulCapacity = m_ulMask + 1;
+            uint64_t ulNext = ulLast > ulCapacity / 2 ? ulLast - ulCapacity / 2 + 1 : 1;
+            if (ulNext > m_ulNext)
+            {
+                m_ulLost += ulNext - m_ulNext;
+                m_ulNext = ulNext;
+            }
+        }
+
+    public:
+        ShmEventReader() = default;
+        ShmEventReader(const ShmEventReader&) = delete;
+        ShmEventReader& operator=(const ShmEventReader&) = delete;
+
+        ~ShmEventReader()
+        {
+            if (m_pMap != nullptr)
+            {
+                munmap(m_pMap, m_ulMapSize);
+            }
+        }
+
+        // 只读打开事件环，bFromLatest 为true时只读打开之后的新事件，失败时输出原因并返回false
+        bool Open(const std::string& strName, bool bFromLatest)
+        {
+            int iFd = shm_open(strName.c_str(), O_RDONLY | O_CLOEXEC, 0);
+            if (iFd < 0)
+            {
+                std::cerr << "shm_open " << strName << " failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            struct stat stStat;
+            if (fstat(iFd, &stStat) != 0 || static_cast<size_t>(stStat.st_size) < sizeof(ShmRingHeader))
+            {
+                std::cerr << strName << " is not an event ring" << std::endl;
+                close(iFd);
+                return false;
+            }
+            size_t ulSize = static_cast<size_t>(stStat.st_size);
+            void* pMap = mmap(nullptr, ulSize, PROT_READ, MAP_SHARED, iFd, 0);
+            close(iFd);
+            if (pMap == MAP_FAILED)
+            {
+                std::cerr << "mmap " << strName << " failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            m_pMap = pMap;
+            m_ulMapSize = ulSize;
+            m_pHeader = static_cast<const ShmRingHeader*>(pMap);
+            if (m_pHeader->m_ulMagic != SHM_RING_MAGIC || m_pHeader->m_uiVersion != SHM_RING_VERSION
+                || m_pHeader->m_uiRecordSize != sizeof(ShmEventRecord)
+                || sizeof(ShmRingHeader) + m_pHeader->m_ulCapacity * sizeof(ShmEventRecord) > ulSize)
+            {
+                std::cerr << strName << " has an incompatible event ring layout" << std::endl;
+                return false;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            m_pRecords = reinterpret_cast<const ShmEventRecord*>(static_cast<const char*>(pMap) + sizeof(ShmRingHeader));
+            m_ulMask = m_pHeader->m_ulCapacity - 1;
+            m_ulNext = 1;
+            if (bFromLatest)
+            {
+                m_ulNext = m_pHeader->m_ulLastSeq.load(std::memory_order_acquire) + 1;
+            }
+            else
+            {
+                SkipOverrun();
+                m_ulLost = 0;
+            }
+            return true;
+        }
+
+        // 读取下一个事件
+        EShmRead Read(ShmEvent& stEvent)
+        {
+            const ShmEventRecord& stRecord = m_pRecords[m_ulNext & m_ulMask];
+            uint64_t ulSeq = stRecord.m_ulSeq.load(std::memory_order_acquire);
+            uint64_t ulSlotSeq = ulSeq & ~SHM_RING_BUSY;
+            if (ulSlotSeq < m_ulNext || (ulSlotSeq == m_ulNext && ulSeq != ulSlotSeq))
+            {
+                // 还没写到或正在写
+                return EShmRead::Empty;
+            }
+            if (ulSlotSeq != m_ulNext)
+            {
+                // 槽位已被更新的事件占用
+                SkipOverrun();
+                return EShmRead::Overrun;
+            }
+
+            char szBoard[SHM_RING_BOARD_LEN];
+            char szMember[SHM_RING_MEMBER_LEN];
+            uint8_t ucType = stRecord.m_ucType;
+            size_t ulBoardLen = std::min<size_t>(stRecord.m_ucBoardLen, SHM_RING_BOARD_LEN);
+            size_t ulMemberLen = std::min<size_t>(stRecord.m_ucMemberLen, SHM_RING_MEMBER_LEN);
+            bool bTruncated = stRecord.m_ucTruncated != 0;
+            int64_t llTimeNs = stRecord.m_llTimeNs;
+            double dOldScore = stRecord.m_dOldScore;
+            double dNewScore = stRecord.m_dNewScore;
+            memcpy(szBoard, stRecord.m_szBoard, ulBoardLen);
+            memcpy(szMember, stRecord.m_szMember, ulMemberLen);
+
+            // 复制期间槽位被改写过则数据可能不完整，视为落后
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (stRecord.m_ulSeq.load(std::memory_order_relaxed) != m_ulNext)
+            {
+                SkipOverrun();
+                return EShmRead::Overrun;
+            }
+
+            stEvent.m_ulSeq = m_ulNext++;
+            stEvent.m_eType = static_cast<EScoreEvent>(ucType);
+            stEvent.m_bTruncated = bTruncated;
+            stEvent.m_llTimeNs = llTimeNs;
+            stEvent.m_dOldScore = dOldScore;
+            stEvent.m_dNewScore = dNewScore;
+            stEvent.m_strBoard.assign(szBoard, ulBoardLen);
+            stEvent.m_strMember.assign(szMember, ulMemberLen);
+            return EShmRead::Ok;
+        }
+
+        // 因落后被覆盖而丢失的事件总数
+        uint64_t GetLost() const
+        {
+            return m_ulLost;
+        }
+};
@@ -1,32 +1,57 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <mutex>
+#include <new>
 #include <random>
+#include <type_traits>
+#include <vector>
 
 // std::atomic 原子操作
 // std::mt19937 随机值
 
+// 跳表节点的内存来源，例如绑定到某个 NUMA 节点的内存池；需要比使用它的跳表活得更久
+class NodeArena
+{
+    public:
+        virtual ~NodeArena() = default;
+        virtual void* Allocate(size_t ulBytes) = 0;
+        virtual void Deallocate(void* pBlock, size_t ulBytes) = 0;
+};
+
 // 跳表节点模板类，支持任意类型的键值对
 template<typename K, typename V>
 struct Node
 {
     K m_stKey;  // 节点键值，用于排序
     V m_stValue;// 节点存储的值
-    std::atomic<Node<K, V>**>    m_pstForward;// 指向下一个节点的原子指针数组，支持多层级索引
+    std::atomic<Node<K, V>*>*    m_pstForward;// 各层级的原子后继指针数组，指针最低位为删除标记
+    std::atomic<size_t>*         m_pulSpan;   // 各层级到后继节点之间跨过的第0层节点数，用于按排名定位
     std::atomic<int>            m_iTopLevel;// 节点的最高层级，随机生成
     std::atomic<bool>         m_bMarked;    // 标记节点是否被删除(逻辑删除)
     std::atomic<bool>         m_bFullyLinked;// 标记节点是否已完全链接到跳表中
+    Node<K, V>*               m_pstNextRetired;// 退休链表中的下一个节点
+    bool                      m_bOwnForward;// 指针和跨度数组是否由节点自己分配
     char                                m_chPadding[64];// 内存对齐填充，减少伪共享
-    
+
     // 节点构造函数
-    Node(K k, V v, int level) : m_stKey(k), m_stValue(v), m_bMarked(false), m_bFullyLinked(false) 
+    Node(K k, V v, int level) : Node(k, v, level, new std::atomic<Node<K, V>*>[level + 1], new std::atomic<size_t>[level + 1])// 分配层级+1个指针和跨度空间
+    {
+        m_bOwnForward = true;
+    }
+
+    // 使用外部提供的指针和跨度数组，数组与节点放在同一块内存中，由分配方负责释放
+    Node(K k, V v, int level, std::atomic<Node<K, V>*>* pstForward, std::atomic<size_t>* pulSpan) : m_stKey(k), m_stValue(v), m_pstForward(pstForward),
+        m_pulSpan(pulSpan), m_bMarked(false), m_bFullyLinked(false), m_pstNextRetired(nullptr), m_bOwnForward(false)
     {
-        m_pstForward = new Node<K, V>* [level + 1];// 分配层级+1个指针空间
         for (int i = 0; i <= level; ++i)
         {
             // 初始化各层级的指针为空
-            m_pstForward.load()[i] = nullptr;
+            m_pstForward[i].store(nullptr, std::memory_order_relaxed);
+            m_pulSpan[i].store(0, std::memory_order_relaxed);
         }
 
         // 设置节点的最高层级
@@ -34,104 +59,524 @@ struct Node
     }
 
     // 节点析构函数
-    ~Node() 
+    ~Node()
     {
-        // 释放指针数组内存
-        delete[] m_pstForward;
+        // 释放指针和跨度数组内存
+        if (m_bOwnForward)
+        {
+            delete[] m_pstForward;
+            delete[] m_pulSpan;
+        }
     }
 };
 
-// 跳表模板类，实现无锁的高效插入、删除和查找操作
+// 批量装载游标，记录各层级当前的最后一个节点，供有序数据顺序追加
 template<typename K, typename V>
+struct BulkCursor
+{
+    std::vector<Node<K, V>*> m_vecLast;// 各层级最后一个节点
+    std::vector<size_t>      m_vecLastPos;// 各层级最后一个节点的位置，头节点为0
+    K                        m_stLastKey;// 最近一次追加的键，用于校验有序
+    bool                     m_bHasLast = false;// 是否已追加过节点
+};
+
+// 并发访问策略：多个线程可同时读写，后继指针用 CAS 修改
+struct ConcurrentAccess
+{
+    static constexpr bool CONCURRENT = true;
+};
+
+// 单线程访问策略：跳表只由一个线程读写(如分片独占的排行榜)，CAS 退化为普通读写，计数不用原子加减
+struct SingleThreadAccess
+{
+    static constexpr bool CONCURRENT = false;
+};
+
+// 跳表模板类，Access 选择并发或单线程访问策略
+// 查找和遍历不加锁；写操作之间由写锁串行，节点先标记再摘除，无锁遍历的线程跳过已标记的节点
+// 每个节点的每层记录到后继之间跨过的节点数，排名和按排名定位沿跨度下降，O(log n)；
+// 写操作修改跨度期间写序号为奇数，按排名读取的线程在写序号变化时重试，读到的排名是某个写操作前后的一致结果
+// 删除和并发策略下更新值摘下的节点挂在退休链表上，无锁读者可能仍在访问，跳表不会自行释放；
+// 使用方须在没有读者的时刻调用 ReclaimRetired 回收(如 BasicLeaderboard 在每次写操作结束时)，否则退休节点一直累积到析构
+template<typename K, typename V, typename Access = ConcurrentAccess>
 class SkipList
 {
     private:
+        // 单线程访问时的空锁
+        struct NullLock
+        {
+            void lock() {}
+            void unlock() {}
+        };
+
+        using WriteMutex = std::conditional_t<Access::CONCURRENT, std::mutex, NullLock>;
+
         const int MAXLEVEL;           // 跳表的最大层级限制
         const float PROBABILITY;    // 随机层级生成的概率因子
         std::atomic<int> m_iCurrentLevel;// 当前跳表的实际最高层级
-        Node<K, V> m_stHead;         // 头节点指针
-        Node<K, V> m_stTail;            // 尾节点指针
+        std::atomic<size_t> m_ulSize;   // 跳表中有效节点数量
+        Node<K, V>* m_stHead;         // 头节点指针
+        Node<K, V>* m_stTail;            // 尾节点指针
         std::mt19937    m_iRang;        // Mersenne Twister随机数生成器
+        std::atomic<Node<K, V>*> m_pstRetired;// 已摘除节点链表，析构时统一释放
+        NodeArena*      m_pArena = nullptr;// 节点内存来源，为空时使用 new/delete
+        WriteMutex      m_stWriteMutex;   // 串行化写操作
+        std::atomic<uint64_t> m_ulWriteSeq{0};// 写序号，写操作进行中为奇数
+
+        // 单线程策略下不需要跨线程可见性，读写都用 relaxed
+        static constexpr std::memory_order LOAD_ORDER = Access::CONCURRENT ? std::memory_order_seq_cst : std::memory_order_relaxed;
+        static constexpr std::memory_order STORE_ORDER = Access::CONCURRENT ? std::memory_order_seq_cst : std::memory_order_relaxed;
+
+        // 比较并交换，单线程策略下没有竞争，直接比较后写入，省去带锁前缀的指令
+        template<typename T>
+        static bool CompareExchange(std::atomic<T>& stRef, T& stExpected, T stDesired)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                return stRef.compare_exchange_strong(stExpected, stDesired);
+            }
+            else
+            {
+                T stCurr = stRef.load(std::memory_order_relaxed);
+                if (stCurr != stExpected)
+                {
+                    stExpected = stCurr;
+                    return false;
+                }
+                stRef.store(stDesired, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // 节点和它的指针、跨度数组占用的字节数，三者在内存池中放在同一块里
+        static size_t GetNodeBytes(int iLevel)
+        {
+            return sizeof(Node<K, V>) + (sizeof(std::atomic<Node<K, V>*>) + sizeof(std::atomic<size_t>)) * static_cast<size_t>(iLevel + 1);
+        }
+
+        Node<K, V>* CreateNode(K key, V value, int iLevel)
+        {
+            if (m_pArena == nullptr)
+            {
+                return new Node<K, V>(key, value, iLevel);
+            }
+            void* pBlock = m_pArena->Allocate(GetNodeBytes(iLevel));
+            auto* pstForward = reinterpret_cast<std::atomic<Node<K, V>*>*>(static_cast<char*>(pBlock) + sizeof(Node<K, V>));
+            auto* pulSpan = reinterpret_cast<std::atomic<size_t>*>(pstForward + iLevel + 1);
+            return new (pBlock) Node<K, V>(key, value, iLevel, pstForward, pulSpan);
+        }
+
+        void DestroyNode(Node<K, V>* pstNode)
+        {
+            if (pstNode->m_bOwnForward)
+            {
+                delete pstNode;
+                return;
+            }
+            size_t ulBytes = GetNodeBytes(pstNode->m_iTopLevel.load(std::memory_order_relaxed));
+            pstNode->~Node<K, V>();
+            m_pArena->Deallocate(pstNode, ulBytes);
+        }
+
+        // 调整有效节点计数
+        void AddSize(size_t ulDelta)
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                m_ulSize.fetch_add(ulDelta);
+            }
+            else
+            {
+                m_ulSize.store(m_ulSize.load(std::memory_order_relaxed) + ulDelta, std::memory_order_relaxed);
+            }
+        }
+
+        // 判断指针是否带删除标记
+        static bool IsMarkedRef(Node<K, V>* pstRef)
+        {
+            return (reinterpret_cast<uintptr_t>(pstRef) & 1) != 0;
+        }
+
+        // 为指针加上删除标记
+        static Node<K, V>* MarkRef(Node<K, V>* pstRef)
+        {
+            return reinterpret_cast<Node<K, V>*>(reinterpret_cast<uintptr_t>(pstRef) | 1);
+        }
+
+        // 去掉指针上的删除标记
+        static Node<K, V>* UnmarkRef(Node<K, V>* pstRef)
+        {
+            return reinterpret_cast<Node<K, V>*>(reinterpret_cast<uintptr_t>(pstRef) & ~uintptr_t(1));
+        }
+
+        // 将摘除的节点挂到退休链表，仍在遍历的线程可继续沿原指针前进
+        void Retire(Node<K, V>* pstNode)
+        {
+            Node<K, V>* pstHead = m_pstRetired.load(LOAD_ORDER);
+            do
+            {
+                pstNode->m_pstNextRetired = pstHead;
+            } while (!CompareExchange(m_pstRetired, pstHead, pstNode));
+        }
+
+        // 写操作开始：写序号变为奇数，按排名读取的线程据此重试
+        void BeginWrite()
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                m_ulWriteSeq.store(m_ulWriteSeq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+        }
+
+        // 写操作结束：写序号恢复为偶数
+        void EndWrite()
+        {
+            if constexpr (Access::CONCURRENT)
+            {
+                m_ulWriteSeq.store(m_ulWriteSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+        }
+
+        // 在没有写操作交错的情况下执行 fn 并返回结果；跨度与后继指针要一起读到同一版本，期间有写操作时重试
+        template<typename Fn>
+        auto ReadConsistent(Fn&& fn)
+        {
+            if constexpr (!Access::CONCURRENT)
+            {
+                return fn();
+            }
+            else
+            {
+                while (true)
+                {
+                    uint64_t ulSeq = m_ulWriteSeq.load(std::memory_order_acquire);
+                    if ((ulSeq & 1) != 0)
+                    {
+                        continue;
+                    }
+                    auto stResult = fn();
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (m_ulWriteSeq.load(std::memory_order_relaxed) == ulSeq)
+                    {
+                        return stResult;
+                    }
+                }
+            }
+        }
+
+        // 跨度加减，跨度只由持有写锁的线程修改
+        static void AddSpan(std::atomic<size_t>& stSpan, size_t ulDelta)
+        {
+            stSpan.store(stSpan.load(std::memory_order_relaxed) + ulDelta, std::memory_order_relaxed);
+        }
 
-		// 查找指定键的节点，并记录路径上前驱和后继节点
-        bool FindNode(K key, Node<K,V>** preds, Node<K,V>** succs)
+        // 找到各层最后一个键小于 key 的节点及其位置(头节点为0，第 i 个节点为 i)，写入 pstPreds/pulRanks
+        // bUseHint 为true时 pstPreds/pulRanks 中保存的是上一次(更小的键)的结果，各层从位置更靠后的一个出发
+        // 调用方持有写锁，路径上没有被标记的节点
+        void FindPath(const K& key, Node<K, V>** pstPreds, size_t* pulRanks, bool bUseHint)
+        {
+            Node<K, V>* pstPred = m_stHead;
+            size_t ulRank = 0;
+            for (int level = m_iCurrentLevel.load(std::memory_order_relaxed); level >= 0; --level)
+            {
+                if (bUseHint && pulRanks[level] > ulRank)
+                {
+                    pstPred = pstPreds[level];
+                    ulRank = pulRanks[level];
+                }
+                while (true)
+                {
+                    Node<K, V>* pstNext = UnmarkRef(pstPred->m_pstForward[level].load(std::memory_order_relaxed));
+                    if (pstNext == m_stTail || !(pstNext->m_stKey < key))
+                    {
+                        break;
+                    }
+                    ulRank += pstPred->m_pulSpan[level].load(std::memory_order_relaxed);
+                    pstPred = pstNext;
+                }
+                pstPreds[level] = pstPred;
+                pulRanks[level] = ulRank;
+            }
+        }
+
+        // 沿各层跨度下降，返回第 ulPos 个节点(从1开始)，超出节点数时返回尾节点；O(log n)
+        Node<K, V>* FindByPosition(size_t ulPos)
+        {
+            Node<K, V>* pstCurr = m_stHead;
+            size_t ulRank = 0;
+            for (int level = m_iCurrentLevel.load(LOAD_ORDER); level >= 0; --level)
+            {
+                while (true)
+                {
+                    Node<K, V>* pstNext = UnmarkRef(pstCurr->m_pstForward[level].load(LOAD_ORDER));
+                    size_t ulSpan = pstCurr->m_pulSpan[level].load(std::memory_order_relaxed);
+                    if (pstNext == m_stTail || ulRank + ulSpan > ulPos)
+                    {
+                        break;
+                    }
+                    ulRank += ulSpan;
+                    pstCurr = pstNext;
+                }
+                if (ulRank == ulPos)
+                {
+                    return pstCurr;
+                }
+            }
+            return m_stTail;
+        }
+
+        // 无锁查找第一个不小于目标键的有效节点，不做物理删除
+        Node<K, V>* FindFirstNotLess(const K& key)
         {
             int iBottomLevel = 0;// 最低层级为0
-            bool bMarked = false;// 标记节点是否被删除
-            bool bSnip = false;// 标记是否成功删除标记节点
-            Node<K, V>* pstPredNode = nullptr;
-            Node<K, V>* pstCurrNode = nullptr;
-            Node<K, V>* pstSuccNode = nullptr;
-            
-        retry:
-            while (true)
-            {// 外层循环，可能需要重试
-                // 从头节点开始遍历
-                pstPredNode = m_stHead;
-                // 从最高层向下遍历
-                for (int level = m_iCurrentLevel; level >= iBottomLevel; --level)
+            Node<K, V>* pstPred = m_stHead;// 从头节点开始
+            Node<K, V>* pstCurr = nullptr;
+            // 从最高层向下遍历
+            for (int level = m_iCurrentLevel.load(LOAD_ORDER); level >= iBottomLevel; --level)
+            {
+                pstCurr = UnmarkRef(pstPred->m_pstForward[level].load(LOAD_ORDER));// 获取当前层级的下一个节点
+                while (true)
                 {
-                    // 获取当前层级的下一个节点
-                    pstCurrNode = pstPredNode->m_pstForward[level];
-                    // 内层循环，查找当前层级的合适位置
-                    while (true)
+                    Node<K, V>* pstSucc = pstCurr->m_pstForward[level].load(LOAD_ORDER);
+                    // 跳过已被标记删除的节点
+                    while (IsMarkedRef(pstSucc))
                     {
-                        // 获取后继节点
-                        pstSuccNode = pstCurrNode->m_pstForward[level];
-                        // 检查当前节点是否被标记删除
-                        bMarked = pstCurrNode->m_bMarked.load();
-                        if (bMarked)
-                        { // 如果节点被标记删除
-                            // 尝试原子删除标记节点
-                            bSnip = pstPredNode->m_pstForward[level].compare_exchange_strong(pstCurrNode, pstSuccNode);
-                            if (!bSnip)
-                            {
-                                // 删除失败则重试
-                                goto retry;
-                            }
-
-                            // 删除成功 更新当前节点
-                            pstCurrNode = pstPredNode->m_pstForward[level];
-                        }
-                        else 
-                        {
-                            // 如果当前节点键 小于 目标键
-                            if (pstCurrNode->m_stKey < key)
-                            {
-                                // 移动前驱节点
-                                pstPredNode = pstCurrNode;
-                                // 移动当前节点
-                                pstCurrNode = pstSuccNode;
-                            }
-                            else 
-                            {
-                                // 已经找到合适位置，退出内层循环
-                                break;
-                            }
-                        }
+                        pstCurr = UnmarkRef(pstSucc);
+                        pstSucc = pstCurr->m_pstForward[level].load(LOAD_ORDER);
                     }
-                    // 记录当前层级的前驱节点
-                    preds[level] = pstPredNode;
-                    // 记录当前层级的后继节点
-                    succs[level] = pstSuccNode;
+                    // 查找当前层级中第一个不小于目标键的节点
+                    if (pstCurr != m_stTail && pstCurr->m_stKey < key)
+                    {
+                        pstPred = pstCurr;
+                        pstCurr = pstSucc;// 移动到下一个节点
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+            }
+            return pstCurr;
+        }
+
+        // 插入或更新键值对，调用方持有写锁；pstPreds/pulRanks 由调用方提供，bUseHint 含义同 FindPath
+        // 新节点在各层接在前驱之后，前驱的跨度拆成两段；高于新节点层级的前驱跨度加1
+        bool InsertLocked(const K& key, const V& value, Node<K, V>** pstPreds, size_t* pulRanks, bool bUseHint)
+        {
+            FindPath(key, pstPreds, pulRanks, bUseHint);
+            Node<K, V>* pstFound = UnmarkRef(pstPreds[0]->m_pstForward[0].load(std::memory_order_relaxed));
+            if (pstFound != m_stTail && pstFound->m_stKey == key)
+            {
+                // 键已存在，更新节点值；并发策略下无锁读者可能正在读旧值，不能原地改写
+                if constexpr (Access::CONCURRENT)
+                {
+                    ReplaceNode(pstFound, value, pstPreds);
+                }
+                else
+                {
+                    pstFound->m_stValue = value;
+                }
+                return true;
+            }
+
+            int iTopLevel = RandomLevel();// 生成新节点的随机层级
+            int iOldLevel = m_iCurrentLevel.load(std::memory_order_relaxed);
+            BeginWrite();
+            if (iTopLevel > iOldLevel)
+            {
+                // 新启用的层级上头节点直接指向尾节点，跨度为节点数 + 1
+                size_t ulTailPos = m_ulSize.load(std::memory_order_relaxed) + 1;
+                for (int level = iOldLevel + 1; level <= iTopLevel; ++level)
+                {
+                    m_stHead->m_pulSpan[level].store(ulTailPos, std::memory_order_relaxed);
+                    pstPreds[level] = m_stHead;
+                    pulRanks[level] = 0;
+                }
+                m_iCurrentLevel.store(iTopLevel, STORE_ORDER);
+            }
+
+            size_t ulPos = pulRanks[0] + 1;// 新节点的位置
+            Node<K, V>* pstNewNode = CreateNode(key, value, iTopLevel);
+            for (int level = 0; level <= iTopLevel; ++level)
+            {
+                Node<K, V>* pstPred = pstPreds[level];
+                size_t ulSpan = pstPred->m_pulSpan[level].load(std::memory_order_relaxed);
+                pstNewNode->m_pstForward[level].store(UnmarkRef(pstPred->m_pstForward[level].load(std::memory_order_relaxed)), std::memory_order_relaxed);
+                pstNewNode->m_pulSpan[level].store(pulRanks[level] + ulSpan + 1 - ulPos, std::memory_order_relaxed);
+            }
+            // 自底向上链接，无锁遍历的线程在第0层链接后即可看到新节点
+            for (int level = 0; level <= iTopLevel; ++level)
+            {
+                pstPreds[level]->m_pulSpan[level].store(ulPos - pulRanks[level], std::memory_order_relaxed);
+                pstPreds[level]->m_pstForward[level].store(pstNewNode, STORE_ORDER);
+            }
+            for (int level = iTopLevel + 1; level <= iOldLevel; ++level)
+            {
+                AddSpan(pstPreds[level]->m_pulSpan[level], 1);
+            }
+            AddSize(1);
+            pstNewNode->m_bFullyLinked.store(true, STORE_ORDER);
+            EndWrite();
+
+            if (bUseHint)
+            {
+                // 下一个更大的键在新节点的各层上都可以从新节点出发
+                for (int level = 0; level <= iTopLevel; ++level)
+                {
+                    pstPreds[level] = pstNewNode;
+                    pulRanks[level] = ulPos;
+                }
+            }
+            return true;
+        }
+
+        // 用带新值的节点替换 pstOld，调用方持有写锁，pstPreds 为 FindPath 得到的前驱
+        // 新节点复制旧节点的层级、后继和跨度后一次性接入各层；旧节点不标记直接退休，
+        // 正停在旧节点上的读者读到更新前的值，并沿它原来的后继继续前进
+        void ReplaceNode(Node<K, V>* pstOld, const V& value, Node<K, V>** pstPreds)
+        {
+            int iTopLevel = pstOld->m_iTopLevel.load(std::memory_order_relaxed);
+            Node<K, V>* pstNewNode = CreateNode(pstOld->m_stKey, value, iTopLevel);
+            for (int level = 0; level <= iTopLevel; ++level)
+            {
+                pstNewNode->m_pstForward[level].store(UnmarkRef(pstOld->m_pstForward[level].load(std::memory_order_relaxed)), std::memory_order_relaxed);
+                pstNewNode->m_pulSpan[level].store(pstOld->m_pulSpan[level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            pstNewNode->m_bFullyLinked.store(true, std::memory_order_relaxed);
+            BeginWrite();
+            for (int level = iTopLevel; level >= 0; --level)
+            {
+                pstPreds[level]->m_pstForward[level].store(pstNewNode, STORE_ORDER);
+            }
+            EndWrite();
+            Retire(pstOld);
+        }
+
+        // 标记节点的各层后继指针，第0层最后标记；之后无锁遍历的线程会跳过该节点
+        void MarkNode(Node<K, V>* pstNode)
+        {
+            for (int level = pstNode->m_iTopLevel.load(std::memory_order_relaxed); level >= 0; --level)
+            {
+                Node<K, V>* pstSucc = pstNode->m_pstForward[level].load(std::memory_order_relaxed);
+                pstNode->m_pstForward[level].store(MarkRef(pstSucc), STORE_ORDER);
+            }
+            pstNode->m_bMarked.store(true, STORE_ORDER);
+        }
+
+        // 删除指定键的节点，调用方持有写锁；pstPreds/pulRanks 由调用方提供，bUseHint 含义同 FindPath
+        bool RemoveLocked(const K& key, Node<K, V>** pstPreds, size_t* pulRanks, bool bUseHint)
+        {
+            FindPath(key, pstPreds, pulRanks, bUseHint);
+            Node<K, V>* pstNode = UnmarkRef(pstPreds[0]->m_pstForward[0].load(std::memory_order_relaxed));
+            if (pstNode == m_stTail || !(pstNode->m_stKey == key))
+            {
+                return false;
+            }
+            BeginWrite();
+            MarkNode(pstNode);
+            // 自顶向下摘除：指向该节点的前驱接上它的后继并合并跨度，其余前驱的跨度减1
+            for (int level = m_iCurrentLevel.load(std::memory_order_relaxed); level >= 0; --level)
+            {
+                Node<K, V>* pstPred = pstPreds[level];
+                if (UnmarkRef(pstPred->m_pstForward[level].load(std::memory_order_relaxed)) == pstNode)
+                {
+                    AddSpan(pstPred->m_pulSpan[level], pstNode->m_pulSpan[level].load(std::memory_order_relaxed) - 1);
+                    pstPred->m_pstForward[level].store(UnmarkRef(pstNode->m_pstForward[level].load(std::memory_order_relaxed)), STORE_ORDER);
+                }
+                else
+                {
+                    AddSpan(pstPred->m_pulSpan[level], size_t(-1));
                 }
-                // 返回是否找到目标键的节点
-                return pstCurrNode->m_stKey == key;
             }
+            AddSize(size_t(-1));
+            EndWrite();
+            // 挂入退休链表，等待无并发访问时释放
+            Retire(pstNode);
+            return true;
+        }
+
+        // 删除从第一个不小于 key 的节点开始、键不大于 *pstHi(为空时不限)的连续节点，最多 ulLimit 个，对每个删除的节点调用 fn(键, 值)
+        // 调用方持有写锁；先沿第0层逐个标记，再在每层把前驱直接接到区间后的第一个节点，整段摘除，前驱跨度减去区间长度
+        // 摘除的节点串成一条链一次挂入退休链表
+        template<typename Fn>
+        size_t RemoveRun(const K& key, const K* pstHi, size_t ulLimit, Fn&& fn)
+        {
+            Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
+            size_t ulRanks[MAXLEVEL + 1];       // 存储各层级前驱节点的位置
+            FindPath(key, pstPreds, ulRanks, false);
+
+            BeginWrite();
+            Node<K, V>* pstFirst = nullptr;// 本次删除的节点，经 m_pstNextRetired 串成链
+            Node<K, V>* pstLast = nullptr;
+            size_t ulRemoved = 0;
+            Node<K, V>* pstCurr = UnmarkRef(pstPreds[0]->m_pstForward[0].load(std::memory_order_relaxed));
+            while (ulRemoved < ulLimit && pstCurr != m_stTail && (pstHi == nullptr || !(*pstHi < pstCurr->m_stKey)))
+            {
+                Node<K, V>* pstNext = UnmarkRef(pstCurr->m_pstForward[0].load(std::memory_order_relaxed));
+                MarkNode(pstCurr);
+                pstCurr->m_pstNextRetired = nullptr;
+                if (pstLast == nullptr)
+                {
+                    pstFirst = pstCurr;
+                }
+                else
+                {
+                    pstLast->m_pstNextRetired = pstCurr;
+                }
+                pstLast = pstCurr;
+                ++ulRemoved;
+                pstCurr = pstNext;
+            }
+            if (ulRemoved == 0)
+            {
+                EndWrite();
+                return 0;
+            }
+
+            // 各层把前驱接到区间后第一个未标记的节点，跨度累加途经的被删节点后减去删除个数
+            for (int level = m_iCurrentLevel.load(std::memory_order_relaxed); level >= 0; --level)
+            {
+                Node<K, V>* pstPred = pstPreds[level];
+                size_t ulSpan = pstPred->m_pulSpan[level].load(std::memory_order_relaxed);
+                Node<K, V>* pstTarget = UnmarkRef(pstPred->m_pstForward[level].load(std::memory_order_relaxed));
+                while (pstTarget != m_stTail && pstTarget->m_bMarked.load(std::memory_order_relaxed))
+                {
+                    ulSpan += pstTarget->m_pulSpan[level].load(std::memory_order_relaxed);
+                    pstTarget = UnmarkRef(pstTarget->m_pstForward[level].load(std::memory_order_relaxed));
+                }
+                pstPred->m_pulSpan[level].store(ulSpan - ulRemoved, std::memory_order_relaxed);
+                pstPred->m_pstForward[level].store(pstTarget, STORE_ORDER);
+            }
+            AddSize(size_t(0) - ulRemoved);
+            EndWrite();
+
+            for (Node<K, V>* pstNode = pstFirst; pstNode != nullptr; pstNode = pstNode->m_pstNextRetired)
+            {
+                fn(pstNode->m_stKey, pstNode->m_stValue);
+            }
+            // 整条链一次挂入退休链表
+            Node<K, V>* pstHead = m_pstRetired.load(LOAD_ORDER);
+            do
+            {
+                pstLast->m_pstNextRetired = pstHead;
+            } while (!CompareExchange(m_pstRetired, pstHead, pstFirst));
+            return ulRemoved;
         }
 
 public:
 	// 跳表构造函数，初始化头节点和尾节点
-    SkipList(int iMaxLevel = 32, float fProbability = 0.5) : MAXLEVEL(iMaxLevel), PROBABILITY(fProbability), m_iCurrentLevel(1)
+    SkipList(int iMaxLevel = 32, float fProbability = 0.5) : MAXLEVEL(iMaxLevel), PROBABILITY(fProbability), m_iCurrentLevel(0), m_ulSize(0), m_pstRetired(nullptr)
     {
         // 创建尾节点
         m_stTail = new Node<K, V>(K(), V(), MAXLEVEL);
         // 创建头节点
-        m_stHead = new Node<K, V>(K().V(), MAXLEVEL);
-        for (int i = 0; i <= MAXLEVEL; ++i) 
+        m_stHead = new Node<K, V>(K(), V(), MAXLEVEL);
+        for (int i = 0; i <= MAXLEVEL; ++i)
         {
-            // 初始化头节点各层级指针指向尾节点
+            // 初始化头节点各层级指针指向尾节点，空表时尾节点的位置为1
             m_stHead->m_pstForward[i] = m_stTail;
+            m_stHead->m_pulSpan[i] = 1;
         }
         // 随机数设备
         std::random_device rd;
@@ -139,6 +584,9 @@ public:
         m_iRang = std::mt19937(rd());
     }
 
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
 	// 跳表析构函数，释放所有节点内存
     ~SkipList()
     {
@@ -148,21 +596,23 @@ public:
         while (pstCurr != m_stTail)
         {
             // 获取下一个节点
-            Node<K, V>* pstNext = pstCurr->m_pstForward[0];
+            Node<K, V>* pstNext = UnmarkRef(pstCurr->m_pstForward[0].load(LOAD_ORDER));
             // 释放当前节点内存
-            delete pstCurr;
+            DestroyNode(pstCurr);
             // 移动到下一个节点
             pstCurr = pstNext;
         }
         // 释放尾节点内存
-        delete m_stTail;
+        DestroyNode(m_stTail);
+        // 释放退休链表中的节点
+        ReclaimRetired();
     }
 
 	// 生成随机层级，决定新节点的高度
-    int RandomLevel() 
+    int RandomLevel()
     {
-        // 初始层级为1
-        int iLevel = 1;
+        // 初始层级为0
+        int iLevel = 0;
         // 均匀分布随机数
 		std::uniform_real_distribution<float> dist(0.0f, 1.0f);
         // 根据概率决定是否增加层级
@@ -175,268 +625,367 @@ public:
 		return iLevel;
     }
 
-	// 插入键值对到跳表中，使用无锁CAS操作保证线程安全
-    bool Insert(K key, V value) 
+    // 插入键值对到跳表中，键已存在时更新值；与其他写操作串行，不阻塞查找和遍历
+    bool Insert(K key, V value)
     {
-		int iTopLevel = RandomLevel();// 生成新节点的随机层级
-		Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
-		Node<K, V>* pstSuccs[MAXLEVEL + 1];// 存储各层级的后继节点
-        while (true) 
+        Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
+        size_t ulRanks[MAXLEVEL + 1];       // 存储各层级前驱节点的位置
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        return InsertLocked(key, value, pstPreds, ulRanks, false);
+    }
+
+    // 从跳表中删除指定键的节点；与其他写操作串行，不阻塞查找和遍历
+    bool Remove(K key)
+    {
+        Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
+        size_t ulRanks[MAXLEVEL + 1];       // 存储各层级前驱节点的位置
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        return RemoveLocked(key, pstPreds, ulRanks, false);
+    }
+
+    // 批量插入，键需按升序排列；相邻键复用上一个键的查找路径，减少重复遍历；整批只加一次写锁
+    template<typename It>
+    void InsertSorted(It first, It last)
+    {
+        Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
+        size_t ulRanks[MAXLEVEL + 1];       // 存储各层级前驱节点的位置
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        bool bUseHint = false;
+        K stPrevKey = K();
+        for (; first != last; ++first)
+        {
+            // 路径提示只对严格升序的下一个键有效
+            bUseHint = bUseHint && stPrevKey < first->first;
+            InsertLocked(first->first, first->second, pstPreds, ulRanks, bUseHint);
+            stPrevKey = first->first;
+            bUseHint = true;
+        }
+    }
+
+    // 批量删除，键需按升序排列；返回实际删除的个数；整批只加一次写锁
+    template<typename It>
+    size_t RemoveSorted(It first, It last)
+    {
+        Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
+        size_t ulRanks[MAXLEVEL + 1];       // 存储各层级前驱节点的位置
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        size_t ulRemoved = 0;
+        bool bUseHint = false;
+        for (; first != last; ++first)
         {
-            // 循环直到插入成功
-            if (FindNode(key, pstPreds, pstSuccs))
+            // 删除不改变前驱的位置，上一个键的路径仍然有效
+            if (RemoveLocked(*first, pstPreds, ulRanks, bUseHint))
             {
-                // 如果键已存在  获取找到的节点
-                Node<K, V>* pstNodeFound = pstSuccs[0];
-                // 查看节点 是否被标记 删除
-                if (!pstNodeFound->m_bMarked)
-                {
-                    // 等待节点完全链接
-                    while (!pstNodeFound->m_bFullyLinked);
-                    // 更新节点值
-                    pstNodeFound->m_stValue = value;
-                    // 返回插入成功(更新操作)
-					return true;
-                }
-                // 否则继续尝试
-                continue;
+                ++ulRemoved;
             }
+            bUseHint = true;
+        }
+        return ulRemoved;
+    }
+
+    // 删除键在 [lo, hi] 内的全部节点，对每个删除的节点调用 fn(键, 值)，返回删除的个数
+    // 一次查找定位区间，每层一次修改整段摘除，O(log n + k)
+    template<typename Fn>
+    size_t RemoveRange(const K& lo, const K& hi, Fn&& fn)
+    {
+        if (hi < lo)
+        {
+            return 0;
+        }
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        return RemoveRun(lo, &hi, SIZE_MAX, fn);
+    }
+
+    size_t RemoveRange(const K& lo, const K& hi)
+    {
+        return RemoveRange(lo, hi, [](const K&, const V&) {});
+    }
+
+    // 删除按键升序的第 ulFirst 到第 ulLast 个节点(从0开始，含两端)，对每个删除的节点调用 fn(键, 值)，返回删除的个数
+    // 沿跨度定位起点，O(log n + k)
+    template<typename Fn>
+    size_t RemoveRankRange(size_t ulFirst, size_t ulLast, Fn&& fn)
+    {
+        if (ulFirst > ulLast)
+        {
+            return 0;
+        }
+        std::lock_guard<WriteMutex> stGuard(m_stWriteMutex);
+        Node<K, V>* pstStart = FindByPosition(ulFirst + 1);
+        if (pstStart == m_stTail)
+        {
+            return 0;
+        }
+        // 终点越过末尾时删到最后一个，避免 ulLast 为 SIZE_MAX 时个数溢出为0
+        ulLast = std::min(ulLast, m_ulSize.load(std::memory_order_relaxed) - 1);
+        return RemoveRun(pstStart->m_stKey, nullptr, ulLast - ulFirst + 1, fn);
+    }
 
-            // 创建新节点
-			Node<K, V> pstNewNode = new Node<K, V>(key, value, iTopLevel);
-            // 初始化新节点各层级指针
-            for (int level = 0; level < iTopLevel; ++level)
+    // 取最后一个(键最大的)有效节点，各层走到尾部再下降，O(log n)；跳表为空时返回false
+    bool GetLast(K& key, V& value)
+    {
+        Node<K, V>* pstPred = m_stHead;
+        for (int level = m_iCurrentLevel.load(LOAD_ORDER); level >= 0; --level)
+        {
+            Node<K, V>* pstCurr = UnmarkRef(pstPred->m_pstForward[level].load(LOAD_ORDER));
+            while (pstCurr != m_stTail)
             {
-                // 初始化新节点各层级指针
-                pstNewNode->m_bFullyLinked[level] = pstSuccs[level];
+                Node<K, V>* pstSucc = pstCurr->m_pstForward[level].load(LOAD_ORDER);
+                // 跳过已被标记删除的节点
+                if (!IsMarkedRef(pstSucc))
+                {
+                    pstPred = pstCurr;
+                }
+                pstCurr = UnmarkRef(pstSucc);
             }
+        }
+        if (pstPred == m_stHead)
+        {
+            return false;
+        }
+        key = pstPred->m_stKey;
+        value = pstPred->m_stValue;
+        return true;
+    }
 
-			// 获取最低层级的前驱节点
-			Node<K, V>* pstPred = pstSuccs[0];
-            // 获取最低层级的后继节点
-            Node<K, V>* pstSucc = pstSuccs[0];
-            // 设置新节点的后继节点
-            pstNewNode->m_pstForward[0] = pstSucc;
-            // 尝试原子插入新节点
-            if (!pstPred->m_pstForward[0].compare_exchange_strong(pstSucc, pstNewNode)) 
+    // 删除键最大的 ulCount 个节点，对每个删除的节点调用 fn(键, 值)，返回删除的个数；每个 O(log n)
+    template<typename Fn>
+    size_t RemoveLast(size_t ulCount, Fn&& fn)
+    {
+        size_t ulRemoved = 0;
+        K key = K();
+        V value = V();
+        while (ulRemoved < ulCount && GetLast(key, value))
+        {
+            // 被其他线程抢先删除时重新取最后一个
+            if (Remove(key))
             {
-                // 如果链接失败，释放新节点内存并重试
-                delete pstNewNode;
-                // 继续尝试
-                continue;
+                fn(key, value);
+                ++ulRemoved;
             }
+        }
+        return ulRemoved;
+    }
 
-            // 处理其他层级
-            for (int level = 1; level < iTopLevel; ++level) 
-            {
-                while (true)
-                {
-                    // 获取当前层级的前驱节点
-                    pstPred = pstPreds[level];
-                    // 获取当前层级的后继节点
-					pstSucc = pstSuccs[level];
-                    // 检查新节点的后继是否仍然有效 并且 尝试原子插入新节点
-                    if (pstNewNode->m_pstForward[level] == pstSucc && 
-                        pstPred->m_pstForward[level].compare_exchange_strong(pstSucc, pstNewNode))
-                    {
-                        // 插入成功，退出循环
-                        break;
-                    }
+	// 检查跳表中是否包含指定键的节点
+    bool Contains(K key)
+    {
+        Node<K, V>* pstCurr = FindFirstNotLess(key);
+        // 返回是否找到有效节点(键匹配、未标记删除且已完全链接)
+		return (pstCurr != m_stTail && pstCurr->m_stKey == key && !pstCurr->m_bMarked.load(LOAD_ORDER) && pstCurr->m_bFullyLinked.load(LOAD_ORDER));
+	}
 
-                    // 没有成功插入新节点  重新查找，更新前驱和后继节点
-                    FindNode(key, pstPreds, pstSuccs);
-                }
-			}
+	V GetValue(K key)
+	{
+        Node<K, V>* pstCurr = FindFirstNotLess(key);
+        if (pstCurr != m_stTail && pstCurr->m_stKey == key && !pstCurr->m_bMarked.load(LOAD_ORDER) && pstCurr->m_bFullyLinked.load(LOAD_ORDER))
+        {
+			return pstCurr->m_stValue;// 返回节点值
+        }
+
+		return V();// 返回默认值
+	}
 
-            // 更新当前调表的最高层级
-            while (m_iCurrentLevel < iTopLevel)
+    // 按键升序遍历所有有效节点，回调返回false时提前结束
+    template<typename Fn>
+    void ForEach(Fn&& fn)
+    {
+        Node<K, V>* pstCurr = UnmarkRef(m_stHead->m_pstForward[0].load(LOAD_ORDER));
+        while (pstCurr != m_stTail)
+        {
+            Node<K, V>* pstNext = pstCurr->m_pstForward[0].load(LOAD_ORDER);
+            if (!IsMarkedRef(pstNext) && !fn(pstCurr->m_stKey, pstCurr->m_stValue))
             {
-				int iOldLevel = m_iCurrentLevel;
-                // 尝试原子更新当前跳表的最高层级
-                if (iOldLevel >= iTopLevel && m_iCurrentLevel.compare_exchange_strong(iOldLevel, iTopLevel))
-                {
-                    // 更新成功，退出循环
-                    break;
-				}
+                return;
             }
-
-			// 设置新节点的完全链接标志为true
-            pstNewNode->m_bFullyLinked = true;
-			return true;// 返回插入成功
+            pstCurr = UnmarkRef(pstNext);
         }
     }
 
-	//从跳表中删除指定键的节点，使用无锁CAS操作保证线程安全
-    bool Remove(K key) 
+    // 从第一个不小于 key 的节点开始按升序遍历，回调返回false时提前结束
+    template<typename Fn>
+    void ForEachFrom(const K& key, Fn&& fn)
     {
-        bool bIsMarked = false;// 标记节点是否被删除
-		int iBottomLevel = 0;// 最低层级为0
-		Node<K, V>* pstPreds[MAXLEVEL + 1];// 存储各层级的前驱节点
-        Node<K, V>* pstSuccs[MAXLEVEL + 1];// 存储各层级的后继节点
-        // 循环直到删除成功或失败
-        while (true)
+        Node<K, V>* pstCurr = FindFirstNotLess(key);
+        while (pstCurr != m_stTail)
         {
-            bool bFound = FindNode(key, pstPreds, pstSuccs);// 查找目标节点
-            if (bFound == false)
+            Node<K, V>* pstNext = pstCurr->m_pstForward[0].load(LOAD_ORDER);
+            if (!IsMarkedRef(pstNext) && !fn(pstCurr->m_stKey, pstCurr->m_stValue))
             {
-                // 未找到目标节点，返回失败
-                return false;
+                return;
             }
-        
-			Node<K, V>* pstNodeFound = pstSuccs[0];// 获取找到的节点
-            // 从最高层向下处理
-            for (int level = pstNodeFound->m_iTopLevel; level >= iBottomLevel + 1; ++level)
+            pstCurr = UnmarkRef(pstNext);
+        }
+    }
+
+    // 获取键的排名(严格小于该键的有效节点数)，沿各层跨度下降，O(log n)
+    size_t GetRank(const K& key)
+    {
+        return ReadConsistent([&]()
+        {
+            Node<K, V>* pstCurr = m_stHead;
+            size_t ulRank = 0;
+            for (int level = m_iCurrentLevel.load(LOAD_ORDER); level >= 0; --level)
             {
-				bool bMarked = false;// 标记节点是否被删除
-                // 获取当前层级的后继节点
-				Node<K, V>* pstSucc = pstNodeFound->m_pstForward[level].load();
-                while (!bMarked)
+                while (true)
                 {
-                    // 标记节点为删除状态
-					pstSucc = pstNodeFound->m_pstForward[level].load();
-					bMarked = pstNodeFound->m_bMarked.load();
-                    if (bMarked)
+                    Node<K, V>* pstNext = UnmarkRef(pstCurr->m_pstForward[level].load(LOAD_ORDER));
+                    if (pstNext == m_stTail || !(pstNext->m_stKey < key))
                     {
-                        // 节点已被标记，退出循环
                         break;
                     }
-                    // 尝试原子标记节点为删除状态
-                    pstNodeFound->m_bMarked.compare_exchange_strong(false, true);
+                    ulRank += pstCurr->m_pulSpan[level].load(std::memory_order_relaxed);
+                    pstCurr = pstNext;
                 }
-
-                //获取当前层级的前驱节点
-				Node<K, V>* pstPred = pstPreds[level];
-                // 获取前驱节点的后继节点
-				Node<K, V>* pstSucc2 = pstPred->m_pstForward[level].load();
-                // 如果前驱节点的后继仍然是当前节点 尝试原子删除节点
-                if (pstSucc2 == pstNodeFound)
-                {
-                    // 从前驱节点中原子移除当前节点
-					pstPred->m_pstForward[level].compare_exchange_strong(pstNodeFound, pstSucc);
-				}
             }
+            return ulRank;
+        });
+    }
 
-            // 确保节点被标记为删除状态
-			bool bMarked = false;// 标记节点是否被删除
-            while (true)
+    // 从按键升序的第 ulRank 个有效节点(从0开始)起按升序遍历，回调返回false时提前结束；定位 O(log n)
+    template<typename Fn>
+    void ForEachFromRank(size_t ulRank, Fn&& fn)
+    {
+        Node<K, V>* pstCurr = ReadConsistent([&]()
+        {
+            return FindByPosition(ulRank + 1);
+        });
+        while (pstCurr != m_stTail)
+        {
+            Node<K, V>* pstNext = pstCurr->m_pstForward[0].load(LOAD_ORDER);
+            if (!IsMarkedRef(pstNext) && !fn(pstCurr->m_stKey, pstCurr->m_stValue))
             {
-				bMarked = pstNodeFound->m_bMarked.load();
-                if (bMarked)
-                {
-                    // 节点已被标记，退出循环
-                    break;
-                }
-				// 尝试原子标记节点为删除状态
-				pstNodeFound->m_bMarked.compare_exchange_strong(false, true);
-            }
-            // 获取最低层级的前驱节点
-            Node<K, V>* pstPred = pstPreds[0];
-			// 获取最低层级的后继节点
-            Node<K, V>* pstSucc = pstNodeFound->m_pstForward[0].load();
-            while (true)
-            {
-                // 检查节点是否已被标记
-                bool bMarkedIt = pstNodeFound->m_bMarked.load();
-				// 获取前驱节点的后继节点
-                Node<K, V>* pstSucc2 = pstPred->m_pstForward[0].load();
-                if (pstSucc2 != pstNodeFound)
-                {
-                    // 如果前驱节点的后继已改变  删除失败，返回
-                    return false;
-                }
-                // 如果节点已被标记 能到这里 说明 pstSucc2 == pstNodeFound 一定是 相等
-                if (bMarkedIt)
-                {
-                    // 原子删除节点 从前驱节点中原子移除当前节点
-                    pstPred->m_pstForward[0].compare_exchange_strong(pstNodeFound, pstSucc);
-					return true;// 返回删除成功
-                }
+                return;
             }
+            pstCurr = UnmarkRef(pstNext);
         }
     }
 
-	// 检查跳表中是否包含指定键的节点
-    bool Contains(K key) 
+    // 开始批量装载，跳表必须为空且装载期间不能有并发访问
+    void BeginBulkLoad(BulkCursor<K, V>& stCursor)
+    {
+        stCursor.m_vecLast.assign(MAXLEVEL + 1, m_stHead);
+        stCursor.m_vecLastPos.assign(MAXLEVEL + 1, 0);
+        stCursor.m_bHasLast = false;
+    }
+
+    // 按键严格升序追加节点，每层直接接在最后一个节点之后，整体O(n)
+    bool AppendSorted(BulkCursor<K, V>& stCursor, const K& key, const V& value)
     {
-		int iBottomLevel = 0;// 最低层级为0
-        Node<K, V>* pstPred = m_stHead;// 从头节点开始
-		Node<K, V>* pstCurr = nullptr;
-        // 从最高层向下遍历
-        for (int level = m_iCurrentLevel; level >= iBottomLevel; --level) 
+        if (stCursor.m_bHasLast && !(stCursor.m_stLastKey < key))
         {
-            pstCurr = pstPred->m_pstForward[level];// 获取当前层级的下一个节点
-            // 查找当前层级中第一个不小于目标键的节点
-            while (pstCurr->m_stKey < key)
-            {
-                pstPred = pstCurr;
-				pstCurr = pstPred->m_pstForward[level];// 移动到下一个节点
-            }
+            // 键无序或重复
+            return false;
         }
 
-        // 移动到最低层级的下一个节点
-        pstCurr = pstCurr->m_pstForward[iBottomLevel];
-        // 返回是否找到有效节点(键匹配、未标记删除且已完全链接)
-		return (pstCurr->m_stKey == key && !pstCurr->m_bMarked && pstCurr->m_bFullyLinked);
-	}
+        int iTopLevel = RandomLevel();
+        Node<K, V>* pstNewNode = CreateNode(key, value, iTopLevel);
+        size_t ulPos = m_ulSize.load(std::memory_order_relaxed) + 1;
+        for (int level = 0; level <= iTopLevel; ++level)
+        {
+            pstNewNode->m_pstForward[level].store(m_stTail, std::memory_order_relaxed);
+            stCursor.m_vecLast[level]->m_pstForward[level].store(pstNewNode, std::memory_order_relaxed);
+            stCursor.m_vecLast[level]->m_pulSpan[level].store(ulPos - stCursor.m_vecLastPos[level], std::memory_order_relaxed);
+            stCursor.m_vecLast[level] = pstNewNode;
+            stCursor.m_vecLastPos[level] = ulPos;
+        }
+        pstNewNode->m_bFullyLinked.store(true, std::memory_order_relaxed);
 
-	V GetValue(K key)
-	{
-		int iBottomLevel = 0;// 最低层级为0
-		Node<K, V>* pstPred = m_stHead;// 从头节点开始
-		Node<K, V>* pstCurr = nullptr;// 存储各层级的后继节点
-		// 从最高层向下遍历
-		for (int level = m_iCurrentLevel; level >= iBottomLevel; --level)
-		{
-			pstCurr = pstPred->m_pstForward[level];// 获取当前层级的下一个节点
-            while (pstCurr->m_stKey < key)
-            {
-				pstPred = pstCurr;// 移动前驱节点
-				pstCurr = pstPred->m_pstForward[level];// 移动到下一个节点
-            }
-		}
-		// 移动到最低层级的下一个节点
-		pstCurr = pstCurr->m_pstForward[iBottomLevel];
-        if (pstCurr->m_stKey == key && !pstCurr->m_bMarked && pstCurr->m_bFullyLinked)
+        if (m_iCurrentLevel.load(std::memory_order_relaxed) < iTopLevel)
         {
-			return pstCurr->m_stValue;// 返回节点值
+            m_iCurrentLevel.store(iTopLevel, std::memory_order_relaxed);
         }
+        AddSize(1);
+        stCursor.m_stLastKey = key;
+        stCursor.m_bHasLast = true;
+        return true;
+    }
 
-		return V();// 返回默认值
-	}
+    // 结束批量装载，补上各层最后一个节点到尾节点的跨度，发布装载结果给其他线程
+    void EndBulkLoad(BulkCursor<K, V>& stCursor)
+    {
+        size_t ulTailPos = m_ulSize.load(std::memory_order_relaxed) + 1;
+        for (size_t level = 0; level < stCursor.m_vecLast.size(); ++level)
+        {
+            stCursor.m_vecLast[level]->m_pulSpan[level].store(ulTailPos - stCursor.m_vecLastPos[level], std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        stCursor.m_vecLast.clear();
+        stCursor.m_vecLastPos.clear();
+    }
+
+    // 释放退休链表中的节点，调用方需保证此时没有其他线程访问跳表
+    void ReclaimRetired()
+    {
+        Node<K, V>* pstCurr = m_pstRetired.exchange(nullptr);
+        while (pstCurr != nullptr)
+        {
+            Node<K, V>* pstNext = pstCurr->m_pstNextRetired;
+            DestroyNode(pstCurr);
+            pstCurr = pstNext;
+        }
+    }
+
+    // 改为从 pArena 分配节点(传入空指针恢复 new/delete)，头尾节点一并迁入；只能在跳表为空且没有并发访问时调用
+    bool SetArena(NodeArena* pArena)
+    {
+        if (Size() != 0)
+        {
+            return false;
+        }
+        ReclaimRetired();
+        DestroyNode(m_stHead);
+        DestroyNode(m_stTail);
+        m_pArena = pArena;
+        m_stTail = CreateNode(K(), V(), MAXLEVEL);
+        m_stHead = CreateNode(K(), V(), MAXLEVEL);
+        for (int i = 0; i <= MAXLEVEL; ++i)
+        {
+            m_stHead->m_pstForward[i].store(m_stTail, std::memory_order_relaxed);
+            m_stHead->m_pulSpan[i].store(1, std::memory_order_relaxed);
+        }
+        m_iCurrentLevel.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 获取跳表中有效节点数量
+    size_t Size() const
+    {
+        return m_ulSize.load(LOAD_ORDER);
+    }
 
     // 获取跳表的当前层级
-    int GetCurrentLevel() 
+    int GetCurrentLevel()
     {
-        return m_iCurrentLevel.load();// 返回当前跳表的最高层级
+        return m_iCurrentLevel.load(LOAD_ORDER);// 返回当前跳表的最高层级
 	}
 
     // 获取跳表的最大层级
-    int GetMaxLevel() 
+    int GetMaxLevel()
     {
         return MAXLEVEL;// 返回跳表的最大层级限制
 	}
 
     // 获取跳表的头节点
-    Node<K, V>* GetHead() 
+    Node<K, V>* GetHead()
     {
-        return &m_stHead;// 返回头节点指针
+        return m_stHead;// 返回头节点指针
     }
     // 获取跳表的尾节点
-    Node<K, V>* GetTail() 
+    Node<K, V>* GetTail()
     {
-        return &m_stTail;// 返回尾节点指针
+        return m_stTail;// 返回尾节点指针
 	}
 
     // 获取跳表的随机数生成器
-    std::mt19937 GetRandomGenerator() 
+    std::mt19937 GetRandomGenerator()
     {
         return m_iRang;// 返回随机数生成器
 	}
 
     // 获取跳表的概率因子
-    float GetProbability() 
+    float GetProbability()
     {
         return PROBABILITY;// 返回随机层级生成的概率因子
     }
 };
-
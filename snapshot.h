@@ -0,0 +1,436 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "crc32c.h"
+#include "skiplist.h"
+
+// 快照文件格式：
+//   SnapshotHeader
+//   SnapshotBlockHeader + 负载(按键升序排列的 K、V 原始字节) ... 共 m_uiBlockCount 个块
+// 每个块的校验和覆盖块头前8字节与负载，加载时多线程并行校验，主线程按顺序批量装载
+// m_usFlags 标明负载编码，为0时是定长的 K、V 原始字节；其他编码见 board_snapshot.h
+
+const uint32_t SNAPSHOT_MAGIC = 0x53535247;// "GRSS"
+const uint16_t SNAPSHOT_VERSION = 1;
+const uint16_t SNAPSHOT_FLAG_BOARD = 0x0001;// 负载为压缩编码的排行榜记录(成员名 + 分数)，键值字节数字段为0
+const uint16_t SNAPSHOT_FLAG_BOARD_EXT = 0x0002;// 与 SNAPSHOT_FLAG_BOARD 同用：文件头后接排行榜扩展头(记录容量等)，不认识该位的旧版本拒绝加载
+const uint32_t SNAPSHOT_BLOCK_ENTRIES = 4096;// 默认每块条目数
+
+// 快照文件头
+struct SnapshotHeader
+{
+    uint32_t m_uiMagic;     // 魔数
+    uint16_t m_usVersion;   // 格式版本
+    uint16_t m_usFlags;     // 负载编码标志，SNAPSHOT_FLAG_*
+    uint32_t m_uiKeySize;   // 键字节数
+    uint32_t m_uiValueSize; // 值字节数
+    uint64_t m_ulCount;     // 条目总数
+    uint32_t m_uiBlockCount;// 块数量
+    uint32_t m_uiHeaderCrc; // 以上字段的CRC32C
+};
+
+// 快照块头
+struct SnapshotBlockHeader
+{
+    uint32_t m_uiEntries;   // 块内条目数
+    uint32_t m_uiBytes;     // 负载字节数
+    uint32_t m_uiCrc;       // 块头前8字节与负载的CRC32C
+    uint32_t m_uiReserved;  // 保留，保持8字节对齐
+};
+
+// 快照读写结果
+enum class ESnapshotResult
+{
+    Ok,
+    OpenFailed,       // 文件打开失败
+    WriteFailed,      // 写入失败
+    BadHeader,        // 文件头损坏或版本不支持
+    TypeMismatch,     // 键值类型大小与文件不一致
+    Truncated,        // 文件被截断
+    ChecksumMismatch, // 块校验失败
+    Unordered,        // 块内数据无序
+};
+
+inline const char* SnapshotResultString(ESnapshotResult eResult)
+{
+    switch (eResult)
+    {
+    case ESnapshotResult::Ok: return "ok";
+    case ESnapshotResult::OpenFailed: return "open failed";
+    case ESnapshotResult::WriteFailed: return "write failed";
+    case ESnapshotResult::BadHeader: return "bad header";
+    case ESnapshotResult::TypeMismatch: return "type mismatch";
+    case ESnapshotResult::Truncated: return "truncated";
+    case ESnapshotResult::ChecksumMismatch: return "checksum mismatch";
+    case ESnapshotResult::Unordered: return "unordered";
+    }
+    return "unknown";
+}
+
+// 计算块校验和
+inline uint32_t SnapshotBlockCrc(const SnapshotBlockHeader& stBlock, const uint8_t* pPayload)
+{
+    uint32_t uiCrc = Crc32c(&stBlock, offsetof(SnapshotBlockHeader, m_uiCrc));
+    return Crc32c(pPayload, stBlock.m_uiBytes, uiCrc);
+}
+
+// 只读映射的快照文件，不支持 mmap 的平台整体读入内存
+class SnapshotFile
+{
+    private:
+        const uint8_t*       m_pData = nullptr;// 文件内容
+        size_t               m_ulSize = 0;     // 文件大小
+        bool                 m_bMapped = false;// 是否通过 mmap 映射
+        std::vector<uint8_t> m_vecBuffer;      // 非映射时的文件内容
+
+    public:
+        SnapshotFile() = default;
+        SnapshotFile(const SnapshotFile&) = delete;
+        SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+        ~SnapshotFile()
+        {
+#if defined(__unix__) || defined(__APPLE__)
+            if (m_bMapped)
+            {
+                munmap(const_cast<uint8_t*>(m_pData), m_ulSize);
+            }
+#endif
+        }
+
+        // bRandomAccess 为true时提示内核按随机访问处理，不做预读
+        bool Open(const std::string& strPath, bool bRandomAccess = false)
+        {
+#if defined(__unix__) || defined(__APPLE__)
+            int iFd = open(strPath.c_str(), O_RDONLY);
+            if (iFd < 0)
+            {
+                return false;
+            }
+            struct stat stStat;
+            if (fstat(iFd, &stStat) != 0)
+            {
+                close(iFd);
+                return false;
+            }
+            m_ulSize = static_cast<size_t>(stStat.st_size);
+            if (m_ulSize > 0)
+            {
+                void* pMap = mmap(nullptr, m_ulSize, PROT_READ, MAP_PRIVATE, iFd, 0);
+                if (pMap != MAP_FAILED)
+                {
+                    // 装载时顺序读取为主，提示内核预读；常驻查询的文件按随机访问
+                    madvise(pMap, m_ulSize, bRandomAccess ? MADV_RANDOM : MADV_SEQUENTIAL);
+                    m_pData = static_cast<const uint8_t*>(pMap);
+                    m_bMapped = true;
+                }
+            }
+            close(iFd);
+            if (m_bMapped || m_ulSize == 0)
+            {
+                return true;
+            }
+#endif
+            FILE* pFile = fopen(strPath.c_str(), "rb");
+            if (pFile == nullptr)
+            {
+                return false;
+            }
+            fseek(pFile, 0, SEEK_END);
+            long lSize = ftell(pFile);
+            fseek(pFile, 0, SEEK_SET);
+            m_vecBuffer.resize(lSize > 0 ? static_cast<size_t>(lSize) : 0);
+            size_t ulRead = fread(m_vecBuffer.data(), 1, m_vecBuffer.size(), pFile);
+            fclose(pFile);
+            m_pData = m_vecBuffer.data();
+            m_ulSize = ulRead;
+            return true;
+        }
+
+        const uint8_t* Data() const
+        {
+            return m_pData;
+        }
+
+        size_t Size() const
+        {
+            return m_ulSize;
+        }
+};
+
+// 把写完的临时文件落盘后改名为 strPath，再同步所在目录：返回true之后掉电也不会丢失文件或只剩半个文件
+// bOk 为false(之前的写入已失败)或任何一步失败时返回false，改名之前失败会删除临时文件；pFile 总会被关闭
+inline bool CommitSnapshotFile(FILE* pFile, bool bOk, const std::string& strTmpPath, const std::string& strPath)
+{
+    bOk = bOk && fflush(pFile) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+    bOk = bOk && fsync(fileno(pFile)) == 0;
+#endif
+    bOk = (fclose(pFile) == 0) && bOk;
+    if (!bOk || rename(strTmpPath.c_str(), strPath.c_str()) != 0)
+    {
+        remove(strTmpPath.c_str());
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    // 改名只修改目录项，目录不同步的话掉电后可能仍是旧文件或没有文件
+    size_t ulSlash = strPath.find_last_of('/');
+    std::string strDir = ulSlash == std::string::npos ? "." : (ulSlash == 0 ? "/" : strPath.substr(0, ulSlash));
+    int iFd = open(strDir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (iFd < 0)
+    {
+        return false;
+    }
+    bool bSynced = fsync(iFd) == 0;
+    close(iFd);
+    return bSynced;
+#else
+    return true;
+#endif
+}
+
+// 将跳表写入快照文件，先写临时文件、落盘后再改名，避免留下半个快照
+template<typename K, typename V, typename Access>
+ESnapshotResult SaveSnapshot(SkipList<K, V, Access>& stList, const std::string& strPath, uint32_t uiBlockEntries = SNAPSHOT_BLOCK_ENTRIES)
+{
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value, "snapshot requires trivially copyable key and value");
+
+    const size_t ulEntryBytes = sizeof(K) + sizeof(V);
+    std::string strTmpPath = strPath + ".tmp";
+    FILE* pFile = fopen(strTmpPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return ESnapshotResult::OpenFailed;
+    }
+
+    SnapshotHeader stHeader;
+    memset(&stHeader, 0, sizeof(stHeader));
+    stHeader.m_uiMagic = SNAPSHOT_MAGIC;
+    stHeader.m_usVersion = SNAPSHOT_VERSION;
+    stHeader.m_uiKeySize = sizeof(K);
+    stHeader.m_uiValueSize = sizeof(V);
+    // 先占位，写完所有块后回填
+    bool bOk = fwrite(&stHeader, sizeof(stHeader), 1, pFile) == 1;
+
+    std::vector<uint8_t> vecPayload;
+    vecPayload.reserve(uiBlockEntries * ulEntryBytes);
+    uint32_t uiEntries = 0;
+    auto FlushBlock = [&]()
+    {
+        SnapshotBlockHeader stBlock;
+        memset(&stBlock, 0, sizeof(stBlock));
+        stBlock.m_uiEntries = uiEntries;
+        stBlock.m_uiBytes = static_cast<uint32_t>(vecPayload.size());
+        stBlock.m_uiCrc = SnapshotBlockCrc(stBlock, vecPayload.data());
+        bOk = bOk && fwrite(&stBlock, sizeof(stBlock), 1, pFile) == 1;
+        bOk = bOk && fwrite(vecPayload.data(), 1, vecPayload.size(), pFile) == vecPayload.size();
+        stHeader.m_ulCount += uiEntries;
+        stHeader.m_uiBlockCount++;
+        vecPayload.clear();
+        uiEntries = 0;
+    };
+
+    stList.ForEach([&](const K& key, const V& value)
+    {
+        size_t ulOffset = vecPayload.size();
+        vecPayload.resize(ulOffset + ulEntryBytes);
+        memcpy(vecPayload.data() + ulOffset, &key, sizeof(K));
+        memcpy(vecPayload.data() + ulOffset + sizeof(K), &value, sizeof(V));
+        if (++uiEntries == uiBlockEntries)
+        {
+            FlushBlock();
+        }
+        return bOk;
+    });
+    if (uiEntries > 0)
+    {
+        FlushBlock();
+    }
+
+    stHeader.m_uiHeaderCrc = Crc32c(&stHeader, offsetof(SnapshotHeader, m_uiHeaderCrc));
+    bOk = bOk && fseek(pFile, 0, SEEK_SET) == 0;
+    bOk = bOk && fwrite(&stHeader, sizeof(stHeader), 1, pFile) == 1;
+    if (!CommitSnapshotFile(pFile, bOk, strTmpPath, strPath))
+    {
+        return ESnapshotResult::WriteFailed;
+    }
+    return ESnapshotResult::Ok;
+}
+
+// 从快照文件批量装载到空跳表
+// 工作线程按块并行校验CRC32C，主线程按顺序等待已校验的块并追加到跳表，
+// 校验与装载流水线重叠。iThreads 为校验线程数，0 表示按CPU核数自动选择。
+// bVerify 为false时跳过块校验，只用于测量校验本身的开销。
+// 失败时跳表中可能残留部分数据，调用方应丢弃该跳表。
+template<typename K, typename V, typename Access>
+ESnapshotResult LoadSnapshot(const std::string& strPath, SkipList<K, V, Access>& stList, int iThreads = 0, bool bVerify = true)
+{
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value, "snapshot requires trivially copyable key and value");
+
+    SnapshotFile stFile;
+    if (!stFile.Open(strPath))
+    {
+        return ESnapshotResult::OpenFailed;
+    }
+    if (stFile.Size() < sizeof(SnapshotHeader))
+    {
+        return ESnapshotResult::Truncated;
+    }
+
+    SnapshotHeader stHeader;
+    memcpy(&stHeader, stFile.Data(), sizeof(stHeader));
+    if (stHeader.m_uiMagic != SNAPSHOT_MAGIC || stHeader.m_usVersion != SNAPSHOT_VERSION ||
+        stHeader.m_uiHeaderCrc != Crc32c(&stHeader, offsetof(SnapshotHeader, m_uiHeaderCrc)))
+    {
+        return ESnapshotResult::BadHeader;
+    }
+    if (stHeader.m_usFlags != 0 || stHeader.m_uiKeySize != sizeof(K) || stHeader.m_uiValueSize != sizeof(V))
+    {
+        return ESnapshotResult::TypeMismatch;
+    }
+
+    // 扫描块头得到各块偏移，只读块头，开销与块数成正比
+    const size_t ulEntryBytes = sizeof(K) + sizeof(V);
+    std::vector<size_t> vecOffsets;
+    vecOffsets.reserve(stHeader.m_uiBlockCount);
+    size_t ulOffset = sizeof(SnapshotHeader);
+    uint64_t ulEntries = 0;
+    for (uint32_t i = 0; i < stHeader.m_uiBlockCount; ++i)
+    {
+        if (ulOffset + sizeof(SnapshotBlockHeader) > stFile.Size())
+        {
+            return ESnapshotResult::Truncated;
+        }
+        SnapshotBlockHeader stBlock;
+        memcpy(&stBlock, stFile.Data() + ulOffset, sizeof(stBlock));
+        if (static_cast<uint64_t>(stBlock.m_uiEntries) * ulEntryBytes != stBlock.m_uiBytes)
+        {
+            return ESnapshotResult::ChecksumMismatch;
+        }
+        if (ulOffset + sizeof(SnapshotBlockHeader) + stBlock.m_uiBytes > stFile.Size())
+        {
+            return ESnapshotResult::Truncated;
+        }
+        vecOffsets.push_back(ulOffset);
+        ulOffset += sizeof(SnapshotBlockHeader) + stBlock.m_uiBytes;
+        ulEntries += stBlock.m_uiEntries;
+    }
+    // 各块条目数之和必须等于文件头的条目总数，块数或块头被改动时在装载前发现
+    if (ulEntries != stHeader.m_ulCount)
+    {
+        return ESnapshotResult::ChecksumMismatch;
+    }
+
+    // 块校验状态：0 未校验，1 通过，2 失败
+    const uint32_t uiBlockCount = stHeader.m_uiBlockCount;
+    std::unique_ptr<std::atomic<uint8_t>[]> pStates(new std::atomic<uint8_t>[uiBlockCount]);
+    for (uint32_t i = 0; i < uiBlockCount; ++i)
+    {
+        pStates[i].store(bVerify ? 0 : 1, std::memory_order_relaxed);
+    }
+    std::atomic<uint32_t> uiNextBlock(0);// 下一个待领取的校验块
+    std::atomic<bool> bAbort(false);     // 装载失败，通知校验线程退出
+
+    auto VerifyBlock = [&](uint32_t uiIndex)
+    {
+        SnapshotBlockHeader stBlock;
+        const uint8_t* pBlock = stFile.Data() + vecOffsets[uiIndex];
+        memcpy(&stBlock, pBlock, sizeof(stBlock));
+        bool bValid = SnapshotBlockCrc(stBlock, pBlock + sizeof(stBlock)) == stBlock.m_uiCrc;
+        pStates[uiIndex].store(bValid ? 1 : 2, std::memory_order_release);
+    };
+    auto VerifyWorker = [&]()
+    {
+        while (!bAbort.load(std::memory_order_relaxed))
+        {
+            uint32_t uiIndex = uiNextBlock.fetch_add(1);
+            if (uiIndex >= uiBlockCount)
+            {
+                return;
+            }
+            VerifyBlock(uiIndex);
+        }
+    };
+
+    if (iThreads <= 0)
+    {
+        iThreads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    // 主线程负责装载，同时在等待时参与校验
+    int iWorkers = bVerify ? std::min<int>(iThreads - 1, static_cast<int>(uiBlockCount)) : 0;
+    std::vector<std::thread> vecWorkers;
+    for (int i = 0; i < iWorkers; ++i)
+    {
+        vecWorkers.emplace_back(VerifyWorker);
+    }
+
+    ESnapshotResult eResult = ESnapshotResult::Ok;
+    BulkCursor<K, V> stCursor;
+    stList.BeginBulkLoad(stCursor);
+    for (uint32_t i = 0; i < uiBlockCount && eResult == ESnapshotResult::Ok; ++i)
+    {
+        // 当前块还没被领取时，主线程自己领取校验，避免空等
+        while (pStates[i].load(std::memory_order_acquire) == 0)
+        {
+            if (uiNextBlock.load(std::memory_order_relaxed) <= i)
+            {
+                uint32_t uiIndex = uiNextBlock.fetch_add(1);
+                if (uiIndex < uiBlockCount)
+                {
+                    VerifyBlock(uiIndex);
+                }
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        if (pStates[i].load(std::memory_order_acquire) != 1)
+        {
+            eResult = ESnapshotResult::ChecksumMismatch;
+            break;
+        }
+
+        const uint8_t* pBlock = stFile.Data() + vecOffsets[i];
+        SnapshotBlockHeader stBlock;
+        memcpy(&stBlock, pBlock, sizeof(stBlock));
+        const uint8_t* pEntry = pBlock + sizeof(stBlock);
+        for (uint32_t j = 0; j < stBlock.m_uiEntries; ++j, pEntry += ulEntryBytes)
+        {
+            K key;
+            V value;
+            memcpy(&key, pEntry, sizeof(K));
+            memcpy(&value, pEntry + sizeof(K), sizeof(V));
+            if (!stList.AppendSorted(stCursor, key, value))
+            {
+                eResult = ESnapshotResult::Unordered;
+                break;
+            }
+        }
+    }
+    stList.EndBulkLoad(stCursor);
+
+    bAbort.store(true);
+    for (auto& stWorker : vecWorkers)
+    {
+        stWorker.join();
+    }
+    return eResult;
+}
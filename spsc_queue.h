@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 有界无锁单生产者单消费者队列
+// 头尾下标各占一条缓存行，两端各自缓存对方的下标，只有看起来满/空时才去读对方的缓存行
+template<typename T>
+class SpscQueue
+{
+    private:
+        std::vector<T> m_vecSlots;// 环形缓冲区
+        const size_t   m_ulMask;  // 容量-1，容量为2的幂
+
+        alignas(64) std::atomic<size_t> m_ulHead;// 消费者读到的位置
+        size_t m_ulCachedTail;                   // 消费者缓存的生产者位置
+        alignas(64) std::atomic<size_t> m_ulTail;// 生产者写到的位置
+        size_t m_ulCachedHead;                   // 生产者缓存的消费者位置
+
+        static size_t RoundUpPowerOfTwo(size_t ulValue)
+        {
+            size_t ulResult = 1;
+            while (ulResult < ulValue)
+            {
+                ulResult <<= 1;
+            }
+            return ulResult;
+        }
+
+    public:
+        explicit SpscQueue(size_t ulCapacity) : m_vecSlots(RoundUpPowerOfTwo(ulCapacity)), m_ulMask(m_vecSlots.size() - 1),
+            m_ulHead(0), m_ulCachedTail(0), m_ulTail(0), m_ulCachedHead(0)
+        {
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // 生产者调用，队列满时返回false
+        bool TryPush(const T& stValue)
+        {
+            size_t ulTail = m_ulTail.load(std::memory_order_relaxed);
+            if (ulTail - m_ulCachedHead > m_ulMask)
+            {
+                m_ulCachedHead = m_ulHead.load(std::memory_order_acquire);
+                if (ulTail - m_ulCachedHead > m_ulMask)
+                {
+                    return false;
+                }
+            }
+            m_vecSlots[ulTail & m_ulMask] = stValue;
+            m_ulTail.store(ulTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 生产者调用，队列满时返回false且不移动 stValue
+        bool TryPush(T&& stValue)
+        {
+            size_t ulTail = m_ulTail.load(std::memory_order_relaxed);
+            if (ulTail - m_ulCachedHead > m_ulMask)
+            {
+                m_ulCachedHead = m_ulHead.load(std::memory_order_acquire);
+                if (ulTail - m_ulCachedHead > m_ulMask)
+                {
+                    return false;
+                }
+            }
+            m_vecSlots[ulTail & m_ulMask] = std::move(stValue);
+            m_ulTail.store(ulTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 消费者调用，队列空时返回false
+        bool TryPop(T& stValue)
+        {
+            size_t ulHead = m_ulHead.load(std::memory_order_relaxed);
+            if (ulHead == m_ulCachedTail)
+            {
+                m_ulCachedTail = m_ulTail.load(std::memory_order_acquire);
+                if (ulHead == m_ulCachedTail)
+                {
+                    return false;
+                }
+            }
+            stValue = std::move(m_vecSlots[ulHead & m_ulMask]);
+            m_ulHead.store(ulHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 队列是否为空，任意线程可调用，结果只是某一时刻的近似
+        bool Empty() const
+        {
+            return m_ulHead.load(std::memory_order_acquire) == m_ulTail.load(std::memory_order_acquire);
+        }
+};
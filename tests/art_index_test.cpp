@@ -0,0 +1,213 @@
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "art_index.h"
+#include "test_util.h"
+
+namespace
+{
+    using LocalArt = ArtIndex<uint64_t, uint64_t, SingleThreadAccess>;
+
+    // 按升序收集从第一个不小于 ulFrom 的键开始的至多 ulCount 个键
+    template<typename Index>
+    std::vector<uint64_t> CollectFrom(Index& stIndex, uint64_t ulFrom, size_t ulCount)
+    {
+        std::vector<uint64_t> vecKeys;
+        stIndex.ForEachFrom(ulFrom, [&](const uint64_t& ulKey, const uint64_t&)
+        {
+            vecKeys.push_back(ulKey);
+            return vecKeys.size() < ulCount;
+        });
+        return vecKeys;
+    }
+
+    // 键集中在少数高位字节上，中间字节常为 0：长公共前缀反复在不同位置分叉，末字节取满 0~255 使节点长到 Node256
+    uint64_t MakeKey(std::mt19937_64& stRng, size_t ulFanout)
+    {
+        uint64_t ulHigh = stRng() % 3;
+        uint64_t ulMid = stRng() % 4 == 0 ? stRng() % 5 : 0;
+        uint64_t ulLow = stRng() % ulFanout;
+        return (ulHigh << 56) | (ulMid << 24) | ulLow;
+    }
+
+    void CheckAgainstModel(LocalArt& stIndex, const std::map<uint64_t, uint64_t>& mapModel, std::mt19937_64& stRng)
+    {
+        CHECK(stIndex.Size() == mapModel.size());
+        std::vector<uint64_t> vecAll;
+        stIndex.ForEach([&](const uint64_t& ulKey, const uint64_t& ulValue)
+        {
+            CHECK(mapModel.count(ulKey) == 1 && mapModel.at(ulKey) == ulValue);
+            vecAll.push_back(ulKey);
+            return true;
+        });
+        CHECK(vecAll.size() == mapModel.size());
+        size_t ulRank = 0;
+        for (const auto& stPair : mapModel)
+        {
+            CHECK(ulRank < vecAll.size() && vecAll[ulRank] == stPair.first);
+            CHECK(stIndex.GetRank(stPair.first) == ulRank);
+            CHECK(stIndex.Contains(stPair.first) && stIndex.GetValue(stPair.first) == stPair.second);
+            ++ulRank;
+        }
+        // 不在树中的键：排名为小于它的键数，遍历从后继开始
+        for (int i = 0; i < 50; ++i)
+        {
+            uint64_t ulKey = MakeKey(stRng, 300) + (stRng() % 2 == 0 ? 0 : stRng() % 1000);
+            auto itFrom = mapModel.lower_bound(ulKey);
+            CHECK(stIndex.GetRank(ulKey) == static_cast<size_t>(std::distance(mapModel.begin(), itFrom)));
+            CHECK(stIndex.Contains(ulKey) == (itFrom != mapModel.end() && itFrom->first == ulKey));
+            std::vector<uint64_t> vecExpect;
+            for (auto it = itFrom; it != mapModel.end() && vecExpect.size() < 40; ++it)
+            {
+                vecExpect.push_back(it->first);
+            }
+            CHECK(CollectFrom(stIndex, ulKey, 40) == vecExpect);
+        }
+    }
+}
+
+// 与 std::map 对照：先长到 Node256 再删到只剩几个键，途经前缀分叉、节点扩大与缩小、Node4 只剩一个子节点时并入子节点
+TEST_CASE(Art_MatchesOrderedMap)
+{
+    LocalArt stIndex;
+    std::map<uint64_t, uint64_t> mapModel;
+    std::mt19937_64 stRng(37);
+    for (int iRound = 0; iRound < 4; ++iRound)
+    {
+        // 扇出逐轮变化，节点在各类型之间来回
+        size_t ulFanout = iRound % 2 == 0 ? 300 : 20;
+        for (int iStep = 0; iStep < 6000; ++iStep)
+        {
+            uint64_t ulKey = MakeKey(stRng, ulFanout);
+            uint64_t ulValue = stRng();
+            CHECK(stIndex.Insert(ulKey, ulValue));
+            mapModel[ulKey] = ulValue;
+            if (iStep % 1500 == 0)
+            {
+                CheckAgainstModel(stIndex, mapModel, stRng);
+            }
+        }
+        CheckAgainstModel(stIndex, mapModel, stRng);
+        // 随机删到只剩几个键，删除不存在的键返回 false
+        while (mapModel.size() > 3)
+        {
+            uint64_t ulKey = MakeKey(stRng, 300);
+            CHECK(stIndex.Remove(ulKey) == (mapModel.erase(ulKey) == 1));
+            if (stRng() % 8 == 0)
+            {
+                auto it = std::next(mapModel.begin(), static_cast<std::ptrdiff_t>(stRng() % mapModel.size()));
+                CHECK(stIndex.Remove(it->first));
+                mapModel.erase(it);
+            }
+            if (mapModel.size() % 700 == 0)
+            {
+                CheckAgainstModel(stIndex, mapModel, stRng);
+            }
+        }
+        CheckAgainstModel(stIndex, mapModel, stRng);
+        stIndex.ReclaimRetired();
+    }
+    for (auto it = mapModel.begin(); it != mapModel.end(); it = mapModel.erase(it))
+    {
+        CHECK(stIndex.Remove(it->first));
+    }
+    CHECK(stIndex.Size() == 0 && !stIndex.Contains(0) && stIndex.GetRank(~0ULL) == 0);
+    CHECK(CollectFrom(stIndex, 0, 10).empty());
+}
+
+// 有符号键翻转符号位后按数值排序；排行榜键按分数降序、同分按成员编号升序
+TEST_CASE(Art_KeyEncodingOrder)
+{
+    ArtIndex<int64_t, int, SingleThreadAccess> stSigned;
+    const int64_t llKeys[] = { -1, 0, 1, INT64_MIN, INT64_MAX, -256, 255, 256 };
+    for (int64_t llKey : llKeys)
+    {
+        stSigned.Insert(llKey, 0);
+    }
+    std::vector<int64_t> vecSigned;
+    stSigned.ForEach([&](const int64_t& llKey, const int&)
+    {
+        vecSigned.push_back(llKey);
+        return true;
+    });
+    CHECK(vecSigned == std::vector<int64_t>({ INT64_MIN, -256, -1, 0, 1, 255, 256, INT64_MAX }));
+
+    ArtIndex<RankKey, uint64_t, SingleThreadAccess> stRank;
+    const RankKey stKeys[] = { { 1.5, 3 }, { -2, 1 }, { 1.5, 1 }, { 0.0, 9 }, { -0.0, 2 }, { 100, 5 } };
+    for (const RankKey& stKey : stKeys)
+    {
+        stRank.Insert(stKey, stKey.m_ulMember);
+    }
+    std::vector<uint64_t> vecMembers;
+    stRank.ForEach([&](const RankKey&, const uint64_t& ulMember)
+    {
+        vecMembers.push_back(ulMember);
+        return true;
+    });
+    CHECK(vecMembers == std::vector<uint64_t>({ 5, 1, 3, 2, 9, 1 }));
+    CHECK(stRank.GetRank(RankKey{ 0.0, 2 }) == 3 && stRank.GetRank(RankKey{ -0.0, 9 }) == 4);
+}
+
+// 读线程反复查找两个始终存在的短键，写线程在它们的根节点上反复插入、删除一个长键：根节点的前缀随之分叉、
+// Node4 只剩一个子节点时并入子节点，读线程不能在前缀变化的节点上按错误的深度比较
+TEST_CASE(Art_ConcurrentReadersDuringPrefixChanges)
+{
+    ArtIndex<uint64_t, uint64_t> stIndex;
+    stIndex.Insert(0x0100, 1);
+    stIndex.Insert(0x0200, 2);
+    std::atomic<bool> bStop(false);
+    std::atomic<size_t> ulFalseNegatives(0);
+    std::atomic<size_t> ulBadRanks(0);
+    std::atomic<size_t> ulBadWalks(0);
+    std::atomic<size_t> ulLookups(0);
+    std::vector<std::thread> vecReaders;
+    for (int t = 0; t < 3; ++t)
+    {
+        vecReaders.emplace_back([&]()
+        {
+            while (!bStop.load(std::memory_order_relaxed))
+            {
+                if (!stIndex.Contains(0x0100) || stIndex.GetValue(0x0200) != 2)
+                {
+                    ++ulFalseNegatives;
+                }
+                if (stIndex.GetRank(0x0100) != 0 || stIndex.GetRank(0x0200) != 1)
+                {
+                    ++ulBadRanks;
+                }
+                std::vector<uint64_t> vecKeys = CollectFrom(stIndex, 0, 2);
+                if (vecKeys != std::vector<uint64_t>({ 0x0100, 0x0200 }))
+                {
+                    ++ulBadWalks;
+                }
+                ulLookups.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    // 单核机器上读线程可能很久才被调度，写到读线程也查够一定次数为止
+    for (int i = 0; i < 200000 || ulLookups.load(std::memory_order_relaxed) < 200000; ++i)
+    {
+        stIndex.Insert(0x0100000000000000ULL, 3);
+        if (i % 4 == 0)
+        {
+            // 让根节点多一层前缀分叉
+            stIndex.Insert(0x0100000000000100ULL, 4);
+            stIndex.Remove(0x0100000000000100ULL);
+        }
+        stIndex.Remove(0x0100000000000000ULL);
+    }
+    bStop = true;
+    for (auto& stReader : vecReaders)
+    {
+        stReader.join();
+    }
+    CHECK(ulFalseNegatives.load() == 0);
+    CHECK(ulBadRanks.load() == 0);
+    CHECK(ulBadWalks.load() == 0);
+    CHECK(stIndex.Size() == 2);
+    stIndex.ReclaimRetired();
+}
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frozen_board.h"
+#include "leaderboard.h"
+#include "test_util.h"
+
+namespace
+{
+    const double INF = std::numeric_limits<double>::infinity();
+
+    // 成员数各异的参照榜：大量同分、±0、负数、±inf
+    void FillBoard(LocalLeaderboard& stBoard, size_t ulCount, uint64_t ulSeed)
+    {
+        const double dSpecial[] = { 0.0, -0.0, -INF, INF, -1.5, 1e300, -1e-300 };
+        std::mt19937_64 stRng(ulSeed);
+        for (size_t i = 0; i < ulCount; ++i)
+        {
+            double dScore = stRng() % 8 == 0 ? dSpecial[stRng() % 7] : static_cast<double>(static_cast<int64_t>(stRng() % 41) - 20) * 0.5;
+            stBoard.Add("m" + std::to_string(i), dScore);
+        }
+    }
+
+    // 查询分数：榜上已有的分数、相邻的浮点数和特殊值
+    std::vector<double> ProbeScores(LocalLeaderboard& stBoard)
+    {
+        std::vector<double> vecProbes = { 0.0, -0.0, -INF, INF, -1.5, 1e300, -1e-300, 10.25, -10.25, 100, -100 };
+        stBoard.ForEachRanked([&](std::string_view, double dScore)
+        {
+            vecProbes.push_back(dScore);
+            vecProbes.push_back(std::nextafter(dScore, INF));
+            vecProbes.push_back(std::nextafter(dScore, -INF));
+            return vecProbes.size() < 400;
+        });
+        return vecProbes;
+    }
+
+    // 冻结榜与参照榜的全部查询一致
+    void CheckMatches(const FrozenBoard& stFrozen, LocalLeaderboard& stBoard)
+    {
+        CHECK(stFrozen.Size() == stBoard.Size());
+        std::vector<RankEntry> vecExpect;
+        std::vector<RankEntry> vecActual;
+        for (bool bReverse : { false, true })
+        {
+            stBoard.GetRange(0, -1, bReverse, vecExpect);
+            stFrozen.GetRange(0, -1, bReverse, vecActual);
+            CHECK(vecActual.size() == vecExpect.size());
+            for (size_t i = 0; i < vecExpect.size() && i < vecActual.size(); ++i)
+            {
+                CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+                CHECK(vecActual[i].m_dScore == vecExpect[i].m_dScore);
+            }
+            stBoard.GetRange(1, -2, bReverse, vecExpect);
+            stFrozen.GetRange(1, -2, bReverse, vecActual);
+            CHECK(vecActual.size() == vecExpect.size());
+        }
+        stBoard.ForEachRanked([&](std::string_view svMember, double dScore)
+        {
+            double dFrozen = 0;
+            CHECK(stFrozen.GetScore(svMember, dFrozen) && dFrozen == dScore);
+            for (bool bReverse : { false, true })
+            {
+                size_t ulExpect = 0;
+                size_t ulActual = 0;
+                CHECK(stBoard.GetRank(svMember, bReverse, ulExpect));
+                CHECK(stFrozen.GetRank(svMember, bReverse, ulActual) && ulActual == ulExpect);
+            }
+            return true;
+        });
+        double dScore = 0;
+        size_t ulRank = 0;
+        CHECK(!stFrozen.GetScore("absent", dScore));
+        CHECK(!stFrozen.GetRank("absent", true, ulRank));
+
+        std::vector<double> vecProbes = ProbeScores(stBoard);
+        for (double dProbe : vecProbes)
+        {
+            // 高于 dProbe 的成员数即 (dProbe, +inf] 内的成员数
+            CHECK(stFrozen.CountAbove(dProbe) == stBoard.Count(ScoreBound{ dProbe, true }, ScoreBound{ INF, false }));
+        }
+        for (size_t i = 0; i + 1 < vecProbes.size(); i += 3)
+        {
+            double dLow = std::min(vecProbes[i], vecProbes[i + 1]);
+            double dHigh = std::max(vecProbes[i], vecProbes[i + 1]);
+            for (int iMask = 0; iMask < 4; ++iMask)
+            {
+                ScoreBound stMin{ dLow, (iMask & 1) != 0 };
+                ScoreBound stMax{ dHigh, (iMask & 2) != 0 };
+                CHECK(stFrozen.Count(stMin, stMax) == stBoard.Count(stMin, stMax));
+                // 上下界颠倒时为空
+                CHECK(stFrozen.Count(stMax, stMin) == stBoard.Count(stMax, stMin));
+            }
+        }
+    }
+
+    std::string TempPath(const char* szName)
+    {
+        return (std::filesystem::temp_directory_path() / (std::string("gameranking-frozen-") + szName + "-" + std::to_string(std::random_device()()))).string();
+    }
+}
+
+// 各种成员数(覆盖 Eytzinger 树从空到多层、最后一层满与不满)的冻结榜与排行榜的查询一致；映像按缓存行对齐
+TEST_CASE(Frozen_MatchesLeaderboard)
+{
+    std::vector<size_t> vecSizes;
+    for (size_t ulCount = 0; ulCount <= 70; ++ulCount)
+    {
+        vecSizes.push_back(ulCount);
+    }
+    vecSizes.push_back(1000);
+    vecSizes.push_back(4097);
+    for (size_t ulCount : vecSizes)
+    {
+        LocalLeaderboard stBoard;
+        FillBoard(stBoard, ulCount, ulCount + 1);
+        FrozenBoard stFrozen;
+        CHECK(stFrozen.Freeze(stBoard));
+        CHECK(stFrozen.ImageBytes() % 64 == 0);
+        CheckMatches(stFrozen, stBoard);
+    }
+}
+
+// CountAbove 即取得该分数时的名次：同分成员不计入，±0 视为同分
+TEST_CASE(Frozen_CountAbove)
+{
+    LocalLeaderboard stBoard;
+    stBoard.Add("a", 10);
+    stBoard.Add("b", 10);
+    stBoard.Add("c", 0.0);
+    stBoard.Add("d", -0.0);
+    stBoard.Add("e", -INF);
+    stBoard.Add("f", INF);
+    FrozenBoard stFrozen;
+    CHECK(stFrozen.Freeze(stBoard));
+    CHECK(stFrozen.CountAbove(INF) == 0);
+    CHECK(stFrozen.CountAbove(100) == 1);
+    CHECK(stFrozen.CountAbove(10) == 1);
+    CHECK(stFrozen.CountAbove(std::nextafter(10.0, -INF)) == 3);
+    CHECK(stFrozen.CountAbove(0.0) == 3);
+    CHECK(stFrozen.CountAbove(-0.0) == 3);
+    CHECK(stFrozen.CountAbove(-1) == 5);
+    CHECK(stFrozen.CountAbove(-INF) == 5);
+
+    FrozenBoard stEmpty;
+    CHECK(stEmpty.CountAbove(0) == 0);
+    CHECK(stEmpty.Count(ScoreBound{ -INF, false }, ScoreBound{ INF, false }) == 0);
+}
+
+// 写入文件后映射回来查询一致，不留临时文件；载荷损坏时校验失败，跳过校验时仍可打开
+TEST_CASE(Frozen_SaveOpen)
+{
+    LocalLeaderboard stBoard;
+    FillBoard(stBoard, 3000, 7);
+    FrozenBoard stFrozen;
+    CHECK(stFrozen.Freeze(stBoard));
+    std::string strPath = TempPath("save");
+    CHECK(stFrozen.Save(strPath) == ESnapshotResult::Ok);
+    CHECK(!std::filesystem::exists(strPath + ".tmp"));
+    CHECK(std::filesystem::file_size(strPath) == stFrozen.ImageBytes());
+
+    for (bool bVerify : { true, false })
+    {
+        FrozenBoard stMapped;
+        CHECK(stMapped.Open(strPath, bVerify) == ESnapshotResult::Ok);
+        CHECK(stMapped.ImageBytes() == stFrozen.ImageBytes());
+        CheckMatches(stMapped, stBoard);
+    }
+
+    // 改写成员名区的最后一个字节
+    FILE* pFile = fopen(strPath.c_str(), "r+b");
+    CHECK(pFile != nullptr);
+    if (pFile != nullptr)
+    {
+        fseek(pFile, static_cast<long>(stFrozen.ImageBytes() - 1), SEEK_SET);
+        fputc(0x5A, pFile);
+        fclose(pFile);
+    }
+    FrozenBoard stCorrupt;
+    CHECK(stCorrupt.Open(strPath) == ESnapshotResult::ChecksumMismatch);
+    CHECK(stCorrupt.Size() == 0 && stCorrupt.ImageBytes() == 0);
+    CHECK(stCorrupt.Open(strPath, false) == ESnapshotResult::Ok);
+
+    // 截断的文件
+    std::filesystem::resize_file(strPath, stFrozen.ImageBytes() - 64);
+    CHECK(stCorrupt.Open(strPath, false) == ESnapshotResult::Truncated);
+    std::filesystem::remove(strPath);
+
+    CHECK(stCorrupt.Open(strPath) == ESnapshotResult::OpenFailed);
+    FrozenBoard stUnfrozen;
+    CHECK(stUnfrozen.Save(strPath) == ESnapshotResult::WriteFailed);
+    CHECK(!std::filesystem::exists(strPath));
+}
@@ -0,0 +1,266 @@
+#include <atomic>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fenwick_index.h"
+#include "int_leaderboard.h"
+#include "leaderboard.h"
+#include "test_util.h"
+
+namespace
+{
+    using SmallKey = BoundedRankKey<50>;
+    using SmallIndex = FenwickIndex<SmallKey, uint64_t, SingleThreadAccess>;
+
+    // 按升序收集从第 ulRank 个键开始的至多 ulCount 个键
+    std::vector<SmallKey> CollectFromRank(SmallIndex& stIndex, size_t ulRank, size_t ulCount)
+    {
+        std::vector<SmallKey> vecKeys;
+        stIndex.ForEachFromRank(ulRank, [&](const SmallKey& stKey, const uint64_t&)
+        {
+            vecKeys.push_back(stKey);
+            return vecKeys.size() < ulCount;
+        });
+        return vecKeys;
+    }
+}
+
+// 值域只有 51 个槽，大量成员落在同一槽，反复拆分、合并桶内的块；排名、遍历、区间删除都与有序集合一致
+TEST_CASE(Fenwick_MatchesOrderedSet)
+{
+    SmallIndex stIndex;
+    std::set<SmallKey> setModel;
+    std::mt19937_64 stRng(29);
+    for (int iStep = 0; iStep < 60000; ++iStep)
+    {
+        // 分数集中在少数几个槽
+        uint32_t uiScore = stRng() % 4 == 0 ? static_cast<uint32_t>(stRng() % 51) : static_cast<uint32_t>(stRng() % 3) * 20;
+        SmallKey stKey{ uiScore, stRng() % 3000 };
+        uint64_t ulRoll = stRng() % 1000;
+        if (ulRoll < 550)
+        {
+            stIndex.Insert(stKey, stKey.m_ulMember * 2);
+            setModel.insert(stKey);
+        }
+        else if (ulRoll < 990)
+        {
+            CHECK(stIndex.Remove(stKey) == (setModel.erase(stKey) == 1));
+        }
+        else if (ulRoll < 995)
+        {
+            SmallKey stHigh{ uiScore > 5 ? uiScore - 5 : 0, stRng() % 3000 };
+            size_t ulExpect = 0;
+            for (auto it = setModel.lower_bound(stKey); it != setModel.end() && !(stHigh < *it);)
+            {
+                it = setModel.erase(it);
+                ++ulExpect;
+            }
+            CHECK(stIndex.RemoveRange(stKey, stHigh) == ulExpect);
+        }
+        else if (!setModel.empty())
+        {
+            size_t ulFirst = stRng() % setModel.size();
+            size_t ulLast = std::min(setModel.size() - 1, ulFirst + stRng() % 300);
+            CHECK(stIndex.RemoveRankRange(ulFirst, ulLast, [](const SmallKey&, const uint64_t&) {}) == ulLast - ulFirst + 1);
+            auto itFirst = std::next(setModel.begin(), static_cast<std::ptrdiff_t>(ulFirst));
+            setModel.erase(itFirst, std::next(itFirst, static_cast<std::ptrdiff_t>(ulLast - ulFirst + 1)));
+        }
+
+        if (iStep % 500 == 0)
+        {
+            CHECK(stIndex.Size() == setModel.size());
+            size_t ulRank = 0;
+            for (const SmallKey& stModelKey : setModel)
+            {
+                CHECK(stIndex.GetRank(stModelKey) == ulRank);
+                CHECK(stIndex.Contains(stModelKey) && stIndex.GetValue(stModelKey) == stModelKey.m_ulMember * 2);
+                ++ulRank;
+            }
+            std::vector<SmallKey> vecAll = CollectFromRank(stIndex, 0, SIZE_MAX);
+            CHECK(vecAll == std::vector<SmallKey>(setModel.begin(), setModel.end()));
+            for (int i = 0; i < 20 && !setModel.empty(); ++i)
+            {
+                size_t ulStart = stRng() % setModel.size();
+                auto itStart = std::next(setModel.begin(), static_cast<std::ptrdiff_t>(ulStart));
+                std::vector<SmallKey> vecExpect(itStart, std::next(itStart, static_cast<std::ptrdiff_t>(std::min<size_t>(150, setModel.size() - ulStart))));
+                CHECK(CollectFromRank(stIndex, ulStart, 150) == vecExpect);
+                std::vector<SmallKey> vecFrom;
+                stIndex.ForEachFrom(*itStart, [&](const SmallKey& stFromKey, const uint64_t&)
+                {
+                    vecFrom.push_back(stFromKey);
+                    return vecFrom.size() < 150;
+                });
+                CHECK(vecFrom == vecExpect);
+            }
+            for (size_t ulSlot = 0; ulSlot <= 51; ulSlot += 7)
+            {
+                size_t ulBelow = 0;
+                for (const SmallKey& stModelKey : setModel)
+                {
+                    ulBelow += 50 - stModelKey.m_uiScore < ulSlot ? 1 : 0;
+                }
+                CHECK(stIndex.CountBelowSlot(ulSlot) == ulBelow);
+            }
+            SmallKey stLast;
+            uint64_t ulValue = 0;
+            CHECK(stIndex.GetLast(stLast, ulValue) == !setModel.empty());
+            CHECK(setModel.empty() || stLast == *setModel.rbegin());
+        }
+    }
+}
+
+// 遍历的回调中删除刚访问的键和远处的键：按小批复制，回调在锁外执行；每个键至多访问一次、按升序，
+// 访问前已删除的后面批次中的键不再访问
+TEST_CASE(Fenwick_ModifyDuringIteration)
+{
+    SmallIndex stIndex;
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        stIndex.Insert(SmallKey{ 7, i }, i);
+    }
+    std::vector<uint64_t> vecVisited;
+    stIndex.ForEach([&](const SmallKey& stKey, const uint64_t& ulValue)
+    {
+        vecVisited.push_back(ulValue);
+        stIndex.Remove(stKey);
+        if (ulValue < 100)
+        {
+            stIndex.Remove(SmallKey{ 7, ulValue + 500 });
+        }
+        return true;
+    });
+    CHECK(vecVisited.size() == 900);
+    for (size_t i = 0; i < vecVisited.size(); ++i)
+    {
+        CHECK(i == 0 || vecVisited[i - 1] < vecVisited[i]);
+        CHECK(vecVisited[i] < 500 || vecVisited[i] >= 600);
+    }
+    CHECK(stIndex.Size() == 0);
+    CHECK(stIndex.CountBelowSlot(51) == 0);
+}
+
+// 整数分数排行榜与 Leaderboard 对照：同分的先后可能不同，逐名次比较分数，成员排名与自身区间一致；CountAbove、百分位与计数一致
+TEST_CASE(IntBoard_MatchesLeaderboard)
+{
+    LocalIntLeaderboard<1000000> stBoard;
+    LocalLeaderboard stReference;
+    std::mt19937_64 stRng(31);
+    for (int iStep = 0; iStep < 30000; ++iStep)
+    {
+        std::string strMember = "m" + std::to_string(stRng() % 2000);
+        uint64_t ulRoll = stRng() % 10;
+        // 一半写入集中在少数分数上
+        uint32_t uiScore = ulRoll < 5 ? static_cast<uint32_t>(stRng() % 4) * 1000 : static_cast<uint32_t>(stRng() % 1000001);
+        if (ulRoll < 7)
+        {
+            CHECK(stBoard.Add(strMember, uiScore) == stReference.Add(strMember, uiScore));
+        }
+        else if (ulRoll < 9)
+        {
+            int64_t llDelta = static_cast<int64_t>(stRng() % 2001) - 1000;
+            uint32_t uiNewScore = 0;
+            stBoard.IncrBy(strMember, llDelta, uiNewScore);
+            double dOld = 0;
+            stReference.GetScore(strMember, dOld);
+            stReference.Add(strMember, std::clamp<double>(dOld + static_cast<double>(llDelta), 0, 1000000));
+            double dExpect = 0;
+            CHECK(stReference.GetScore(strMember, dExpect) && dExpect == uiNewScore);
+        }
+        else
+        {
+            CHECK(stBoard.Remove(strMember) == stReference.Remove(strMember));
+        }
+    }
+
+    CHECK(stBoard.Size() == stReference.Size());
+    std::vector<RankEntry> vecEntries;
+    std::vector<RankEntry> vecExpect;
+    stBoard.GetRange(0, -1, true, vecEntries);
+    stReference.GetRange(0, -1, true, vecExpect);
+    CHECK(vecEntries.size() == vecExpect.size());
+    for (size_t i = 0; i < vecEntries.size() && i < vecExpect.size(); ++i)
+    {
+        CHECK(vecEntries[i].m_dScore == vecExpect[i].m_dScore);
+        size_t ulRank = 0;
+        CHECK(stBoard.GetRank(vecEntries[i].m_strMember, true, ulRank) && ulRank == i);
+        CHECK(stBoard.GetRank(vecEntries[i].m_strMember, false, ulRank) && ulRank == vecEntries.size() - 1 - i);
+        uint32_t uiScore = 0;
+        CHECK(stBoard.GetScore(vecEntries[i].m_strMember, uiScore) && uiScore == vecEntries[i].m_dScore);
+    }
+    for (int i = 0; i < 200; ++i)
+    {
+        int64_t llStart = static_cast<int64_t>(stRng() % (vecEntries.size() + 10)) - 5;
+        int64_t llStop = llStart + static_cast<int64_t>(stRng() % 100);
+        std::vector<RankEntry> vecPart;
+        std::vector<RankEntry> vecPartExpect;
+        stBoard.GetRange(llStart, llStop, false, vecPart);
+        stReference.GetRange(llStart, llStop, false, vecPartExpect);
+        CHECK(vecPart.size() == vecPartExpect.size());
+        for (size_t j = 0; j < vecPart.size() && j < vecPartExpect.size(); ++j)
+        {
+            CHECK(vecPart[j].m_dScore == vecPartExpect[j].m_dScore);
+        }
+    }
+    const double dInf = std::numeric_limits<double>::infinity();
+    for (uint32_t uiScore : { 0u, 1u, 999u, 1000u, 1001u, 3000u, 500000u, 999999u, 1000000u })
+    {
+        double dScore = uiScore;
+        CHECK(stBoard.CountAbove(uiScore) == stReference.Count(ScoreBound{ dScore, true }, ScoreBound{ dInf, false }));
+        size_t ulBelow = stReference.Count(ScoreBound{ -dInf, false }, ScoreBound{ dScore, true });
+        CHECK(stBoard.GetPercentile(uiScore) == static_cast<double>(ulBelow) / static_cast<double>(stReference.Size()));
+    }
+}
+
+// 多线程写入同一批分数，读线程同时查询区间和排名；结束后成员数、分数与写入一致
+TEST_CASE(IntBoard_ConcurrentWrites)
+{
+    IntLeaderboard<1000000> stBoard;
+    std::atomic<bool> bStop(false);
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 3; ++t)
+    {
+        vecThreads.emplace_back([&stBoard, t]()
+        {
+            uint32_t uiNewScore = 0;
+            for (int i = 0; i < 20000; ++i)
+            {
+                stBoard.IncrBy("t" + std::to_string(t) + "_" + std::to_string(i % 500), 1 + i % 3, uiNewScore);
+            }
+        });
+    }
+    std::thread stReader([&stBoard, &bStop]()
+    {
+        std::vector<RankEntry> vecEntries;
+        size_t ulRank = 0;
+        while (!bStop.load())
+        {
+            stBoard.GetRange(0, 99, true, vecEntries);
+            for (size_t i = 1; i < vecEntries.size(); ++i)
+            {
+                CHECK(vecEntries[i - 1].m_dScore >= vecEntries[i].m_dScore);
+            }
+            stBoard.GetRank("t0_0", true, ulRank);
+            stBoard.CountAbove(100);
+        }
+    });
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    bStop = true;
+    stReader.join();
+    CHECK(stBoard.Size() == 1500);
+    std::vector<RankEntry> vecEntries;
+    stBoard.GetRange(0, -1, true, vecEntries);
+    double dTotal = 0;
+    for (const RankEntry& stEntry : vecEntries)
+    {
+        dTotal += stEntry.m_dScore;
+    }
+    CHECK(dTotal == 3 * 39999.0);
+    CHECK(stBoard.CountAbove(0) == 1500);
+}
@@ -0,0 +1,527 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "leaderboard.h"
+#include "test_util.h"
+
+namespace
+{
+    double Ulp(double dValue)
+    {
+        dValue = std::fabs(dValue);
+        return std::nextafter(dValue, std::numeric_limits<double>::infinity()) - dValue;
+    }
+}
+
+// 换算能精确得到写入值时读回原值：整数分数加整数偏移、按 2 的幂缩放；原始分数 0 附近的大片同值区间不会拖慢写入
+TEST_CASE(Leaderboard_TransformExactWhenRepresentable)
+{
+    const double dTransforms[][2] = { { 1, 500 }, { 0.5, -3 }, { 2, 0 }, { 0.25, 1024 }, { 3, 500 } };
+    for (const auto& dTransform : dTransforms)
+    {
+        LocalLeaderboard stBoard;
+        CHECK(stBoard.ApplyTransform(dTransform[0], dTransform[1]));
+        for (int i = -2000; i <= 2000; ++i)
+        {
+            double dScore = i * 0.5;
+            stBoard.Add("m", dScore);
+            double dRead = 0;
+            CHECK(stBoard.GetScore("m", dRead) && dRead == dScore);
+        }
+        // 偏移 500 时原始分数 0 及其附近的非规格化数都换算为 500
+        stBoard.Add("m", 500);
+        double dRead = 0;
+        CHECK(stBoard.GetScore("m", dRead) && dRead == 500);
+        CHECK(stBoard.Count(ScoreBound{ 500, false }, ScoreBound{ 500, false }) == 1);
+        CHECK(stBoard.Count(ScoreBound{ 500, true }, ScoreBound{ 1000, false }) == 0);
+        CHECK(stBoard.Count(ScoreBound{ 0, false }, ScoreBound{ 500, true }) == 0);
+    }
+}
+
+// 任意变换下读回值与写入值之差不超过 m_dScale 个原始分数 ulp 加对外分数的 1 ulp，IncrBy 返回值与读回值一致，
+// 排名、区间和计数与按读回值建的 Leaderboard 一致
+TEST_CASE(Leaderboard_TransformPrecisionBound)
+{
+    std::mt19937_64 stRng(23);
+    std::uniform_real_distribution<double> stUnit(0, 1);
+    for (int iRound = 0; iRound < 20; ++iRound)
+    {
+        LocalLeaderboard stBoard;
+        std::map<std::string, double> mapScores;
+        double dScale = 1;
+        double dOffset = 0;
+        for (int iStep = 0; iStep < 3000; ++iStep)
+        {
+            std::string strMember = "m" + std::to_string(stRng() % 200);
+            uint64_t ulRoll = stRng() % 100;
+            if (ulRoll < 2)
+            {
+                double dFactor = 0.5 + stUnit(stRng);
+                double dShift = (stUnit(stRng) - 0.5) * std::pow(10.0, static_cast<double>(stRng() % 7));
+                CHECK(stBoard.ApplyTransform(dFactor, dShift));
+                dScale *= dFactor;
+                dOffset = dOffset * dFactor + dShift;
+                // 变换后的分数以读回值为准
+                for (auto& stPair : mapScores)
+                {
+                    CHECK(stBoard.GetScore(stPair.first, stPair.second));
+                }
+                continue;
+            }
+            // 分数间隔远大于误差，读回值互不相同，排名与并列的处理无关
+            double dWritten = 0;
+            double dRead = 0;
+            if (ulRoll < 70 || mapScores.count(strMember) == 0)
+            {
+                dWritten = static_cast<double>(iStep) + stUnit(stRng) * 0.5;
+                stBoard.Add(strMember, dWritten);
+                CHECK(stBoard.GetScore(strMember, dRead));
+            }
+            else
+            {
+                double dDelta = static_cast<double>(stRng() % 4000) + 0.25;
+                dWritten = mapScores[strMember] + dDelta;
+                CHECK(stBoard.IncrBy(strMember, dDelta, dRead));
+                double dScore = 0;
+                CHECK(stBoard.GetScore(strMember, dScore) && dScore == dRead);
+            }
+            double dBound = dScale * Ulp((dWritten - dOffset) / dScale) + Ulp(dWritten);
+            CHECK(std::fabs(dRead - dWritten) <= dBound);
+            mapScores[strMember] = dRead;
+        }
+
+        LocalLeaderboard stReference;
+        for (const auto& stPair : mapScores)
+        {
+            stReference.Add(stPair.first, stPair.second);
+        }
+        std::vector<RankEntry> vecEntries;
+        std::vector<RankEntry> vecExpect;
+        stBoard.GetRange(0, -1, true, vecEntries);
+        stReference.GetRange(0, -1, true, vecExpect);
+        CHECK(vecEntries.size() == vecExpect.size());
+        for (size_t i = 0; i < vecEntries.size() && i < vecExpect.size(); ++i)
+        {
+            CHECK(vecEntries[i].m_strMember == vecExpect[i].m_strMember && vecEntries[i].m_dScore == vecExpect[i].m_dScore);
+            size_t ulRank = 0;
+            CHECK(stBoard.GetRank(vecEntries[i].m_strMember, true, ulRank) && ulRank == i);
+        }
+        // 端点取成员的读回值，检验开闭区间的反算
+        for (int i = 0; i < 50 && !vecExpect.empty(); ++i)
+        {
+            ScoreBound stMin{ vecExpect[stRng() % vecExpect.size()].m_dScore, (stRng() & 1) != 0 };
+            ScoreBound stMax{ vecExpect[stRng() % vecExpect.size()].m_dScore, (stRng() & 1) != 0 };
+            CHECK(stBoard.Count(stMin, stMax) == stReference.Count(stMin, stMax));
+        }
+    }
+}
+
+namespace
+{
+    // 记录分数事件的接收者
+    struct EventCounter : public ScoreEventSink
+    {
+        size_t m_ulAdded = 0;
+        size_t m_ulRemoved = 0;
+
+        void OnScoreEvent(const ScoreEvent& stEvent) override
+        {
+            m_ulAdded += stEvent.m_eType == EScoreEvent::Added ? 1 : 0;
+            m_ulRemoved += stEvent.m_eType == EScoreEvent::Removed ? 1 : 0;
+        }
+    };
+}
+
+// 满员后低于准入分数的新成员增量写入不进榜，也不产生新增、删除事件；高于准入分数的挤掉最后一名
+TEST_CASE(Leaderboard_CapacityIncrByAdmission)
+{
+    LocalLeaderboard stBoard;
+    EventCounter stCounter;
+    stBoard.SetEventSink(&stCounter, "b");
+    stBoard.SetCapacity(3);
+    stBoard.Add("a", 10);
+    stBoard.Add("b", 20);
+    stBoard.Add("c", 30);
+    CHECK(stBoard.GetAdmitScore() == 10);
+    double dNewScore = 0;
+    CHECK(stBoard.IncrBy("x", 5, dNewScore) && dNewScore == 5);
+    CHECK(stBoard.Size() == 3 && !stBoard.GetScore("x", dNewScore));
+    CHECK(stCounter.m_ulAdded == 3 && stCounter.m_ulRemoved == 0);
+
+    // 榜内成员的增量照常执行
+    CHECK(stBoard.IncrBy("a", -100, dNewScore) && dNewScore == -90);
+    CHECK(stBoard.GetAdmitScore() == -90);
+    CHECK(stBoard.IncrBy("y", 0, dNewScore) && dNewScore == 0);
+    CHECK(stBoard.Size() == 3 && !stBoard.GetScore("a", dNewScore) && stBoard.GetScore("y", dNewScore));
+    CHECK(stCounter.m_ulAdded == 4 && stCounter.m_ulRemoved == 1);
+
+    // 批量写与逐条执行一致
+    std::vector<WriteOp> vecOps = { WriteOp{ EWriteOp::IncrBy, "z", -1, AddOptions() }, WriteOp{ EWriteOp::IncrBy, "w", 25, AddOptions() } };
+    std::vector<WriteResult> vecResults;
+    stBoard.ApplyBatch(vecOps, vecResults);
+    CHECK(vecResults[0].m_bOk && vecResults[0].m_dScore == -1 && vecResults[1].m_bOk);
+    std::vector<RankEntry> vecEntries;
+    stBoard.GetRange(0, -1, true, vecEntries);
+    CHECK(vecEntries.size() == 3 && vecEntries[0].m_strMember == "c" && vecEntries[1].m_strMember == "w" && vecEntries[2].m_strMember == "b");
+}
+
+// 满员后榜内成员降到准入分数以下照常更新，降为最后一名仍在榜内；随后准入分数跟着下降，新成员按新的准入分数进榜
+TEST_CASE(Leaderboard_CapacityLowersMemberScore)
+{
+    LocalLeaderboard stBoard;
+    EventCounter stCounter;
+    stBoard.SetEventSink(&stCounter, "b");
+    stBoard.SetCapacity(3);
+    stBoard.Add("a", 10);
+    stBoard.Add("b", 20);
+    stBoard.Add("c", 30);
+    CHECK(stBoard.Add("c", 5) == EAddResult::Updated);
+    double dScore = 0;
+    CHECK(stBoard.GetScore("c", dScore) && dScore == 5);
+    CHECK(stBoard.Size() == 3 && stBoard.GetAdmitScore() == 5);
+    size_t ulRank = 0;
+    CHECK(stBoard.GetRank("c", true, ulRank) && ulRank == 2);
+    CHECK(stCounter.m_ulRemoved == 0);
+
+    // 低于准入分数的新成员仍被拒绝，XX 对新成员也不生效
+    CHECK(stBoard.Add("x", 4) == EAddResult::Unchanged);
+    AddOptions stXx;
+    stXx.m_bXx = true;
+    CHECK(stBoard.Add("x", 50, stXx) == EAddResult::Unchanged);
+    CHECK(stBoard.Size() == 3 && !stBoard.GetScore("x", dScore));
+
+    // 高于准入分数的新成员挤掉降分后的 c
+    CHECK(stBoard.Add("x", 7) == EAddResult::Added);
+    CHECK(!stBoard.GetScore("c", dScore) && stBoard.GetAdmitScore() == 7);
+    CHECK(stCounter.m_ulRemoved == 1);
+
+    // 批量写中同样先降分再按容量挤出
+    std::vector<WriteOp> vecOps = { WriteOp{ EWriteOp::Add, "b", 1, AddOptions() }, WriteOp{ EWriteOp::Add, "y", 2, AddOptions() },
+        WriteOp{ EWriteOp::Add, "z", 0.5, AddOptions() } };
+    std::vector<WriteResult> vecResults;
+    stBoard.ApplyBatch(vecOps, vecResults);
+    CHECK(vecResults[0].m_eAdd == EAddResult::Updated && vecResults[1].m_eAdd == EAddResult::Added);
+    std::vector<RankEntry> vecEntries;
+    stBoard.GetRange(0, -1, true, vecEntries);
+    CHECK(vecEntries.size() == 3 && vecEntries[0].m_strMember == "a" && vecEntries[1].m_strMember == "x" && vecEntries[2].m_strMember == "y");
+    CHECK(stBoard.GetAdmitScore() == 2);
+}
+
+// 计数按排名之差计算：与逐个比较全部成员的结果一致，覆盖同分、开闭端点、±0、±inf 和紧凑数组与跳表两种索引
+TEST_CASE(Leaderboard_CountMatchesScan)
+{
+    const double dInf = std::numeric_limits<double>::infinity();
+    const double dSpecial[] = { 0.0, -0.0, -dInf, dInf, 2.5 };
+    std::mt19937_64 stRng(41);
+    for (size_t ulMembers : { size_t(10), size_t(3000) })
+    {
+        LocalLeaderboard stBoard;
+        std::vector<double> vecScores;
+        for (size_t i = 0; i < ulMembers; ++i)
+        {
+            double dScore = stRng() % 10 == 0 ? dSpecial[stRng() % 5] : static_cast<double>(static_cast<int64_t>(stRng() % 61) - 30) * 0.5;
+            stBoard.Add("m" + std::to_string(i), dScore);
+            vecScores.push_back(dScore);
+        }
+        for (int i = 0; i < 400; ++i)
+        {
+            ScoreBound stMin{ i % 7 == 0 ? dSpecial[stRng() % 5] : static_cast<double>(static_cast<int64_t>(stRng() % 71) - 35) * 0.5, (stRng() & 1) != 0 };
+            ScoreBound stMax{ i % 5 == 0 ? dSpecial[stRng() % 5] : static_cast<double>(static_cast<int64_t>(stRng() % 71) - 35) * 0.5, (stRng() & 1) != 0 };
+            size_t ulExpect = 0;
+            for (double dScore : vecScores)
+            {
+                bool bAboveMin = stMin.m_bExclusive ? dScore > stMin.m_dValue : dScore >= stMin.m_dValue;
+                bool bBelowMax = stMax.m_bExclusive ? dScore < stMax.m_dValue : dScore <= stMax.m_dValue;
+                ulExpect += bAboveMin && bBelowMax ? 1 : 0;
+            }
+            CHECK(stBoard.Count(stMin, stMax) == ulExpect);
+        }
+    }
+}
+
+namespace
+{
+    // 按 GetRange 的升序排名(分数从低到高)取出全部成员
+    std::vector<RankEntry> Ascending(LocalLeaderboard& stBoard)
+    {
+        std::vector<RankEntry> vecEntries;
+        stBoard.GetRange(0, -1, false, vecEntries);
+        return vecEntries;
+    }
+
+    bool InBounds(double dScore, const ScoreBound& stMin, const ScoreBound& stMax)
+    {
+        bool bAboveMin = stMin.m_bExclusive ? dScore > stMin.m_dValue : dScore >= stMin.m_dValue;
+        bool bBelowMax = stMax.m_bExclusive ? dScore < stMax.m_dValue : dScore <= stMax.m_dValue;
+        return bAboveMin && bBelowMax;
+    }
+
+    // 删除后剩余成员与预期一致，各成员的排名与位置一致(索引的跨度在整段摘除后仍正确)
+    void CheckRemaining(LocalLeaderboard& stBoard, const std::vector<RankEntry>& vecExpect)
+    {
+        std::vector<RankEntry> vecActual = Ascending(stBoard);
+        CHECK(stBoard.Size() == vecExpect.size() && vecActual.size() == vecExpect.size());
+        for (size_t i = 0; i < vecActual.size() && i < vecExpect.size(); ++i)
+        {
+            CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember && vecActual[i].m_dScore == vecExpect[i].m_dScore);
+            size_t ulRank = 0;
+            CHECK(stBoard.GetRank(vecActual[i].m_strMember, false, ulRank) && ulRank == i);
+            std::vector<RankEntry> vecOne;
+            stBoard.GetRange(static_cast<int64_t>(i), static_cast<int64_t>(i), false, vecOne);
+            CHECK(vecOne.size() == 1 && vecOne[0].m_strMember == vecActual[i].m_strMember);
+        }
+    }
+}
+
+// 按分数、按排名整段删除与逐个判断的结果一致：开闭端点、±inf、负数和越界排名、起点大于终点，
+// 紧凑数组与跳表两种索引，以及偏移缩放生效时按对外的分数判断
+TEST_CASE(Leaderboard_RemoveRangeMatchesModel)
+{
+    const double dInf = std::numeric_limits<double>::infinity();
+    std::mt19937_64 stRng(47);
+    for (int iRound = 0; iRound < 60; ++iRound)
+    {
+        LocalLeaderboard stBoard;
+        size_t ulMembers = iRound % 3 == 0 ? 40 : 800;
+        if (iRound % 4 == 1)
+        {
+            CHECK(stBoard.ApplyTransform(iRound % 8 == 1 ? 0.5 : 3, -7.25));
+        }
+        for (size_t i = 0; i < ulMembers; ++i)
+        {
+            stBoard.Add("m" + std::to_string(i), static_cast<double>(static_cast<int64_t>(stRng() % 81) - 40) * 0.5);
+        }
+        for (int iStep = 0; iStep < 6 && stBoard.Size() > 0; ++iStep)
+        {
+            std::vector<RankEntry> vecBefore = Ascending(stBoard);
+            std::vector<RankEntry> vecExpect;
+            int64_t llSize = static_cast<int64_t>(vecBefore.size());
+            if (iStep % 2 == 0)
+            {
+                // 端点取榜上的分数或任意分数，偶尔为 ±inf
+                auto PickBound = [&]()
+                {
+                    double dValue = stRng() % 2 == 0 ? vecBefore[stRng() % vecBefore.size()].m_dScore : static_cast<double>(static_cast<int64_t>(stRng() % 101) - 50) * 0.25;
+                    dValue = stRng() % 10 == 0 ? (stRng() % 2 == 0 ? dInf : -dInf) : dValue;
+                    return ScoreBound{ dValue, (stRng() & 1) != 0 };
+                };
+                ScoreBound stMin = PickBound();
+                ScoreBound stMax = PickBound();
+                for (const RankEntry& stEntry : vecBefore)
+                {
+                    if (!InBounds(stEntry.m_dScore, stMin, stMax))
+                    {
+                        vecExpect.push_back(stEntry);
+                    }
+                }
+                CHECK(stBoard.Count(stMin, stMax) == vecBefore.size() - vecExpect.size());
+                CHECK(stBoard.RemoveRangeByScore(stMin, stMax) == vecBefore.size() - vecExpect.size());
+            }
+            else
+            {
+                // 起止可正可负，可以越过两端
+                int64_t llStart = static_cast<int64_t>(stRng() % static_cast<uint64_t>(2 * llSize + 10)) - llSize - 5;
+                int64_t llStop = static_cast<int64_t>(stRng() % static_cast<uint64_t>(2 * llSize + 10)) - llSize - 5;
+                int64_t llFirst = llStart < 0 ? std::max<int64_t>(llStart + llSize, 0) : llStart;
+                int64_t llLast = std::min(llStop < 0 ? llStop + llSize : llStop, llSize - 1);
+                for (int64_t i = 0; i < llSize; ++i)
+                {
+                    if (i < llFirst || i > llLast)
+                    {
+                        vecExpect.push_back(vecBefore[static_cast<size_t>(i)]);
+                    }
+                }
+                CHECK(stBoard.RemoveRangeByRank(llStart, llStop) == vecBefore.size() - vecExpect.size());
+            }
+            CheckRemaining(stBoard, vecExpect);
+        }
+    }
+
+    // 只保留前 N 名；删除全部
+    LocalLeaderboard stBoard;
+    for (int i = 0; i < 300; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), i);
+    }
+    CHECK(stBoard.RemoveRangeByRank(0, -11) == 290);
+    std::vector<RankEntry> vecTop = Ascending(stBoard);
+    CHECK(vecTop.size() == 10 && vecTop.front().m_dScore == 290 && vecTop.back().m_dScore == 299);
+    CHECK(stBoard.RemoveRangeByRank(5, 2) == 0 && stBoard.RemoveRangeByRank(10, 20) == 0 && stBoard.RemoveRangeByRank(-100, -20) == 0);
+    CHECK(stBoard.RemoveRangeByScore(ScoreBound{ 299, true }, ScoreBound{ dInf, false }) == 0);
+    CHECK(stBoard.RemoveRangeByScore(ScoreBound{ 295, false }, ScoreBound{ 295, true }) == 0);
+    CHECK(stBoard.RemoveRangeByScore(ScoreBound{ -dInf, false }, ScoreBound{ dInf, false }) == 10);
+    CHECK(stBoard.Size() == 0);
+}
+
+namespace
+{
+    // 订阅者按事件重建的窗口：成员名与分数按排名排列，事件序号连续
+    struct WindowReplica
+    {
+        std::vector<RankEntry> m_vecWindow;
+        uint64_t m_ulSeq = 0;
+        size_t m_ulEvents = 0;
+        size_t m_ulEnters = 0;
+        size_t m_ulExits = 0;
+        size_t m_ulMoves = 0;
+
+        // 取出一次写操作产生的全部事件：离开按旧排名、进入和移动按新排名，其余成员排名不变
+        void Drain(RankSubscription& stSub)
+        {
+            std::vector<RankEntry> vecOld = m_vecWindow;
+            std::vector<bool> vecStays(vecOld.size(), true);
+            std::map<size_t, RankEntry> mapPlaced;
+            RankEvent stEvent;
+            while (stSub.Poll(stEvent))
+            {
+                CHECK(stEvent.m_ulSeq == ++m_ulSeq);
+                ++m_ulEvents;
+                auto FindOld = [&](const std::string& strMember)
+                {
+                    for (size_t i = 0; i < vecOld.size(); ++i)
+                    {
+                        if (vecOld[i].m_strMember == strMember)
+                        {
+                            return i;
+                        }
+                    }
+                    return SIZE_MAX;
+                };
+                size_t ulOld = FindOld(stEvent.m_strMember);
+                switch (stEvent.m_eType)
+                {
+                case ERankEvent::Exit:
+                    ++m_ulExits;
+                    CHECK(ulOld == stEvent.m_ulOldRank && ulOld < vecOld.size() && vecOld[ulOld].m_dScore == stEvent.m_dScore);
+                    if (ulOld < vecOld.size())
+                    {
+                        vecStays[ulOld] = false;
+                    }
+                    break;
+                case ERankEvent::Enter:
+                    ++m_ulEnters;
+                    CHECK(ulOld == SIZE_MAX || !vecStays[ulOld]);
+                    mapPlaced[stEvent.m_ulNewRank] = RankEntry{ stEvent.m_strMember, stEvent.m_dScore };
+                    break;
+                case ERankEvent::Move:
+                    ++m_ulMoves;
+                    CHECK(ulOld == stEvent.m_ulOldRank && ulOld < vecOld.size());
+                    if (ulOld < vecOld.size())
+                    {
+                        vecStays[ulOld] = false;
+                    }
+                    mapPlaced[stEvent.m_ulNewRank] = RankEntry{ stEvent.m_strMember, stEvent.m_dScore };
+                    break;
+                }
+            }
+            for (size_t i = 0; i < vecOld.size(); ++i)
+            {
+                if (vecStays[i])
+                {
+                    CHECK(mapPlaced.count(i) == 0);
+                    mapPlaced[i] = vecOld[i];
+                }
+            }
+            m_vecWindow.clear();
+            for (const auto& stPair : mapPlaced)
+            {
+                CHECK(stPair.first == m_vecWindow.size());
+                m_vecWindow.push_back(stPair.second);
+            }
+        }
+    };
+
+    void CheckReplica(LocalLeaderboard& stBoard, const WindowReplica& stReplica, size_t ulWindow)
+    {
+        std::vector<RankEntry> vecTop;
+        stBoard.GetRange(0, static_cast<int64_t>(ulWindow) - 1, true, vecTop);
+        CHECK(stReplica.m_vecWindow.size() == vecTop.size());
+        for (size_t i = 0; i < vecTop.size() && i < stReplica.m_vecWindow.size(); ++i)
+        {
+            CHECK(stReplica.m_vecWindow[i].m_strMember == vecTop[i].m_strMember && stReplica.m_vecWindow[i].m_dScore == vecTop[i].m_dScore);
+        }
+    }
+}
+
+// 两个窗口大小不同的订阅按事件重建的窗口始终与榜单前 N 名一致：进入和离开窗口、窗口内移动、删除、批量写；
+// 取消订阅后不再收到事件，另一个订阅不受影响
+TEST_CASE(Leaderboard_SubscribeWindowMatchesTop)
+{
+    LocalLeaderboard stBoard;
+    std::mt19937_64 stRng(53);
+    for (int i = 0; i < 60; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), static_cast<double>(stRng() % 100));
+    }
+    const size_t ulSmall = 5;
+    const size_t ulLarge = 12;
+    std::shared_ptr<RankSubscription> pSmall = stBoard.Subscribe(ulSmall, 4096);
+    std::shared_ptr<RankSubscription> pLarge = stBoard.Subscribe(ulLarge, 4096);
+    WindowReplica stSmall;
+    WindowReplica stLarge;
+    // 订阅时收到当前窗口内每个成员的进入事件
+    stSmall.Drain(*pSmall);
+    stLarge.Drain(*pLarge);
+    CHECK(stSmall.m_ulEnters == ulSmall && stLarge.m_ulEnters == ulLarge);
+    CheckReplica(stBoard, stSmall, ulSmall);
+    CheckReplica(stBoard, stLarge, ulLarge);
+
+    for (int iStep = 0; iStep < 4000; ++iStep)
+    {
+        std::string strMember = "m" + std::to_string(stRng() % 80);
+        uint64_t ulRoll = stRng() % 100;
+        if (ulRoll < 40)
+        {
+            stBoard.Add(strMember, static_cast<double>(stRng() % 120));
+        }
+        else if (ulRoll < 70)
+        {
+            double dNewScore = 0;
+            stBoard.IncrBy(strMember, static_cast<double>(static_cast<int64_t>(stRng() % 21) - 10), dNewScore);
+        }
+        else if (ulRoll < 85)
+        {
+            stBoard.Remove(strMember);
+        }
+        else
+        {
+            // 批量写中同一成员可能多次修改，事件只反映整批前后的窗口
+            std::vector<std::string> vecNames;
+            std::vector<WriteOp> vecOps;
+            for (int i = 0; i < 6; ++i)
+            {
+                vecNames.push_back("m" + std::to_string(stRng() % 80));
+            }
+            for (int i = 0; i < 6; ++i)
+            {
+                EWriteOp eOp = i % 3 == 0 ? EWriteOp::Add : (i % 3 == 1 ? EWriteOp::IncrBy : EWriteOp::Remove);
+                vecOps.push_back(WriteOp{ eOp, vecNames[i], static_cast<double>(stRng() % 120), AddOptions() });
+            }
+            std::vector<WriteResult> vecResults;
+            stBoard.ApplyBatch(vecOps, vecResults);
+        }
+        stSmall.Drain(*pSmall);
+        stLarge.Drain(*pLarge);
+        if (iStep <= 2000)
+        {
+            CheckReplica(stBoard, stSmall, ulSmall);
+        }
+        CheckReplica(stBoard, stLarge, ulLarge);
+        if (iStep == 2000)
+        {
+            stBoard.Unsubscribe(pSmall);
+            stSmall.m_vecWindow.clear();
+        }
+        if (iStep > 2000)
+        {
+            CHECK(stSmall.m_vecWindow.empty());
+        }
+    }
+    CHECK(stLarge.m_ulExits > 0 && stLarge.m_ulMoves > 0 && stLarge.m_ulEnters > ulLarge);
+    CHECK(pSmall->GetDropped() == 0 && pLarge->GetDropped() == 0);
+}
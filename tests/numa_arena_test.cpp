@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "numa_arena.h"
+#include "test_util.h"
+
+namespace
+{
+    struct Block
+    {
+        char*  m_pData;
+        size_t m_ulBytes;
+        char   m_cFill;
+    };
+
+    size_t Rounded(size_t ulBytes)
+    {
+        return (ulBytes + 15) & ~size_t(15);
+    }
+
+    // 块内容仍是分配时写入的字节，说明块之间没有重叠
+    size_t CountCorrupt(const std::vector<Block>& vecBlocks)
+    {
+        size_t ulCorrupt = 0;
+        for (const Block& stBlock : vecBlocks)
+        {
+            for (size_t i = 0; i < stBlock.m_ulBytes; ++i)
+            {
+                if (stBlock.m_pData[i] != stBlock.m_cFill)
+                {
+                    ++ulCorrupt;
+                    break;
+                }
+            }
+        }
+        return ulCorrupt;
+    }
+}
+
+TEST_CASE(NumaArena_ParseCpuList)
+{
+    CHECK(ParseCpuList("0-3,8-11") == std::vector<int>({ 0, 1, 2, 3, 8, 9, 10, 11 }));
+    CHECK(ParseCpuList("5") == std::vector<int>({ 5 }));
+    CHECK(ParseCpuList("0,2-3,7") == std::vector<int>({ 0, 2, 3, 7 }));
+    CHECK(ParseCpuList("").empty());
+    CHECK(!GetNumaNodes().empty());
+}
+
+// 单节点内存池：分配按 16 字节对齐并归入大小档，块放不下时映射新块且从新块开头切分，
+// 释放的块只被同档的分配复用(后进先出)，超过最大档的分配不占用内存池；使用量随分配和释放增减
+TEST_CASE(NumaArena_SizeClassesAndChunkRollover)
+{
+    const size_t ulChunk = 16 * 1024;
+    NumaArena stArena(GetNumaNodes()[0], ulChunk);
+    std::mt19937_64 stRng(29);
+    std::vector<Block> vecBlocks;
+    size_t ulMapped = 0;
+    size_t ulInUse = 0;
+    size_t ulExpectInUse = 0;
+    size_t ulRollovers = 0;
+    for (int i = 0; i < 400; ++i)
+    {
+        size_t ulBytes = i % 50 == 0 ? 4096 : 1 + stRng() % 700;
+        size_t ulBefore = 0;
+        stArena.GetUsage(ulBefore, ulInUse);
+        char* pData = static_cast<char*>(stArena.Allocate(ulBytes));
+        CHECK(reinterpret_cast<uintptr_t>(pData) % 16 == 0);
+        stArena.GetUsage(ulMapped, ulInUse);
+        if (ulMapped != ulBefore)
+        {
+            // 新块由 mmap 映射，按页对齐，块内第一次切分落在开头
+            CHECK(ulMapped == ulBefore + ulChunk);
+            CHECK(reinterpret_cast<uintptr_t>(pData) % 4096 == 0);
+            ++ulRollovers;
+        }
+        char cFill = static_cast<char>('a' + i % 26);
+        memset(pData, cFill, ulBytes);
+        vecBlocks.push_back(Block{ pData, ulBytes, cFill });
+        ulExpectInUse += Rounded(ulBytes);
+        CHECK(ulInUse == ulExpectInUse);
+    }
+    CHECK(ulRollovers > 5);
+    CHECK(CountCorrupt(vecBlocks) == 0);
+
+    // 释放一批块后，同档的分配按后进先出复用它们，不映射新块
+    std::vector<Block> vecFreed;
+    for (size_t i = 0; i < vecBlocks.size(); i += 3)
+    {
+        vecFreed.push_back(vecBlocks[i]);
+        stArena.Deallocate(vecBlocks[i].m_pData, vecBlocks[i].m_ulBytes);
+        ulExpectInUse -= Rounded(vecBlocks[i].m_ulBytes);
+    }
+    std::vector<Block> vecKept;
+    for (size_t i = 0; i < vecBlocks.size(); ++i)
+    {
+        if (i % 3 != 0)
+        {
+            vecKept.push_back(vecBlocks[i]);
+        }
+    }
+    size_t ulMappedBefore = 0;
+    stArena.GetUsage(ulMappedBefore, ulInUse);
+    CHECK(ulInUse == ulExpectInUse);
+    for (auto it = vecFreed.rbegin(); it != vecFreed.rend(); ++it)
+    {
+        // 请求同档中不同的字节数；各档的空闲链表后进先出，按释放的逆序分配时每次取回的正是当时释放的块
+        size_t ulBytes = Rounded(it->m_ulBytes) - (stRng() % 16);
+        char* pData = static_cast<char*>(stArena.Allocate(ulBytes));
+        CHECK(pData == it->m_pData);
+        memset(pData, 'Z', ulBytes);
+        vecKept.push_back(Block{ pData, ulBytes, 'Z' });
+        ulExpectInUse += Rounded(ulBytes);
+    }
+    stArena.GetUsage(ulMapped, ulInUse);
+    CHECK(ulMapped == ulMappedBefore && ulInUse == ulExpectInUse);
+    CHECK(CountCorrupt(vecKept) == 0);
+
+    // 不同档不互相复用
+    char* pSmall = static_cast<char*>(stArena.Allocate(32));
+    stArena.Deallocate(pSmall, 32);
+    char* pOther = static_cast<char*>(stArena.Allocate(48));
+    CHECK(pOther != pSmall);
+    CHECK(static_cast<char*>(stArena.Allocate(20)) == pSmall);
+
+    // 超过最大档直接向系统申请
+    stArena.GetUsage(ulMappedBefore, ulExpectInUse);
+    void* pLarge = stArena.Allocate(64 * 1024);
+    stArena.GetUsage(ulMapped, ulInUse);
+    CHECK(ulMapped == ulMappedBefore && ulInUse == ulExpectInUse);
+    stArena.Deallocate(pLarge, 64 * 1024);
+}
+
+// 跳表节点从内存池分配：插入删除后内容与顺序正确，删除的节点回到空闲链表被后续插入复用
+TEST_CASE(NumaArena_SkipListNodes)
+{
+    NumaArena stArena(GetNumaNodes()[0], 64 * 1024);
+    {
+        SkipList<uint64_t, uint64_t, SingleThreadAccess> stList;
+        CHECK(stList.SetArena(&stArena));
+        for (uint64_t i = 0; i < 5000; ++i)
+        {
+            stList.Insert(i * 7 % 5003, i);
+        }
+        size_t ulMapped = 0;
+        size_t ulInUse = 0;
+        stArena.GetUsage(ulMapped, ulInUse);
+        CHECK(ulInUse > 0 && ulMapped >= ulInUse);
+        for (uint64_t i = 0; i < 5000; i += 2)
+        {
+            stList.Remove(i * 7 % 5003);
+        }
+        stList.ReclaimRetired();
+        size_t ulMappedAfterRemove = 0;
+        size_t ulInUseAfterRemove = 0;
+        stArena.GetUsage(ulMappedAfterRemove, ulInUseAfterRemove);
+        CHECK(ulInUseAfterRemove < ulInUse);
+        for (uint64_t i = 0; i < 5000; i += 2)
+        {
+            stList.Insert(i * 7 % 5003, i);
+        }
+        size_t ulMappedAgain = 0;
+        stArena.GetUsage(ulMappedAgain, ulInUse);
+        // 重新插入同样多的节点，层高随机，复用之外最多再映射少量块
+        CHECK(ulMappedAgain <= ulMappedAfterRemove + 64 * 1024);
+        CHECK(stList.Size() == 5000);
+        uint64_t ulPrev = 0;
+        size_t ulCount = 0;
+        bool bOrdered = true;
+        stList.ForEach([&](const uint64_t& ulKey, const uint64_t&)
+        {
+            bOrdered = bOrdered && (ulCount == 0 || ulKey > ulPrev);
+            ulPrev = ulKey;
+            ++ulCount;
+            return true;
+        });
+        CHECK(bOrdered && ulCount == 5000);
+    }
+    // 跳表析构后节点全部归还
+    size_t ulMapped = 0;
+    size_t ulInUse = 0;
+    stArena.GetUsage(ulMapped, ulInUse);
+    CHECK(ulInUse == 0);
+}
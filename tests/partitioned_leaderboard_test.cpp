@@ -0,0 +1,266 @@
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "partitioned_leaderboard.h"
+#include "test_util.h"
+
+// 排名、区间和计数与普通排行榜逐项比较；调用方保证分数互不相同，排名不受同分次序影响
+template<typename Board>
+static void CheckAgainst(Board& stBoard, Leaderboard& stExpect)
+{
+    CHECK(stBoard.Size() == stExpect.Size());
+    std::vector<RankEntry> vecExpect;
+    std::vector<RankEntry> vecActual;
+    stExpect.GetRange(0, -1, true, vecExpect);
+    stBoard.GetRange(0, -1, true, vecActual);
+    CHECK(vecActual.size() == vecExpect.size());
+    for (size_t i = 0; i < vecActual.size() && i < vecExpect.size(); ++i)
+    {
+        CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+        CHECK(vecActual[i].m_dScore == vecExpect[i].m_dScore);
+        size_t ulRank = 0;
+        CHECK(stBoard.GetRank(vecExpect[i].m_strMember, true, ulRank) && ulRank == i);
+    }
+    int64_t llSize = static_cast<int64_t>(vecExpect.size());
+    for (int64_t llStart = -llSize - 3; llStart < llSize + 3; llStart += 7)
+    {
+        stExpect.GetRange(llStart, llStart + 11, false, vecExpect);
+        stBoard.GetRange(llStart, llStart + 11, false, vecActual);
+        CHECK(vecActual.size() == vecExpect.size());
+        for (size_t i = 0; i < vecActual.size() && i < vecExpect.size(); ++i)
+        {
+            CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+        }
+    }
+    for (double dLow = -50; dLow < 1200; dLow += 97)
+    {
+        ScoreBound stMin{ dLow, false };
+        ScoreBound stMax{ dLow + 300, true };
+        CHECK(stBoard.Count(stMin, stMax) == stExpect.Count(stMin, stMax));
+    }
+
+    // 分区目录的成员数之和等于总数，各分区成员都在自己的区间内
+    size_t ulTotal = 0;
+    for (const PartitionInfo& stInfo : stBoard.GetDirectory())
+    {
+        ulTotal += stInfo.m_ulCount;
+        ScoreBound stMin{ stInfo.m_dLow, false };
+        ScoreBound stMax{ stInfo.m_dHigh, true };
+        CHECK(stExpect.Count(stMin, stMax) == stInfo.m_ulCount);
+    }
+    CHECK(ulTotal == stBoard.Size());
+}
+
+// 单线程随机写入并穿插拆分，结果与普通排行榜一致
+TEST_CASE(Partitioned_MatchesLeaderboard)
+{
+    LocalPartitionedLeaderboard stBoard({ 250, 500, 750 });
+    Leaderboard stExpect;
+    std::mt19937_64 stRng(7);
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string strMember = "m" + std::to_string(stRng() % 600);
+        uint64_t ulOp = stRng() % 10;
+        if (ulOp < 6)
+        {
+            // 分数带成员相关的小数部分，保证互不相同
+            double dScore = static_cast<double>(stRng() % 1000) + std::stod(strMember.substr(1)) / 1000.0;
+            CHECK(stBoard.Add(strMember, dScore) == stExpect.Add(strMember, dScore));
+        }
+        else if (ulOp < 8)
+        {
+            double dNew = 0;
+            double dExpect = 0;
+            if (stExpect.GetScore(strMember, dExpect))
+            {
+                CHECK(stBoard.IncrBy(strMember, 3, dNew) && stExpect.IncrBy(strMember, 3, dExpect) && dNew == dExpect);
+            }
+        }
+        else
+        {
+            CHECK(stBoard.Remove(strMember) == stExpect.Remove(strMember));
+        }
+        if (i % 4000 == 3999)
+        {
+            stBoard.SplitHottest(2);
+        }
+    }
+    CHECK(stBoard.GetDirectory().size() > 4);
+    CheckAgainst(stBoard, stExpect);
+}
+
+// NaN 与正负无穷一律拒绝，不影响已有成员
+TEST_CASE(Partitioned_RejectsNonFinite)
+{
+    const double dInf = std::numeric_limits<double>::infinity();
+    PartitionedLeaderboard stBoard({ 0 });
+    double dNew = 0;
+    CHECK(stBoard.Add("a", std::nan("")) == EAddResult::Unchanged);
+    CHECK(stBoard.Add("a", dInf) == EAddResult::Unchanged);
+    CHECK(stBoard.Add("a", -dInf) == EAddResult::Unchanged);
+    CHECK(!stBoard.IncrBy("a", std::nan(""), dNew));
+    CHECK(!stBoard.IncrBy("a", dInf, dNew));
+    CHECK(stBoard.Size() == 0);
+    CHECK(stBoard.Add("b", std::numeric_limits<double>::max()) == EAddResult::Added);
+    CHECK(!stBoard.IncrBy("b", std::numeric_limits<double>::max(), dNew));
+    double dScore = 0;
+    CHECK(stBoard.GetScore("b", dScore) && dScore == std::numeric_limits<double>::max());
+    CHECK(stBoard.Size() == 1);
+}
+
+// 并发写入期间反复拆分：各写线程独占一批成员，结束后与按相同操作写入的普通排行榜一致
+TEST_CASE(Partitioned_SplitUnderConcurrentWrites)
+{
+    const int iWriters = 3;
+    const int iMembers = 3000;
+    PartitionedLeaderboard stBoard({ 1e6 });
+    for (int i = 0; i < iMembers * iWriters; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), i);
+    }
+    std::atomic<bool> bDone(false);
+    std::vector<std::vector<std::pair<std::string, double>>> vecFinal(iWriters);
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < iWriters; ++t)
+    {
+        vecThreads.emplace_back([&, t]()
+        {
+            std::mt19937_64 stRng(t);
+            std::vector<double> vecScores(iMembers);
+            for (int i = 0; i < iMembers; ++i)
+            {
+                vecScores[i] = i * iWriters + t;
+            }
+            for (int iStep = 0; iStep < 60000; ++iStep)
+            {
+                // 只改写前一半成员，后一半在拆分期间保持不变，复制时漏掉它们就会被检查出来
+                int i = static_cast<int>(stRng() % (iMembers / 2));
+                std::string strMember = "m" + std::to_string(i * iWriters + t);
+                if (stRng() % 8 == 0)
+                {
+                    stBoard.Remove(strMember);
+                    vecScores[i] = std::nan("");
+                }
+                else
+                {
+                    // 新分数仍按成员编号错开，全局互不相同
+                    double dScore = static_cast<double>((stRng() % 1000) * iMembers * iWriters + i * iWriters + t);
+                    stBoard.Add(strMember, dScore);
+                    vecScores[i] = dScore;
+                }
+            }
+            for (int i = 0; i < iMembers; ++i)
+            {
+                if (!std::isnan(vecScores[i]))
+                {
+                    vecFinal[t].emplace_back("m" + std::to_string(i * iWriters + t), vecScores[i]);
+                }
+            }
+        });
+    }
+    std::thread stSplitter([&]()
+    {
+        while (!bDone.load())
+        {
+            stBoard.SplitHottest(64);
+        }
+    });
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    bDone.store(true);
+    stSplitter.join();
+
+    Leaderboard stExpect;
+    for (const auto& vecMembers : vecFinal)
+    {
+        for (const auto& stPair : vecMembers)
+        {
+            stExpect.Add(stPair.first, stPair.second);
+        }
+    }
+    CHECK(stBoard.GetDirectory().size() > 2);
+    CheckAgainst(stBoard, stExpect);
+}
+
+// 拆分选出写入最多的分区，按中位数一分为二，并清零写入计数
+TEST_CASE(Partitioned_SplitHottestPicksBusiest)
+{
+    LocalPartitionedLeaderboard stBoard({ 100, 200 });
+    for (int i = 0; i < 300; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), i);
+    }
+    for (int i = 0; i < 50; ++i)
+    {
+        stBoard.Add("m" + std::to_string(150 + i), 150 + i + 0.5);
+    }
+    CHECK(stBoard.SplitHottest(2));
+    std::vector<PartitionInfo> vecDirectory = stBoard.GetDirectory();
+    CHECK(vecDirectory.size() == 4);
+    CHECK(vecDirectory[1].m_dLow == 100 && vecDirectory[2].m_dLow == 150.5 && vecDirectory[3].m_dLow == 200);
+    CHECK(vecDirectory[1].m_ulCount == 50 && vecDirectory[2].m_ulCount == 50);
+    for (const PartitionInfo& stInfo : vecDirectory)
+    {
+        CHECK(stInfo.m_ulWrites == 0);
+    }
+    // 没有新的写入时没有热点分区
+    CHECK(!stBoard.SplitHottest(2));
+
+    // 所有成员同分时无法拆开
+    LocalPartitionedLeaderboard stFlat({});
+    for (int i = 0; i < 10; ++i)
+    {
+        stFlat.Add("m" + std::to_string(i), 5);
+    }
+    CHECK(!stFlat.SplitPartition(0));
+    CHECK(stFlat.GetDirectory().size() == 1);
+}
+
+// 拆分期间并发读取：成员分数不变，排名和区间始终与拆分前一致
+TEST_CASE(Partitioned_ReadsDuringSplit)
+{
+    PartitionedLeaderboard stBoard({});
+    Leaderboard stExpect;
+    for (int i = 0; i < 20000; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), i);
+        stExpect.Add("m" + std::to_string(i), i);
+    }
+    std::atomic<bool> bDone(false);
+    std::atomic<size_t> ulMismatches(0);
+    std::thread stReader([&]()
+    {
+        std::mt19937_64 stRng(3);
+        std::vector<RankEntry> vecEntries;
+        while (!bDone.load())
+        {
+            int i = static_cast<int>(stRng() % 20000);
+            size_t ulRank = 0;
+            if (!stBoard.GetRank("m" + std::to_string(i), true, ulRank) || ulRank != static_cast<size_t>(19999 - i))
+            {
+                ulMismatches.fetch_add(1);
+            }
+            stBoard.GetRange(i, i + 4, true, vecEntries);
+            if (vecEntries.empty() || vecEntries[0].m_dScore != 19999 - i)
+            {
+                ulMismatches.fetch_add(1);
+            }
+        }
+    });
+    for (int iRound = 0; iRound < 6; ++iRound)
+    {
+        stBoard.SplitPartition(stBoard.GetDirectory().size() - 1);
+    }
+    bDone.store(true);
+    stReader.join();
+    CHECK(ulMismatches.load() == 0);
+    CHECK(stBoard.GetDirectory().size() == 7);
+    CheckAgainst(stBoard, stExpect);
+}
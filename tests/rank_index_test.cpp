@@ -0,0 +1,69 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "leaderboard.h"
+#include "test_util.h"
+
+// 紧凑数组转为跳表前后，排名和区间与转换无关
+TEST_CASE(RankIndex_PromoteKeepsOrder)
+{
+    RankIndex<SingleThreadAccess> stIndex;
+    for (uint64_t i = 0; i < 300; ++i)
+    {
+        stIndex.Insert(RankKey{ static_cast<double>(i % 50), i }, i);
+        CHECK(stIndex.Size() == i + 1);
+        CHECK(stIndex.IsPromoted() == (i + 1 > RankIndex<SingleThreadAccess>::COMPACT_MAX));
+    }
+    for (uint64_t i = 0; i < 300; ++i)
+    {
+        // 分数降序、同分按编号升序：分数更高的有 (49 - 分数) * 6 个，同分中编号更小的有 i / 50 个
+        size_t ulExpect = (49 - i % 50) * 6 + i / 50;
+        CHECK(stIndex.GetRank(RankKey{ static_cast<double>(i % 50), i }) == ulExpect);
+    }
+}
+
+// 写线程让大量小排行榜越过紧凑上限，读线程同时不加锁读取成员数：不出现数据竞争，成员数不回退
+TEST_CASE(RankIndex_SizeDuringPromote)
+{
+    const size_t ulBoards = 200;
+    const size_t ulMembers = RankIndex<ConcurrentAccess>::COMPACT_MAX + 8;
+    std::vector<std::unique_ptr<Leaderboard>> vecBoards;
+    for (size_t i = 0; i < ulBoards; ++i)
+    {
+        vecBoards.push_back(std::make_unique<Leaderboard>());
+    }
+    std::atomic<bool> bDone(false);
+    std::atomic<size_t> ulRegressions(0);
+    std::thread stReader([&]()
+    {
+        std::vector<size_t> vecLast(ulBoards, 0);
+        while (!bDone.load())
+        {
+            for (size_t i = 0; i < ulBoards; ++i)
+            {
+                size_t ulSize = vecBoards[i]->Size();
+                if (ulSize < vecLast[i] || ulSize > ulMembers)
+                {
+                    ulRegressions.fetch_add(1);
+                }
+                vecLast[i] = ulSize;
+            }
+        }
+    });
+    for (size_t j = 0; j < ulMembers; ++j)
+    {
+        for (size_t i = 0; i < ulBoards; ++i)
+        {
+            vecBoards[i]->Add("m" + std::to_string(j), static_cast<double>(j));
+        }
+    }
+    bDone.store(true);
+    stReader.join();
+    CHECK(ulRegressions.load() == 0);
+    for (const auto& pBoard : vecBoards)
+    {
+        CHECK(pBoard->Size() == ulMembers);
+    }
+}
@@ -0,0 +1,211 @@
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "ranking_service.h"
+#include "test_util.h"
+
+static std::vector<std::string_view> Args(const std::vector<std::string>& vecStrings)
+{
+    return std::vector<std::string_view>(vecStrings.begin(), vecStrings.end());
+}
+
+static std::string Run(RankingService& stService, const std::vector<std::string>& vecCommand)
+{
+    std::string strOut;
+    stService.Execute(Args(vecCommand), strOut);
+    return strOut;
+}
+
+static void FillBoard(RankingService& stService, int iMembers)
+{
+    for (int i = 0; i < iMembers; ++i)
+    {
+        Run(stService, { "ZADD", "b", std::to_string(i * 3), "m" + std::to_string(i) });
+    }
+}
+
+// 不同 (start, stop, WITHSCORES) 的小区间各自缓存，回复与不走缓存的负下标查询一致
+TEST_CASE(Service_TopCacheKeyedOnRange)
+{
+    RankingService stService;
+    FillBoard(stService, 200);
+    const std::vector<std::vector<std::string>> vecCases = {
+        { "ZREVRANGE", "b", "0", "9" },
+        { "ZREVRANGE", "b", "0", "9", "WITHSCORES" },
+        { "ZREVRANGE", "b", "5", "20" },
+        { "ZREVRANGE", "b", "0", "99" },
+    };
+    for (const auto& vecCommand : vecCases)
+    {
+        std::vector<std::string> vecUncached = vecCommand;
+        vecUncached[2] = std::to_string(std::stoll(vecCommand[2]) - 200);
+        vecUncached[3] = std::to_string(std::stoll(vecCommand[3]) - 200);
+
+        ReplyBuffer stReplies;
+        stService.Execute(Args(vecCommand), stReplies);
+        stService.Execute(Args(vecCommand), stReplies);
+        CHECK(stReplies.m_vecSlots.size() == 2);
+        CHECK(stReplies.m_vecSlots[0].m_iShared >= 0);
+        // 同一版本内两次命中引用同一份缓存，不复制
+        CHECK(stReplies.GetReply(0).data() == stReplies.GetReply(1).data());
+        CHECK(stReplies.GetReply(0) == Run(stService, vecUncached));
+        CHECK(Run(stService, vecCommand) == Run(stService, vecUncached));
+    }
+
+    // 超出缓存范围或负下标不走缓存
+    ReplyBuffer stReplies;
+    stService.Execute(Args({ "ZREVRANGE", "b", "0", "100" }), stReplies);
+    stService.Execute(Args({ "ZREVRANGE", "b", "-10", "-1" }), stReplies);
+    CHECK(stReplies.m_vecSlots[0].m_iShared < 0);
+    CHECK(stReplies.m_vecSlots[1].m_iShared < 0);
+}
+
+// 写入改变榜首区间后缓存作废，批量执行的回复同样引用缓存
+TEST_CASE(Service_TopCacheInvalidatedByWrites)
+{
+    RankingService stService;
+    FillBoard(stService, 50);
+    std::string strBefore = Run(stService, { "ZREVRANGE", "b", "0", "4", "WITHSCORES" });
+    Run(stService, { "ZADD", "b", "1000", "top" });
+    std::string strAfter = Run(stService, { "ZREVRANGE", "b", "0", "4", "WITHSCORES" });
+    CHECK(strBefore != strAfter);
+    CHECK(strAfter == Run(stService, { "ZREVRANGE", "b", "-51", "-47", "WITHSCORES" }));
+
+    std::string strInput = "*4\r\n$9\r\nZREVRANGE\r\n$1\r\nb\r\n$1\r\n0\r\n$1\r\n4\r\n"
+        "*4\r\n$4\r\nZADD\r\n$1\r\nb\r\n$4\r\n2000\r\n$3\r\nnew\r\n"
+        "*4\r\n$9\r\nZREVRANGE\r\n$1\r\nb\r\n$1\r\n0\r\n$1\r\n4\r\n";
+    CommandBatch stBatch;
+    size_t ulConsumed = 0;
+    CHECK(ParseCommandBatch(strInput.data(), strInput.size(), stBatch, ulConsumed) == ERespParse::Ok);
+    CHECK(stBatch.m_ulCount == 3);
+    ReplyBuffer stReplies;
+    stService.ExecuteBatch(stBatch, stReplies);
+    CHECK(stReplies.m_vecSlots[0].m_iShared >= 0);
+    CHECK(stReplies.m_vecSlots[2].m_iShared >= 0);
+    CHECK(stReplies.GetReply(0) != stReplies.GetReply(2));
+    CHECK(stReplies.GetReply(2) == Run(stService, { "ZREVRANGE", "b", "-52", "-48" }));
+}
+
+// 转为冷榜：文件落盘后才释放排行榜，不留下临时文件，访问时装回的内容不变
+TEST_CASE(Service_ColdEvictDurable)
+{
+    std::string strDir = (std::filesystem::temp_directory_path() / ("gameranking-cold-" + std::to_string(getpid()))).string();
+    std::filesystem::remove_all(strDir);
+    RankingService stService;
+    CHECK(stService.SetColdTier(strDir, 0));
+    FillBoard(stService, 300);
+    std::string strBefore = Run(stService, { "ZREVRANGE", "b", "0", "-1", "WITHSCORES" });
+    CHECK(stService.EvictIdleBoards() == 1);
+    CHECK(stService.GetColdBoardCount() == 1);
+    size_t ulFiles = 0;
+    for (const auto& stFile : std::filesystem::directory_iterator(strDir))
+    {
+        CHECK(stFile.path().extension() != ".tmp");
+        ++ulFiles;
+    }
+    CHECK(ulFiles == 1);
+    CHECK(Run(stService, { "ZREVRANGE", "b", "0", "-1", "WITHSCORES" }) == strBefore);
+    std::filesystem::remove_all(strDir);
+}
+
+// 冷榜文件写不出去时排行榜留在内存，数据不丢
+TEST_CASE(Service_ColdEvictFailureKeepsBoard)
+{
+    std::string strDir = (std::filesystem::temp_directory_path() / ("gameranking-cold-fail-" + std::to_string(getpid()))).string();
+    RankingService stService;
+    CHECK(stService.SetColdTier(strDir, 0));
+    FillBoard(stService, 50);
+    std::string strBefore = Run(stService, { "ZRANGE", "b", "0", "-1", "WITHSCORES" });
+    std::filesystem::remove_all(strDir);
+    CHECK(stService.EvictIdleBoards() == 0);
+    CHECK(stService.GetColdBoardCount() == 0);
+    CHECK(Run(stService, { "ZRANGE", "b", "0", "-1", "WITHSCORES" }) == strBefore);
+}
+
+// ZCAPACITY 读取和设置容量：设置后只保留前 N 名，低于准入分数的新成员 ZADD、ZINCRBY 都不进榜
+TEST_CASE(Service_CapacityCommand)
+{
+    RankingService stService;
+    CHECK(Run(stService, { "ZCAPACITY", "b" }) == ":0\r\n");
+    FillBoard(stService, 50);
+    CHECK(Run(stService, { "ZCAPACITY", "b", "10" }) == "+OK\r\n");
+    CHECK(Run(stService, { "ZCAPACITY", "b" }) == ":10\r\n");
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":10\r\n");
+    CHECK(Run(stService, { "ZREVRANGE", "b", "-1", "-1" }) == "*1\r\n$3\r\nm40\r\n");
+    CHECK(Run(stService, { "ZINCRBY", "b", "5", "low" }) == "$1\r\n5\r\n");
+    CHECK(Run(stService, { "ZADD", "b", "6", "low2" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZSCORE", "b", "low" }) == "$-1\r\n");
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":10\r\n");
+    // 高于准入分数的新成员挤掉最后一名
+    Run(stService, { "ZINCRBY", "b", "500", "high" });
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":10\r\n");
+    CHECK(Run(stService, { "ZSCORE", "b", "m40" }) == "$-1\r\n");
+
+    CHECK(Run(stService, { "ZCAPACITY", "b", "-1" }).rfind("-ERR", 0) == 0);
+    CHECK(Run(stService, { "ZCAPACITY", "b", "1", "2" }).rfind("-ERR", 0) == 0);
+    CHECK(Run(stService, { "ZCAPACITY", "b", "0" }) == "+OK\r\n");
+    CHECK(Run(stService, { "ZINCRBY", "b", "5", "low" }) == "$1\r\n5\r\n");
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":11\r\n");
+    // 对不存在的排行榜取消容量不建榜
+    CHECK(Run(stService, { "ZCAPACITY", "none", "0" }) == "+OK\r\n");
+    CHECK(Run(stService, { "ZCAPACITY", "none" }) == ":0\r\n");
+}
+
+// 容量随冷榜文件保存，装回后仍然生效；设置了容量的空榜不会在转冷时丢掉设置
+TEST_CASE(Service_ColdEvictKeepsCapacity)
+{
+    std::string strDir = (std::filesystem::temp_directory_path() / ("gameranking-cold-cap-" + std::to_string(getpid()))).string();
+    std::filesystem::remove_all(strDir);
+    RankingService stService;
+    CHECK(stService.SetColdTier(strDir, 0));
+    Run(stService, { "ZCAPACITY", "b", "5" });
+    Run(stService, { "ZCAPACITY", "empty", "3" });
+    FillBoard(stService, 20);
+    std::string strBefore = Run(stService, { "ZREVRANGE", "b", "0", "-1", "WITHSCORES" });
+    CHECK(stService.EvictIdleBoards() == 2);
+    CHECK(stService.GetColdBoardCount() == 2);
+    CHECK(Run(stService, { "ZCAPACITY", "b" }) == ":5\r\n");
+    CHECK(Run(stService, { "ZCAPACITY", "empty" }) == ":3\r\n");
+    CHECK(Run(stService, { "ZREVRANGE", "b", "0", "-1", "WITHSCORES" }) == strBefore);
+    CHECK(Run(stService, { "ZADD", "b", "1", "low" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZINCRBY", "b", "1", "low" }) == "$1\r\n1\r\n");
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":5\r\n");
+    std::filesystem::remove_all(strDir);
+}
+
+// ZREMRANGEBYSCORE 支持开区间和 ±inf，ZREMRANGEBYRANK 支持负数下标；返回删除个数，不存在的榜返回0，参数错误返回错误
+TEST_CASE(Service_RemoveRangeCommands)
+{
+    RankingService stService;
+    FillBoard(stService, 20);
+    CHECK(Run(stService, { "ZREMRANGEBYSCORE", "b", "(0", "9" }) == ":3\r\n");
+    CHECK(Run(stService, { "ZSCORE", "b", "m0" }) == "$1\r\n0\r\n");
+    CHECK(Run(stService, { "ZSCORE", "b", "m3" }) == "$-1\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYSCORE", "b", "54", "+inf" }) == ":2\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYSCORE", "b", "(51", "(54" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZCARD", "b" }) == ":15\r\n");
+    // 升序排名：删除最低的两名和最高的一名，剩下 m5~m16
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "0", "1" }) == ":2\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "-1", "-1" }) == ":1\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "5", "2" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "100", "200" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZRANGE", "b", "0", "0" }) == "*1\r\n$2\r\nm5\r\n");
+    CHECK(Run(stService, { "ZREVRANGE", "b", "0", "0" }) == "*1\r\n$3\r\nm16\r\n");
+    CHECK(Run(stService, { "ZRANK", "b", "m16" }) == ":11\r\n");
+    // 只保留前 3 名
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "0", "-4" }) == ":9\r\n");
+    CHECK(Run(stService, { "ZRANGE", "b", "0", "-1" }) == "*3\r\n$3\r\nm14\r\n$3\r\nm15\r\n$3\r\nm16\r\n");
+    // 偏移缩放后按对外的分数删除
+    CHECK(Run(stService, { "ZTRANSFORM", "b", "2", "1" }) == "+OK\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYSCORE", "b", "(85", "(97" }) == ":1\r\n");
+    CHECK(Run(stService, { "ZRANGE", "b", "0", "-1", "WITHSCORES" }) == "*4\r\n$3\r\nm14\r\n$2\r\n85\r\n$3\r\nm16\r\n$2\r\n97\r\n");
+
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "none", "0", "-1" }) == ":0\r\n");
+    CHECK(Run(stService, { "ZTRANSFORM", "none", "2", "1" }) == "-ERR no such key\r\n");
+    CHECK(Run(stService, { "ZREMRANGEBYSCORE", "b", "x", "1" }).rfind("-ERR", 0) == 0);
+    CHECK(Run(stService, { "ZREMRANGEBYRANK", "b", "0", "1.5" }).rfind("-ERR", 0) == 0);
+}
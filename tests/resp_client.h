@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ranking_service.h"
+
+// 服务器测试用的阻塞 RESP 客户端：经回环地址连接，发送编码好的命令，按字节数读回回复
+
+// 取一个当前空闲的端口，关闭后交给服务器绑定
+inline uint16_t PickFreePort()
+{
+    int iFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sin_family = AF_INET;
+    stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t uiLen = sizeof(stAddr);
+    uint16_t usPort = 0;
+    if (iFd >= 0 && bind(iFd, reinterpret_cast<sockaddr*>(&stAddr), sizeof(stAddr)) == 0 &&
+        getsockname(iFd, reinterpret_cast<sockaddr*>(&stAddr), &uiLen) == 0)
+    {
+        usPort = ntohs(stAddr.sin_port);
+    }
+    if (iFd >= 0)
+    {
+        close(iFd);
+    }
+    return usPort;
+}
+
+// 连接本机端口，读超时 10 秒，失败返回-1
+inline int ConnectLoopback(uint16_t usPort)
+{
+    int iFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (iFd < 0)
+    {
+        return -1;
+    }
+    timeval stTimeout = { 10, 0 };
+    setsockopt(iFd, SOL_SOCKET, SO_RCVTIMEO, &stTimeout, sizeof(stTimeout));
+    sockaddr_in stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sin_family = AF_INET;
+    stAddr.sin_port = htons(usPort);
+    stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(iFd, reinterpret_cast<sockaddr*>(&stAddr), sizeof(stAddr)) != 0)
+    {
+        close(iFd);
+        return -1;
+    }
+    return iFd;
+}
+
+inline bool SendAll(int iFd, const std::string& strData)
+{
+    size_t ulSent = 0;
+    while (ulSent < strData.size())
+    {
+        ssize_t lWritten = write(iFd, strData.data() + ulSent, strData.size() - ulSent);
+        if (lWritten <= 0)
+        {
+            return false;
+        }
+        ulSent += static_cast<size_t>(lWritten);
+    }
+    return true;
+}
+
+// 读满 ulSize 字节，连接关闭或超时时返回已读到的部分
+inline std::string ReadBytes(int iFd, size_t ulSize)
+{
+    std::string strData(ulSize, '\0');
+    size_t ulRead = 0;
+    while (ulRead < ulSize)
+    {
+        ssize_t lRead = read(iFd, &strData[ulRead], ulSize - ulRead);
+        if (lRead <= 0)
+        {
+            break;
+        }
+        ulRead += static_cast<size_t>(lRead);
+    }
+    strData.resize(ulRead);
+    return strData;
+}
+
+inline std::string EncodeCommand(const std::vector<std::string>& vecArgs)
+{
+    std::string strOut = "*" + std::to_string(vecArgs.size()) + "\r\n";
+    for (const std::string& strArg : vecArgs)
+    {
+        strOut += "$" + std::to_string(strArg.size()) + "\r\n" + strArg + "\r\n";
+    }
+    return strOut;
+}
+
+// 在 stService 上逐条执行命令，得到按命令顺序拼接的回复，作为服务器回复的对照
+inline std::string ExecuteInOrder(RankingService& stService, const std::vector<std::vector<std::string>>& vecCommands)
+{
+    std::string strOut;
+    for (const auto& vecCommand : vecCommands)
+    {
+        stService.Execute(std::vector<std::string_view>(vecCommand.begin(), vecCommand.end()), strOut);
+    }
+    return strOut;
+}
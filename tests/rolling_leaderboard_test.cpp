@@ -0,0 +1,183 @@
+#include <atomic>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rolling_leaderboard.h"
+#include "test_util.h"
+
+// 按得分记录逐条求和的参照实现：成员分数为最近 桶数 个时间桶内的得分之和
+struct RollingModel
+{
+    struct Event
+    {
+        int64_t m_llBucket;
+        double  m_dPoints;
+    };
+
+    int64_t m_llBuckets;
+    std::map<std::string, std::vector<Event>> m_mapEvents;
+
+    void Expire(int64_t llNow)
+    {
+        for (auto it = m_mapEvents.begin(); it != m_mapEvents.end();)
+        {
+            std::vector<Event>& vecEvents = it->second;
+            std::erase_if(vecEvents, [&](const Event& stEvent) { return stEvent.m_llBucket <= llNow - m_llBuckets; });
+            it = vecEvents.empty() ? m_mapEvents.erase(it) : std::next(it);
+        }
+    }
+
+    double Sum(const std::string& strMember) const
+    {
+        double dSum = 0;
+        for (const Event& stEvent : m_mapEvents.at(strMember))
+        {
+            dSum += stEvent.m_dPoints;
+        }
+        return dSum;
+    }
+};
+
+// 随机推进时间(含跳过整个窗口)并写入，分数、成员数、排名和计数始终与逐条求和一致
+TEST_CASE(Rolling_ExpiryMatchesModel)
+{
+    int64_t llNow = 12345;
+    RollingConfig stConfig;
+    stConfig.m_llWindowMs = 1000;
+    stConfig.m_uiBuckets = 10;
+    LocalRollingLeaderboard stBoard(stConfig, [&llNow]() { return llNow; });
+    RollingModel stModel{ 10, {} };
+    std::mt19937_64 stRng(5);
+    for (int iStep = 0; iStep < 20000; ++iStep)
+    {
+        uint64_t ulRoll = stRng() % 100;
+        if (ulRoll < 10)
+        {
+            llNow += static_cast<int64_t>(stRng() % 150);
+        }
+        else if (ulRoll == 10)
+        {
+            llNow += 900 + static_cast<int64_t>(stRng() % 400);
+        }
+        int64_t llBucket = llNow / 100;
+        stModel.Expire(llBucket);
+        std::string strMember = "m" + std::to_string(stRng() % 40);
+        if (ulRoll < 95)
+        {
+            double dPoints = static_cast<double>(stRng() % 9 + 1);
+            double dNewSum = 0;
+            CHECK(stBoard.AddPoints(strMember, dPoints, dNewSum));
+            stModel.m_mapEvents[strMember].push_back(RollingModel::Event{ llBucket, dPoints });
+            CHECK(dNewSum == stModel.Sum(strMember));
+        }
+        else
+        {
+            CHECK(stBoard.Remove(strMember) == (stModel.m_mapEvents.erase(strMember) == 1));
+        }
+
+        if (iStep % 50 == 0)
+        {
+            CHECK(stBoard.Size() == stModel.m_mapEvents.size());
+            for (const auto& stPair : stModel.m_mapEvents)
+            {
+                double dScore = 0;
+                CHECK(stBoard.GetScore(stPair.first, dScore) && dScore == stModel.Sum(stPair.first));
+            }
+            std::vector<RankEntry> vecEntries;
+            stBoard.GetRange(0, -1, true, vecEntries);
+            CHECK(vecEntries.size() == stModel.m_mapEvents.size());
+            for (size_t i = 0; i < vecEntries.size(); ++i)
+            {
+                size_t ulRank = 0;
+                CHECK(stBoard.GetRank(vecEntries[i].m_strMember, true, ulRank) && ulRank == i);
+                CHECK(i == 0 || vecEntries[i - 1].m_dScore >= vecEntries[i].m_dScore);
+            }
+            ScoreBound stMin{ 10, false };
+            ScoreBound stMax{ 40, true };
+            size_t ulExpect = 0;
+            for (const auto& stPair : stModel.m_mapEvents)
+            {
+                double dSum = stModel.Sum(stPair.first);
+                ulExpect += dSum >= 10 && dSum < 40 ? 1 : 0;
+            }
+            CHECK(stBoard.Count(stMin, stMax) == ulExpect);
+        }
+    }
+}
+
+// 窗口整体滑过后排行榜清空，到期的成员也从成员表中释放
+TEST_CASE(Rolling_FullExpiryReleasesMembers)
+{
+    int64_t llNow = 0;
+    RollingConfig stConfig;
+    stConfig.m_llWindowMs = 1000;
+    stConfig.m_uiBuckets = 4;
+    LocalRollingLeaderboard stBoard(stConfig, [&llNow]() { return llNow; });
+    for (int i = 0; i < 100; ++i)
+    {
+        stBoard.AddPoints("m" + std::to_string(i), i + 1);
+    }
+    llNow = 250;
+    stBoard.AddPoints("m0", 5);
+    double dScore = 0;
+    CHECK(stBoard.GetScore("m0", dScore) && dScore == 6);
+    // 第一个桶滑出，只剩 m0 在第二个桶的得分
+    llNow = 1000;
+    CHECK(stBoard.Size() == 1);
+    CHECK(stBoard.GetScore("m0", dScore) && dScore == 5);
+    CHECK(stBoard.GetActiveCount() == 1);
+    llNow = 1250;
+    stBoard.Expire();
+    CHECK(stBoard.Size() == 0);
+    CHECK(stBoard.GetActiveCount() == 0);
+    CHECK(!stBoard.AddPoints("m0", std::numeric_limits<double>::infinity()));
+}
+
+// 多线程写入与时间推进并发，停止后各成员的分数等于窗口内的得分之和
+TEST_CASE(Rolling_ConcurrentWrites)
+{
+    std::atomic<int64_t> llNow(0);
+    RollingConfig stConfig;
+    stConfig.m_llWindowMs = 1000;
+    stConfig.m_uiBuckets = 10;
+    RollingLeaderboard stBoard(stConfig, [&llNow]() { return llNow.load(); });
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 3; ++t)
+    {
+        vecThreads.emplace_back([&stBoard, t]()
+        {
+            for (int i = 0; i < 20000; ++i)
+            {
+                stBoard.AddPoints("t" + std::to_string(t) + "_" + std::to_string(i % 50), 1);
+            }
+        });
+    }
+    std::thread stReader([&stBoard]()
+    {
+        std::vector<RankEntry> vecEntries;
+        for (int i = 0; i < 2000; ++i)
+        {
+            stBoard.GetRange(0, 9, true, vecEntries);
+        }
+    });
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    stReader.join();
+    CHECK(stBoard.Size() == 150);
+    double dTotal = 0;
+    std::vector<RankEntry> vecEntries;
+    stBoard.GetRange(0, -1, true, vecEntries);
+    for (const RankEntry& stEntry : vecEntries)
+    {
+        dTotal += stEntry.m_dScore;
+    }
+    CHECK(dTotal == 60000);
+    llNow = 1000;
+    CHECK(stBoard.Size() == 0);
+}
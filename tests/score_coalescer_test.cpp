@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "score_coalescer.h"
+#include "test_util.h"
+
+// 同分成员按加入顺序排名，刷新顺序与直接写入不同，因此逐个成员比较分数并比较排名上的分数序列
+static void CheckSameScores(Leaderboard& stLeft, Leaderboard& stRight)
+{
+    std::vector<RankEntry> vecLeft;
+    std::vector<RankEntry> vecRight;
+    stLeft.GetRange(0, -1, true, vecLeft);
+    stRight.GetRange(0, -1, true, vecRight);
+    CHECK(vecLeft.size() == vecRight.size());
+    for (size_t i = 0; i < vecLeft.size() && i < vecRight.size(); ++i)
+    {
+        CHECK(vecLeft[i].m_dScore == vecRight[i].m_dScore);
+        double dScore = 0;
+        CHECK(stRight.GetScore(vecLeft[i].m_strMember, dScore) && dScore == vecLeft[i].m_dScore);
+    }
+}
+
+// 三种合并方式刷新后的排行榜与逐次直接写入一致
+TEST_CASE(Coalescer_ModesMatchDirectWrites)
+{
+    const ECoalesceMode arrModes[] = { ECoalesceMode::Last, ECoalesceMode::Max, ECoalesceMode::Sum };
+    for (ECoalesceMode eMode : arrModes)
+    {
+        Leaderboard stCoalesced;
+        Leaderboard stDirect;
+        CoalescerConfig stConfig;
+        stConfig.m_eMode = eMode;
+        stConfig.m_ulStripes = 4;
+        ScoreCoalescer stCoalescer(stCoalesced, stConfig);
+        for (int i = 0; i < 3000; ++i)
+        {
+            std::string strMember = "m" + std::to_string(i % 53);
+            double dValue = (i * 37) % 101;
+            CHECK(stCoalescer.Update(strMember, dValue));
+            double dNewScore = 0;
+            AddOptions stOptions;
+            switch (eMode)
+            {
+            case ECoalesceMode::Last:
+                stDirect.Add(strMember, dValue);
+                break;
+            case ECoalesceMode::Max:
+                stOptions.m_bGt = true;
+                stDirect.Add(strMember, dValue, stOptions);
+                break;
+            case ECoalesceMode::Sum:
+                stDirect.IncrBy(strMember, dValue, dNewScore);
+                break;
+            }
+        }
+        CHECK(stCoalescer.GetPending() == 53);
+        stCoalescer.Flush();
+        CHECK(stCoalescer.GetPending() == 0);
+        CheckSameScores(stCoalesced, stDirect);
+    }
+}
+
+// 累加模式拒绝非有限增量，其余模式只拒绝 NaN
+TEST_CASE(Coalescer_RejectsNonFinite)
+{
+    const double dInf = std::numeric_limits<double>::infinity();
+    Leaderboard stBoard;
+    CoalescerConfig stConfig;
+    stConfig.m_eMode = ECoalesceMode::Sum;
+    ScoreCoalescer stSum(stBoard, stConfig);
+    CHECK(!stSum.Update("a", std::nan("")));
+    CHECK(!stSum.Update("a", dInf));
+    CHECK(!stSum.Update("a", -dInf));
+    CHECK(stSum.Update("a", 5));
+    stSum.Flush();
+    double dScore = 0;
+    CHECK(stBoard.GetScore("a", dScore) && dScore == 5);
+
+    stConfig.m_eMode = ECoalesceMode::Last;
+    ScoreCoalescer stLast(stBoard, stConfig);
+    CHECK(!stLast.Update("b", std::nan("")));
+    CHECK(stLast.Update("b", dInf));
+    stLast.Flush();
+    CHECK(stBoard.GetScore("b", dScore) && dScore == dInf);
+}
+
+// Stop 之后重新 Start，后台线程仍按窗口刷新
+TEST_CASE(Coalescer_RestartAfterStop)
+{
+    Leaderboard stBoard;
+    CoalescerConfig stConfig;
+    stConfig.m_uiWindowMs = 5;
+    ScoreCoalescer stCoalescer(stBoard, stConfig);
+    stCoalescer.Start();
+    stCoalescer.Update("a", 1);
+    stCoalescer.Stop();
+    CHECK(stBoard.Size() == 1);
+
+    stCoalescer.Start();
+    stCoalescer.Update("b", 2);
+    double dScore = 0;
+    for (int i = 0; i < 400 && !stBoard.GetScore("b", dScore); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(stBoard.GetScore("b", dScore) && dScore == 2);
+    stCoalescer.Stop();
+}
+
+// 多线程并发累加，刷新后总分等于全部增量之和
+TEST_CASE(Coalescer_ConcurrentSum)
+{
+    Leaderboard stBoard;
+    CoalescerConfig stConfig;
+    stConfig.m_eMode = ECoalesceMode::Sum;
+    stConfig.m_uiWindowMs = 1;
+    stConfig.m_ulMaxPending = 8;
+    ScoreCoalescer stCoalescer(stBoard, stConfig);
+    stCoalescer.Start();
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 4; ++t)
+    {
+        vecThreads.emplace_back([&stCoalescer]()
+        {
+            for (int i = 0; i < 10000; ++i)
+            {
+                stCoalescer.Update("m" + std::to_string(i % 16), 1);
+            }
+        });
+    }
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    stCoalescer.Stop();
+    double dTotal = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        double dScore = 0;
+        CHECK(stBoard.GetScore("m" + std::to_string(i), dScore));
+        dTotal += dScore;
+    }
+    CHECK(dTotal == 40000);
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "score_ingestor.h"
+#include "test_util.h"
+
+// 经写入阶段提交的更新与直接写入排行榜的结果一致
+TEST_CASE(Ingestor_MatchesDirectWrites)
+{
+    Leaderboard stQueued;
+    Leaderboard stDirect;
+    ScoreIngestor stIngestor(2, 1024, 64);
+    stIngestor.Start();
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string strMember = "m" + std::to_string(i % 97);
+        EWriteOp eOp = (i % 3 == 0) ? EWriteOp::Add : EWriteOp::IncrBy;
+        double dValue = (i * 7) % 13;
+        while (!stIngestor.Submit(stQueued, strMember, eOp, dValue))
+        {
+            std::this_thread::yield();
+        }
+        double dNewScore = 0;
+        if (eOp == EWriteOp::Add)
+        {
+            stDirect.Add(strMember, dValue);
+        }
+        else
+        {
+            stDirect.IncrBy(strMember, dValue, dNewScore);
+        }
+    }
+    stIngestor.Stop();
+
+    CHECK(stQueued.Size() == stDirect.Size());
+    std::vector<RankEntry> vecQueued;
+    std::vector<RankEntry> vecDirect;
+    stQueued.GetRange(0, -1, true, vecQueued);
+    stDirect.GetRange(0, -1, true, vecDirect);
+    CHECK(vecQueued.size() == vecDirect.size());
+    for (size_t i = 0; i < vecQueued.size() && i < vecDirect.size(); ++i)
+    {
+        CHECK(vecQueued[i].m_strMember == vecDirect[i].m_strMember);
+        CHECK(vecQueued[i].m_dScore == vecDirect[i].m_dScore);
+    }
+}
+
+// 与 Stop 并发的提交：返回true的更新都已写入，Stop 之后的提交一律返回false
+TEST_CASE(Ingestor_SubmitRacingStop)
+{
+    for (int iRound = 0; iRound < 20; ++iRound)
+    {
+        Leaderboard stBoard;
+        ScoreIngestor stIngestor(1, 256, 32);
+        stIngestor.Start();
+        std::atomic<uint64_t> ulAccepted(0);
+        std::vector<std::thread> vecThreads;
+        for (int t = 0; t < 3; ++t)
+        {
+            vecThreads.emplace_back([&]()
+            {
+                for (int i = 0; i < 20000; ++i)
+                {
+                    if (stIngestor.Submit(stBoard, "hot", EWriteOp::IncrBy, 1))
+                    {
+                        ulAccepted.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200 * (iRound % 5)));
+        stIngestor.Stop();
+        CHECK(!stIngestor.Submit(stBoard, "late", EWriteOp::Add, 1));
+        for (auto& stThread : vecThreads)
+        {
+            stThread.join();
+        }
+
+        // Stop 返回时已接受的提交都已写入，之后的提交被拒绝，排行榜不再变化
+        double dScore = 0;
+        bool bFound = stBoard.GetScore("hot", dScore);
+        CHECK(ulAccepted.load() == 0 || bFound);
+        CHECK(static_cast<uint64_t>(dScore) == ulAccepted.load());
+        CHECK(!stBoard.GetScore("late", dScore));
+    }
+}
+
+// 停止后重新启动可以继续接收更新
+TEST_CASE(Ingestor_RestartAfterStop)
+{
+    Leaderboard stBoard;
+    ScoreIngestor stIngestor(1, 16, 4);
+    stIngestor.Start();
+    CHECK(stIngestor.Submit(stBoard, "a", EWriteOp::Add, 1));
+    stIngestor.Stop();
+    CHECK(!stIngestor.Submit(stBoard, "b", EWriteOp::Add, 2));
+    stIngestor.Start();
+    CHECK(stIngestor.Submit(stBoard, "b", EWriteOp::Add, 2));
+    stIngestor.Stop();
+    CHECK(stBoard.Size() == 2);
+}
@@ -0,0 +1,226 @@
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include "resp_client.h"
+#include "server.h"
+#include "test_util.h"
+
+namespace
+{
+    // 回环地址上运行的单线程服务器，析构时停止事件循环
+    struct LoopbackServer
+    {
+        ServerConfig      m_stConfig;
+        RankingService    m_stService;
+        RankingServer     m_stServer;
+        std::atomic<bool> m_bStop;
+        std::thread       m_stThread;
+        bool              m_bStarted;
+
+        explicit LoopbackServer(size_t ulMaxPendingOutput) : m_stConfig(MakeConfig(ulMaxPendingOutput)), m_stServer(m_stConfig, m_stService), m_bStop(false)
+        {
+            m_bStarted = m_stServer.Start();
+            if (m_bStarted)
+            {
+                m_stThread = std::thread([this]()
+                {
+                    m_stServer.Run(m_bStop);
+                });
+            }
+        }
+
+        ~LoopbackServer()
+        {
+            m_bStop = true;
+            if (m_stThread.joinable())
+            {
+                m_stThread.join();
+            }
+        }
+
+        static ServerConfig MakeConfig(size_t ulMaxPendingOutput)
+        {
+            ServerConfig stConfig;
+            stConfig.m_strBindAddr = "127.0.0.1";
+            stConfig.m_usPort = PickFreePort();
+            stConfig.m_ulMaxPendingOutput = ulMaxPendingOutput;
+            return stConfig;
+        }
+    };
+
+    // 三个排行榜交错的读写命令，夹带走榜首缓存的查询、参数错误和未知命令；
+    // 批量执行时按排行榜分组，相邻命令的回复在缓冲区中不相邻
+    std::vector<std::vector<std::string>> MixedCommands(int iRound, int iCount)
+    {
+        const char* aszBoards[] = { "alpha", "beta", "gamma" };
+        std::vector<std::vector<std::string>> vecCommands;
+        for (int i = 0; i < iCount; ++i)
+        {
+            std::string strBoard = aszBoards[(i + iRound) % 3];
+            std::string strMember = "m" + std::to_string((iRound * 5 + i) % 31);
+            switch (i % 9)
+            {
+            case 0:
+            case 5:
+                vecCommands.push_back({ "ZADD", strBoard, std::to_string((i * 7 + iRound) % 100), strMember });
+                break;
+            case 1:
+                vecCommands.push_back({ "ZINCRBY", strBoard, "2", strMember });
+                break;
+            case 2:
+                vecCommands.push_back({ "ZREVRANGE", strBoard, "0", "4", "WITHSCORES" });
+                break;
+            case 3:
+                vecCommands.push_back({ "ZRANK", strBoard, strMember });
+                break;
+            case 4:
+                vecCommands.push_back({ "PING" });
+                break;
+            case 6:
+                vecCommands.push_back({ "ZREM", strBoard, strMember });
+                break;
+            case 7:
+                vecCommands.push_back(i % 2 == 0 ? std::vector<std::string>({ "ZSCORE", strBoard }) : std::vector<std::string>({ "NOSUCH", strBoard }));
+                break;
+            default:
+                vecCommands.push_back({ "ZCARD", strBoard });
+                break;
+            }
+        }
+        return vecCommands;
+    }
+
+    std::string Encode(const std::vector<std::vector<std::string>>& vecCommands)
+    {
+        std::string strOut;
+        for (const auto& vecCommand : vecCommands)
+        {
+            strOut += EncodeCommand(vecCommand);
+        }
+        return strOut;
+    }
+}
+
+// 解析出的一批命令按排行榜分组执行，回复仍按命令顺序，与逐条执行一致
+TEST_CASE(Server_BatchMatchesSequential)
+{
+    RankingService stBatched;
+    RankingService stModel;
+    CommandBatch stBatch;
+    ReplyBuffer stReplies;
+    for (int iRound = 0; iRound < 30; ++iRound)
+    {
+        auto vecCommands = MixedCommands(iRound, 100 + iRound * 10);
+        std::string strInput = Encode(vecCommands);
+        // 末尾留半条命令，不计入本批
+        strInput += EncodeCommand({ "ZADD", "alpha", "1", "partial" }).substr(0, 9);
+        stBatch.m_ulCount = 0;
+        size_t ulConsumed = 0;
+        CHECK(ParseCommandBatch(strInput.data(), strInput.size(), stBatch, ulConsumed) == ERespParse::Ok);
+        CHECK(stBatch.m_ulCount == vecCommands.size() && ulConsumed == strInput.size() - 9);
+        CHECK(stBatched.ExecuteBatch(stBatch, stReplies));
+        CHECK(stReplies.m_vecSlots.size() == vecCommands.size());
+        std::string strActual;
+        stReplies.AppendTo(strActual);
+        CHECK(strActual == ExecuteInOrder(stModel, vecCommands));
+    }
+}
+
+// 流水线发送上千条交错的命令，不相邻的回复超过单次 writev 的 iovec 上限，分多次发送且不乱序；
+// 客户端读之前服务器写不完，剩余部分转入待发送缓冲区后按顺序发出
+TEST_CASE(Server_PipelineReplyOrder)
+{
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackServer stServer(64 * 1024 * 1024);
+    CHECK(stServer.m_bStarted);
+    int iFd = stServer.m_bStarted ? ConnectLoopback(stServer.m_stConfig.m_usPort) : -1;
+    CHECK(iFd >= 0);
+    if (iFd < 0)
+    {
+        return;
+    }
+    RankingService stModel;
+    for (int iRound = 0; iRound < 6; ++iRound)
+    {
+        auto vecCommands = MixedCommands(iRound, iRound % 2 == 0 ? 3000 : 200);
+        std::string strExpect = ExecuteInOrder(stModel, vecCommands);
+        CHECK(SendAll(iFd, Encode(vecCommands)));
+        CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+    }
+    close(iFd);
+}
+
+// 客户端只发不收：待发送回复超过上限后服务器停止读取，客户端的发送被 TCP 流控挡住；
+// 客户端开始读取后服务器继续执行，全部回复按顺序到达
+TEST_CASE(Server_PausesReadingWhenOutputBacksUp)
+{
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackServer stServer(256 * 1024);
+    CHECK(stServer.m_bStarted);
+    int iFd = stServer.m_bStarted ? ConnectLoopback(stServer.m_stConfig.m_usPort) : -1;
+    CHECK(iFd >= 0);
+    if (iFd < 0)
+    {
+        return;
+    }
+    RankingService stModel;
+    std::vector<std::vector<std::string>> vecFill;
+    for (int i = 0; i < 20; ++i)
+    {
+        vecFill.push_back({ "ZADD", "b", std::to_string(i * 11), "member-" + std::to_string(i) });
+    }
+    std::string strExpect = ExecuteInOrder(stModel, vecFill);
+    CHECK(SendAll(iFd, Encode(vecFill)));
+    CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+
+    // 每条命令约 50 字节，回复约 500 字节
+    const std::string strCommand = EncodeCommand({ "ZREVRANGE", "b", "0", "19", "WITHSCORES" });
+    const std::string strReply = ExecuteInOrder(stModel, { { "ZREVRANGE", "b", "0", "19", "WITHSCORES" } });
+    std::string strBlock;
+    for (int i = 0; i < 1000; ++i)
+    {
+        strBlock += strCommand;
+    }
+    // 服务器停止读取后，客户端最多再填满双方的套接字缓冲区(接收缓冲区可自动增长到数十 MiB)；
+    // 服务器一直读取时发送不会停下，发到 128 MiB 为止
+    const size_t ulMaxInput = 128 * 1024 * 1024;
+    size_t ulSent = 0;
+    bool bStalled = false;
+    while (ulSent < ulMaxInput && !bStalled)
+    {
+        size_t ulOffset = ulSent % strBlock.size();
+        ssize_t lWritten = send(iFd, strBlock.data() + ulOffset, strBlock.size() - ulOffset, MSG_DONTWAIT);
+        if (lWritten > 0)
+        {
+            ulSent += static_cast<size_t>(lWritten);
+            continue;
+        }
+        pollfd stPoll = { iFd, POLLOUT, 0 };
+        bStalled = lWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && poll(&stPoll, 1, 300) == 0;
+    }
+    CHECK(bStalled);
+
+    // 补齐最后半条命令，同时读回全部回复
+    size_t ulCommands = (ulSent + strCommand.size() - 1) / strCommand.size();
+    std::string strActual;
+    std::thread stReader([&]()
+    {
+        strActual = ReadBytes(iFd, ulCommands * strReply.size());
+    });
+    CHECK(SendAll(iFd, strCommand.substr(ulSent % strCommand.size() == 0 ? strCommand.size() : ulSent % strCommand.size())));
+    stReader.join();
+    CHECK(strActual.size() == ulCommands * strReply.size());
+    size_t ulBad = 0;
+    for (size_t i = 0; i + strReply.size() <= strActual.size(); i += strReply.size())
+    {
+        ulBad += strActual.compare(i, strReply.size(), strReply) == 0 ? 0 : 1;
+    }
+    CHECK(ulBad == 0);
+    close(iFd);
+}
@@ -0,0 +1,238 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "resp_client.h"
+#include "shard_server.h"
+#include "test_util.h"
+
+namespace
+{
+    // 两个分片的回环服务器，析构时停止分片线程
+    struct LoopbackShards
+    {
+        ServerConfig         m_stConfig;
+        ShardedRankingServer m_stServer;
+        std::atomic<bool>    m_bStop;
+        std::thread          m_stThread;
+        bool                 m_bStarted;
+
+        explicit LoopbackShards(size_t ulQueueCapacity) : m_stConfig(MakeConfig(ulQueueCapacity)), m_stServer(m_stConfig), m_bStop(false)
+        {
+            m_bStarted = m_stServer.Start();
+            if (m_bStarted)
+            {
+                m_stThread = std::thread([this]()
+                {
+                    m_stServer.Run(m_bStop);
+                });
+            }
+        }
+
+        ~LoopbackShards()
+        {
+            m_bStop = true;
+            if (m_stThread.joinable())
+            {
+                m_stThread.join();
+            }
+        }
+
+        static ServerConfig MakeConfig(size_t ulQueueCapacity)
+        {
+            ServerConfig stConfig;
+            stConfig.m_strBindAddr = "127.0.0.1";
+            stConfig.m_usPort = PickFreePort();
+            stConfig.m_iShards = 2;
+            stConfig.m_ulShardQueueCapacity = ulQueueCapacity;
+            return stConfig;
+        }
+
+        // 以 strPrefix 开头、归属分片 iShard 的排行榜名
+        std::string BoardOn(const std::string& strPrefix, int iShard) const
+        {
+            for (int i = 0;; ++i)
+            {
+                std::string strBoard = strPrefix + std::to_string(i);
+                if (m_stServer.GetBoardShard(strBoard) == iShard)
+                {
+                    return strBoard;
+                }
+            }
+        }
+    };
+
+    // 两个分片的排行榜交错的读写命令，夹带与排行榜无关的命令，回复依赖此前命令的执行结果
+    std::vector<std::vector<std::string>> MixedCommands(const std::string& strA, const std::string& strB, int iRound, int iCount)
+    {
+        std::vector<std::vector<std::string>> vecCommands;
+        for (int i = 0; i < iCount; ++i)
+        {
+            std::string strMember = "m" + std::to_string((iRound * 7 + i) % 23);
+            switch (i % 7)
+            {
+            case 0:
+                vecCommands.push_back({ "ZADD", strA, std::to_string(i * 3 + iRound), strMember });
+                break;
+            case 1:
+                vecCommands.push_back({ "ZINCRBY", strB, std::to_string(i % 5 + 1), strMember });
+                break;
+            case 2:
+                vecCommands.push_back({ "ZREVRANK", strA, strMember });
+                break;
+            case 3:
+                vecCommands.push_back({ "PING" });
+                break;
+            case 4:
+                vecCommands.push_back({ "ZREVRANGE", strB, "0", "2", "WITHSCORES" });
+                break;
+            case 5:
+                vecCommands.push_back({ "ZCARD", i % 2 == 0 ? strA : strB });
+                break;
+            default:
+                vecCommands.push_back({ "ZSCORE", strB, strMember });
+                break;
+            }
+        }
+        return vecCommands;
+    }
+
+    std::string Encode(const std::vector<std::vector<std::string>>& vecCommands)
+    {
+        std::string strOut;
+        for (const auto& vecCommand : vecCommands)
+        {
+            strOut += EncodeCommand(vecCommand);
+        }
+        return strOut;
+    }
+}
+
+// 一条连接流水线发送两个分片上排行榜的命令，回复按命令顺序，与逐条执行一致；
+// 一批命令分两次到达时后半段在前半段的回复到齐后执行；QUIT 之后的命令不执行，回复发完后关闭连接
+TEST_CASE(ShardServer_PipelineReplyOrder)
+{
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackShards stShards(4096);
+    CHECK(stShards.m_bStarted);
+    if (!stShards.m_bStarted)
+    {
+        return;
+    }
+    std::string strA = stShards.BoardOn("a", 0);
+    std::string strB = stShards.BoardOn("b", 1);
+    int iFd = ConnectLoopback(stShards.m_stConfig.m_usPort);
+    CHECK(iFd >= 0);
+    if (iFd < 0)
+    {
+        return;
+    }
+    RankingService stModel;
+    for (int iRound = 0; iRound < 20; ++iRound)
+    {
+        auto vecCommands = MixedCommands(strA, strB, iRound, 150);
+        std::string strInput = Encode(vecCommands);
+        if (iRound % 2 == 0)
+        {
+            CHECK(SendAll(iFd, strInput));
+        }
+        else
+        {
+            // 从命令中间断开
+            size_t ulSplit = strInput.size() / 2 + 3;
+            CHECK(SendAll(iFd, strInput.substr(0, ulSplit)));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            CHECK(SendAll(iFd, strInput.substr(ulSplit)));
+        }
+        std::string strExpect = ExecuteInOrder(stModel, vecCommands);
+        CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+    }
+
+    std::string strExpect = ExecuteInOrder(stModel, { { "ZCARD", strA }, { "QUIT" } });
+    CHECK(SendAll(iFd, Encode({ { "ZCARD", strA }, { "QUIT" }, { "ZADD", strA, "1", "late" } })));
+    // 多读一个字节：回复之后应是连接关闭
+    CHECK(ReadBytes(iFd, strExpect.size() + 1) == strExpect);
+    close(iFd);
+
+    int iCheckFd = ConnectLoopback(stShards.m_stConfig.m_usPort);
+    CHECK(iCheckFd >= 0);
+    if (iCheckFd >= 0)
+    {
+        strExpect = ExecuteInOrder(stModel, { { "ZSCORE", strA, "late" } });
+        CHECK(SendAll(iCheckFd, EncodeCommand({ "ZSCORE", strA, "late" })));
+        CHECK(ReadBytes(iCheckFd, strExpect.size()) == strExpect);
+        close(iCheckFd);
+    }
+}
+
+// 分片间队列容量为 1：多条连接同时发出跨分片的流水线，放不进队列的请求暂存在发送方，回复顺序和内容不变；
+// 有请求在其他分片执行时关闭的连接，结果送回后才释放，之后的连接照常服务
+TEST_CASE(ShardServer_FullQueuesAndClosedConnections)
+{
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackShards stShards(1);
+    CHECK(stShards.m_bStarted);
+    if (!stShards.m_bStarted)
+    {
+        return;
+    }
+    const int iConnections = 8;
+    std::vector<int> vecFds;
+    std::vector<std::string> vecA;
+    std::vector<std::string> vecB;
+    for (int i = 0; i < iConnections; ++i)
+    {
+        vecFds.push_back(ConnectLoopback(stShards.m_stConfig.m_usPort));
+        CHECK(vecFds.back() >= 0);
+        // 各连接使用各自的排行榜，回复与连接之间的执行顺序无关
+        vecA.push_back(stShards.BoardOn("c" + std::to_string(i) + "a", 0));
+        vecB.push_back(stShards.BoardOn("c" + std::to_string(i) + "b", 1));
+    }
+    RankingService stModel;
+    for (int iRound = 0; iRound < 10; ++iRound)
+    {
+        std::vector<std::string> vecExpect;
+        for (int i = 0; i < iConnections; ++i)
+        {
+            auto vecCommands = MixedCommands(vecA[i], vecB[i], iRound, 40);
+            vecExpect.push_back(ExecuteInOrder(stModel, vecCommands));
+            CHECK(vecFds[i] >= 0 && SendAll(vecFds[i], Encode(vecCommands)));
+        }
+        for (int i = 0; i < iConnections; ++i)
+        {
+            CHECK(vecFds[i] >= 0 && ReadBytes(vecFds[i], vecExpect[i].size()) == vecExpect[i]);
+        }
+    }
+    for (int iFd : vecFds)
+    {
+        if (iFd >= 0)
+        {
+            close(iFd);
+        }
+    }
+
+    // 发出大批跨分片命令后立即关闭，不读回复
+    for (int i = 0; i < iConnections; ++i)
+    {
+        int iFd = ConnectLoopback(stShards.m_stConfig.m_usPort);
+        CHECK(iFd >= 0);
+        if (iFd >= 0)
+        {
+            CHECK(SendAll(iFd, Encode(MixedCommands(vecA[0] + "-gone", vecB[0] + "-gone", i, 3000))));
+            close(iFd);
+        }
+    }
+    int iFd = ConnectLoopback(stShards.m_stConfig.m_usPort);
+    CHECK(iFd >= 0);
+    if (iFd >= 0)
+    {
+        auto vecCommands = MixedCommands(vecA[1], vecB[1], 10, 200);
+        std::string strExpect = ExecuteInOrder(stModel, vecCommands);
+        CHECK(SendAll(iFd, Encode(vecCommands)));
+        CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+        close(iFd);
+    }
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loser_tree.h"
+#include "sharded_leaderboard.h"
+#include "test_util.h"
+
+// 任意路数(含非2的幂和空路)归并的输出与整体排序一致
+TEST_CASE(LoserTree_MergeOrder)
+{
+    std::mt19937_64 stRng(11);
+    for (size_t ulWays = 1; ulWays <= 17; ++ulWays)
+    {
+        std::vector<std::vector<int>> vecRuns(ulWays);
+        std::vector<int> vecAll;
+        for (auto& vecRun : vecRuns)
+        {
+            size_t ulLen = stRng() % 40;
+            for (size_t i = 0; i < ulLen; ++i)
+            {
+                vecRun.push_back(static_cast<int>(stRng() % 100));
+            }
+            std::sort(vecRun.begin(), vecRun.end());
+            vecAll.insert(vecAll.end(), vecRun.begin(), vecRun.end());
+        }
+        std::sort(vecAll.begin(), vecAll.end());
+
+        std::vector<size_t> vecPos(ulWays, 0);
+        LoserTree stTree(ulWays, [&](size_t ulA, size_t ulB)
+        {
+            bool bValidA = vecPos[ulA] < vecRuns[ulA].size();
+            bool bValidB = vecPos[ulB] < vecRuns[ulB].size();
+            if (!bValidA || !bValidB)
+            {
+                return bValidA;
+            }
+            int iA = vecRuns[ulA][vecPos[ulA]];
+            int iB = vecRuns[ulB][vecPos[ulB]];
+            return iA != iB ? iA < iB : ulA < ulB;
+        });
+        std::vector<int> vecMerged;
+        std::vector<size_t> vecLastWay;
+        for (size_t i = 0; i < vecAll.size(); ++i)
+        {
+            size_t ulWay = stTree.Winner();
+            CHECK(vecPos[ulWay] < vecRuns[ulWay].size());
+            if (vecPos[ulWay] >= vecRuns[ulWay].size())
+            {
+                break;
+            }
+            // 相等元素按路下标排列，保证归并稳定
+            if (!vecMerged.empty() && vecMerged.back() == vecRuns[ulWay][vecPos[ulWay]])
+            {
+                CHECK(vecLastWay.back() <= ulWay);
+            }
+            vecMerged.push_back(vecRuns[ulWay][vecPos[ulWay]++]);
+            vecLastWay.push_back(ulWay);
+            stTree.Replay();
+        }
+        CHECK(vecMerged == vecAll);
+        // 全部耗尽后胜者也是耗尽的路
+        size_t ulWinner = stTree.Winner();
+        CHECK(vecPos[ulWinner] == vecRuns[ulWinner].size());
+    }
+}
+
+// 分数互不相同时排名、区间和计数与普通排行榜一致
+TEST_CASE(Sharded_MatchesLeaderboard)
+{
+    const size_t arrShards[] = { 1, 3, 8 };
+    for (size_t ulShards : arrShards)
+    {
+        LocalShardedLeaderboard stBoard(ulShards);
+        Leaderboard stExpect;
+        std::mt19937_64 stRng(ulShards);
+        for (int i = 0; i < 6000; ++i)
+        {
+            int iMember = static_cast<int>(stRng() % 700);
+            std::string strMember = "m" + std::to_string(iMember);
+            if (stRng() % 6 == 0)
+            {
+                CHECK(stBoard.Remove(strMember) == stExpect.Remove(strMember));
+            }
+            else
+            {
+                double dScore = static_cast<double>(stRng() % 5000) + iMember / 1000.0;
+                CHECK(stBoard.Add(strMember, dScore) == stExpect.Add(strMember, dScore));
+            }
+        }
+        CHECK(stBoard.Size() == stExpect.Size());
+        std::vector<RankEntry> vecExpect;
+        std::vector<RankEntry> vecActual;
+        stExpect.GetRange(0, -1, true, vecExpect);
+        for (size_t i = 0; i < vecExpect.size(); ++i)
+        {
+            size_t ulRank = 0;
+            CHECK(stBoard.GetRank(vecExpect[i].m_strMember, true, ulRank) && ulRank == i);
+            CHECK(stBoard.GetRank(vecExpect[i].m_strMember, false, ulRank) && ulRank == vecExpect.size() - 1 - i);
+        }
+        int64_t llSize = static_cast<int64_t>(vecExpect.size());
+        for (int64_t llStart = -llSize - 5; llStart < llSize + 5; llStart += 37)
+        {
+            for (int iDir = 0; iDir < 2; ++iDir)
+            {
+                stExpect.GetRange(llStart, llStart + 60, iDir == 0, vecExpect);
+                stBoard.GetRange(llStart, llStart + 60, iDir == 0, vecActual);
+                CHECK(vecActual.size() == vecExpect.size());
+                for (size_t i = 0; i < vecActual.size() && i < vecExpect.size(); ++i)
+                {
+                    CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+                    CHECK(vecActual[i].m_dScore == vecExpect[i].m_dScore);
+                }
+            }
+        }
+        stBoard.GetTop(10, vecActual);
+        stExpect.GetRange(0, 9, true, vecExpect);
+        CHECK(vecActual.size() == vecExpect.size());
+        for (double dLow = -10; dLow < 5100; dLow += 331)
+        {
+            ScoreBound stMin{ dLow, true };
+            ScoreBound stMax{ dLow + 900, false };
+            CHECK(stBoard.Count(stMin, stMax) == stExpect.Count(stMin, stMax));
+        }
+    }
+}
+
+// 同分成员：GetRank 与 GetRange 对同分次序的约定一致
+TEST_CASE(Sharded_TiesConsistent)
+{
+    ShardedLeaderboard stBoard(4);
+    for (int i = 0; i < 400; ++i)
+    {
+        stBoard.Add("m" + std::to_string(i), i % 10);
+    }
+    for (int iDir = 0; iDir < 2; ++iDir)
+    {
+        std::vector<RankEntry> vecEntries;
+        stBoard.GetRange(0, -1, iDir == 0, vecEntries);
+        CHECK(vecEntries.size() == 400);
+        for (size_t i = 0; i < vecEntries.size(); ++i)
+        {
+            size_t ulRank = 0;
+            CHECK(stBoard.GetRank(vecEntries[i].m_strMember, iDir == 0, ulRank) && ulRank == i);
+            if (i > 0)
+            {
+                CHECK(iDir == 0 ? vecEntries[i - 1].m_dScore >= vecEntries[i].m_dScore : vecEntries[i - 1].m_dScore <= vecEntries[i].m_dScore);
+            }
+        }
+    }
+}
+
+// 多线程并发写入不同分片后，总数和前N名正确
+TEST_CASE(Sharded_ConcurrentWrites)
+{
+    ShardedLeaderboard stBoard(8);
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 4; ++t)
+    {
+        vecThreads.emplace_back([&stBoard, t]()
+        {
+            for (int i = 0; i < 5000; ++i)
+            {
+                stBoard.Add("t" + std::to_string(t) + "_" + std::to_string(i), i * 4 + t);
+            }
+        });
+    }
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    CHECK(stBoard.Size() == 20000);
+    std::vector<RankEntry> vecTop;
+    stBoard.GetTop(100, vecTop);
+    CHECK(vecTop.size() == 100);
+    for (size_t i = 0; i < vecTop.size(); ++i)
+    {
+        CHECK(vecTop[i].m_dScore == 19999 - static_cast<double>(i));
+    }
+}
@@ -0,0 +1,226 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shm_ring.h"
+#include "test_util.h"
+
+namespace
+{
+    std::string RingName(const char* szName)
+    {
+        return std::string("/gameranking-test-") + szName + "-" + std::to_string(getpid());
+    }
+
+    // 第 ulSeq 个事件：成员名和分数都由序号决定，读者据此检查读到的事件是否完整
+    void WriteEvent(ShmEventRing& stRing, uint64_t ulSeq)
+    {
+        std::string strMember = "member-" + std::to_string(ulSeq);
+        stRing.OnScoreEvent(ScoreEvent{ EScoreEvent::Updated, "board", strMember, static_cast<double>(ulSeq - 1), static_cast<double>(ulSeq) });
+    }
+
+    bool EventMatches(const ShmEvent& stEvent)
+    {
+        return stEvent.m_eType == EScoreEvent::Updated && stEvent.m_strBoard == "board" && stEvent.m_strMember == "member-" + std::to_string(stEvent.m_ulSeq)
+            && stEvent.m_dOldScore == static_cast<double>(stEvent.m_ulSeq - 1) && stEvent.m_dNewScore == static_cast<double>(stEvent.m_ulSeq) && !stEvent.m_bTruncated;
+    }
+
+    // 以读写方式映射共享内存，用于伪造槽位状态和头部
+    void* MapWritable(const std::string& strName, size_t ulSize)
+    {
+        int iFd = shm_open(strName.c_str(), O_RDWR, 0);
+        if (iFd < 0)
+        {
+            return nullptr;
+        }
+        void* pMap = mmap(nullptr, ulSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+        close(iFd);
+        return pMap == MAP_FAILED ? nullptr : pMap;
+    }
+}
+
+// 读者按序号依次读到每个事件，读完后为空；超长名字截断并置标志；只读新事件的读者看不到打开前的事件
+TEST_CASE(ShmRing_ReadInOrder)
+{
+    ShmEventRing stRing;
+    CHECK(stRing.Create(RingName("order"), 6));
+    ShmEventReader stReader;
+    CHECK(stReader.Open(stRing.GetName(), false));
+    ShmEvent stEvent;
+    CHECK(stReader.Read(stEvent) == EShmRead::Empty);
+    for (uint64_t i = 1; i <= 5; ++i)
+    {
+        WriteEvent(stRing, i);
+    }
+    ShmEventReader stLatest;
+    CHECK(stLatest.Open(stRing.GetName(), true));
+    for (uint64_t i = 1; i <= 5; ++i)
+    {
+        CHECK(stReader.Read(stEvent) == EShmRead::Ok && stEvent.m_ulSeq == i && EventMatches(stEvent));
+    }
+    CHECK(stReader.Read(stEvent) == EShmRead::Empty);
+    CHECK(stLatest.Read(stEvent) == EShmRead::Empty);
+
+    std::string strLong(100, 'x');
+    stRing.OnScoreEvent(ScoreEvent{ EScoreEvent::Added, strLong, strLong, 0, 1 });
+    CHECK(stLatest.Read(stEvent) == EShmRead::Ok && stEvent.m_ulSeq == 6 && stEvent.m_bTruncated);
+    CHECK(stEvent.m_strBoard.size() == SHM_RING_BOARD_LEN && stEvent.m_strMember.size() == SHM_RING_MEMBER_LEN);
+    CHECK(stReader.GetLost() == 0 && stLatest.GetLost() == 0);
+}
+
+// 环满后覆盖最旧的槽位：新打开的读者从仍有效的位置开始；落后的读者得到 Overrun，跳过的事件计入丢失数，之后照常读取
+TEST_CASE(ShmRing_OverrunSkipsAhead)
+{
+    ShmEventRing stRing;
+    CHECK(stRing.Create(RingName("overrun"), 8));
+    for (uint64_t i = 1; i <= 20; ++i)
+    {
+        WriteEvent(stRing, i);
+    }
+    // 容量 8，留一半余量：从 20 - 4 + 1 = 17 开始
+    ShmEventReader stFresh;
+    CHECK(stFresh.Open(stRing.GetName(), false));
+    ShmEvent stEvent;
+    for (uint64_t i = 17; i <= 20; ++i)
+    {
+        CHECK(stFresh.Read(stEvent) == EShmRead::Ok && stEvent.m_ulSeq == i && EventMatches(stEvent));
+    }
+    CHECK(stFresh.Read(stEvent) == EShmRead::Empty && stFresh.GetLost() == 0);
+
+    // 读完 21 后停下，写入者再写到 50，槽位中只剩 43~50
+    WriteEvent(stRing, 21);
+    CHECK(stFresh.Read(stEvent) == EShmRead::Ok && stEvent.m_ulSeq == 21);
+    for (uint64_t i = 22; i <= 50; ++i)
+    {
+        WriteEvent(stRing, i);
+    }
+    CHECK(stFresh.Read(stEvent) == EShmRead::Overrun);
+    CHECK(stFresh.GetLost() == 47 - 22);
+    for (uint64_t i = 47; i <= 50; ++i)
+    {
+        CHECK(stFresh.Read(stEvent) == EShmRead::Ok && stEvent.m_ulSeq == i && EventMatches(stEvent));
+    }
+    CHECK(stFresh.Read(stEvent) == EShmRead::Empty);
+}
+
+// 槽位带改写标志时读者视为还没写完；写线程持续覆盖时读者读到的每个事件都完整，序号递增，读到的加丢失的等于写入总数
+TEST_CASE(ShmRing_BusySlotAndConcurrentWriter)
+{
+    ShmEventRing stRing;
+    CHECK(stRing.Create(RingName("busy"), 16));
+    size_t ulSize = sizeof(ShmRingHeader) + 16 * sizeof(ShmEventRecord);
+    void* pMap = MapWritable(stRing.GetName(), ulSize);
+    CHECK(pMap != nullptr);
+    if (pMap != nullptr)
+    {
+        ShmEventReader stReader;
+        CHECK(stReader.Open(stRing.GetName(), false));
+        ShmEventRecord* pRecords = reinterpret_cast<ShmEventRecord*>(static_cast<char*>(pMap) + sizeof(ShmRingHeader));
+        pRecords[1].m_ulSeq.store(1 | SHM_RING_BUSY);
+        ShmEvent stEvent;
+        CHECK(stReader.Read(stEvent) == EShmRead::Empty);
+        pRecords[1].m_ulSeq.store(0);
+        WriteEvent(stRing, 1);
+        CHECK(stReader.Read(stEvent) == EShmRead::Ok && EventMatches(stEvent));
+        munmap(pMap, ulSize);
+    }
+
+    const uint64_t ulTotal = 300000;
+    ShmEventReader stReader;
+    CHECK(stReader.Open(stRing.GetName(), true));
+    std::atomic<bool> bDone(false);
+    std::thread stWriter([&]()
+    {
+        for (uint64_t i = 2; i <= ulTotal; ++i)
+        {
+            WriteEvent(stRing, i);
+        }
+        bDone = true;
+    });
+    uint64_t ulRead = 0;
+    uint64_t ulLastSeq = 1;
+    size_t ulBad = 0;
+    while (true)
+    {
+        bool bFinished = bDone.load();
+        ShmEvent stEvent;
+        EShmRead eRead = stReader.Read(stEvent);
+        if (eRead == EShmRead::Ok)
+        {
+            ulBad += EventMatches(stEvent) && stEvent.m_ulSeq > ulLastSeq ? 0 : 1;
+            ulLastSeq = stEvent.m_ulSeq;
+            ++ulRead;
+        }
+        else if (eRead == EShmRead::Empty && bFinished)
+        {
+            break;
+        }
+    }
+    stWriter.join();
+    CHECK(ulBad == 0);
+    CHECK(ulLastSeq == ulTotal);
+    CHECK(ulRead + stReader.GetLost() == ulTotal - 1);
+}
+
+// 魔数、版本、记录大小不符，容量超出映射或共享内存小于头部时拒绝打开；不存在的名字打开失败
+TEST_CASE(ShmRing_RejectsBadLayout)
+{
+    ShmEventReader stMissing;
+    CHECK(!stMissing.Open(RingName("missing"), false));
+
+    ShmEventRing stRing;
+    CHECK(stRing.Create(RingName("layout"), 4));
+    ShmEventReader stGood;
+    CHECK(stGood.Open(stRing.GetName(), false));
+    void* pMap = MapWritable(stRing.GetName(), sizeof(ShmRingHeader));
+    CHECK(pMap != nullptr);
+    if (pMap != nullptr)
+    {
+        ShmRingHeader* pHeader = static_cast<ShmRingHeader*>(pMap);
+        ShmRingHeader stSaved;
+        memcpy(static_cast<void*>(&stSaved), pHeader, sizeof(stSaved));
+        for (int iCase = 0; iCase < 4; ++iCase)
+        {
+            memcpy(static_cast<void*>(pHeader), &stSaved, sizeof(stSaved));
+            switch (iCase)
+            {
+            case 0:
+                pHeader->m_ulMagic ^= 1;
+                break;
+            case 1:
+                pHeader->m_uiVersion = SHM_RING_VERSION + 1;
+                break;
+            case 2:
+                pHeader->m_uiRecordSize = sizeof(ShmEventRecord) / 2;
+                break;
+            default:
+                pHeader->m_ulCapacity = 1024;
+                break;
+            }
+            ShmEventReader stReader;
+            CHECK(!stReader.Open(stRing.GetName(), false));
+        }
+        memcpy(static_cast<void*>(pHeader), &stSaved, sizeof(stSaved));
+        munmap(pMap, sizeof(ShmRingHeader));
+    }
+    ShmEventReader stRestored;
+    CHECK(stRestored.Open(stRing.GetName(), false));
+
+    // 比头部还小的共享内存
+    std::string strSmall = RingName("small");
+    int iFd = shm_open(strSmall.c_str(), O_CREAT | O_RDWR, 0600);
+    CHECK(iFd >= 0);
+    if (iFd >= 0)
+    {
+        CHECK(ftruncate(iFd, 16) == 0);
+        close(iFd);
+        ShmEventReader stSmall;
+        CHECK(!stSmall.Open(strSmall, false));
+        shm_unlink(strSmall.c_str());
+    }
+}
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "skiplist.h"
+#include "test_util.h"
+
+namespace
+{
+    using LocalList = SkipList<uint64_t, uint64_t, SingleThreadAccess>;
+
+    // 各节点的排名、按排名定位和升序遍历都与有序集合一致，说明整段摘除后各层跨度仍然正确
+    void CheckSpans(LocalList& stList, const std::set<uint64_t>& setModel, std::mt19937_64& stRng)
+    {
+        CHECK(stList.Size() == setModel.size());
+        std::vector<uint64_t> vecAll;
+        stList.ForEach([&](const uint64_t& ulKey, const uint64_t& ulValue)
+        {
+            CHECK(ulValue == ulKey * 3);
+            vecAll.push_back(ulKey);
+            return true;
+        });
+        CHECK(vecAll == std::vector<uint64_t>(setModel.begin(), setModel.end()));
+        size_t ulRank = 0;
+        for (uint64_t ulKey : setModel)
+        {
+            CHECK(stList.GetRank(ulKey) == ulRank);
+            // 不在表中的相邻键排名相同
+            CHECK(stList.GetRank(ulKey + 1) == ulRank + 1 || setModel.count(ulKey + 1) == 1);
+            ++ulRank;
+        }
+        for (int i = 0; i < 20 && !setModel.empty(); ++i)
+        {
+            size_t ulStart = stRng() % (setModel.size() + 2);
+            std::vector<uint64_t> vecFrom;
+            stList.ForEachFromRank(ulStart, [&](const uint64_t& ulKey, const uint64_t&)
+            {
+                vecFrom.push_back(ulKey);
+                return vecFrom.size() < 30;
+            });
+            std::vector<uint64_t> vecExpect;
+            for (auto it = ulStart < setModel.size() ? std::next(setModel.begin(), static_cast<std::ptrdiff_t>(ulStart)) : setModel.end();
+                it != setModel.end() && vecExpect.size() < 30; ++it)
+            {
+                vecExpect.push_back(*it);
+            }
+            CHECK(vecFrom == vecExpect);
+        }
+    }
+
+    // 值由同一个字符重复组成，读到被改写一半的值时字符不一致
+    bool IsWholeValue(const std::string& strValue)
+    {
+        return !strValue.empty() && strValue.find_first_not_of(strValue[0]) == std::string::npos;
+    }
+}
+
+// 按键区间和按排名区间整段删除与有序集合一致：回调按升序收到每个被删节点，返回值为删除个数，空区间和越界区间不删除
+TEST_CASE(SkipList_RemoveRangeMatchesSet)
+{
+    LocalList stList;
+    std::set<uint64_t> setModel;
+    std::mt19937_64 stRng(43);
+    for (int iRound = 0; iRound < 300; ++iRound)
+    {
+        // 补充节点，键间隔 2，留出不在表中的键
+        while (setModel.size() < 600)
+        {
+            uint64_t ulKey = (stRng() % 5000) * 2;
+            stList.Insert(ulKey, ulKey * 3);
+            setModel.insert(ulKey);
+        }
+        std::vector<uint64_t> vecRemoved;
+        auto fnCollect = [&](const uint64_t& ulKey, const uint64_t& ulValue)
+        {
+            CHECK(ulValue == ulKey * 3);
+            vecRemoved.push_back(ulKey);
+        };
+        std::vector<uint64_t> vecExpect;
+        if (iRound % 2 == 0)
+        {
+            // 端点可能不在表中，lo > hi 时不删除
+            uint64_t ulLo = stRng() % 10000;
+            uint64_t ulHi = iRound % 10 == 0 ? ulLo / 2 : ulLo + stRng() % 400;
+            for (auto it = setModel.lower_bound(ulLo); it != setModel.end() && *it <= ulHi && ulLo <= ulHi;)
+            {
+                vecExpect.push_back(*it);
+                it = setModel.erase(it);
+            }
+            CHECK(stList.RemoveRange(ulLo, ulHi, fnCollect) == vecExpect.size());
+        }
+        else
+        {
+            // 起点可能越过末尾，终点越过末尾时删到最后一个
+            size_t ulFirst = stRng() % (setModel.size() + 5);
+            size_t ulLast = iRound % 7 == 1 ? ulFirst - 1 : (iRound % 11 == 1 ? SIZE_MAX : ulFirst + stRng() % 200);
+            if (ulFirst <= ulLast && ulFirst < setModel.size())
+            {
+                auto itFirst = std::next(setModel.begin(), static_cast<std::ptrdiff_t>(ulFirst));
+                auto itLast = ulLast < setModel.size() - 1 ? std::next(setModel.begin(), static_cast<std::ptrdiff_t>(ulLast + 1)) : setModel.end();
+                vecExpect.assign(itFirst, itLast);
+                setModel.erase(itFirst, itLast);
+            }
+            CHECK(stList.RemoveRankRange(ulFirst, ulLast, fnCollect) == vecExpect.size());
+        }
+        CHECK(vecRemoved == vecExpect);
+        if (iRound % 10 == 0)
+        {
+            CheckSpans(stList, setModel, stRng);
+        }
+        stList.ReclaimRetired();
+    }
+    CheckSpans(stList, setModel, stRng);
+    // 终点为 SIZE_MAX 时删到最后一个
+    CHECK(stList.RemoveRankRange(0, SIZE_MAX, [](const uint64_t&, const uint64_t&) {}) == setModel.size());
+    setModel.clear();
+    CheckSpans(stList, setModel, stRng);
+    CHECK(stList.RemoveRange(0, UINT64_MAX) == 0);
+}
+
+// 并发策略下更新已有键时换上新节点：读线程同时查找和遍历，读到的值总是某次写入的完整值，
+// 键不丢失不重复，排名不变；退休的旧节点在没有读者后回收
+TEST_CASE(SkipList_ConcurrentUpdateReplacesNode)
+{
+    const uint64_t ulKeys = 200;
+    SkipList<uint64_t, std::string> stList;
+    for (uint64_t i = 0; i < ulKeys; ++i)
+    {
+        stList.Insert(i, std::string(40, 'a'));
+    }
+    std::atomic<bool> bStop(false);
+    std::atomic<size_t> ulBad(0);
+    std::thread stReader([&]()
+    {
+        std::mt19937_64 stRng(3);
+        while (!bStop.load())
+        {
+            uint64_t ulKey = stRng() % ulKeys;
+            if (!IsWholeValue(stList.GetValue(ulKey)) || stList.GetRank(ulKey) != ulKey)
+            {
+                ++ulBad;
+            }
+            uint64_t ulExpect = 0;
+            stList.ForEach([&](const uint64_t& ulCurr, const std::string& strValue)
+            {
+                ulBad += ulCurr == ulExpect && IsWholeValue(strValue) ? 0 : 1;
+                ++ulExpect;
+                return true;
+            });
+            ulBad += ulExpect == ulKeys ? 0 : 1;
+        }
+    });
+    std::mt19937_64 stRng(5);
+    for (int iRound = 0; iRound < 20000; ++iRound)
+    {
+        // 长短交替，短值在字符串对象内，长值在堆上
+        stList.Insert(stRng() % ulKeys, std::string(1 + stRng() % 100, static_cast<char>('a' + iRound % 26)));
+    }
+    bStop = true;
+    stReader.join();
+    CHECK(ulBad.load() == 0);
+    CHECK(stList.Size() == ulKeys);
+    stList.ReclaimRetired();
+    for (uint64_t i = 0; i < ulKeys; ++i)
+    {
+        stList.Insert(i, "final-" + std::to_string(i));
+    }
+    stList.ReclaimRetired();
+    for (uint64_t i = 0; i < ulKeys; ++i)
+    {
+        CHECK(stList.GetValue(i) == "final-" + std::to_string(i) && stList.GetRank(i) == i);
+    }
+}
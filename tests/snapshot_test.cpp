@@ -0,0 +1,236 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "board_snapshot.h"
+#include "leaderboard.h"
+#include "snapshot.h"
+#include "test_util.h"
+
+namespace
+{
+    std::string TempPath(const char* szName)
+    {
+        return (std::filesystem::temp_directory_path() / (std::string("gameranking-snapshot-") + szName + "-" + std::to_string(std::random_device()()))).string();
+    }
+
+    SnapshotHeader ReadHeader(const std::string& strPath)
+    {
+        SnapshotHeader stHeader;
+        memset(&stHeader, 0, sizeof(stHeader));
+        FILE* pFile = fopen(strPath.c_str(), "rb");
+        CHECK(pFile != nullptr);
+        if (pFile != nullptr)
+        {
+            CHECK(fread(&stHeader, sizeof(stHeader), 1, pFile) == 1);
+            fclose(pFile);
+        }
+        return stHeader;
+    }
+
+    std::vector<uint8_t> ReadFileBytes(const std::string& strPath)
+    {
+        std::vector<uint8_t> vecData(static_cast<size_t>(std::filesystem::file_size(strPath)));
+        FILE* pFile = fopen(strPath.c_str(), "rb");
+        CHECK(pFile != nullptr);
+        if (pFile != nullptr)
+        {
+            CHECK(fread(vecData.data(), 1, vecData.size(), pFile) == vecData.size());
+            fclose(pFile);
+        }
+        return vecData;
+    }
+
+    void WriteFileBytes(const std::string& strPath, const std::vector<uint8_t>& vecData)
+    {
+        FILE* pFile = fopen(strPath.c_str(), "wb");
+        CHECK(pFile != nullptr);
+        if (pFile != nullptr)
+        {
+            CHECK(fwrite(vecData.data(), 1, vecData.size(), pFile) == vecData.size());
+            fclose(pFile);
+        }
+    }
+
+    // 不校验、串行校验和并行校验三种方式装载，返回校验装载的结果；两种校验方式结果须一致
+    ESnapshotResult LoadVerified(const std::string& strPath)
+    {
+        SkipList<uint64_t, uint64_t, SingleThreadAccess> stSerial;
+        SkipList<uint64_t, uint64_t, SingleThreadAccess> stParallel;
+        ESnapshotResult eSerial = LoadSnapshot(strPath, stSerial, 1, true);
+        ESnapshotResult eParallel = LoadSnapshot(strPath, stParallel, 4, true);
+        CHECK(eSerial == eParallel);
+        return eSerial;
+    }
+}
+
+// 限定容量的排行榜快照设扩展标志、容量写在扩展头，文件头的键值字节数保持为0；不限容量时不写扩展头
+// 装回后容量与成员一致；扩展头损坏时报告文件头损坏
+TEST_CASE(Snapshot_BoardCapacityHeader)
+{
+    std::string strPath = TempPath("board-cap");
+    for (size_t ulCapacity : { size_t(0), size_t(7), (size_t(1) << 33) + 5 })
+    {
+        LocalLeaderboard stBoard;
+        stBoard.SetCapacity(ulCapacity);
+        for (int i = 0; i < 20; ++i)
+        {
+            stBoard.Add("m" + std::to_string(i), i * 1.5);
+        }
+        CHECK(SaveBoardSnapshot(stBoard, strPath, 4) == ESnapshotResult::Ok);
+        SnapshotHeader stHeader = ReadHeader(strPath);
+        CHECK(stHeader.m_uiKeySize == 0 && stHeader.m_uiValueSize == 0);
+        CHECK(stHeader.m_usFlags == (ulCapacity != 0 ? SNAPSHOT_FLAG_BOARD | SNAPSHOT_FLAG_BOARD_EXT : SNAPSHOT_FLAG_BOARD));
+
+        LocalLeaderboard stLoaded;
+        CHECK(LoadBoardSnapshot(strPath, stLoaded) == ESnapshotResult::Ok);
+        CHECK(stLoaded.GetCapacity() == ulCapacity);
+        std::vector<RankEntry> vecExpect;
+        std::vector<RankEntry> vecActual;
+        stBoard.GetRange(0, -1, true, vecExpect);
+        stLoaded.GetRange(0, -1, true, vecActual);
+        CHECK(vecActual.size() == vecExpect.size());
+        for (size_t i = 0; i < vecActual.size() && i < vecExpect.size(); ++i)
+        {
+            CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember && vecActual[i].m_dScore == vecExpect[i].m_dScore);
+        }
+    }
+
+    // 改写扩展头中的容量
+    FILE* pFile = fopen(strPath.c_str(), "r+b");
+    CHECK(pFile != nullptr);
+    if (pFile != nullptr)
+    {
+        fseek(pFile, static_cast<long>(sizeof(SnapshotHeader)), SEEK_SET);
+        fputc(0x11, pFile);
+        fclose(pFile);
+    }
+    LocalLeaderboard stCorrupt;
+    CHECK(LoadBoardSnapshot(strPath, stCorrupt) == ESnapshotResult::BadHeader);
+    CHECK(stCorrupt.Size() == 0 && stCorrupt.GetCapacity() == 0);
+
+    // 截断在扩展头中间
+    std::filesystem::resize_file(strPath, sizeof(SnapshotHeader) + 4);
+    CHECK(LoadBoardSnapshot(strPath, stCorrupt) == ESnapshotResult::Truncated);
+    std::filesystem::remove(strPath);
+}
+
+// 损坏的跳表快照：块负载或块校验和被改写时报告校验和不符，不校验装载时跳过块校验；
+// 文件被截断在文件头、块头或负载中间时报告截断；文件头或块头的条目数与实际不符时报告校验和不符
+TEST_CASE(Snapshot_CorruptionDetected)
+{
+    const uint32_t uiBlockEntries = 64;
+    const uint64_t ulEntries = 1000;
+    const size_t ulHeaderBytes = sizeof(SnapshotHeader);
+    const size_t ulBlockBytes = sizeof(SnapshotBlockHeader) + uiBlockEntries * 2 * sizeof(uint64_t);
+    std::string strPath = TempPath("corrupt");
+    {
+        SkipList<uint64_t, uint64_t, SingleThreadAccess> stList;
+        for (uint64_t i = 0; i < ulEntries; ++i)
+        {
+            stList.Insert(i * 3, i);
+        }
+        CHECK(SaveSnapshot(stList, strPath, uiBlockEntries) == ESnapshotResult::Ok);
+    }
+    const std::vector<uint8_t> vecGood = ReadFileBytes(strPath);
+    const uint64_t ulBlocks = (ulEntries + uiBlockEntries - 1) / uiBlockEntries;
+    CHECK(vecGood.size() == ulHeaderBytes + (ulBlocks - 1) * ulBlockBytes + sizeof(SnapshotBlockHeader) + (ulEntries % uiBlockEntries) * 2 * sizeof(uint64_t));
+    CHECK(LoadVerified(strPath) == ESnapshotResult::Ok);
+
+    // 翻转中间一块负载中值的一个字节：键序不变，只有块校验能发现
+    const size_t ulMiddleBlock = ulHeaderBytes + 7 * ulBlockBytes;
+    std::vector<uint8_t> vecData = vecGood;
+    vecData[ulMiddleBlock + sizeof(SnapshotBlockHeader) + 5 * 2 * sizeof(uint64_t) + sizeof(uint64_t)] ^= 0x40;
+    WriteFileBytes(strPath, vecData);
+    CHECK(LoadVerified(strPath) == ESnapshotResult::ChecksumMismatch);
+    {
+        SkipList<uint64_t, uint64_t, SingleThreadAccess> stUnverified;
+        CHECK(LoadSnapshot(strPath, stUnverified, 0, false) == ESnapshotResult::Ok);
+        CHECK(stUnverified.Size() == ulEntries);
+    }
+
+    // 翻转最后一块(不满一块)中最后一个键的最低位
+    vecData = vecGood;
+    vecData[vecData.size() - 2 * sizeof(uint64_t)] ^= 0x01;
+    WriteFileBytes(strPath, vecData);
+    CHECK(LoadVerified(strPath) == ESnapshotResult::ChecksumMismatch);
+
+    // 改写块头中的校验和
+    vecData = vecGood;
+    vecData[ulHeaderBytes + offsetof(SnapshotBlockHeader, m_uiCrc)] ^= 0x80;
+    WriteFileBytes(strPath, vecData);
+    CHECK(LoadVerified(strPath) == ESnapshotResult::ChecksumMismatch);
+
+    // 截断：文件头中间、块头中间、负载中间、少了最后一块
+    for (size_t ulSize : { ulHeaderBytes - 1, ulHeaderBytes + 3 * ulBlockBytes + 8, ulHeaderBytes + 3 * ulBlockBytes + sizeof(SnapshotBlockHeader) + 100,
+                           ulHeaderBytes + (ulBlocks - 1) * ulBlockBytes })
+    {
+        WriteFileBytes(strPath, vecGood);
+        std::filesystem::resize_file(strPath, ulSize);
+        CHECK(LoadVerified(strPath) == ESnapshotResult::Truncated);
+    }
+
+    // 文件头的条目数多一条或少一条，文件头校验和随之重算
+    for (int64_t llDelta : { int64_t(1), int64_t(-1) })
+    {
+        vecData = vecGood;
+        SnapshotHeader stHeader;
+        memcpy(&stHeader, vecData.data(), sizeof(stHeader));
+        stHeader.m_ulCount = static_cast<uint64_t>(static_cast<int64_t>(stHeader.m_ulCount) + llDelta);
+        stHeader.m_uiHeaderCrc = Crc32c(&stHeader, offsetof(SnapshotHeader, m_uiHeaderCrc));
+        memcpy(vecData.data(), &stHeader, sizeof(stHeader));
+        WriteFileBytes(strPath, vecData);
+        CHECK(LoadVerified(strPath) == ESnapshotResult::ChecksumMismatch);
+    }
+
+    // 文件头的条目数改了但校验和没重算
+    vecData = vecGood;
+    vecData[offsetof(SnapshotHeader, m_ulCount)] ^= 0x01;
+    WriteFileBytes(strPath, vecData);
+    CHECK(LoadVerified(strPath) == ESnapshotResult::BadHeader);
+
+    // 块头的条目数与负载字节数不符
+    vecData = vecGood;
+    SnapshotBlockHeader stBlock;
+    memcpy(&stBlock, vecData.data() + ulMiddleBlock, sizeof(stBlock));
+    stBlock.m_uiEntries -= 1;
+    memcpy(vecData.data() + ulMiddleBlock, &stBlock, sizeof(stBlock));
+    WriteFileBytes(strPath, vecData);
+    CHECK(LoadVerified(strPath) == ESnapshotResult::ChecksumMismatch);
+    std::filesystem::remove(strPath);
+}
+
+// 损坏的排行榜快照：块负载被改写时报告校验和不符，截断在块中间时报告截断，装载失败不改动排行榜
+TEST_CASE(Snapshot_BoardCorruptionDetected)
+{
+    std::string strPath = TempPath("board-corrupt");
+    LocalLeaderboard stBoard;
+    for (int i = 0; i < 200; ++i)
+    {
+        stBoard.Add("member-" + std::to_string(i), i * 0.5);
+    }
+    CHECK(SaveBoardSnapshot(stBoard, strPath, 16) == ESnapshotResult::Ok);
+    const std::vector<uint8_t> vecGood = ReadFileBytes(strPath);
+
+    // 改写第一块负载中的一个字节
+    std::vector<uint8_t> vecData = vecGood;
+    vecData[sizeof(SnapshotHeader) + sizeof(SnapshotBlockHeader) + 10] ^= 0x20;
+    WriteFileBytes(strPath, vecData);
+    LocalLeaderboard stLoaded;
+    CHECK(LoadBoardSnapshot(strPath, stLoaded) == ESnapshotResult::ChecksumMismatch);
+    CHECK(stLoaded.Size() == 0);
+
+    WriteFileBytes(strPath, vecGood);
+    std::filesystem::resize_file(strPath, vecGood.size() - 7);
+    CHECK(LoadBoardSnapshot(strPath, stLoaded) == ESnapshotResult::Truncated);
+    CHECK(stLoaded.Size() == 0);
+
+    WriteFileBytes(strPath, vecGood);
+    CHECK(LoadBoardSnapshot(strPath, stLoaded) == ESnapshotResult::Ok);
+    CHECK(stLoaded.Size() == 200);
+    std::filesystem::remove(strPath);
+}
@@ -0,0 +1,84 @@
+#include <memory>
+#include <thread>
+
+#include "spsc_queue.h"
+#include "test_util.h"
+
+// 容量向上取到 2 的幂；满时入队失败且不移动参数，出队后又能入队；头尾下标多次绕过环形缓冲区后顺序不变
+TEST_CASE(SpscQueue_WraparoundAndFull)
+{
+    SpscQueue<int> stQueue(5);
+    int iValue = 0;
+    CHECK(stQueue.Empty() && !stQueue.TryPop(iValue));
+    for (int i = 0; i < 8; ++i)
+    {
+        CHECK(stQueue.TryPush(i));
+    }
+    CHECK(!stQueue.TryPush(8) && !stQueue.Empty());
+
+    // 每轮出队 3 个再入队 3 个，下标绕过缓冲区多次
+    int iNextPop = 0;
+    int iNextPush = 8;
+    for (int iRound = 0; iRound < 100; ++iRound)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            CHECK(stQueue.TryPop(iValue) && iValue == iNextPop);
+            ++iNextPop;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            CHECK(stQueue.TryPush(iNextPush));
+            ++iNextPush;
+        }
+        CHECK(!stQueue.TryPush(-1));
+    }
+    while (stQueue.TryPop(iValue))
+    {
+        CHECK(iValue == iNextPop);
+        ++iNextPop;
+    }
+    CHECK(iNextPop == iNextPush && stQueue.Empty());
+
+    SpscQueue<std::unique_ptr<int>> stOwned(1);
+    CHECK(stOwned.TryPush(std::unique_ptr<int>(new int(1))));
+    std::unique_ptr<int> pKept(new int(2));
+    CHECK(!stOwned.TryPush(std::move(pKept)));
+    CHECK(pKept != nullptr && *pKept == 2);
+    std::unique_ptr<int> pOut;
+    CHECK(stOwned.TryPop(pOut) && *pOut == 1);
+    CHECK(stOwned.TryPush(std::move(pKept)) && pKept == nullptr);
+}
+
+// 生产者和消费者各一个线程，小容量下频繁满和空，消费者按入队顺序收到全部元素
+TEST_CASE(SpscQueue_ConcurrentOrder)
+{
+    const int iTotal = 500000;
+    SpscQueue<int> stQueue(16);
+    std::thread stProducer([&]()
+    {
+        for (int i = 0; i < iTotal; ++i)
+        {
+            while (!stQueue.TryPush(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int iExpect = 0;
+    size_t ulBad = 0;
+    while (iExpect < iTotal)
+    {
+        int iValue = 0;
+        if (!stQueue.TryPop(iValue))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ulBad += iValue == iExpect ? 0 : 1;
+        ++iExpect;
+    }
+    stProducer.join();
+    CHECK(ulBad == 0);
+    CHECK(stQueue.Empty());
+}
@@ -0,0 +1,42 @@
+#include <cstring>
+#include <iostream>
+
+#include "test_util.h"
+
+static size_t g_ulFailures = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> s_vecCases;
+    return s_vecCases;
+}
+
+void ReportFailure(const char* szFile, int iLine, const char* szExpr)
+{
+    ++g_ulFailures;
+    std::cerr << szFile << ":" << iLine << ": CHECK(" << szExpr << ") failed" << std::endl;
+}
+
+// 参数为测试名前缀，不带参数时运行全部测试
+int main(int argc, char* argv[])
+{
+    const char* szPrefix = argc > 1 ? argv[1] : "";
+    size_t ulRun = 0;
+    for (const TestCase& stCase : GetTestCases())
+    {
+        if (strncmp(stCase.m_szName, szPrefix, strlen(szPrefix)) != 0)
+        {
+            continue;
+        }
+        size_t ulBefore = g_ulFailures;
+        stCase.m_pfnRun();
+        ++ulRun;
+        std::cout << (g_ulFailures == ulBefore ? "[ ok ] " : "[FAIL] ") << stCase.m_szName << std::endl;
+    }
+    if (ulRun == 0)
+    {
+        std::cerr << "no test matches '" << szPrefix << "'" << std::endl;
+        return 1;
+    }
+    return g_ulFailures == 0 ? 0 : 1;
+}
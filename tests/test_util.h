@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// 单元测试的最小框架：TEST_CASE 定义并注册测试，CHECK 失败时记录文件行号后继续执行
+// 测试程序的参数为测试名前缀，只运行名字以它开头的测试，ctest 按模块各注册一项
+
+typedef void (*TestFunc)();
+
+struct TestCase
+{
+    const char* m_szName;// 测试名，约定为 模块_内容
+    TestFunc    m_pfnRun;// 测试函数
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportFailure(const char* szFile, int iLine, const char* szExpr);
+
+struct TestRegistrar
+{
+    TestRegistrar(const char* szName, TestFunc pfnRun)
+    {
+        GetTestCases().push_back(TestCase{ szName, pfnRun });
+    }
+};
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestRegistrar s_stRegistrar_##name(#name, name); \
+    static void name()
+
+#define CHECK(expr) \
+    do \
+    { \
+        if (!(expr)) \
+        { \
+            ReportFailure(__FILE__, __LINE__, #expr); \
+        } \
+    } while (0)
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "leaderboard.h"
+#include "test_util.h"
+#include "timer_wheel.h"
+#include "ttl_leaderboard.h"
+
+// 到期的定时器按刻度顺序各触发一次，触发刻度等于到期刻度(已过期的为加入后的下一个刻度)，覆盖各层与溢出表
+TEST_CASE(TimerWheel_FiresAtDeadline)
+{
+    struct Fired
+    {
+        uint64_t m_ulTick;
+        size_t   m_ulIndex;
+    };
+    TimerWheel<size_t> stWheel(1000);
+    std::vector<uint64_t> vecExpect;
+    std::vector<Fired> vecFired;
+    std::mt19937_64 stRng(11);
+    const uint64_t ulSpans[] = { 1, 64, 4096, 262144, 1ULL << 24, 1ULL << 25 };
+    for (int iRound = 0; iRound < 200; ++iRound)
+    {
+        uint64_t ulNow = stWheel.GetNow();
+        uint64_t ulDeadline = ulNow + stRng() % ulSpans[stRng() % 6] - (iRound % 10 == 0 ? 5 : 0);
+        vecExpect.push_back(std::max(ulDeadline, ulNow + 1));
+        stWheel.Schedule(ulDeadline, vecExpect.size() - 1);
+        if (iRound % 4 == 0)
+        {
+            stWheel.Advance(ulNow + stRng() % 5000, [&](size_t ulIndex) { vecFired.push_back(Fired{ stWheel.GetNow(), ulIndex }); });
+        }
+    }
+    stWheel.Advance(stWheel.GetNow() + (1ULL << 26), [&](size_t ulIndex) { vecFired.push_back(Fired{ stWheel.GetNow(), ulIndex }); });
+    CHECK(stWheel.Size() == 0);
+    CHECK(vecFired.size() == vecExpect.size());
+    std::vector<int> vecCount(vecExpect.size(), 0);
+    for (size_t i = 0; i < vecFired.size(); ++i)
+    {
+        CHECK(vecFired[i].m_ulTick == vecExpect[vecFired[i].m_ulIndex]);
+        CHECK(i == 0 || vecFired[i - 1].m_ulTick <= vecFired[i].m_ulTick);
+        ++vecCount[vecFired[i].m_ulIndex];
+    }
+    CHECK(std::all_of(vecCount.begin(), vecCount.end(), [](int iCount) { return iCount == 1; }));
+}
+
+// 回调中加入的定时器按新的当前刻度放置，同一次推进内到期的也会触发
+TEST_CASE(TimerWheel_ScheduleInCallback)
+{
+    TimerWheel<int> stWheel;
+    std::vector<std::pair<uint64_t, int>> vecFired;
+    stWheel.Schedule(10, 0);
+    stWheel.Advance(200, [&](int iValue)
+    {
+        vecFired.emplace_back(stWheel.GetNow(), iValue);
+        if (iValue < 3)
+        {
+            stWheel.Schedule(stWheel.GetNow() + 50, iValue + 1);
+        }
+    });
+    CHECK(vecFired.size() == 4);
+    for (int i = 0; i < 4 && i < static_cast<int>(vecFired.size()); ++i)
+    {
+        CHECK(vecFired[i].first == static_cast<uint64_t>(10 + 50 * i) && vecFired[i].second == i);
+    }
+    CHECK(stWheel.Size() == 0 && stWheel.GetNow() == 200);
+}
+
+// 参照实现：成员的分数与到期毫秒时间，清理时删除到期刻度不晚于当前刻度的成员
+struct TtlModel
+{
+    int64_t m_llTickMs;
+    std::map<std::string, std::pair<double, int64_t>> m_mapMembers;
+
+    // 到期刻度：有效期向上取整到刻度
+    int64_t GetDeadlineTick(int64_t llDeadlineMs) const
+    {
+        return (llDeadlineMs + m_llTickMs - 1) / m_llTickMs;
+    }
+
+    size_t Reap(int64_t llNow, LocalLeaderboard& stReference)
+    {
+        size_t ulExpired = 0;
+        for (auto it = m_mapMembers.begin(); it != m_mapMembers.end();)
+        {
+            if (GetDeadlineTick(it->second.second) <= llNow / m_llTickMs)
+            {
+                stReference.Remove(it->first);
+                it = m_mapMembers.erase(it);
+                ++ulExpired;
+                continue;
+            }
+            ++it;
+        }
+        return ulExpired;
+    }
+};
+
+// 随机写入、续期、缩短有效期、删除并推进时钟，每次清理删除的成员、剩余有效期和排名、区间、计数都与参照一致
+TEST_CASE(Ttl_ReapMatchesModel)
+{
+    int64_t llNow = 5000;
+    TtlConfig stConfig;
+    stConfig.m_uiDefaultTtlMs = 1000;
+    stConfig.m_uiTickMs = 100;
+    LocalTtlLeaderboard stBoard(stConfig, [&llNow]() { return llNow; });
+    LocalLeaderboard stReference;
+    TtlModel stModel{ 100, {} };
+    std::mt19937_64 stRng(17);
+    uint64_t ulExpired = 0;
+    for (int iStep = 0; iStep < 20000; ++iStep)
+    {
+        std::string strMember = "m" + std::to_string(stRng() % 60);
+        uint64_t ulRoll = stRng() % 100;
+        uint32_t uiTtlMs = ulRoll % 3 == 0 ? 0 : static_cast<uint32_t>(stRng() % 3000 + 1);
+        int64_t llDeadline = llNow + (uiTtlMs == 0 ? 1000 : uiTtlMs);
+        auto it = stModel.m_mapMembers.find(strMember);
+        if (ulRoll < 60)
+        {
+            // 分数各不相同，排名与并列的处理无关
+            double dScore = iStep;
+            stBoard.Add(strMember, dScore, AddOptions(), uiTtlMs);
+            stReference.Add(strMember, dScore);
+            stModel.m_mapMembers[strMember] = { dScore, llDeadline };
+        }
+        else if (ulRoll < 80)
+        {
+            CHECK(stBoard.Touch(strMember, uiTtlMs) == (it != stModel.m_mapMembers.end()));
+            if (it != stModel.m_mapMembers.end())
+            {
+                it->second.second = llDeadline;
+            }
+        }
+        else if (ulRoll < 85)
+        {
+            CHECK(stBoard.Remove(strMember) == (it != stModel.m_mapMembers.end()));
+            stReference.Remove(strMember);
+            stModel.m_mapMembers.erase(strMember);
+        }
+        else
+        {
+            llNow += static_cast<int64_t>(stRng() % 250);
+            size_t ulReaped = stBoard.Reap();
+            CHECK(ulReaped == stModel.Reap(llNow, stReference));
+            ulExpired += ulReaped;
+        }
+
+        if (iStep % 100 == 0)
+        {
+            CHECK(stBoard.Size() == stModel.m_mapMembers.size());
+            CHECK(stBoard.GetExpiredCount() == ulExpired);
+            for (const auto& stPair : stModel.m_mapMembers)
+            {
+                int64_t llRemainingMs = -1;
+                CHECK(stBoard.GetTtl(stPair.first, llRemainingMs));
+                CHECK(llRemainingMs == std::max<int64_t>(stModel.GetDeadlineTick(stPair.second.second) * 100 - llNow, 0));
+            }
+            std::vector<RankEntry> vecEntries;
+            std::vector<RankEntry> vecExpect;
+            stBoard.GetRange(0, -1, true, vecEntries);
+            stReference.GetRange(0, -1, true, vecExpect);
+            CHECK(vecEntries.size() == vecExpect.size());
+            for (size_t i = 0; i < vecEntries.size() && i < vecExpect.size(); ++i)
+            {
+                CHECK(vecEntries[i].m_strMember == vecExpect[i].m_strMember && vecEntries[i].m_dScore == vecExpect[i].m_dScore);
+                size_t ulRank = 0;
+                CHECK(stBoard.GetRank(vecEntries[i].m_strMember, true, ulRank) && ulRank == i);
+            }
+            ScoreBound stMin{ static_cast<double>(iStep / 2), false };
+            ScoreBound stMax{ static_cast<double>(iStep), true };
+            CHECK(stBoard.Count(stMin, stMax) == stReference.Count(stMin, stMax));
+        }
+    }
+}
+
+// 成员至少保留完整的有效期，最多晚一个刻度被删除；缩短有效期后按新期限删除，旧定时器到期时丢弃
+TEST_CASE(Ttl_DeadlineBounds)
+{
+    int64_t llNow = 1050;
+    TtlConfig stConfig;
+    stConfig.m_uiDefaultTtlMs = 500;
+    stConfig.m_uiTickMs = 100;
+    LocalTtlLeaderboard stBoard(stConfig, [&llNow]() { return llNow; });
+    stBoard.Add("a", 1);
+    stBoard.Add("b", 2, AddOptions(), 5000);
+    // a 在 1550 到期，向上取整到 1600
+    llNow = 1549;
+    CHECK(stBoard.Reap() == 0);
+    llNow = 1599;
+    CHECK(stBoard.Reap() == 0);
+    double dScore = 0;
+    CHECK(stBoard.GetScore("a", dScore));
+    llNow = 1600;
+    CHECK(stBoard.Reap() == 1);
+    CHECK(!stBoard.GetScore("a", dScore));
+    CHECK(!stBoard.Touch("a"));
+
+    // b 缩短到 300 毫秒后按新期限删除，原定时器留在时间轮上，到期时丢弃
+    CHECK(stBoard.Touch("b", 300));
+    CHECK(stBoard.GetTimerCount() == 2);
+    llNow = 1900;
+    CHECK(stBoard.Reap() == 1);
+    CHECK(stBoard.Size() == 0);
+    CHECK(stBoard.GetTimerCount() == 1);
+    llNow = 7000;
+    CHECK(stBoard.Reap() == 0);
+    CHECK(stBoard.GetTimerCount() == 0);
+    CHECK(stBoard.GetExpiredCount() == 2);
+
+    // 续期推迟期限，原定时器到期时按新期限重新登记
+    stBoard.Add("c", 3);
+    llNow = 7400;
+    CHECK(stBoard.Touch("c", 1000));
+    llNow = 7500;
+    CHECK(stBoard.Reap() == 0);
+    int64_t llRemainingMs = 0;
+    CHECK(stBoard.GetTtl("c", llRemainingMs) && llRemainingMs == 900);
+    llNow = 8400;
+    CHECK(stBoard.Reap() == 1);
+    CHECK(!stBoard.GetTtl("c", llRemainingMs));
+}
+
+// 后台线程清理时并发写入：持续续期的成员保留，停止写入的成员在有效期后被删除
+TEST_CASE(Ttl_ConcurrentReaper)
+{
+    std::atomic<int64_t> llNow(0);
+    TtlConfig stConfig;
+    stConfig.m_uiDefaultTtlMs = 50;
+    stConfig.m_uiTickMs = 1;
+    TtlLeaderboard stBoard(stConfig, [&llNow]() { return llNow.load(); });
+    for (int i = 0; i < 1000; ++i)
+    {
+        stBoard.Add("idle" + std::to_string(i), i);
+    }
+    stBoard.Start();
+    std::atomic<bool> bStop(false);
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 2; ++t)
+    {
+        vecThreads.emplace_back([&stBoard, &bStop, t]()
+        {
+            double dNewScore = 0;
+            while (!bStop.load())
+            {
+                for (int i = 0; i < 100; ++i)
+                {
+                    stBoard.IncrBy("live" + std::to_string(t) + "_" + std::to_string(i), 1, dNewScore);
+                }
+            }
+        });
+    }
+    // 时钟推进到 idle 成员过期，每步不超过写线程一轮续期的时间
+    for (int i = 0; i < 200; ++i)
+    {
+        llNow += 1;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    bStop = true;
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    stBoard.Stop();
+    stBoard.Reap();
+    CHECK(stBoard.Size() == 200);
+    CHECK(stBoard.GetExpiredCount() >= 1000);
+    double dScore = 0;
+    CHECK(!stBoard.GetScore("idle0", dScore));
+    CHECK(stBoard.GetScore("live1_99", dScore) && dScore > 0);
+}
@@ -0,0 +1,333 @@
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "resp_client.h"
+#include "test_util.h"
+#include "uring.h"
+#include "uring_server.h"
+
+namespace
+{
+    const uint64_t PROVIDE_USER_DATA = 1;// PROVIDE_BUFFERS 请求的完成事件
+    const uint64_t RECV_USER_DATA = 2;   // 接收请求的完成事件
+
+    // 沙箱或旧内核上没有 io_uring 时跳过
+    bool UringAvailable(const char* szTest)
+    {
+        IoUring stRing;
+        int iRet = stRing.Init(8, 0, 0);
+        if (iRet < 0)
+        {
+            std::cout << "[skip] " << szTest << ": io_uring_setup: " << strerror(-iRet) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 向 iFd 写入 strData 后用缓冲区组接收一次，返回接收到的缓冲区编号，失败返回-1；
+    // PROVIDE_BUFFERS 请求与接收请求一起提交，它们的完成事件在这里消费
+    int RecvOnce(IoUring& stRing, UringBufferRing& stBuffers, int iWriteFd, int iReadFd, const std::string& strData)
+    {
+        if (write(iWriteFd, strData.data(), strData.size()) != static_cast<ssize_t>(strData.size()))
+        {
+            return -1;
+        }
+        io_uring_sqe* pstSqe = stRing.GetSqe();
+        if (pstSqe == nullptr)
+        {
+            return -1;
+        }
+        pstSqe->opcode = IORING_OP_RECV;
+        pstSqe->fd = iReadFd;
+        pstSqe->flags = IOSQE_BUFFER_SELECT;
+        pstSqe->buf_group = stBuffers.GetGroup();
+        pstSqe->user_data = RECV_USER_DATA;
+        int iBuffer = -1;
+        bool bDone = false;
+        size_t ulBadProvides = 0;
+        while (!bDone && stRing.Submit(1) >= 0)
+        {
+            stRing.ForEachCqe([&](const io_uring_cqe& stCqe)
+            {
+                if (stCqe.user_data == PROVIDE_USER_DATA)
+                {
+                    ulBadProvides += stCqe.res < 0 ? 1 : 0;
+                    return;
+                }
+                bDone = true;
+                if (stCqe.res == static_cast<int>(strData.size()) && (stCqe.flags & IORING_CQE_F_BUFFER))
+                {
+                    iBuffer = static_cast<int>(stCqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                }
+            });
+        }
+        CHECK(ulBadProvides == 0);
+        return iBuffer;
+    }
+
+    // 回环地址上运行的 io_uring 服务器，析构时停止事件循环；
+    // 只有创建 io_uring 的线程能提交，Start 和 Run 在同一个线程上
+    struct LoopbackUringServer
+    {
+        ServerConfig       m_stConfig;
+        RankingService     m_stService;
+        UringRankingServer m_stServer;
+        std::atomic<bool>  m_bStop;
+        std::atomic<int>   m_iStarted;
+        std::thread        m_stThread;
+
+        explicit LoopbackUringServer(size_t ulMaxPendingOutput) : m_stConfig(MakeConfig(ulMaxPendingOutput)), m_stServer(m_stConfig, m_stService), m_bStop(false), m_iStarted(-1)
+        {
+            m_stThread = std::thread([this]()
+            {
+                bool bOk = m_stServer.Start();
+                m_iStarted = bOk ? 1 : 0;
+                if (bOk)
+                {
+                    m_stServer.Run(m_bStop);
+                }
+            });
+            while (m_iStarted.load() < 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~LoopbackUringServer()
+        {
+            m_bStop = true;
+            m_stThread.join();
+        }
+
+        bool Started() const
+        {
+            return m_iStarted.load() == 1;
+        }
+
+        static ServerConfig MakeConfig(size_t ulMaxPendingOutput)
+        {
+            ServerConfig stConfig;
+            stConfig.m_strBindAddr = "127.0.0.1";
+            stConfig.m_usPort = PickFreePort();
+            stConfig.m_ulMaxPendingOutput = ulMaxPendingOutput;
+            return stConfig;
+        }
+    };
+
+    // TCP 发送和接收缓冲区可自动增长到的上限之和，读不到时按 64 MiB
+    size_t SocketBufferLimit()
+    {
+        size_t ulTotal = 0;
+        for (const char* szPath : { "/proc/sys/net/ipv4/tcp_rmem", "/proc/sys/net/ipv4/tcp_wmem" })
+        {
+            std::ifstream stFile(szPath);
+            size_t ulMin = 0;
+            size_t ulDefault = 0;
+            size_t ulMax = 0;
+            if (!(stFile >> ulMin >> ulDefault >> ulMax))
+            {
+                return 64 * 1024 * 1024;
+            }
+            ulTotal += ulMax;
+        }
+        return ulTotal;
+    }
+
+    // 没有 io_uring 或内核缺少多发 accept/recv 时跳过
+    bool UringServerAvailable(const char* szTest)
+    {
+        if (!UringAvailable(szTest))
+        {
+            return false;
+        }
+        if (!UringRankingServer::IsSupported())
+        {
+            std::cout << "[skip] " << szTest << ": kernel lacks multishot accept/recv" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+// 注册缓冲区环和 PROVIDE_BUFFERS 两种方式各接收多次：2 个缓冲区轮流使用，每次收到的数据落在内核选出的缓冲区中，
+// 归还并发布后可再次被选中；缓冲区环不可用时(自检失败)只测 PROVIDE_BUFFERS
+TEST_CASE(Uring_ProvidedBuffersRecycled)
+{
+    if (!UringAvailable("Uring_ProvidedBuffersRecycled"))
+    {
+        return;
+    }
+    bool bRingWorks = UringRankingServer::BufferRingWorks();
+    std::cout << "buffer ring " << (bRingWorks ? "works" : "unavailable, PROVIDE_BUFFERS only") << std::endl;
+    for (bool bUseRing : { true, false })
+    {
+        if (bUseRing && !bRingWorks)
+        {
+            continue;
+        }
+        IoUring stRing;
+        CHECK(stRing.Init(8, 0, 0) == 0);
+        if (!bUseRing && !stRing.IsOpSupported(IORING_OP_PROVIDE_BUFFERS))
+        {
+            std::cout << "[skip] IORING_OP_PROVIDE_BUFFERS is not supported" << std::endl;
+            continue;
+        }
+        UringBufferRing stBuffers;
+        CHECK(stBuffers.Init(stRing, 3, 2, 64, bUseRing, PROVIDE_USER_DATA) == 0);
+        CHECK(stBuffers.IsRing() == bUseRing);
+        int aiFds[2];
+        CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, aiFds) == 0);
+        std::set<int> setUsed;
+        for (int i = 0; i < 10; ++i)
+        {
+            std::string strData = "message-" + std::to_string(i);
+            int iBuffer = RecvOnce(stRing, stBuffers, aiFds[1], aiFds[0], strData);
+            CHECK(iBuffer >= 0 && iBuffer < 2);
+            if (iBuffer < 0)
+            {
+                break;
+            }
+            CHECK(std::string(stBuffers.GetBuffer(static_cast<uint16_t>(iBuffer)), strData.size()) == strData);
+            setUsed.insert(iBuffer);
+            stBuffers.Recycle(static_cast<uint16_t>(iBuffer));
+            stBuffers.Publish();
+        }
+        CHECK(!setUsed.empty() && setUsed.size() <= 2);
+        close(aiFds[0]);
+        close(aiFds[1]);
+    }
+}
+
+// io_uring 服务器冒烟测试：流水线命令(超过单个接收缓冲区)的回复与逐条执行一致
+TEST_CASE(Uring_ServerPipeline)
+{
+    if (!UringServerAvailable("Uring_ServerPipeline"))
+    {
+        return;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackUringServer stServer(64 * 1024 * 1024);
+    CHECK(stServer.Started());
+    int iFd = stServer.Started() ? ConnectLoopback(stServer.m_stConfig.m_usPort) : -1;
+    CHECK(iFd >= 0);
+    if (iFd >= 0)
+    {
+        RankingService stModel;
+        for (int iRound = 0; iRound < 4; ++iRound)
+        {
+            std::vector<std::vector<std::string>> vecCommands;
+            for (int i = 0; i < (iRound % 2 == 0 ? 2000 : 10); ++i)
+            {
+                std::string strBoard = i % 2 == 0 ? "a" : "b";
+                std::string strMember = "m" + std::to_string(i % 37);
+                if (i % 3 == 0)
+                {
+                    vecCommands.push_back({ "ZREVRANGE", strBoard, "0", "2", "WITHSCORES" });
+                }
+                else
+                {
+                    vecCommands.push_back({ "ZINCRBY", strBoard, std::to_string(i % 7), strMember });
+                }
+            }
+            std::string strInput;
+            for (const auto& vecCommand : vecCommands)
+            {
+                strInput += EncodeCommand(vecCommand);
+            }
+            std::string strExpect = ExecuteInOrder(stModel, vecCommands);
+            CHECK(SendAll(iFd, strInput));
+            CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+        }
+        close(iFd);
+    }
+}
+
+// 客户端只发不收：待发送回复超过上限后服务器取消多发 recv，客户端的发送被 TCP 流控挡住；
+// 客户端开始读取后服务器先执行暂停期间收下的命令再恢复接收，全部回复按顺序到达
+TEST_CASE(Uring_PausesReadingWhenOutputBacksUp)
+{
+    if (!UringServerAvailable("Uring_PausesReadingWhenOutputBacksUp"))
+    {
+        return;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    LoopbackUringServer stServer(256 * 1024);
+    CHECK(stServer.Started());
+    int iFd = stServer.Started() ? ConnectLoopback(stServer.m_stConfig.m_usPort) : -1;
+    CHECK(iFd >= 0);
+    if (iFd < 0)
+    {
+        return;
+    }
+    RankingService stModel;
+    std::vector<std::vector<std::string>> vecFill;
+    for (int i = 0; i < 20; ++i)
+    {
+        vecFill.push_back({ "ZADD", "b", std::to_string(i * 11), "member-" + std::to_string(i) });
+    }
+    std::string strExpect = ExecuteInOrder(stModel, vecFill);
+    std::string strFill;
+    for (const auto& vecCommand : vecFill)
+    {
+        strFill += EncodeCommand(vecCommand);
+    }
+    CHECK(SendAll(iFd, strFill));
+    CHECK(ReadBytes(iFd, strExpect.size()) == strExpect);
+
+    // 每条命令约 50 字节，回复约 500 字节
+    const std::string strCommand = EncodeCommand({ "ZREVRANGE", "b", "0", "19", "WITHSCORES" });
+    const std::string strReply = ExecuteInOrder(stModel, { { "ZREVRANGE", "b", "0", "19", "WITHSCORES" } });
+    std::string strBlock;
+    for (int i = 0; i < 1000; ++i)
+    {
+        strBlock += strCommand;
+    }
+    // 服务器停止接收后，客户端最多再填满双方的套接字缓冲区；服务器一直接收时发送不会停下，发到 128 MiB 为止
+    const size_t ulMaxInput = 128 * 1024 * 1024;
+    size_t ulSent = 0;
+    bool bStalled = false;
+    while (ulSent < ulMaxInput && !bStalled)
+    {
+        size_t ulOffset = ulSent % strBlock.size();
+        ssize_t lWritten = send(iFd, strBlock.data() + ulOffset, strBlock.size() - ulOffset, MSG_DONTWAIT);
+        if (lWritten > 0)
+        {
+            ulSent += static_cast<size_t>(lWritten);
+            continue;
+        }
+        pollfd stPoll = { iFd, POLLOUT, 0 };
+        bStalled = lWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && poll(&stPoll, 1, 300) == 0;
+    }
+    CHECK(bStalled);
+    // 服务器一直接收时，回复堆积在内存中使事件循环变慢，客户端也可能停顿；停顿时已发出的数据不应超过套接字缓冲区加上已执行的一段输入
+    CHECK(ulSent < SocketBufferLimit() + 4 * 1024 * 1024);
+
+    // 补齐最后半条命令，同时读回全部回复
+    size_t ulCommands = (ulSent + strCommand.size() - 1) / strCommand.size();
+    std::string strActual;
+    std::thread stReader([&]()
+    {
+        strActual = ReadBytes(iFd, ulCommands * strReply.size());
+    });
+    CHECK(SendAll(iFd, strCommand.substr(ulSent % strCommand.size() == 0 ? strCommand.size() : ulSent % strCommand.size())));
+    stReader.join();
+    CHECK(strActual.size() == ulCommands * strReply.size());
+    size_t ulBad = 0;
+    for (size_t i = 0; i + strReply.size() <= strActual.size(); i += strReply.size())
+    {
+        ulBad += strActual.compare(i, strReply.size(), strReply) == 0 ? 0 : 1;
+    }
+    CHECK(ulBad == 0);
+    close(iFd);
+}
@@ -0,0 +1,133 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+#include "windowed_leaderboard.h"
+
+// 当前窗口的排名、区间和计数与普通排行榜一致；到了新窗口从空榜开始，上一窗口仍可查询
+TEST_CASE(Windowed_RolloverKeepsHistory)
+{
+    std::atomic<int64_t> llNow(1000);
+    WindowConfig stConfig;
+    stConfig.m_llLengthMs = 100;
+    stConfig.m_ulRetain = 1;
+    WindowedLeaderboard stBoard(stConfig, [&llNow]() { return llNow.load(); });
+    Leaderboard stExpect;
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string strMember = "m" + std::to_string(i % 200);
+        double dNew = 0;
+        stBoard.IncrBy(strMember, i % 7 + i / 1000.0, dNew);
+        stExpect.IncrBy(strMember, i % 7 + i / 1000.0, dNew);
+    }
+    CHECK(stBoard.GetWindowIndex() == 10);
+    CHECK(stBoard.Size() == stExpect.Size());
+    std::vector<RankEntry> vecExpect;
+    std::vector<RankEntry> vecActual;
+    stExpect.GetRange(0, -1, true, vecExpect);
+    stBoard.GetRange(0, -1, true, vecActual);
+    CHECK(vecActual.size() == vecExpect.size());
+    for (size_t i = 0; i < vecExpect.size() && i < vecActual.size(); ++i)
+    {
+        CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+        size_t ulRank = 0;
+        CHECK(stBoard.GetRank(vecExpect[i].m_strMember, true, ulRank) && ulRank == i);
+    }
+    ScoreBound stMin{ 5, false };
+    ScoreBound stMax{ 20, true };
+    CHECK(stBoard.Count(stMin, stMax) == stExpect.Count(stMin, stMax));
+
+    llNow = 1199;
+    CHECK(stBoard.GetWindowIndex() == 11);
+    CHECK(stBoard.GetRolloverCount() == 1);
+    CHECK(stBoard.Size() == 0);
+    stBoard.Add("new", 1);
+    CHECK(stBoard.Size() == 1);
+    // 上一窗口冻结保留
+    CHECK(stBoard.Size(1) == stExpect.Size());
+    CHECK(stBoard.Count(stMin, stMax, 1) == stExpect.Count(stMin, stMax));
+    stBoard.GetRange(0, 9, true, vecActual, 1);
+    stExpect.GetRange(0, 9, true, vecExpect);
+    CHECK(vecActual.size() == 10);
+    for (size_t i = 0; i < vecExpect.size() && i < vecActual.size(); ++i)
+    {
+        CHECK(vecActual[i].m_strMember == vecExpect[i].m_strMember);
+    }
+    double dScore = 0;
+    CHECK(stBoard.GetScore("m0", dScore, 1));
+    CHECK(!stBoard.GetScore("new", dScore, 1));
+
+    // 保留数按日历窗口计：跳过一个窗口后，原来的窗口超出保留数被释放
+    llNow = 1300;
+    CHECK(stBoard.Size(1) == 0);
+    CHECK(stBoard.Size(2) == 0);
+    CHECK(stBoard.Reap() == 2);
+    CHECK(stBoard.GetRetiredCount() == 0);
+}
+
+// 窗口按起点对齐，起点之前的时间向下取整
+TEST_CASE(Windowed_OriginAlignment)
+{
+    std::atomic<int64_t> llNow(-1);
+    WindowConfig stConfig;
+    stConfig.m_llLengthMs = 1000;
+    stConfig.m_llOriginMs = 500;
+    WindowedLeaderboard stBoard(stConfig, [&llNow]() { return llNow.load(); });
+    CHECK(stBoard.GetWindowIndex() == -1);
+    llNow = 499;
+    CHECK(stBoard.GetWindowIndex() == -1);
+    llNow = 500;
+    CHECK(stBoard.GetWindowIndex() == 0);
+    // 时钟回拨时继续使用已发布的窗口
+    llNow = 0;
+    CHECK(stBoard.GetWindowIndex() == 0);
+}
+
+// 读写线程不停访问当前窗口，主线程推进时钟并释放过期窗口：请求用到的窗口不会被提前释放
+TEST_CASE(Windowed_ConcurrentRolloverAndReap)
+{
+    std::atomic<int64_t> llNow(0);
+    WindowConfig stConfig;
+    stConfig.m_llLengthMs = 10;
+    stConfig.m_ulRetain = 0;
+    WindowedLeaderboard stBoard(stConfig, [&llNow]() { return llNow.load(); });
+    std::atomic<bool> bDone(false);
+    std::atomic<size_t> ulBad(0);
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 3; ++t)
+    {
+        vecThreads.emplace_back([&, t]()
+        {
+            std::vector<RankEntry> vecEntries;
+            for (int i = 0; !bDone.load(); ++i)
+            {
+                stBoard.Add("t" + std::to_string(t) + "_" + std::to_string(i % 300), i);
+                stBoard.GetRange(0, 20, true, vecEntries);
+                if (vecEntries.size() > 21 || stBoard.Size() > 900)
+                {
+                    ulBad.fetch_add(1);
+                }
+            }
+        });
+    }
+    size_t ulFreed = 0;
+    for (int i = 0; i < 400; ++i)
+    {
+        llNow.fetch_add(10);
+        ulFreed += stBoard.Reap();
+        std::this_thread::yield();
+    }
+    bDone.store(true);
+    for (auto& stThread : vecThreads)
+    {
+        stThread.join();
+    }
+    ulFreed += stBoard.Reap();
+    CHECK(ulBad.load() == 0);
+    CHECK(stBoard.GetRolloverCount() == 400);
+    // 保留数为0，除当前窗口外全部释放
+    CHECK(ulFreed == 400);
+    CHECK(stBoard.GetRetiredCount() == 0);
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 分层时间轮：LEVELS 层、每层 64 个槽，第 l 层每槽跨 64^l 个刻度，共覆盖 2^(6 x LEVELS) 个刻度，更远的放在溢出表
+// 定时器按到期刻度与当前刻度最高的不同 6 位分组放入对应层，槽号取到期刻度在该层的 6 位；
+// 低层转完一圈时把高一层当前槽中的定时器重新放置(下沉)，每个定时器最多下沉 LEVELS-1 次，
+// 加入和到期都是摊还O(1)，推进一个刻度只看一个槽
+// 定时器不能取消：调用方在到期回调中检查对象的当前期限，期限被推迟过的重新加入即可
+template<typename T>
+class TimerWheel
+{
+    private:
+        static constexpr int      LEVEL_BITS = 6;
+        static constexpr uint64_t SLOTS = 1ULL << LEVEL_BITS;
+        static constexpr int      LEVELS = 4;
+        static constexpr int      SPAN_BITS = LEVEL_BITS * LEVELS;// 时间轮覆盖的刻度位数
+
+        // 一个定时器
+        struct Timer
+        {
+            uint64_t m_ulDeadline;// 到期刻度
+            T        m_stValue;   // 到期时交给回调的值
+        };
+
+        std::vector<Timer> m_vecSlots[LEVELS][SLOTS];// 各层各槽
+        std::vector<Timer> m_vecOverflow;            // 超出覆盖范围的定时器，最高层转完一圈时重新放置
+        std::vector<Timer> m_vecCascade;             // 下沉时复用的缓冲区
+        uint64_t           m_ulNow;                  // 当前刻度
+        size_t             m_ulSize = 0;             // 定时器个数
+
+        void Place(Timer&& stTimer)
+        {
+            uint64_t ulDiff = stTimer.m_ulDeadline ^ m_ulNow;
+            if ((ulDiff >> SPAN_BITS) != 0)
+            {
+                m_vecOverflow.push_back(std::move(stTimer));
+                return;
+            }
+            int iLevel = 0;
+            while ((ulDiff >> (LEVEL_BITS * (iLevel + 1))) != 0)
+            {
+                ++iLevel;
+            }
+            uint64_t ulSlot = (stTimer.m_ulDeadline >> (LEVEL_BITS * iLevel)) & (SLOTS - 1);
+            m_vecSlots[iLevel][ulSlot].push_back(std::move(stTimer));
+        }
+
+        // 把一组定时器按当前刻度重新放置
+        void Replace(std::vector<Timer>& vecTimers)
+        {
+            m_vecCascade.clear();
+            m_vecCascade.swap(vecTimers);
+            for (Timer& stTimer : m_vecCascade)
+            {
+                Place(std::move(stTimer));
+            }
+        }
+
+    public:
+        explicit TimerWheel(uint64_t ulNow = 0) : m_ulNow(ulNow)
+        {
+        }
+
+        // 加入在 ulDeadline 刻度到期的定时器，已过期的在下一个刻度到期
+        void Schedule(uint64_t ulDeadline, T stValue)
+        {
+            if (ulDeadline <= m_ulNow)
+            {
+                ulDeadline = m_ulNow + 1;
+            }
+            Place(Timer{ ulDeadline, std::move(stValue) });
+            ++m_ulSize;
+        }
+
+        // 推进到 ulTick，按刻度顺序对到期的定时器调用 fn(值)；回调中可以再加入定时器
+        // 没有定时器时直接跳到目标刻度
+        template<typename Fn>
+        void Advance(uint64_t ulTick, Fn&& fn)
+        {
+            while (m_ulNow < ulTick)
+            {
+                if (m_ulSize == 0)
+                {
+                    m_ulNow = ulTick;
+                    return;
+                }
+                ++m_ulNow;
+                // 从高到低处理转完一圈的层：第 l 层的当前槽下沉到低层
+                if ((m_ulNow & ((1ULL << SPAN_BITS) - 1)) == 0)
+                {
+                    Replace(m_vecOverflow);
+                }
+                for (int iLevel = LEVELS - 1; iLevel > 0; --iLevel)
+                {
+                    if ((m_ulNow & ((1ULL << (LEVEL_BITS * iLevel)) - 1)) == 0)
+                    {
+                        Replace(m_vecSlots[iLevel][(m_ulNow >> (LEVEL_BITS * iLevel)) & (SLOTS - 1)]);
+                    }
+                }
+                std::vector<Timer>& vecDue = m_vecSlots[0][m_ulNow & (SLOTS - 1)];
+                if (vecDue.empty())
+                {
+                    continue;
+                }
+                // 回调可能加入新的定时器，先换出再处理
+                std::vector<Timer> vecFiring;
+                vecFiring.swap(vecDue);
+                m_ulSize -= vecFiring.size();
+                for (Timer& stTimer : vecFiring)
+                {
+                    fn(stTimer.m_stValue);
+                }
+                // 归还换出的数组，保留容量
+                vecFiring.clear();
+                if (vecDue.empty())
+                {
+                    vecDue.swap(vecFiring);
+                }
+            }
+        }
+
+        uint64_t GetNow() const
+        {
+            return m_ulNow;
+        }
+
+        size_t Size() const
+        {
+            return m_ulSize;
+        }
+};
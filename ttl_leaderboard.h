@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "leaderboard.h"
+#include "timer_wheel.h"
+
+// 成员过期配置
+struct TtlConfig
+{
+    uint32_t m_uiDefaultTtlMs = 3600000;// 写入时未指定有效期时使用的有效期(毫秒)
+    uint32_t m_uiTickMs = 100;          // 时间轮刻度(毫秒)，也是后台线程的清理间隔，成员最多晚一个刻度被删除
+};
+
+// 成员带有效期的排行榜：每次写入刷新成员的有效期，到期没有再写入的成员被删除，例如"近一小时活跃玩家"榜
+// 到期时间登记在分层时间轮上，清理只处理本刻度到期的定时器，不扫描成员表，每个成员的过期开销摊还O(1)
+// 续期只改成员的期限，不动时间轮：定时器到期时发现期限已推迟就按新期限重新登记；
+// 缩短有效期时另登记一个定时器，旧定时器按编号识别为失效后丢弃
+// 到期的成员每 REAP_BATCH 个合并为一次批量删除，排行榜按键排序后删除，相邻键共享查找路径
+// 写操作与清理由 m_stMutex 串行，清理不会删掉刚续期的成员；读操作直接读排行榜，
+// 已到期但还没清理的成员在下一次清理前仍可查到
+// Access 为 SingleThreadAccess 时不启动后台线程，由调用方定时调用 Reap
+template<typename Access>
+class ExpiringBoard
+{
+    private:
+        using Mutex = std::conditional_t<Access::CONCURRENT, std::mutex, NullSharedMutex>;
+
+        static constexpr size_t REAP_BATCH = 1024;// 每次批量删除的成员数，批次之间释放锁让写操作进来
+
+        // 时间轮上的定时器
+        struct ExpiryTimer
+        {
+            std::string m_strMember;// 成员名
+            uint64_t    m_ulId;     // 定时器编号，与成员记录的编号不同时已失效
+        };
+
+        // 成员的有效期
+        struct Expiry
+        {
+            uint64_t m_ulDeadline;// 到期刻度
+            uint64_t m_ulTimer;   // 有效定时器的编号
+            uint64_t m_ulTimerAt; // 有效定时器的到期刻度，不晚于 m_ulDeadline
+        };
+
+        const TtlConfig                m_stConfig;// 配置
+        const std::function<int64_t()> m_fnClock; // 当前时间(毫秒)
+        BasicLeaderboard<Access>       m_stBoard; // 排行榜，自带读写锁
+        Mutex                          m_stMutex; // 保护以下有效期状态，写操作持有它完成排行榜写入
+        std::unordered_map<std::string, Expiry, StringHash, std::equal_to<>> m_mapExpiry;// 榜上成员的有效期
+        TimerWheel<ExpiryTimer>        m_stWheel; // 到期时间轮
+        uint64_t                       m_ulNextTimer = 0;// 下一个定时器编号
+        // 清理状态，由 m_stReapMutex 保护
+        std::mutex                     m_stReapMutex;
+        std::vector<ExpiryTimer>       m_vecDue;  // 本次到期的定时器
+        std::vector<WriteOp>           m_vecOps;
+        std::vector<WriteResult>       m_vecResults;
+        uint64_t                       m_ulExpired = 0;// 累计过期删除的成员数
+        // 后台线程
+        std::mutex                     m_stThreadMutex;
+        std::condition_variable        m_stCond;
+        bool                           m_bStop = false;// 受 m_stThreadMutex 保护
+        std::thread                    m_stReaper;
+
+        static int64_t GetSteadyMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static TtlConfig Normalize(TtlConfig stConfig)
+        {
+            stConfig.m_uiTickMs = std::max<uint32_t>(stConfig.m_uiTickMs, 1);
+            stConfig.m_uiDefaultTtlMs = std::max<uint32_t>(stConfig.m_uiDefaultTtlMs, 1);
+            return stConfig;
+        }
+
+        uint64_t GetTick(int64_t llNowMs) const
+        {
+            return static_cast<uint64_t>(std::max<int64_t>(llNowMs, 0)) / m_stConfig.m_uiTickMs;
+        }
+
+        void ScheduleLocked(std::string_view svMember, Expiry& stExpiry, uint64_t ulAt)
+        {
+            stExpiry.m_ulTimer = m_ulNextTimer++;
+            stExpiry.m_ulTimerAt = ulAt;
+            m_stWheel.Schedule(ulAt, ExpiryTimer{ std::string(svMember), stExpiry.m_ulTimer });
+        }
+
+        // 写入后按成员是否在榜上更新有效期：在榜上时期限设为 现在 + 有效期，不在时删除记录；持有 m_stMutex 时调用
+        void SyncLocked(std::string_view svMember, uint32_t uiTtlMs)
+        {
+            double dScore = 0;
+            if (!m_stBoard.GetScore(svMember, dScore))
+            {
+                auto it = m_mapExpiry.find(svMember);
+                if (it != m_mapExpiry.end())
+                {
+                    m_mapExpiry.erase(it);
+                }
+                return;
+            }
+            if (uiTtlMs == 0)
+            {
+                uiTtlMs = m_stConfig.m_uiDefaultTtlMs;
+            }
+            int64_t llDeadlineMs = std::max<int64_t>(m_fnClock(), 0) + uiTtlMs;
+            // 向上取整，成员至少保留完整的有效期；时钟回拨时不早于时间轮的下一个刻度
+            uint64_t ulDeadline = std::max<uint64_t>(GetTick(llDeadlineMs + m_stConfig.m_uiTickMs - 1), m_stWheel.GetNow() + 1);
+            auto it = m_mapExpiry.find(svMember);
+            if (it == m_mapExpiry.end())
+            {
+                it = m_mapExpiry.emplace(std::string(svMember), Expiry()).first;
+                it->second.m_ulDeadline = ulDeadline;
+                ScheduleLocked(it->first, it->second, ulDeadline);
+                return;
+            }
+            it->second.m_ulDeadline = ulDeadline;
+            if (ulDeadline < it->second.m_ulTimerAt)
+            {
+                ScheduleLocked(it->first, it->second, ulDeadline);
+            }
+        }
+
+        void RunReaper()
+        {
+            std::unique_lock<std::mutex> stLock(m_stThreadMutex);
+            while (!m_bStop)
+            {
+                m_stCond.wait_for(stLock, std::chrono::milliseconds(m_stConfig.m_uiTickMs));
+                if (m_bStop)
+                {
+                    break;
+                }
+                stLock.unlock();
+                Reap();
+                stLock.lock();
+            }
+        }
+
+    public:
+        // fnClock 返回当前的毫秒时间，为空时使用单调时钟
+        explicit ExpiringBoard(const TtlConfig& stConfig, std::function<int64_t()> fnClock = nullptr)
+            : m_stConfig(Normalize(stConfig)), m_fnClock(fnClock ? std::move(fnClock) : std::function<int64_t()>(GetSteadyMs)),
+            m_stWheel(GetTick(m_fnClock()))
+        {
+        }
+
+        ExpiringBoard(const ExpiringBoard&) = delete;
+        ExpiringBoard& operator=(const ExpiringBoard&) = delete;
+
+        ~ExpiringBoard()
+        {
+            Stop();
+        }
+
+        // 启动后台清理线程，每个刻度清理一次
+        void Start()
+        {
+            static_assert(Access::CONCURRENT, "single-thread board has no reaper thread, call Reap instead");
+            m_stReaper = std::thread([this]() { RunReaper(); });
+        }
+
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> stLock(m_stThreadMutex);
+                m_bStop = true;
+            }
+            m_stCond.notify_one();
+            if (m_stReaper.joinable())
+            {
+                m_stReaper.join();
+            }
+        }
+
+        // 推进时间轮到当前刻度，删除到期的成员，返回删除的个数；用于不启动后台线程的场合
+        size_t Reap()
+        {
+            std::lock_guard<std::mutex> stReapLock(m_stReapMutex);
+            m_vecDue.clear();
+            uint64_t ulNow = 0;
+            {
+                std::unique_lock<Mutex> stLock(m_stMutex);
+                ulNow = std::max(GetTick(m_fnClock()), m_stWheel.GetNow());
+                m_stWheel.Advance(ulNow, [this](ExpiryTimer& stTimer) { m_vecDue.push_back(std::move(stTimer)); });
+            }
+
+            size_t ulExpired = 0;
+            for (size_t ulBegin = 0; ulBegin < m_vecDue.size(); ulBegin += REAP_BATCH)
+            {
+                size_t ulEnd = std::min(ulBegin + REAP_BATCH, m_vecDue.size());
+                std::unique_lock<Mutex> stLock(m_stMutex);
+                m_vecOps.clear();
+                for (size_t i = ulBegin; i < ulEnd; ++i)
+                {
+                    // 批次之间写操作可能已删除、续期或缩短了成员的有效期，在锁内重新判断
+                    ExpiryTimer& stTimer = m_vecDue[i];
+                    auto it = m_mapExpiry.find(stTimer.m_strMember);
+                    if (it == m_mapExpiry.end() || it->second.m_ulTimer != stTimer.m_ulId)
+                    {
+                        continue;
+                    }
+                    if (it->second.m_ulDeadline > ulNow)
+                    {
+                        ScheduleLocked(it->first, it->second, it->second.m_ulDeadline);
+                        continue;
+                    }
+                    m_mapExpiry.erase(it);
+                    // 写操作引用定时器中的名字，m_vecDue 在批量写之后才清空
+                    m_vecOps.push_back(WriteOp{ EWriteOp::Remove, stTimer.m_strMember, 0, AddOptions() });
+                }
+                if (!m_vecOps.empty())
+                {
+                    m_stBoard.ApplyBatch(m_vecOps, m_vecResults);
+                    ulExpired += m_vecOps.size();
+                }
+            }
+            m_ulExpired += ulExpired;
+            return ulExpired;
+        }
+
+        // 以下写操作的 uiTtlMs 为写入后成员的有效期，0 表示使用配置的默认值；写入后成员在榜上即刷新有效期
+
+        EAddResult Add(std::string_view svMember, double dScore, const AddOptions& stOptions = AddOptions(), uint32_t uiTtlMs = 0)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            EAddResult eResult = m_stBoard.Add(svMember, dScore, stOptions);
+            SyncLocked(svMember, uiTtlMs);
+            return eResult;
+        }
+
+        bool IncrBy(std::string_view svMember, double dDelta, double& dNewScore, uint32_t uiTtlMs = 0)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            bool bOk = m_stBoard.IncrBy(svMember, dDelta, dNewScore);
+            SyncLocked(svMember, uiTtlMs);
+            return bOk;
+        }
+
+        // 删除成员，时间轮上的定时器到期时发现没有记录即丢弃
+        bool Remove(std::string_view svMember)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            bool bRemoved = m_stBoard.Remove(svMember);
+            SyncLocked(svMember, 0);
+            return bRemoved;
+        }
+
+        void ApplyBatch(const std::vector<WriteOp>& vecOps, std::vector<WriteResult>& vecResults, uint32_t uiTtlMs = 0)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            m_stBoard.ApplyBatch(vecOps, vecResults);
+            for (const WriteOp& stOp : vecOps)
+            {
+                SyncLocked(stOp.m_svMember, uiTtlMs);
+            }
+        }
+
+        // 把榜上成员的有效期重设为 uiTtlMs，可以延长也可以缩短；成员不在榜上时返回false
+        bool Touch(std::string_view svMember, uint32_t uiTtlMs = 0)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            SyncLocked(svMember, uiTtlMs);
+            return m_mapExpiry.find(svMember) != m_mapExpiry.end();
+        }
+
+        // 成员剩余的有效期(毫秒)，按刻度取整；成员不在榜上时返回false
+        bool GetTtl(std::string_view svMember, int64_t& llRemainingMs)
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            auto it = m_mapExpiry.find(svMember);
+            if (it == m_mapExpiry.end())
+            {
+                return false;
+            }
+            int64_t llDeadlineMs = static_cast<int64_t>(it->second.m_ulDeadline * m_stConfig.m_uiTickMs);
+            llRemainingMs = std::max<int64_t>(llDeadlineMs - m_fnClock(), 0);
+            return true;
+        }
+
+        bool GetScore(std::string_view svMember, double& dScore)
+        {
+            return m_stBoard.GetScore(svMember, dScore);
+        }
+
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank)
+        {
+            return m_stBoard.GetRank(svMember, bReverse, ulRank);
+        }
+
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut)
+        {
+            m_stBoard.GetRange(llStart, llStop, bReverse, vecOut);
+        }
+
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax)
+        {
+            return m_stBoard.Count(stMin, stMax);
+        }
+
+        size_t Size()
+        {
+            return m_stBoard.Size();
+        }
+
+        // 时间轮上的定时器数，包括已失效还没到期的
+        size_t GetTimerCount()
+        {
+            std::unique_lock<Mutex> stLock(m_stMutex);
+            return m_stWheel.Size();
+        }
+
+        // 累计过期删除的成员数
+        uint64_t GetExpiredCount()
+        {
+            std::lock_guard<std::mutex> stLock(m_stReapMutex);
+            return m_ulExpired;
+        }
+};
+
+// 多线程共享的带有效期排行榜
+using TtlLeaderboard = ExpiringBoard<ConcurrentAccess>;
+// 只由一个线程访问的带有效期排行榜
+using LocalTtlLeaderboard = ExpiringBoard<SingleThreadAccess>;
@@ -0,0 +1,403 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 直接通过系统调用使用 io_uring，不依赖 liburing
+// 提交队列只由一个线程填写和提交，完成队列也只由该线程消费
+class IoUring
+{
+    private:
+        int m_iRingFd = -1;// io_uring 实例
+
+        // 提交队列
+        unsigned*     m_puiSqHead = nullptr;// 内核已消费到的位置
+        unsigned*     m_puiSqTail = nullptr;// 已发布给内核的位置
+        unsigned      m_uiSqMask = 0;
+        unsigned      m_uiSqEntries = 0;
+        io_uring_sqe* m_pstSqes = nullptr;
+        unsigned      m_uiSqeTail = 0;      // 本地已填写到的位置，Submit 时发布
+        unsigned      m_uiSubmitted = 0;    // 已经通过 io_uring_enter 提交到的位置
+
+        // 完成队列
+        unsigned*     m_puiCqHead = nullptr;
+        unsigned*     m_puiCqTail = nullptr;
+        unsigned      m_uiCqMask = 0;
+        io_uring_cqe* m_pstCqes = nullptr;
+
+        // 映射的内存
+        void*  m_pSqRing = MAP_FAILED;
+        size_t m_ulSqRingSize = 0;
+        void*  m_pCqRing = MAP_FAILED;
+        size_t m_ulCqRingSize = 0;
+        size_t m_ulSqesSize = 0;
+
+    public:
+        IoUring() = default;
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        ~IoUring()
+        {
+            Close();
+        }
+
+        // 创建 io_uring，uiCqEntries 为 0 时使用内核默认的完成队列长度；成功返回0，失败返回-errno
+        int Init(unsigned uiEntries, unsigned uiCqEntries, unsigned uiFlags)
+        {
+            io_uring_params stParams;
+            memset(&stParams, 0, sizeof(stParams));
+            stParams.flags = uiFlags;
+            if (uiCqEntries > 0)
+            {
+                stParams.flags |= IORING_SETUP_CQSIZE;
+                stParams.cq_entries = uiCqEntries;
+            }
+            m_iRingFd = static_cast<int>(syscall(__NR_io_uring_setup, uiEntries, &stParams));
+            if (m_iRingFd < 0)
+            {
+                return -errno;
+            }
+
+            m_ulSqRingSize = stParams.sq_off.array + stParams.sq_entries * sizeof(unsigned);
+            m_ulCqRingSize = stParams.cq_off.cqes + stParams.cq_entries * sizeof(io_uring_cqe);
+            bool bSingleMmap = (stParams.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (bSingleMmap)
+            {
+                m_ulSqRingSize = m_ulCqRingSize = m_ulSqRingSize > m_ulCqRingSize ? m_ulSqRingSize : m_ulCqRingSize;
+            }
+            m_pSqRing = mmap(nullptr, m_ulSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_SQ_RING);
+            if (m_pSqRing == MAP_FAILED)
+            {
+                int iError = errno;
+                Close();
+                return -iError;
+            }
+            if (bSingleMmap)
+            {
+                m_pCqRing = m_pSqRing;
+            }
+            else
+            {
+                m_pCqRing = mmap(nullptr, m_ulCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_CQ_RING);
+                if (m_pCqRing == MAP_FAILED)
+                {
+                    int iError = errno;
+                    Close();
+                    return -iError;
+                }
+            }
+            m_ulSqesSize = stParams.sq_entries * sizeof(io_uring_sqe);
+            void* pSqes = mmap(nullptr, m_ulSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_iRingFd, IORING_OFF_SQES);
+            if (pSqes == MAP_FAILED)
+            {
+                int iError = errno;
+                Close();
+                return -iError;
+            }
+            m_pstSqes = static_cast<io_uring_sqe*>(pSqes);
+
+            char* pSq = static_cast<char*>(m_pSqRing);
+            m_puiSqHead = reinterpret_cast<unsigned*>(pSq + stParams.sq_off.head);
+            m_puiSqTail = reinterpret_cast<unsigned*>(pSq + stParams.sq_off.tail);
+            m_uiSqMask = *reinterpret_cast<unsigned*>(pSq + stParams.sq_off.ring_mask);
+            m_uiSqEntries = *reinterpret_cast<unsigned*>(pSq + stParams.sq_off.ring_entries);
+            // SQE 按顺序使用，下标数组固定为恒等映射
+            unsigned* puiArray = reinterpret_cast<unsigned*>(pSq + stParams.sq_off.array);
+            for (unsigned i = 0; i < m_uiSqEntries; ++i)
+            {
+                puiArray[i] = i;
+            }
+            m_uiSqeTail = m_uiSubmitted = *m_puiSqTail;
+
+            char* pCq = static_cast<char*>(m_pCqRing);
+            m_puiCqHead = reinterpret_cast<unsigned*>(pCq + stParams.cq_off.head);
+            m_puiCqTail = reinterpret_cast<unsigned*>(pCq + stParams.cq_off.tail);
+            m_uiCqMask = *reinterpret_cast<unsigned*>(pCq + stParams.cq_off.ring_mask);
+            m_pstCqes = reinterpret_cast<io_uring_cqe*>(pCq + stParams.cq_off.cqes);
+            return 0;
+        }
+
+        void Close()
+        {
+            if (m_pstSqes != nullptr)
+            {
+                munmap(m_pstSqes, m_ulSqesSize);
+                m_pstSqes = nullptr;
+            }
+            if (m_pCqRing != MAP_FAILED && m_pCqRing != m_pSqRing)
+            {
+                munmap(m_pCqRing, m_ulCqRingSize);
+            }
+            m_pCqRing = MAP_FAILED;
+            if (m_pSqRing != MAP_FAILED)
+            {
+                munmap(m_pSqRing, m_ulSqRingSize);
+                m_pSqRing = MAP_FAILED;
+            }
+            if (m_iRingFd >= 0)
+            {
+                close(m_iRingFd);
+                m_iRingFd = -1;
+            }
+        }
+
+        int GetFd() const
+        {
+            return m_iRingFd;
+        }
+
+        // 取一个清零的 SQE，提交队列满时先把已填写的提交给内核
+        io_uring_sqe* GetSqe()
+        {
+            unsigned uiHead = __atomic_load_n(m_puiSqHead, __ATOMIC_ACQUIRE);
+            if (m_uiSqeTail - uiHead >= m_uiSqEntries)
+            {
+                if (Submit(0) < 0)
+                {
+                    return nullptr;
+                }
+                uiHead = __atomic_load_n(m_puiSqHead, __ATOMIC_ACQUIRE);
+                if (m_uiSqeTail - uiHead >= m_uiSqEntries)
+                {
+                    return nullptr;
+                }
+            }
+            io_uring_sqe* pstSqe = &m_pstSqes[m_uiSqeTail & m_uiSqMask];
+            memset(pstSqe, 0, sizeof(*pstSqe));
+            ++m_uiSqeTail;
+            return pstSqe;
+        }
+
+        // 发布已填写的 SQE 并用一次 io_uring_enter 全部提交，uiWaitNr 大于0时同时等待完成事件
+        // 返回提交的个数，失败返回-errno
+        int Submit(unsigned uiWaitNr)
+        {
+            __atomic_store_n(m_puiSqTail, m_uiSqeTail, __ATOMIC_RELEASE);
+            unsigned uiToSubmit = m_uiSqeTail - m_uiSubmitted;
+            if (uiToSubmit == 0 && uiWaitNr == 0)
+            {
+                return 0;
+            }
+            long lRet = syscall(__NR_io_uring_enter, m_iRingFd, uiToSubmit, uiWaitNr, uiWaitNr > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (lRet < 0)
+            {
+                return -errno;
+            }
+            m_uiSubmitted += static_cast<unsigned>(lRet);
+            return static_cast<int>(lRet);
+        }
+
+        // 依次处理已到达的完成事件，返回处理的个数
+        template<typename Fn>
+        unsigned ForEachCqe(Fn&& fnHandle)
+        {
+            unsigned uiHead = *m_puiCqHead;
+            unsigned uiTail = __atomic_load_n(m_puiCqTail, __ATOMIC_ACQUIRE);
+            unsigned uiCount = 0;
+            while (uiHead != uiTail)
+            {
+                // 先复制再归还槽位，处理函数中可以继续提交请求
+                io_uring_cqe stCqe = m_pstCqes[uiHead & m_uiCqMask];
+                ++uiHead;
+                __atomic_store_n(m_puiCqHead, uiHead, __ATOMIC_RELEASE);
+                fnHandle(stCqe);
+                ++uiCount;
+                if (uiHead == uiTail)
+                {
+                    uiTail = __atomic_load_n(m_puiCqTail, __ATOMIC_ACQUIRE);
+                }
+            }
+            return uiCount;
+        }
+
+        // io_uring_register，成功返回0，失败返回-errno
+        int Register(unsigned uiOpcode, void* pArg, unsigned uiCount)
+        {
+            long lRet = syscall(__NR_io_uring_register, m_iRingFd, uiOpcode, pArg, uiCount);
+            return lRet < 0 ? -errno : 0;
+        }
+
+        // 查询内核是否支持某个操作
+        bool IsOpSupported(uint8_t ucOp)
+        {
+            const unsigned uiOps = 256;
+            size_t ulSize = sizeof(io_uring_probe) + uiOps * sizeof(io_uring_probe_op);
+            io_uring_probe* pstProbe = static_cast<io_uring_probe*>(calloc(1, ulSize));
+            if (pstProbe == nullptr)
+            {
+                return false;
+            }
+            bool bSupported = Register(IORING_REGISTER_PROBE, pstProbe, uiOps) == 0 &&
+                ucOp <= pstProbe->last_op && (pstProbe->ops[ucOp].flags & IO_URING_OP_SUPPORTED) != 0;
+            free(pstProbe);
+            return bSupported;
+        }
+};
+
+// 提供给 io_uring 的接收缓冲区：接收时由内核从缓冲区组中挑选缓冲区，数据处理完后再归还
+// 优先使用注册的缓冲区环，归还只需写共享内存；不可用时用 IORING_OP_PROVIDE_BUFFERS 请求归还，随下一次提交批量发出
+class UringBufferRing
+{
+    private:
+        IoUring* m_pstUring = nullptr;         // 所属 io_uring
+        io_uring_buf_ring* m_pstRing = nullptr;// 与内核共享的缓冲区描述环，为空表示使用 PROVIDE_BUFFERS
+        size_t   m_ulRingSize = 0;
+        char*    m_pBuffers = nullptr;         // 全部缓冲区的连续内存
+        size_t   m_ulBuffersSize = 0;
+        size_t   m_ulBufferSize = 0;           // 单个缓冲区大小
+        unsigned m_uiEntries = 0;              // 缓冲区个数，2的幂
+        uint16_t m_usGroup = 0;                // 缓冲区组号
+        uint16_t m_usTail = 0;                 // 本地尾部，Publish 时发布给内核
+        uint64_t m_ulProvideUserData = 0;      // PROVIDE_BUFFERS 请求的 user_data
+        std::vector<uint16_t> m_vecReturned;   // 等待用 PROVIDE_BUFFERS 归还的缓冲区
+
+        // 提交一个 PROVIDE_BUFFERS 请求归还编号连续的 uiCount 个缓冲区
+        bool Provide(uint16_t usFirst, unsigned uiCount)
+        {
+            io_uring_sqe* pstSqe = m_pstUring->GetSqe();
+            if (pstSqe == nullptr)
+            {
+                return false;
+            }
+            pstSqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            pstSqe->fd = static_cast<int>(uiCount);
+            pstSqe->addr = reinterpret_cast<uint64_t>(GetBuffer(usFirst));
+            pstSqe->len = static_cast<uint32_t>(m_ulBufferSize);
+            pstSqe->off = usFirst;
+            pstSqe->buf_group = m_usGroup;
+            pstSqe->user_data = m_ulProvideUserData;
+            return true;
+        }
+
+    public:
+        UringBufferRing() = default;
+        UringBufferRing(const UringBufferRing&) = delete;
+        UringBufferRing& operator=(const UringBufferRing&) = delete;
+
+        ~UringBufferRing()
+        {
+            if (m_pstRing != nullptr)
+            {
+                munmap(m_pstRing, m_ulRingSize);
+            }
+            if (m_pBuffers != nullptr)
+            {
+                munmap(m_pBuffers, m_ulBuffersSize);
+            }
+        }
+
+        // 分配 uiEntries 个大小为 ulBufferSize 的缓冲区作为缓冲区组 usGroup
+        // bUseRing 为true时注册缓冲区环，否则通过 PROVIDE_BUFFERS 请求提供，请求的完成事件带 ulProvideUserData
+        // 成功返回0，失败返回-errno
+        int Init(IoUring& stRing, uint16_t usGroup, unsigned uiEntries, size_t ulBufferSize, bool bUseRing, uint64_t ulProvideUserData = 0)
+        {
+            m_pstUring = &stRing;
+            m_usGroup = usGroup;
+            m_uiEntries = uiEntries;
+            m_ulBufferSize = ulBufferSize;
+            m_ulProvideUserData = ulProvideUserData;
+            m_ulBuffersSize = uiEntries * ulBufferSize;
+            void* pBuffers = mmap(nullptr, m_ulBuffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pBuffers == MAP_FAILED)
+            {
+                m_pBuffers = nullptr;
+                return -errno;
+            }
+            m_pBuffers = static_cast<char*>(pBuffers);
+            if (!bUseRing)
+            {
+                m_vecReturned.reserve(uiEntries);
+                return Provide(0, uiEntries) ? 0 : -EBUSY;
+            }
+
+            m_ulRingSize = uiEntries * sizeof(io_uring_buf);
+            void* pRing = mmap(nullptr, m_ulRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pRing == MAP_FAILED)
+            {
+                return -errno;
+            }
+            m_pstRing = static_cast<io_uring_buf_ring*>(pRing);
+
+            io_uring_buf_reg stReg;
+            memset(&stReg, 0, sizeof(stReg));
+            stReg.ring_addr = reinterpret_cast<uint64_t>(m_pstRing);
+            stReg.ring_entries = uiEntries;
+            stReg.bgid = usGroup;
+            int iRet = stRing.Register(IORING_REGISTER_PBUF_RING, &stReg, 1);
+            if (iRet < 0)
+            {
+                return iRet;
+            }
+            for (unsigned i = 0; i < uiEntries; ++i)
+            {
+                Recycle(static_cast<uint16_t>(i));
+            }
+            Publish();
+            return 0;
+        }
+
+        bool IsRing() const
+        {
+            return m_pstRing != nullptr;
+        }
+
+        uint16_t GetGroup() const
+        {
+            return m_usGroup;
+        }
+
+        char* GetBuffer(uint16_t usId) const
+        {
+            return m_pBuffers + usId * m_ulBufferSize;
+        }
+
+        // 归还缓冲区，Publish 之后内核才能再次使用
+        void Recycle(uint16_t usId)
+        {
+            if (m_pstRing == nullptr)
+            {
+                m_vecReturned.push_back(usId);
+                return;
+            }
+            io_uring_buf& stBuf = m_pstRing->bufs[m_usTail & (m_uiEntries - 1)];
+            stBuf.addr = reinterpret_cast<uint64_t>(GetBuffer(usId));
+            stBuf.len = static_cast<uint32_t>(m_ulBufferSize);
+            stBuf.bid = usId;
+            ++m_usTail;
+        }
+
+        // 一次发布所有归还的缓冲区；PROVIDE_BUFFERS 方式下编号连续的缓冲区合并为一个请求
+        void Publish()
+        {
+            if (m_pstRing != nullptr)
+            {
+                __atomic_store_n(&m_pstRing->tail, m_usTail, __ATOMIC_RELEASE);
+                return;
+            }
+            size_t ulCount = m_vecReturned.size();
+            size_t i = 0;
+            while (i < ulCount)
+            {
+                size_t j = i + 1;
+                while (j < ulCount && m_vecReturned[j] == m_vecReturned[j - 1] + 1)
+                {
+                    ++j;
+                }
+                if (!Provide(m_vecReturned[i], static_cast<unsigned>(j - i)))
+                {
+                    break;
+                }
+                i = j;
+            }
+            m_vecReturned.erase(m_vecReturned.begin(), m_vecReturned.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+};
@@ -0,0 +1,566 @@
+#include "uring_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "resp.h"
+
+const unsigned URING_SQ_ENTRIES = 1024;          // 提交队列长度
+const unsigned URING_CQ_ENTRIES = 16384;         // 完成队列长度，多发请求会连续产生完成事件
+const unsigned URING_BUFFER_COUNT = 1024;        // 接收缓冲区个数，2的幂
+const size_t URING_BUFFER_SIZE = 16 * 1024;      // 单个接收缓冲区大小
+const uint16_t URING_BUFFER_GROUP = 0;           // 接收缓冲区组号
+const size_t URING_MAX_QUERY = 1024 * 1024 * 1024;// 单连接未解析数据上限
+const size_t URING_MAX_SEND = 1024 * 1024 * 1024; // 单次 send 的字节数上限
+const size_t URING_MAX_INPUT_PER_PASS = 1024 * 1024;// 一次最多执行的输入字节数，余下的留给下一轮事件循环，限制一批命令产生的回复量
+const long URING_TICK_NS = 100 * 1000 * 1000;    // 检查退出标志的间隔
+
+// 单一提交线程和协作式任务执行可以减少内核侧的同步和中断，旧内核不支持时去掉这些标志重试
+static int InitRing(IoUring& stRing, unsigned uiEntries, unsigned uiCqEntries)
+{
+    int iRet = stRing.Init(uiEntries, uiCqEntries, IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN);
+    if (iRet == -EINVAL)
+    {
+        iRet = stRing.Init(uiEntries, uiCqEntries, 0);
+    }
+    return iRet;
+}
+
+UringRankingServer::UringRankingServer(const ServerConfig& stConfig, RankingService& stService) : m_stConfig(stConfig), m_stService(stService)
+{
+    memset(&m_stTick, 0, sizeof(m_stTick));
+    m_stTick.tv_nsec = URING_TICK_NS;
+}
+
+UringRankingServer::~UringRankingServer()
+{
+    // 先关闭 io_uring 取消所有在途请求，再关闭套接字和释放缓冲区
+    m_stRing.Close();
+    for (auto& stPair : m_mapConnections)
+    {
+        close(stPair.first);
+    }
+    if (m_iListenFd >= 0)
+    {
+        close(m_iListenFd);
+    }
+}
+
+bool UringRankingServer::IsSupported()
+{
+    IoUring stRing;
+    if (InitRing(stRing, 8, 0) < 0)
+    {
+        return false;
+    }
+    // 多发 recv 与 SEND_ZC 在同一内核版本(6.0)引入，探测不到 SEND_ZC 时认为不支持多发 recv
+    return stRing.IsOpSupported(IORING_OP_ACCEPT) && stRing.IsOpSupported(IORING_OP_RECV) &&
+        stRing.IsOpSupported(IORING_OP_SEND) && stRing.IsOpSupported(IORING_OP_TIMEOUT) &&
+        stRing.IsOpSupported(IORING_OP_PROVIDE_BUFFERS) && stRing.IsOpSupported(IORING_OP_SEND_ZC);
+}
+
+// 注册缓冲区环成功不代表内核能从中取到缓冲区(部分内核/沙箱上接收总是返回 ENOBUFS)，用一对本地套接字实际接收一次来确认
+bool UringRankingServer::BufferRingWorks()
+{
+    IoUring stRing;
+    UringBufferRing stBuffers;
+    if (InitRing(stRing, 8, 0) < 0 || stBuffers.Init(stRing, URING_BUFFER_GROUP, 1, 64, true) < 0)
+    {
+        return false;
+    }
+    int aiFds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, aiFds) != 0)
+    {
+        return false;
+    }
+    bool bWorks = false;
+    io_uring_sqe* pstSqe = stRing.GetSqe();
+    if (write(aiFds[1], "", 1) == 1 && pstSqe != nullptr)
+    {
+        pstSqe->opcode = IORING_OP_RECV;
+        pstSqe->fd = aiFds[0];
+        pstSqe->flags = IOSQE_BUFFER_SELECT;
+        pstSqe->buf_group = stBuffers.GetGroup();
+        if (stRing.Submit(1) == 1)
+        {
+            stRing.ForEachCqe([&bWorks](const io_uring_cqe& stCqe)
+            {
+                bWorks = stCqe.res == 1 && (stCqe.flags & IORING_CQE_F_BUFFER);
+            });
+        }
+    }
+    close(aiFds[0]);
+    close(aiFds[1]);
+    return bWorks;
+}
+
+bool UringRankingServer::Start()
+{
+    int iRet = InitRing(m_stRing, URING_SQ_ENTRIES, URING_CQ_ENTRIES);
+    if (iRet < 0)
+    {
+        std::cerr << "io_uring_setup: " << strerror(-iRet) << std::endl;
+        return false;
+    }
+    iRet = m_stBuffers.Init(m_stRing, URING_BUFFER_GROUP, URING_BUFFER_COUNT, URING_BUFFER_SIZE,
+        BufferRingWorks(), MakeUserData(EUringOp::ProvideBuffers, 0));
+    if (iRet < 0)
+    {
+        std::cerr << "io_uring provide buffers: " << strerror(-iRet) << std::endl;
+        return false;
+    }
+    m_iListenFd = CreateListenSocket(m_stConfig);
+    return m_iListenFd >= 0;
+}
+
+void UringRankingServer::Run(const std::atomic<bool>& bStop)
+{
+    ArmAccept();
+    ArmTimeout();
+    while (!bStop.load(std::memory_order_relaxed))
+    {
+        // 上一轮完成事件中产生的请求在这里一次提交，同时等待新的完成事件；有推迟的工作时不等待
+        bool bDeferred = m_bAcceptRetry || m_bTimeoutRetry || !m_vecDeferred.empty();
+        int iRet = m_stRing.Submit(bDeferred ? 0 : 1);
+        if (iRet < 0 && iRet != -EINTR && iRet != -EAGAIN && iRet != -EBUSY)
+        {
+            std::cerr << "io_uring_enter: " << strerror(-iRet) << std::endl;
+            return;
+        }
+        m_stRing.ForEachCqe([this](const io_uring_cqe& stCqe)
+        {
+            HandleCompletion(stCqe);
+        });
+        // 本轮处理完的接收缓冲区一次归还给内核
+        m_stBuffers.Publish();
+        RunDeferred();
+    }
+}
+
+void UringRankingServer::Defer(Connection& stConn)
+{
+    m_vecDeferred.push_back(stConn.m_iFd);
+}
+
+void UringRankingServer::RunDeferred()
+{
+    if (m_bAcceptRetry)
+    {
+        m_bAcceptRetry = false;
+        ArmAccept();
+    }
+    if (m_bTimeoutRetry)
+    {
+        m_bTimeoutRetry = false;
+        ArmTimeout();
+    }
+    std::vector<int> vecFds;
+    vecFds.swap(m_vecDeferred);
+    for (int iFd : vecFds)
+    {
+        // 连接可能已经释放，套接字也可能已被新连接复用，标志都在连接上，新连接的标志为空
+        auto it = m_mapConnections.find(iFd);
+        if (it == m_mapConnections.end())
+        {
+            continue;
+        }
+        Connection& stConn = *it->second;
+        if (stConn.m_bShutdown)
+        {
+            stConn.m_bRecvRetry = stConn.m_bSendRetry = stConn.m_bInputDeferred = false;
+            continue;
+        }
+        if (stConn.m_bSendRetry)
+        {
+            stConn.m_bSendRetry = false;
+            SubmitSend(stConn);
+        }
+        if (stConn.m_bRecvRetry && !stConn.m_bRecvPaused && !stConn.m_bRecvArmed)
+        {
+            ArmRecv(stConn);
+        }
+        if (stConn.m_bInputDeferred && !stConn.m_bRecvPaused)
+        {
+            // ProcessInput 可能关闭并释放连接，放在最后
+            stConn.m_bInputDeferred = false;
+            if (!stConn.m_bClosing && !stConn.m_strIn.empty())
+            {
+                ProcessInput(stConn, nullptr, 0);
+            }
+        }
+    }
+}
+
+void UringRankingServer::HandleCompletion(const io_uring_cqe& stCqe)
+{
+    EUringOp eOp = static_cast<EUringOp>(stCqe.user_data >> 32);
+    int iFd = static_cast<int>(static_cast<uint32_t>(stCqe.user_data));
+    switch (eOp)
+    {
+        case EUringOp::Accept:
+            HandleAccept(stCqe);
+            return;
+        case EUringOp::Timeout:
+            m_stService.EvictIdleBoards();
+            ArmTimeout();
+            return;
+        case EUringOp::ProvideBuffers:
+            if (stCqe.res < 0)
+            {
+                std::cerr << "io_uring provide buffers: " << strerror(-stCqe.res) << std::endl;
+            }
+            return;
+        case EUringOp::Cancel:
+            // 取消的结果体现在 recv 的最后一个完成事件上
+            return;
+        case EUringOp::Recv:
+        case EUringOp::Send:
+            break;
+        default:
+            return;
+    }
+
+    auto it = m_mapConnections.find(iFd);
+    if (it != m_mapConnections.end())
+    {
+        if (eOp == EUringOp::Recv)
+        {
+            HandleRecv(*it->second, stCqe);
+        }
+        else
+        {
+            HandleSend(*it->second, stCqe);
+        }
+    }
+    // 处理完的数据已复制或执行完毕，缓冲区立即归还
+    if (eOp == EUringOp::Recv && (stCqe.flags & IORING_CQE_F_BUFFER))
+    {
+        m_stBuffers.Recycle(static_cast<uint16_t>(stCqe.flags >> IORING_CQE_BUFFER_SHIFT));
+    }
+}
+
+void UringRankingServer::ArmAccept()
+{
+    // GetSqe 在队列满时已经提交过一次，仍取不到说明内核暂时不接收新请求，下一轮重试
+    io_uring_sqe* pstSqe = m_stRing.GetSqe();
+    if (pstSqe == nullptr)
+    {
+        m_bAcceptRetry = true;
+        return;
+    }
+    pstSqe->opcode = IORING_OP_ACCEPT;
+    pstSqe->fd = m_iListenFd;
+    pstSqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    pstSqe->accept_flags = SOCK_CLOEXEC;
+    pstSqe->user_data = MakeUserData(EUringOp::Accept, m_iListenFd);
+}
+
+void UringRankingServer::ArmRecv(Connection& stConn)
+{
+    io_uring_sqe* pstSqe = m_stRing.GetSqe();
+    if (pstSqe == nullptr)
+    {
+        stConn.m_bRecvRetry = true;
+        Defer(stConn);
+        return;
+    }
+    pstSqe->opcode = IORING_OP_RECV;
+    pstSqe->fd = stConn.m_iFd;
+    pstSqe->ioprio = IORING_RECV_MULTISHOT;
+    pstSqe->flags = IOSQE_BUFFER_SELECT;
+    pstSqe->buf_group = m_stBuffers.GetGroup();
+    pstSqe->user_data = MakeUserData(EUringOp::Recv, stConn.m_iFd);
+    stConn.m_bRecvArmed = true;
+    stConn.m_bRecvRetry = false;
+}
+
+void UringRankingServer::ArmTimeout()
+{
+    io_uring_sqe* pstSqe = m_stRing.GetSqe();
+    if (pstSqe == nullptr)
+    {
+        m_bTimeoutRetry = true;
+        return;
+    }
+    pstSqe->opcode = IORING_OP_TIMEOUT;
+    pstSqe->fd = -1;
+    pstSqe->addr = reinterpret_cast<uint64_t>(&m_stTick);
+    pstSqe->len = 1;
+    pstSqe->user_data = MakeUserData(EUringOp::Timeout, 0);
+}
+
+void UringRankingServer::CancelRecv(Connection& stConn)
+{
+    io_uring_sqe* pstSqe = m_stRing.GetSqe();
+    if (pstSqe == nullptr)
+    {
+        // 取消不了时 recv 继续进行，收到的数据先存入输入缓冲区，下一个完成事件再尝试取消
+        return;
+    }
+    pstSqe->opcode = IORING_OP_ASYNC_CANCEL;
+    pstSqe->fd = -1;
+    pstSqe->addr = MakeUserData(EUringOp::Recv, stConn.m_iFd);
+    pstSqe->user_data = MakeUserData(EUringOp::Cancel, stConn.m_iFd);
+    stConn.m_bRecvCancelled = true;
+}
+
+void UringRankingServer::UpdateRecvPause(Connection& stConn)
+{
+    // 客户端只发不收时回复会在 m_strOut 中无限堆积，超过上限后不再接收新命令，由 TCP 流控让客户端停下
+    size_t ulPending = stConn.m_strOut.size() + stConn.m_strSending.size() - stConn.m_ulSendPos;
+    bool bPause = ulPending > m_stConfig.m_ulMaxPendingOutput;
+    if (bPause == stConn.m_bRecvPaused || stConn.m_bShutdown)
+    {
+        return;
+    }
+    stConn.m_bRecvPaused = bPause;
+    if (bPause)
+    {
+        if (stConn.m_bRecvArmed && !stConn.m_bRecvCancelled)
+        {
+            CancelRecv(stConn);
+        }
+        return;
+    }
+    // 恢复：先执行暂停期间存下的输入，recv 已结束时重新发起
+    if (!stConn.m_strIn.empty())
+    {
+        stConn.m_bInputDeferred = true;
+        Defer(stConn);
+    }
+    if (!stConn.m_bRecvArmed)
+    {
+        ArmRecv(stConn);
+    }
+}
+
+void UringRankingServer::HandleAccept(const io_uring_cqe& stCqe)
+{
+    if (stCqe.res >= 0)
+    {
+        int iFd = stCqe.res;
+        int iOn = 1;
+        setsockopt(iFd, IPPROTO_TCP, TCP_NODELAY, &iOn, sizeof(iOn));
+        std::unique_ptr<Connection> pConn(new Connection());
+        pConn->m_iFd = iFd;
+        Connection& stConn = *pConn;
+        m_mapConnections[iFd] = std::move(pConn);
+        ArmRecv(stConn);
+    }
+    else if (stCqe.res != -EAGAIN && stCqe.res != -EINTR && stCqe.res != -ECONNABORTED)
+    {
+        std::cerr << "accept: " << strerror(-stCqe.res) << std::endl;
+    }
+    // 多发 accept 被内核终止时重新发起
+    if (!(stCqe.flags & IORING_CQE_F_MORE))
+    {
+        ArmAccept();
+    }
+}
+
+void UringRankingServer::HandleRecv(Connection& stConn, const io_uring_cqe& stCqe)
+{
+    // 处理数据时 recv 仍视为在途，保证处理中关闭连接也不会释放它
+    if (stCqe.res > 0 && (stCqe.flags & IORING_CQE_F_BUFFER))
+    {
+        if (!stConn.m_bClosing && !stConn.m_bShutdown)
+        {
+            uint16_t usId = static_cast<uint16_t>(stCqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            const char* pData = m_stBuffers.GetBuffer(usId);
+            if (stConn.m_bRecvPaused || stConn.m_bInputDeferred)
+            {
+                // 暂停后、取消生效前到达的数据，以及排在推迟的命令之后的数据，只存入输入缓冲区，保持命令顺序
+                stConn.m_strIn.append(pData, static_cast<size_t>(stCqe.res));
+                if (stConn.m_strIn.size() > URING_MAX_QUERY)
+                {
+                    CloseConnection(stConn);
+                }
+                else if (stConn.m_bRecvPaused && !stConn.m_bRecvCancelled && (stCqe.flags & IORING_CQE_F_MORE))
+                {
+                    CancelRecv(stConn);
+                }
+            }
+            else
+            {
+                ProcessInput(stConn, pData, static_cast<size_t>(stCqe.res));
+            }
+        }
+    }
+    else if (stCqe.res != -ENOBUFS && !(stCqe.res == -ECANCELED && stConn.m_bRecvCancelled))
+    {
+        // 对端关闭或出错；ENOBUFS 只是缓冲区暂时用完，归还后重新发起即可；ECANCELED 是暂停接收时主动取消的
+        CloseConnection(stConn);
+    }
+
+    if (stCqe.flags & IORING_CQE_F_MORE)
+    {
+        return;
+    }
+    stConn.m_bRecvArmed = false;
+    stConn.m_bRecvCancelled = false;
+    if (stConn.m_bShutdown)
+    {
+        ReleaseIfIdle(stConn);
+        return;
+    }
+    if (!stConn.m_bRecvPaused)
+    {
+        ArmRecv(stConn);
+    }
+}
+
+void UringRankingServer::ProcessInput(Connection& stConn, const char* pData, size_t ulLen)
+{
+    // 没有残留数据时直接在接收缓冲区上解析，省去一次复制
+    bool bDirect = stConn.m_strIn.empty();
+    if (!bDirect)
+    {
+        stConn.m_strIn.append(pData, ulLen);
+        pData = stConn.m_strIn.data();
+        ulLen = stConn.m_strIn.size();
+    }
+
+    // 恢复接收后输入缓冲区中可能积压了大量命令，一次只执行开头一段；开头一条命令就超过这一段时整条解析
+    size_t ulWindow = ulLen < URING_MAX_INPUT_PER_PASS ? ulLen : URING_MAX_INPUT_PER_PASS;
+    m_stBatch.m_ulCount = 0;
+    size_t ulConsumed = 0;
+    ERespParse eParse = ParseCommandBatch(pData, ulWindow, m_stBatch, ulConsumed);
+    if (eParse != ERespParse::Error && ulConsumed == 0 && ulWindow < ulLen)
+    {
+        ulWindow = ulLen;
+        eParse = ParseCommandBatch(pData, ulWindow, m_stBatch, ulConsumed);
+    }
+    bool bProtocolError = eParse == ERespParse::Error;
+    if (m_stBatch.m_ulCount > 0)
+    {
+        if (!m_stService.ExecuteBatch(m_stBatch, m_stReplies))
+        {
+            stConn.m_bClosing = true;
+        }
+        m_stReplies.AppendTo(stConn.m_strOut);
+    }
+    if (bProtocolError && !stConn.m_bClosing)
+    {
+        RespAppendError(stConn.m_strOut, "ERR Protocol error");
+        stConn.m_bClosing = true;
+    }
+
+    // 不完整的命令留到下次接收
+    if (bDirect)
+    {
+        stConn.m_strIn.assign(pData + ulConsumed, ulLen - ulConsumed);
+    }
+    else
+    {
+        stConn.m_strIn.erase(0, ulConsumed);
+    }
+    if (stConn.m_strIn.size() > URING_MAX_QUERY)
+    {
+        CloseConnection(stConn);
+        return;
+    }
+    if (ulWindow < ulLen && !stConn.m_bClosing)
+    {
+        stConn.m_bInputDeferred = true;
+        Defer(stConn);
+    }
+    UpdateRecvPause(stConn);
+    StartSend(stConn);
+}
+
+void UringRankingServer::StartSend(Connection& stConn)
+{
+    if (stConn.m_bSending || stConn.m_bSendRetry || stConn.m_bShutdown)
+    {
+        return;
+    }
+    if (stConn.m_strOut.empty())
+    {
+        if (stConn.m_bClosing)
+        {
+            CloseConnection(stConn);
+        }
+        return;
+    }
+    // 发送期间新产生的回复继续追加到 m_strOut，本次发送完成后再发
+    stConn.m_strSending.swap(stConn.m_strOut);
+    stConn.m_strOut.clear();
+    stConn.m_ulSendPos = 0;
+
+    SubmitSend(stConn);
+}
+
+void UringRankingServer::SubmitSend(Connection& stConn)
+{
+    io_uring_sqe* pstSqe = m_stRing.GetSqe();
+    if (pstSqe == nullptr)
+    {
+        stConn.m_bSendRetry = true;
+        Defer(stConn);
+        return;
+    }
+    size_t ulLen = stConn.m_strSending.size() - stConn.m_ulSendPos;
+    pstSqe->opcode = IORING_OP_SEND;
+    pstSqe->fd = stConn.m_iFd;
+    pstSqe->addr = reinterpret_cast<uint64_t>(stConn.m_strSending.data() + stConn.m_ulSendPos);
+    pstSqe->len = static_cast<uint32_t>(ulLen < URING_MAX_SEND ? ulLen : URING_MAX_SEND);
+    pstSqe->msg_flags = MSG_NOSIGNAL;
+    pstSqe->user_data = MakeUserData(EUringOp::Send, stConn.m_iFd);
+    stConn.m_bSending = true;
+}
+
+void UringRankingServer::HandleSend(Connection& stConn, const io_uring_cqe& stCqe)
+{
+    stConn.m_bSending = false;
+    if (stConn.m_bShutdown)
+    {
+        ReleaseIfIdle(stConn);
+        return;
+    }
+    if (stCqe.res < 0)
+    {
+        CloseConnection(stConn);
+        return;
+    }
+    stConn.m_ulSendPos += static_cast<size_t>(stCqe.res);
+    if (stConn.m_ulSendPos < stConn.m_strSending.size())
+    {
+        // 只发出了一部分，继续发送剩余的数据
+        SubmitSend(stConn);
+        UpdateRecvPause(stConn);
+        return;
+    }
+    stConn.m_strSending.clear();
+    stConn.m_ulSendPos = 0;
+    // StartSend 可能关闭并释放连接，放在最后
+    UpdateRecvPause(stConn);
+    StartSend(stConn);
+}
+
+void UringRankingServer::CloseConnection(Connection& stConn)
+{
+    if (!stConn.m_bShutdown)
+    {
+        // shutdown 让在途的 recv/send 尽快完成，套接字本身等它们结束后再关闭
+        shutdown(stConn.m_iFd, SHUT_RDWR);
+        stConn.m_bShutdown = true;
+    }
+    ReleaseIfIdle(stConn);
+}
+
+void UringRankingServer::ReleaseIfIdle(Connection& stConn)
+{
+    if (!stConn.m_bShutdown || stConn.m_bRecvArmed || stConn.m_bSending)
+    {
+        return;
+    }
+    int iFd = stConn.m_iFd;
+    close(iFd);
+    m_mapConnections.erase(iFd);
+}
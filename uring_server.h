@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/time_types.h>
+
+#include "ranking_service.h"
+#include "server.h"
+#include "uring.h"
+
+// 基于 io_uring 的单线程 RESP 服务器
+// 多发 accept/recv 只需提交一次请求，接收数据落在预先提供给内核的缓冲区中；
+// 一轮完成事件中产生的所有请求合并为一次 io_uring_enter 提交，命令在收割完成事件的线程上直接执行
+class UringRankingServer
+{
+    private:
+        // 客户端连接，关闭时先 shutdown，等所有在途请求完成后才 close，保证套接字不会被复用
+        struct Connection
+        {
+            int         m_iFd = -1;            // 套接字
+            std::string m_strIn;               // 未解析的输入数据
+            std::string m_strOut;              // 等待发送的回复
+            std::string m_strSending;          // 正在发送的回复，发送完成前不能修改
+            size_t      m_ulSendPos = 0;       // 已发送到的位置
+            bool        m_bRecvArmed = false;  // 多发 recv 是否仍在进行
+            bool        m_bRecvPaused = false; // 待发送回复超过上限，不再接收新数据，发送到上限以下再恢复
+            bool        m_bRecvCancelled = false;// 已请求取消多发 recv，等待它的最后一个完成事件
+            bool        m_bInputDeferred = false;// 输入缓冲区中还有未执行的命令，留到下一轮事件循环
+            bool        m_bRecvRetry = false;  // 提交队列满没能发起 recv，下一轮事件循环重试
+            bool        m_bSendRetry = false;  // 提交队列满没能发起 send，下一轮事件循环重试
+            bool        m_bSending = false;    // 是否有在途的 send
+            bool        m_bClosing = false;    // 回复发完后关闭
+            bool        m_bShutdown = false;   // 已 shutdown，等待在途请求结束
+        };
+
+        // 请求类型，编码在 user_data 的高位
+        enum class EUringOp : uint64_t
+        {
+            Accept = 1,
+            Recv,
+            Send,
+            Timeout,
+            ProvideBuffers,
+            Cancel,
+        };
+
+        const ServerConfig m_stConfig;      // 配置
+        RankingService&    m_stService;     // 命令服务
+        int                m_iListenFd = -1;// 监听套接字
+        UringBufferRing    m_stBuffers;     // 接收缓冲区，须在 io_uring 关闭之后释放
+        IoUring            m_stRing;        // io_uring 实例
+        __kernel_timespec  m_stTick;        // 定期检查退出标志的超时，请求完成前须保持有效
+        std::unordered_map<int, std::unique_ptr<Connection>> m_mapConnections;// 套接字到连接
+        CommandBatch       m_stBatch;       // 解析出的流水线命令，跨完成事件复用
+        ReplyBuffer        m_stReplies;     // 批量执行的回复，跨完成事件复用
+        std::vector<int>   m_vecDeferred;   // 有推迟到下一轮事件循环的工作(重试提交、执行剩余输入)的连接
+        bool               m_bAcceptRetry = false; // 提交队列满没能发起 accept，下一轮事件循环重试
+        bool               m_bTimeoutRetry = false;// 提交队列满没能发起定时器，下一轮事件循环重试
+
+        static uint64_t MakeUserData(EUringOp eOp, int iFd)
+        {
+            return (static_cast<uint64_t>(eOp) << 32) | static_cast<uint32_t>(iFd);
+        }
+
+        void ArmAccept();
+        void ArmRecv(Connection& stConn);
+        void ArmTimeout();
+        // 取消连接的多发 recv，最后一个完成事件到达前 recv 仍视为在途
+        void CancelRecv(Connection& stConn);
+        // 待发送回复超过上限时暂停接收，回到上限以下时恢复
+        void UpdateRecvPause(Connection& stConn);
+        void Defer(Connection& stConn);
+        // 执行上一轮推迟的工作
+        void RunDeferred();
+        // 有待发送的回复且没有在途 send 时发起发送
+        void StartSend(Connection& stConn);
+        // 提交 m_strSending 中剩余数据的 send
+        void SubmitSend(Connection& stConn);
+
+        void HandleCompletion(const io_uring_cqe& stCqe);
+        void HandleAccept(const io_uring_cqe& stCqe);
+        void HandleRecv(Connection& stConn, const io_uring_cqe& stCqe);
+        void HandleSend(Connection& stConn, const io_uring_cqe& stCqe);
+        // 解析并执行 pData 中的命令，不完整的尾部保存到连接的输入缓冲区；
+        // 一次最多执行 URING_MAX_INPUT_PER_PASS 字节的命令，余下的推迟到下一轮事件循环
+        void ProcessInput(Connection& stConn, const char* pData, size_t ulLen);
+        // 开始关闭连接，在途请求都完成后释放
+        void CloseConnection(Connection& stConn);
+        void ReleaseIfIdle(Connection& stConn);
+
+    public:
+        UringRankingServer(const ServerConfig& stConfig, RankingService& stService);
+        UringRankingServer(const UringRankingServer&) = delete;
+        UringRankingServer& operator=(const UringRankingServer&) = delete;
+        ~UringRankingServer();
+
+        // 检查内核是否支持本服务器需要的 io_uring 特性(多发 accept/recv、提供缓冲区)
+        static bool IsSupported();
+        // 用一对本地套接字实际接收一次，确认内核能从注册的缓冲区环取到缓冲区；否则改用 PROVIDE_BUFFERS 提供缓冲区
+        static bool BufferRingWorks();
+
+        // 创建 io_uring 并绑定监听端口，失败时输出原因并返回false
+        // io_uring 以 IORING_SETUP_SINGLE_ISSUER 创建，只有创建它的线程能提交，Start 与 Run 须在同一线程调用
+        bool Start();
+        // 运行事件循环直到 bStop 被置位
+        void Run(const std::atomic<bool>& bStop);
+};
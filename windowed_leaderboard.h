@@ -0,0 +1,424 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "leaderboard.h"
+
+// 时间窗口配置
+struct WindowConfig
+{
+    int64_t m_llLengthMs = 86400000;// 窗口长度(毫秒)，日榜为一天，周榜为七天
+    int64_t m_llOriginMs = 0;       // 某个窗口的起点(Unix 毫秒)，用来对齐时区和重置日：东八区零点重置取 -8 小时，
+                                    // 周一重置的周榜取 1970-01-05(周一)加时区偏移
+    size_t  m_ulRetain = 1;         // 结束后保留供查询的窗口数，例如查询昨日榜、上周榜
+};
+
+// 按时间窗口重置的排行榜(日榜、周榜)
+// 当前窗口通过原子裸指针发布，每个请求先取当前窗口：到了新窗口就新建一个空排行榜替换指针，
+// 空排行榜只有紧凑索引，替换是O(1)的；结束的窗口冻结只读，保留 m_ulRetain 个，更早的交给后台线程，
+// 等没有请求还在使用时才析构，逐个释放节点的开销不落在请求线程上
+// 请求是否还在使用由纪元判断：请求进入时在自己的读者槽中登记当前纪元，窗口被替换时纪元加一并记在窗口上，
+// 所有槽都空闲或登记的纪元不早于该值时，不会再有请求持有它的指针；
+// 读当前窗口只有读者槽上的一次 CAS 和两次原子读写，不加锁也不修改共享的引用计数
+// (libstdc++ 12 的 atomic<shared_ptr> 内部用自旋锁位实现，并不是无锁的)
+// 线程多于读者槽、槽被占用时退化为在锁内复制窗口的 shared_ptr
+// 边界处已取到旧窗口的写入仍落在旧窗口，视为发生在边界之前
+// 不启动后台线程时由调用方调用 Reap 释放过期窗口
+class WindowedLeaderboard
+{
+    private:
+        // 一个时间窗口的排行榜
+        struct Window
+        {
+            const int64_t m_llIndex;// 窗口序号，(时间 - 起点) / 长度 向下取整
+            Leaderboard   m_stBoard;// 窗口内的排行榜
+            uint64_t      m_ulUnpublishEpoch = 0;// 不再是当前窗口时的纪元，受 m_stMutex 保护
+
+            explicit Window(int64_t llIndex) : m_llIndex(llIndex)
+            {
+            }
+        };
+
+        // 读者槽：请求期间登记进入时的纪元，0 表示空闲；各占一个缓存行
+        struct alignas(64) ReaderSlot
+        {
+            std::atomic<uint64_t> m_ulEpoch{ 0 };
+        };
+
+        // 读者槽个数，线程按领取的编号取模使用
+        static constexpr size_t READER_SLOTS = 64;
+
+        // 请求期间保护窗口不被释放：占用本线程的读者槽，槽被共用它的线程占着时改为持有窗口的引用
+        class ReadGuard
+        {
+            private:
+                WindowedLeaderboard&    m_stOwner;
+                ReaderSlot*             m_pSlot = nullptr;// 占用的读者槽，为空表示走了加锁路径
+                std::shared_ptr<Window> m_pHold;          // 加锁路径持有的当前窗口
+
+            public:
+                explicit ReadGuard(WindowedLeaderboard& stOwner) : m_stOwner(stOwner)
+                {
+                    ReaderSlot& stSlot = stOwner.m_pSlots[GetThreadSlot()];
+                    uint64_t ulIdle = 0;
+                    if (stSlot.m_ulEpoch.compare_exchange_strong(ulIdle, stOwner.m_ulEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst))
+                    {
+                        m_pSlot = &stSlot;
+                    }
+                }
+
+                ReadGuard(const ReadGuard&) = delete;
+                ReadGuard& operator=(const ReadGuard&) = delete;
+
+                ~ReadGuard()
+                {
+                    if (m_pSlot != nullptr)
+                    {
+                        m_pSlot->m_ulEpoch.store(0, std::memory_order_release);
+                    }
+                }
+
+                // 当前窗口，守护对象存在期间有效
+                Window* GetCurrent()
+                {
+                    if (m_pSlot != nullptr)
+                    {
+                        return m_stOwner.m_pCurrent.load(std::memory_order_seq_cst);
+                    }
+                    std::lock_guard<std::mutex> stLock(m_stOwner.m_stMutex);
+                    m_pHold = m_stOwner.m_pCurrentOwner;
+                    return m_pHold.get();
+                }
+
+                // 切换后的新窗口：未占用读者槽时改为持有它
+                Window* Hold(const std::shared_ptr<Window>& pWindow)
+                {
+                    if (m_pSlot == nullptr)
+                    {
+                        m_pHold = pWindow;
+                    }
+                    return pWindow.get();
+                }
+        };
+
+        // 后台线程的检查间隔，同时在无人访问时按时切换窗口
+        static constexpr std::chrono::milliseconds REAP_INTERVAL{ 1000 };
+
+        const WindowConfig                   m_stConfig;// 配置
+        const std::function<int64_t()>       m_fnClock; // 当前时间(Unix 毫秒)
+        std::atomic<Window*>                 m_pCurrent;// 当前窗口，所有权在 m_pCurrentOwner
+        std::atomic<uint64_t>                m_ulEpoch{ 1 };// 纪元，每次替换当前窗口加一
+        std::unique_ptr<ReaderSlot[]>        m_pSlots;  // 读者槽
+        std::mutex                           m_stMutex; // 保护窗口切换、历史窗口和待释放窗口，后台线程也在此等待
+        std::shared_ptr<Window>              m_pCurrentOwner;// 当前窗口的所有者，受 m_stMutex 保护
+        std::condition_variable              m_stCond;  // 有窗口待释放或停止时唤醒后台线程
+        std::deque<std::shared_ptr<Window>>  m_deqHistory;// 已结束的窗口，新的在前
+        std::vector<std::shared_ptr<Window>> m_vecRetired;// 超出保留数、等待释放的窗口
+        bool                                 m_bStop = false;// 是否停止，受 m_stMutex 保护
+        std::thread                          m_stReaper;// 后台释放线程
+        std::atomic<uint64_t>                m_ulRollovers{ 0 };// 窗口切换次数
+
+        static int64_t GetSystemMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        static WindowConfig Normalize(WindowConfig stConfig)
+        {
+            stConfig.m_llLengthMs = std::max<int64_t>(stConfig.m_llLengthMs, 1);
+            return stConfig;
+        }
+
+        int64_t GetWindowIndex(int64_t llNowMs) const
+        {
+            int64_t llOffset = llNowMs - m_stConfig.m_llOriginMs;
+            int64_t llIndex = llOffset / m_stConfig.m_llLengthMs;
+            // 起点之前的时间向下取整
+            return llOffset % m_stConfig.m_llLengthMs < 0 ? llIndex - 1 : llIndex;
+        }
+
+        // 本线程使用的读者槽下标
+        static size_t GetThreadSlot()
+        {
+            static std::atomic<size_t> s_ulNextThread{ 0 };
+            thread_local size_t t_ulSlot = s_ulNextThread.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+            return t_ulSlot;
+        }
+
+        // 当前窗口，时间已进入新窗口时先切换；时钟回拨时继续使用已发布的窗口；返回的窗口在 stGuard 存在期间有效
+        Window* Acquire(ReadGuard& stGuard)
+        {
+            Window* pWindow = stGuard.GetCurrent();
+            int64_t llIndex = GetWindowIndex(m_fnClock());
+            if (pWindow->m_llIndex >= llIndex)
+            {
+                return pWindow;
+            }
+            return stGuard.Hold(Rollover(llIndex));
+        }
+
+        // 发布序号为 llIndex 的空窗口，同时到达边界的请求只有一个创建窗口
+        // 新窗口发布之后纪元才加一，取到旧窗口的请求登记的纪元一定早于旧窗口记下的纪元
+        std::shared_ptr<Window> Rollover(int64_t llIndex)
+        {
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            if (m_pCurrentOwner->m_llIndex >= llIndex)
+            {
+                return m_pCurrentOwner;
+            }
+            std::shared_ptr<Window> pOld = std::move(m_pCurrentOwner);
+            m_pCurrentOwner = std::make_shared<Window>(llIndex);
+            std::shared_ptr<Window> pNew = m_pCurrentOwner;
+            m_pCurrent.store(pNew.get(), std::memory_order_seq_cst);
+            pOld->m_ulUnpublishEpoch = m_ulEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+            m_deqHistory.push_front(std::move(pOld));
+            bool bRetired = false;
+            // 保留数按日历窗口计，中间没有写入的窗口也占一个名额
+            while (!m_deqHistory.empty() && m_deqHistory.back()->m_llIndex < llIndex - static_cast<int64_t>(m_stConfig.m_ulRetain))
+            {
+                m_vecRetired.push_back(std::move(m_deqHistory.back()));
+                m_deqHistory.pop_back();
+                bRetired = true;
+            }
+            m_ulRollovers.fetch_add(1, std::memory_order_relaxed);
+            if (bRetired)
+            {
+                m_stCond.notify_one();
+            }
+            return pNew;
+        }
+
+        // 往前第 ulBack 个窗口，0 为当前窗口；该窗口没有写入过或已不再保留时返回空
+        // 返回的窗口在 stGuard 存在期间有效：历史窗口由 pHold 持有，当前窗口由读者槽保护
+        Window* GetWindow(size_t ulBack, ReadGuard& stGuard, std::shared_ptr<Window>& pHold)
+        {
+            Window* pCurrent = Acquire(stGuard);
+            if (ulBack == 0)
+            {
+                return pCurrent;
+            }
+            int64_t llIndex = pCurrent->m_llIndex - static_cast<int64_t>(ulBack);
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            for (const auto& pWindow : m_deqHistory)
+            {
+                if (pWindow->m_llIndex == llIndex)
+                {
+                    pHold = pWindow;
+                    return pWindow.get();
+                }
+            }
+            return nullptr;
+        }
+
+        // 是否已没有请求可能持有在纪元 ulEpoch 时被替换下来的窗口
+        bool IsQuiescent(uint64_t ulEpoch) const
+        {
+            for (size_t i = 0; i < READER_SLOTS; ++i)
+            {
+                uint64_t ulSlot = m_pSlots[i].m_ulEpoch.load(std::memory_order_seq_cst);
+                if (ulSlot != 0 && ulSlot < ulEpoch)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 析构没有请求在用的待释放窗口，析构在锁外进行；返回释放的个数
+        size_t ReapLocked(std::unique_lock<std::mutex>& stLock)
+        {
+            std::vector<std::shared_ptr<Window>> vecFree;
+            for (size_t i = 0; i < m_vecRetired.size();)
+            {
+                // 只剩待释放列表这一个引用、且读者槽中没有更早的纪元时，之后不会再有请求取到它
+                if (m_vecRetired[i].use_count() == 1 && IsQuiescent(m_vecRetired[i]->m_ulUnpublishEpoch))
+                {
+                    vecFree.push_back(std::move(m_vecRetired[i]));
+                    m_vecRetired[i] = std::move(m_vecRetired.back());
+                    m_vecRetired.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            stLock.unlock();
+            size_t ulFreed = vecFree.size();
+            vecFree.clear();
+            stLock.lock();
+            return ulFreed;
+        }
+
+        void RunReaper()
+        {
+            std::unique_lock<std::mutex> stLock(m_stMutex);
+            while (!m_bStop)
+            {
+                m_stCond.wait_for(stLock, REAP_INTERVAL);
+                if (m_bStop)
+                {
+                    break;
+                }
+                // 无人访问时也按时切换，请求线程到了边界基本不用再切换
+                stLock.unlock();
+                {
+                    ReadGuard stGuard(*this);
+                    Acquire(stGuard);
+                }
+                stLock.lock();
+                ReapLocked(stLock);
+            }
+        }
+
+    public:
+        // fnClock 返回当前的 Unix 毫秒时间，为空时使用系统时钟
+        explicit WindowedLeaderboard(const WindowConfig& stConfig, std::function<int64_t()> fnClock = nullptr)
+            : m_stConfig(Normalize(stConfig)), m_fnClock(fnClock ? std::move(fnClock) : std::function<int64_t()>(GetSystemMs)),
+            m_pSlots(new ReaderSlot[READER_SLOTS])
+        {
+            m_pCurrentOwner = std::make_shared<Window>(GetWindowIndex(m_fnClock()));
+            m_pCurrent.store(m_pCurrentOwner.get());
+        }
+
+        WindowedLeaderboard(const WindowedLeaderboard&) = delete;
+        WindowedLeaderboard& operator=(const WindowedLeaderboard&) = delete;
+
+        ~WindowedLeaderboard()
+        {
+            Stop();
+        }
+
+        // 启动后台释放线程
+        void Start()
+        {
+            m_stReaper = std::thread([this]() { RunReaper(); });
+        }
+
+        // 停止后台线程，释放此时已无人使用的过期窗口
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> stLock(m_stMutex);
+                m_bStop = true;
+            }
+            m_stCond.notify_one();
+            if (m_stReaper.joinable())
+            {
+                m_stReaper.join();
+            }
+            Reap();
+        }
+
+        // 在调用线程上切换到期的窗口并释放无人使用的过期窗口，返回释放的个数；用于不启动后台线程的场合
+        size_t Reap()
+        {
+            {
+                ReadGuard stGuard(*this);
+                Acquire(stGuard);
+            }
+            std::unique_lock<std::mutex> stLock(m_stMutex);
+            return ReapLocked(stLock);
+        }
+
+        // 以下写操作都作用于当前窗口
+
+        EAddResult Add(std::string_view svMember, double dScore, const AddOptions& stOptions = AddOptions())
+        {
+            ReadGuard stGuard(*this);
+            return Acquire(stGuard)->m_stBoard.Add(svMember, dScore, stOptions);
+        }
+
+        bool IncrBy(std::string_view svMember, double dDelta, double& dNewScore)
+        {
+            ReadGuard stGuard(*this);
+            return Acquire(stGuard)->m_stBoard.IncrBy(svMember, dDelta, dNewScore);
+        }
+
+        bool Remove(std::string_view svMember)
+        {
+            ReadGuard stGuard(*this);
+            return Acquire(stGuard)->m_stBoard.Remove(svMember);
+        }
+
+        void ApplyBatch(const std::vector<WriteOp>& vecOps, std::vector<WriteResult>& vecResults)
+        {
+            ReadGuard stGuard(*this);
+            Acquire(stGuard)->m_stBoard.ApplyBatch(vecOps, vecResults);
+        }
+
+        // 以下查询的 ulBack 为往前第几个窗口，0 为当前窗口；窗口没有数据或已不再保留时按空榜处理
+
+        bool GetScore(std::string_view svMember, double& dScore, size_t ulBack = 0)
+        {
+            ReadGuard stGuard(*this);
+            std::shared_ptr<Window> pHold;
+            Window* pWindow = GetWindow(ulBack, stGuard, pHold);
+            return pWindow != nullptr && pWindow->m_stBoard.GetScore(svMember, dScore);
+        }
+
+        bool GetRank(std::string_view svMember, bool bReverse, size_t& ulRank, size_t ulBack = 0)
+        {
+            ReadGuard stGuard(*this);
+            std::shared_ptr<Window> pHold;
+            Window* pWindow = GetWindow(ulBack, stGuard, pHold);
+            return pWindow != nullptr && pWindow->m_stBoard.GetRank(svMember, bReverse, ulRank);
+        }
+
+        void GetRange(int64_t llStart, int64_t llStop, bool bReverse, std::vector<RankEntry>& vecOut, size_t ulBack = 0)
+        {
+            vecOut.clear();
+            ReadGuard stGuard(*this);
+            std::shared_ptr<Window> pHold;
+            Window* pWindow = GetWindow(ulBack, stGuard, pHold);
+            if (pWindow != nullptr)
+            {
+                pWindow->m_stBoard.GetRange(llStart, llStop, bReverse, vecOut);
+            }
+        }
+
+        size_t Count(const ScoreBound& stMin, const ScoreBound& stMax, size_t ulBack = 0)
+        {
+            ReadGuard stGuard(*this);
+            std::shared_ptr<Window> pHold;
+            Window* pWindow = GetWindow(ulBack, stGuard, pHold);
+            return pWindow != nullptr ? pWindow->m_stBoard.Count(stMin, stMax) : 0;
+        }
+
+        size_t Size(size_t ulBack = 0)
+        {
+            ReadGuard stGuard(*this);
+            std::shared_ptr<Window> pHold;
+            Window* pWindow = GetWindow(ulBack, stGuard, pHold);
+            return pWindow != nullptr ? pWindow->m_stBoard.Size() : 0;
+        }
+
+        // 当前窗口的序号，窗口起始时间为 起点 + 序号 x 长度
+        int64_t GetWindowIndex()
+        {
+            ReadGuard stGuard(*this);
+            return Acquire(stGuard)->m_llIndex;
+        }
+
+        uint64_t GetRolloverCount() const
+        {
+            return m_ulRollovers.load(std::memory_order_relaxed);
+        }
+
+        // 等待释放的窗口数
+        size_t GetRetiredCount()
+        {
+            std::lock_guard<std::mutex> stLock(m_stMutex);
+            return m_vecRetired.size();
+        }
+};